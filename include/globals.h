@@ -142,6 +142,9 @@
 #define INPSTACKMAX 10
 #define INPLINEMAX 255
 #define BUFFERMAX 80 /* smaller buffer */
+#define OUTPUTMAX 65536 /* default size of the output buffer */
+#define INPUTMAX 4096   /* size of the input buffer of read_bytes */
+#define INPBLOCKMAX 65536 /* bytes of a source file read at once */
 #define HELPLINEMAX 72
 #define MAXNUM 40 /* even smaller buffer */
 #define FILENAMEMAX 14
@@ -175,6 +178,8 @@ enum {
     VECTOR_,   /* was LIST_PRIME_ - native contiguous vector */
     DICT_,
     MATRIX_,   /* native contiguous matrix */
+    SEQ_,      /* lazy sequence */
+    SPARSE_,   /* native sparse matrix */
 
     LIBRA,
     EQDEF,
@@ -201,6 +206,9 @@ typedef enum {
 
 typedef enum { ABORT_NONE, ABORT_RETRY, ABORT_QUIT } Abort;
 
+/* flush policies of output, as JoyFlush in joy/joy.h */
+typedef enum { FLUSH_AUTO, FLUSH_LINE, FLUSH_SIZE, FLUSH_TERM, FLUSH_NONE } Flush;
+
 /* types			*/
 typedef unsigned char Operator; /* opcode / datatype */
 
@@ -214,39 +222,188 @@ typedef unsigned Index;
 typedef struct Node* Index;
 #endif
 
+/*
+ * Element types of native vectors and matrices. Values of other types than
+ * DT_F64 only result from ncast; conversions never happen implicitly.
+ */
+enum { DT_F64, DT_F32, DT_I64, DT_I32, DT_U8 };
+
+#define NATIVE_MAX_LEN ((int64_t)1 << 56) /* elements of a native value */
+
+/*
+ * A scalar operand, of the element type of the native operand.
+ */
+typedef union NativeScalar {
+    double f64;
+    float f32;
+    int64_t i64;
+    int32_t i32;
+    uint8_t u8;
+} NativeScalar;
+
 /*
  * Native contiguous vector/matrix storage for BLAS operations.
- * These are allocated via GC_malloc_atomic (no pointers inside).
- * The data[] array is a flexible array member for contiguous storage.
+ * These are allocated via native_vector and native_matrix (native.c).
+ * The elements follow the header in the same block; data points to them.
+ * A vector that is the result of an element-wise operation is deferred:
+ * kind and op tell the operation, and data is only computed by vector_force
+ * (kernel.c) when it is needed.
+ * A view shares the elements of the block base: data points into them, the
+ * elements of a vector are inc apart and the rows of a matrix ld apart, as
+ * BLAS expects them. Other values have base 0, inc 1 and ld equal to cols.
  */
 typedef struct VectorData {
-    int len;          /* number of elements */
-    double data[];    /* flexible array member */
+    int64_t len;              /* number of elements */
+    unsigned char dtype;      /* element type, DT_F64 ... */
+    unsigned char kind, op;   /* deferred operation, or VX_NONE */
+    unsigned short size;      /* number of deferred operations */
+    struct VectorData *a, *b; /* operands of the deferred operation */
+    NativeScalar s;           /* scalar operand */
+    int64_t inc;              /* distance between elements */
+    void* base;               /* block of the elements of a view, or 0 */
+    void* data;               /* elements */
 } VectorData;
 
 typedef struct MatrixData {
-    int rows;         /* number of rows */
-    int cols;         /* number of columns */
-    double data[];    /* row-major storage, flexible array member */
+    int64_t rows;        /* number of rows */
+    int64_t cols;        /* number of columns */
+    unsigned char dtype; /* element type, DT_F64 ... */
+    int64_t ld;          /* distance between rows */
+    void* base;          /* block of the elements of a view, or 0 */
+    void* data;          /* row-major storage */
 } MatrixData;
 
+/*
+ * Native sparse matrix (sparse.c), with compressed rows (SP_CSR) or columns
+ * (SP_CSC). With compressed rows, the nonzeros of row i are val[ptr[i]] up
+ * to val[ptr[i + 1]], in increasing order of their columns in idx; ptr has
+ * rows + 1 entries. With compressed columns, the same holds for columns and
+ * rows. The arrays follow the header in the same block; values are doubles.
+ */
+enum { SP_CSR, SP_CSC };
+
+typedef struct SparseData {
+    int64_t rows;         /* number of rows */
+    int64_t cols;         /* number of columns */
+    int64_t nnz;          /* number of stored elements */
+    unsigned char format; /* SP_CSR or SP_CSC */
+    int64_t* ptr;         /* start of each row or column in idx and val */
+    int64_t* idx;         /* column or row of each element */
+    double* val;          /* elements */
+} SparseData;
+
+/*
+ * Kinds of deferred vectors, and operations of the kernels (kernel.c).
+ * The R versions have the scalar as left operand.
+ */
+enum { VX_NONE, VX_BINARY, VX_SCALAR, VX_MAP };
+
+enum {
+    NK_ADD, NK_SUB, NK_MUL, NK_DIV,
+    NK_EQ, NK_NE, NK_LT, NK_LE, NK_GT, NK_GE,
+    NK_RSUB, NK_RDIV
+};
+
+enum { NK_SUM, NK_PROD, NK_MIN, NK_MAX, NK_SUMSQ };
+enum { NK_ABS, NK_SQRT, NK_EXP, NK_LOG };
+
 typedef union {
     int64_t num;      /* USR, BOOLEAN, CHAR, INTEGER */
     proc_t proc;      /* ANON_FUNCT */
     uint64_t set;     /* SET */
     char* str;        /* STRING */
-    Index lis;        /* LIST */
+    Index lis;        /* LIST, SEQ */
     double dbl;       /* FLOAT */
     FILE* fil;        /* FILE */
     int ent;          /* SYMBOL */
     void* dict;       /* DICT */
     VectorData* vec;  /* VECTOR_ */
     MatrixData* mat;  /* MATRIX_ */
+    SparseData* spm;  /* SPARSE_ */
 } Types;
 
+#ifdef NOBDW
+/*
+ * Table of canonical list nodes, used by hash-consing (hashcons.c).
+ * Open addressing with linear probing; 0 marks an empty slot.
+ */
+typedef struct HashCons {
+    Index* slot;  /* canonical nodes */
+    size_t size;  /* number of slots, a power of 2 */
+    size_t count; /* number of occupied slots */
+} HashCons;
+
+/*
+ * Kinds of lazy sequence (seq.c). The lis of a SEQ_ node is the state: a
+ * list that starts with the kind, followed by the parameters of the kind.
+ */
+enum {
+    SEQ_ITERATE,  /* [x [P] b] - x, P(x), P(P(x)), ...; b: x was the last */
+    SEQ_RANGE,    /* [i j] - i, i+1, ..., j */
+    SEQ_REPEAT,   /* [x] - x, x, ... */
+    SEQ_CYCLE,    /* [l m] - members of l, then of m, m, ... */
+    SEQ_MAP,      /* [s [P]] - P applied to the members of s */
+    SEQ_FILTER,   /* [s [P]] - members of s that satisfy P */
+    SEQ_TAKE,     /* [n s] - the first n members of s */
+    SEQ_TAKEWHILE /* [s [P]] - members of s as long as they satisfy P */
+};
+
+/*
+ * Cache of the memo and memorec combinators (memo.c). Entries are chained
+ * in buckets and in a list from most to least recently used.
+ */
+typedef struct MemoEntry {
+    uint64_t hash; /* hash of quote, argument and kind */
+    Index quote;   /* quotation, single node */
+    Index arg;     /* argument, single node */
+    Index value;   /* result, single node */
+    int rec;       /* 1 for memorec */
+    int chain;     /* next entry in bucket */
+    int newer, older; /* LRU order */
+} MemoEntry;
+
+typedef struct MemoTable {
+    MemoEntry* entry; /* entries, 0 .. count-1 */
+    int* bucket;      /* first entry in bucket, or -1 */
+    int size;         /* number of allocated entries */
+    int count;        /* number of used entries */
+    int buckets;      /* number of buckets, a power of 2 */
+    int limit;        /* maximum number of entries */
+    int newest, oldest; /* LRU ends, or -1 */
+} MemoTable;
+
+/*
+ * Blocks with the data of native vectors and matrices (native.c).
+ */
+typedef struct NativeHeap {
+    struct NativeBlock** block; /* blocks, 0 .. count-1 */
+    size_t count, size;         /* used and allocated slots */
+    size_t bytes;               /* bytes in all blocks */
+    size_t fresh;               /* bytes allocated since the last collection */
+    Index scanned;              /* definitions below have been scanned */
+} NativeHeap;
+#endif
+
+/*
+ * JSON read from a stream, in blocks, or from a string (json.c).
+ */
+typedef struct JsonReader {
+    FILE* fp;             /* stream, or 0 for a string */
+    size_t step;          /* bytes read at once */
+    char* buf;            /* block, or the string */
+    size_t pos, len;
+    char* str;            /* characters of a string or a number */
+    int64_t leng, room;
+    char* kind;           /* [ or { of each open array or object */
+    int64_t depth, size;
+    int expect;           /* what is allowed next */
+} JsonReader;
+
+#define MAX_STRING_LEN ((1u << 27) - 1) /* characters in a string node */
+
 #ifdef NOBDW
 typedef struct Node {
-    unsigned op : 4, len : 28; /* length of string */
+    unsigned op : 5, len : 27; /* length of string */
     Index next;
     Types u;
 } Node;
@@ -274,6 +431,79 @@ typedef struct Entry {
     } u;
 } Entry;
 
+#ifdef NOBDW
+/*
+ * Compiled patterns of match and cases (pattern.c). A pattern becomes a
+ * sequence of instructions in prefix order; a list instruction is followed
+ * by the patterns of its members. Cases programs also have a jump table for
+ * runs of clauses that are integer literals.
+ */
+enum {
+    PAT_ANY,  /* _ : anything */
+    PAT_BIND, /* name : anything, bound to the symbol in arg */
+    PAT_LIT,  /* literal in lit */
+    PAT_LIST, /* [p1 .. pn] : a list of exactly arg members */
+    PAT_CONS, /* [p1 .. pn : t] : a list of at least arg members, and 1 */
+    PAT_BAD,  /* cons pattern without exactly one tail pattern */
+    PAT_NONE  /* pattern that matches nothing */
+};
+
+typedef struct PatInstr {
+    int code; /* PAT_ANY .. PAT_NONE */
+    int arg;  /* symbol or number of members */
+    Index lit; /* literal */
+} PatInstr;
+
+typedef struct PatClause {
+    int start, stop; /* instructions of the pattern, none: anything */
+    int run;         /* > 0: number of clauses in the integer run */
+    int jump;        /* first entry of the run in the jump table */
+    Index action;    /* action of the clause */
+    char* error;     /* clause is malformed */
+} PatClause;
+
+typedef struct PatJump {
+    int64_t num; /* integer literal */
+    int clause;  /* first clause with that literal */
+} PatJump;
+
+typedef struct PatProgram {
+    Index key;         /* cases list, or pattern of match */
+    int kind;          /* 0 for cases, 1 for match */
+    int binds;         /* maximum number of variables in a clause */
+    PatInstr* instr;   /* instructions of all clauses */
+    PatClause* clause; /* clauses, or the pattern of match */
+    PatJump* jump;     /* sorted by literal and clause */
+    int instrs, clauses, jumps;
+    struct PatProgram* chain; /* next program in bucket */
+} PatProgram;
+
+typedef struct PatValue {
+    Index node; /* value, or first member of a tail */
+    int tail;   /* 1 when node is the first member of a tail */
+} PatValue;
+
+typedef struct PatBinding {
+    int sym;     /* bound symbol */
+    int top;     /* body is in the symbol table, used during collection */
+    Index body;  /* body of the binding */
+    Entry saved; /* entry before binding */
+} PatBinding;
+
+/*
+ * The cache of compiled programs is weak, like the table of hashcons.c. The
+ * bindings of running actions are roots: the collector copies their bodies.
+ */
+typedef struct PatternCache {
+    PatProgram** bucket;   /* programs, chained */
+    int buckets, count;    /* buckets is a power of 2 */
+    PatBinding* bind;      /* bindings of running actions */
+    int binds, maxbinds;
+    PatValue* pend;        /* values waiting to be matched */
+    int maxpend;
+} PatternCache;
+#endif
+
 #ifdef USE_KHASHL
 KHASHL_MAP_INIT(KH_LOCAL, symtab_t, symtab, const char*, int, kh_hash_str,
                 kh_eq_str)
@@ -287,6 +517,8 @@ KHASH_MAP_INIT_INT64(Funtab, int)
 /* Dictionary type: string keys, Index values */
 #ifdef NOBDW
 KHASH_MAP_INIT_STR(Dict, unsigned)
+/* Tables of dictionaries, by address (utils.c) */
+KHASH_SET_INIT_INT64(Seen)
 #else
 KHASH_MAP_INIT_STR(Dict, struct Node*)
 #endif
@@ -332,6 +564,16 @@ typedef struct EnvError {
     int column;         /* column of error */
 } EnvError;
 
+/*
+ * Cleanup - memory that a builtin holds while it executes a quotation. The
+ * procedure is called with data at the end of the builtin, or when execution
+ * is aborted (error.c).
+ */
+typedef struct Cleanup {
+    void (*proc)(void* data);
+    void* data;
+} Cleanup;
+
 /* EnvStats - Runtime statistics */
 typedef struct EnvStats {
     double nodes;    /* current node count */
@@ -366,6 +608,12 @@ typedef struct EnvScanner {
         int line;
         char name[FILENAMEMAX + 1];
     } infile[INPSTACKMAX];                /* include file stack */
+    struct {
+        FILE* fp;                         /* file of the block, or 0 */
+        int on;                           /* fp is read in blocks */
+        char* buf;                        /* block of INPBLOCKMAX bytes */
+        size_t pos, len;                  /* next and end of the block */
+    } block;                              /* source file read ahead */
     int ilevel;                           /* index in infile stack (-1 = empty) */
     int startnum;                         /* line number of token start */
     int startpos;                         /* position of token start */
@@ -410,8 +658,16 @@ typedef struct Env {
     size_t memorymax;   /* total capacity of memory array (was static in utils.c) */
     char* stack_bottom; /* bottom of C stack for this context (was global) */
     GC_Context* gc_ctx; /* per-context conservative GC (Phase 3) */
+    HashCons* hcons;    /* canonical nodes of shared lists */
+    MemoTable* memo;    /* cache of memo and memorec */
+    PatternCache* patterns; /* compiled patterns of match and cases */
+    NativeHeap* native; /* data of native vectors and matrices */
+    khash_t(Seen)* dicts;  /* tables of dictionaries in nodes */
+    khash_t(Seen)* copied; /* tables of dictionaries copied in a collection */
+    Index dicts_scanned;   /* definitions below have been scanned */
 #endif
     Index prog, stck;
+    vector(Cleanup) * cleanups; /* released when execution is aborted */
 #ifdef COMPILER
     FILE *declfp, *outfp;
 #endif
@@ -439,7 +695,20 @@ typedef struct Env {
         void  (*write_string)(void* user_data, const char* s);
         void  (*on_error)(void* user_data, int code, const char* msg,
                           const char* filename, int line, int column);
+        void  (*write_bytes)(void* user_data, const char* s, size_t n);
+        size_t (*read_bytes)(void* user_data, char* buf, size_t n);
     } io;
+    /* Input buffer of read_bytes */
+    struct {
+        char* buf;       /* characters read, or 0 before the first read */
+        size_t pos, len; /* next and number of characters in buf */
+    } in;
+    /* Output buffer of the callbacks; stdout has its own */
+    struct {
+        char* buf;            /* pending output, or 0 when unbuffered */
+        size_t len, size;     /* pending and maximum number of characters */
+        unsigned char policy; /* when to flush: FLUSH_AUTO ... */
+    } out;
 #ifdef JOY_SESSION
     Session* session;  /* persistent session state */
 #endif
@@ -530,10 +799,13 @@ typedef struct table_t {
 void fatal(char* str);
 /* error.c */
 void abortexecution_(pEnv env, int num);
+void cleanup_push(pEnv env, void (*proc)(void* data), void* data);
+void cleanup_pop(pEnv env);
 /* interp.c */
 void exec_term(pEnv env, Index n);
 /* scan.c */
 void inilinebuffer(pEnv env);
+void exitlinebuffer(pEnv env);
 int getch(pEnv env);
 void ungetch(pEnv env, int ch);
 void error(pEnv env, char* str);
@@ -551,8 +823,148 @@ void inimem2(pEnv env);
 void printnode(pEnv env, Index p);
 void gc_collect(pEnv env);
 void ensure_capacity(pEnv env, int num);
+void dict_free(pEnv env);
+int nodesize(pEnv env, Index n);
 char *check_strdup(char *str);
 void *check_malloc(size_t leng);
+/* hashcons.c */
+size_t hashcons_need(pEnv env, Index list);
+Index hashcons_list(pEnv env, Index list);
+void hashcons_forward(pEnv env);
+void hashcons_reset(pEnv env);
+void hashcons_free(pEnv env);
+uint64_t hash_value(pEnv env, Index n);
+int same_value(pEnv env, Index a, Index b);
+/* memo.c */
+int memo_lookup(pEnv env, uint64_t hash, Index quote, Index arg, int rec);
+void memo_insert(pEnv env, uint64_t hash, Index quote, Index arg, Index value,
+                 int rec);
+void memo_setlimit(pEnv env, int limit);
+void memo_clear(pEnv env);
+void memo_free(pEnv env);
+/* pattern.c */
+PatProgram* pattern_lookup(pEnv env, Index key, int kind);
+PatProgram* pattern_insert(pEnv env, PatProgram* prog);
+void pattern_bind(pEnv env, int sym, Index body);
+int pattern_depth(pEnv env);
+void pattern_unbind(pEnv env, int depth);
+PatValue* pattern_stack(pEnv env, int size);
+void pattern_forward(pEnv env);
+void pattern_reset(pEnv env);
+void pattern_free(pEnv env);
+/* kernel.c */
+size_t kernel_width(int dtype);
+const char* kernel_name(int dtype);
+int kernel_dtype(const char* name);
+void kernel_binary(int dtype, int op, void* c, const void* a, const void* b,
+                   size_t n);
+void kernel_scalar(int dtype, int op, void* c, const void* a,
+                   const NativeScalar* s, size_t n);
+double kernel_reduce(int dtype, int op, const void* a, size_t n);
+int64_t kernel_ireduce(int dtype, int op, const void* a, size_t n);
+void kernel_accumulate(int dtype, int op, void* r, const void* a, size_t n);
+void kernel_argaccumulate(int dtype, int op, void* r, int64_t* k, int64_t row,
+                          const void* a, size_t n);
+size_t kernel_argreduce(int dtype, int op, const void* a, size_t n);
+void kernel_map(int dtype, int op, void* c, const void* a, size_t n);
+void kernel_cast(int to, void* c, int from, const void* a, size_t n);
+double kernel_get(int dtype, const void* a, size_t i);
+int64_t kernel_geti(int dtype, const void* a, size_t i);
+void kernel_set(int dtype, void* c, size_t i, double x);
+void kernel_gather(int dtype, void* c, const void* a, int64_t i, int64_t inc,
+                   size_t n);
+double kernel_combine(int op, double r, double x);
+int64_t kernel_icombine(int op, int64_t r, int64_t x);
+VectorData* vector_defer(pEnv env, int kind, int op, VectorData* a,
+                         VectorData* b, const NativeScalar* s);
+void vector_eval(const VectorData* vec, void* c);
+void* vector_force(VectorData* vec);
+double vector_reduce(int op, VectorData* vec);
+int64_t vector_ireduce(int op, VectorData* vec);
+void vector_cast(int to, void* c, const VectorData* vec);
+/* gemm.c */
+void gemm_f64(int64_t m, int64_t n, int64_t k, double alpha, const double* a,
+              int64_t lda, const double* b, int64_t ldb, double* c,
+              int64_t ldc);
+void gemm_f32(int64_t m, int64_t n, int64_t k, float alpha, const float* a,
+              int64_t lda, const float* b, int64_t ldb, float* c, int64_t ldc);
+/* bytes.c */
+char* bytes_map(pEnv env, char* path, VectorData** res);
+int64_t bytes_find(const char* a, int64_t n, const char* s, int64_t m);
+/* csv.c */
+char* csv_read(pEnv env, char* path, int sep, MatrixData** res);
+/* data.c */
+char* data_read(pEnv env, const char* s, size_t n);
+char* data_fread(pEnv env, FILE* fp);
+/* json.c */
+void json_open(JsonReader* js, FILE* fp, char* s, size_t n);
+void json_close(JsonReader* js);
+int json_event(JsonReader* js, Types* u, int* type);
+void json_push(pEnv env, Types* u, int type);
+int json_read(pEnv env, JsonReader* js);
+/* fft.c */
+void fft_complex(double* x, int64_t n, int inverse);
+void fft_real(const double* x, int64_t n, double* c);
+void fft_ireal(const double* c, int64_t n, double* x);
+void fft_convolve(const double* a, int64_t na, const double* b, int64_t nb,
+                  double* c);
+/* linalg.c */
+void linalg_gemm(int64_t m, int64_t n, int64_t k, double alpha,
+                 const double* a, int64_t lda, const double* b, int64_t ldb,
+                 double* c, int64_t ldc);
+int linalg_lu(double* a, int64_t n, int64_t* piv);
+int linalg_solve(double* a, int64_t n, double* b, int64_t nrhs);
+double linalg_det(double* a, int64_t n);
+int linalg_cholesky(double* a, int64_t n);
+void linalg_qr(double* a, int64_t m, int64_t n, double* tau);
+void linalg_qr_q(const double* a, int64_t m, int64_t n, const double* tau,
+                 double* q);
+int linalg_lstsq(double* a, int64_t m, int64_t n, double* b, int64_t nrhs);
+/* native.c */
+void* native_alloc(pEnv env, size_t size);
+VectorData* native_vector(pEnv env, int dtype, int64_t len);
+MatrixData* native_matrix(pEnv env, int dtype, int64_t rows, int64_t cols);
+VectorData* native_vector_view(pEnv env, void* parent, void* data,
+                               int64_t len, int64_t inc);
+MatrixData* native_matrix_view(pEnv env, void* parent, void* data,
+                               int64_t rows, int64_t cols, int64_t ld);
+SparseData* native_sparse(pEnv env, int64_t rows, int64_t cols, int64_t nnz,
+                          int format);
+void* native_file(pEnv env, void* addr, size_t size);
+void* native_copy(pEnv env, void* ptr);
+void native_store(void* ptr);
+void native_mark(void* ptr);
+int native_full(pEnv env);
+void native_sweep(pEnv env);
+void native_free(pEnv env);
+/* npy.c */
+char* npy_load(pEnv env, char* path, Operator* type, Types* u);
+char* npy_save(pEnv env, char* path, Operator type, Types u);
+/* sparse.c */
+SparseData* sparse_build(pEnv env, int64_t rows, int64_t cols, int64_t n,
+                         const int64_t* ri, const int64_t* ci, const double* x,
+                         int format);
+SparseData* sparse_dense(pEnv env, const double* a, int64_t rows, int64_t cols,
+                         int64_t ld, int format);
+SparseData* sparse_convert(pEnv env, SparseData* spm, int format);
+SparseData* sparse_transpose(pEnv env, SparseData* spm);
+void sparse_todense(const SparseData* spm, double* c);
+void sparse_spmv(const SparseData* spm, const double* x, double* y);
+void sparse_spmm(const SparseData* spm, const double* b, int64_t ldb,
+                 int64_t n, double* c);
+SparseData* sparse_combine(pEnv env, int op, const SparseData* a,
+                           const SparseData* b);
+SparseData* sparse_scale(pEnv env, const SparseData* spm, double x);
+/* stats.c */
+void stats_sort(int dtype, void* a, int64_t n);
+void stats_argsort(int dtype, const void* a, int64_t* k, int64_t n);
+double stats_select(int dtype, void* a, int64_t n, int64_t k);
+int64_t stats_unique(int dtype, void* a, int64_t n);
+void stats_cumsum(int dtype, void* r, const void* a, int64_t n);
+void stats_hist(int dtype, const void* a, int64_t n, const double* edges,
+                int64_t bins, int64_t* counts);
+void stats_rollsum(int dtype, void* r, const void* a, int64_t n, int64_t w);
+void stats_rollmax(int dtype, void* r, const void* a, int64_t n, int64_t w);
 #endif
 /* error.c */
 void execerror(pEnv env, char* message, char* op);
@@ -592,6 +1004,8 @@ void hide_inner_modules(pEnv env, int flag);
 /* write.c */
 void writefactor(pEnv env, Index n, FILE* fp);
 void writeterm(pEnv env, Index n, FILE* fp);
+int writeinteger(char* buf, int64_t num);
+int writedouble(char* buf, double dbl);
 #ifdef BYTECODE
 /* bytecode.c */
 void bytecode(pEnv env, Node* list);
@@ -638,6 +1052,7 @@ void readtemp(pEnv env, char* file, Node* nodes[], int found, int seqnr);
 /* iolib.c - I/O abstraction layer */
 int joy_getchar(pEnv env);
 int joy_getc(pEnv env, FILE* fp);
+void joy_ungetc(pEnv env, int ch, FILE* fp);
 void joy_putchar(pEnv env, int ch);
 void joy_putc(pEnv env, int ch, FILE* fp);
 void joy_fputs(pEnv env, const char* s, FILE* fp);
@@ -645,12 +1060,20 @@ void joy_fwrite(pEnv env, const char* s, size_t len, FILE* fp);
 void joy_fprintf(pEnv env, FILE* fp, const char* fmt, ...);
 void joy_puts(pEnv env, const char* s);
 void joy_printf(pEnv env, const char* fmt, ...);
+void joy_output(pEnv env, int policy, size_t size);
+void joy_stdout(int policy);
 void joy_flush(pEnv env);
+void joy_flush_term(pEnv env);
+void joy_output_free(pEnv env);
+void joy_input_free(pEnv env);
 void joy_report_error(pEnv env, int code, const char* msg);
 #ifdef JOY_SESSION
 /* session.c - persistent session operations */
 void session_persist_symbol(pEnv env, const char* name, Index body);
 #endif
+/* seq.c - lazy sequences */
+void seq_make(pEnv env, int kind, int num);
+int seq_uncons(pEnv env);
 
 /*
  * Context-aware GC allocation macros (Phase 3)
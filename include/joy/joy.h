@@ -1,7 +1,7 @@
 /*
  *  module  : joy/joy.h
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Public API for the Joy programming language interpreter.
  *  This header provides the stable interface for embedding Joy.
@@ -17,12 +17,13 @@ extern "C" {
 #endif
 
 /*
- * Version information
+ * Version information. The major version changes when the layout of the
+ * public structs changes; code that embeds Joy must then be recompiled.
  */
-#define JOY_VERSION_MAJOR 1
+#define JOY_VERSION_MAJOR 2
 #define JOY_VERSION_MINOR 0
 #define JOY_VERSION_PATCH 0
-#define JOY_VERSION_STRING "1.0.0"
+#define JOY_VERSION_STRING "2.0.0"
 
 /*
  * Result codes returned by Joy API functions.
@@ -56,8 +57,27 @@ typedef struct JoyIO {
     void (*on_error)(void* user_data, JoyResult result,   /* Error callback */
                      const char* message, const char* file,
                      int line, int column);
+    void (*write_bytes)(void* user_data, const char* s,   /* Write n bytes, */
+                        size_t n);                        /* preferred */
+    size_t (*read_bytes)(void* user_data, char* buf,      /* Read up to n */
+                         size_t n);                       /* bytes, 0 = EOF */
 } JoyIO;
 
+/*
+ * When buffered output is written: to stdout, or to the callbacks.
+ * Output is also flushed when the buffer is full, by the fflush builtin on
+ * stdout, before error messages and at the end of an evaluation. The buffer
+ * of stdout is not changed by joy_create; the policy tells when it is
+ * flushed.
+ */
+typedef enum JoyFlush {
+    JOY_FLUSH_AUTO = 0, /* LINE on a terminal, TERM with callbacks, else SIZE */
+    JOY_FLUSH_LINE,     /* at each newline, and after each term */
+    JOY_FLUSH_SIZE,     /* only when the buffer is full */
+    JOY_FLUSH_TERM,     /* after each term evaluated at top level */
+    JOY_FLUSH_NONE      /* unbuffered: every write at once */
+} JoyFlush;
+
 /*
  * Configuration for creating a new interpreter context.
  * All fields are optional and have sensible defaults when set to 0/NULL.
@@ -69,6 +89,8 @@ typedef struct JoyConfig {
     int enable_autoput;            /* Auto-print stack after each line */
     int enable_echo;               /* Echo input lines */
     JoyIO* io;                     /* Custom I/O callbacks (NULL = stdio) */
+    JoyFlush flush_policy;         /* When buffered output is written */
+    size_t output_buffer_size;     /* Output buffer size (0 = default) */
 } JoyConfig;
 
 /*
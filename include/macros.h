@@ -71,11 +71,15 @@
     (env->bucket.str = u, newnode(env, BIGNUM_, env->bucket, r))
 #define DICT_NEWNODE(u, r)                                                    \
     (env->bucket.dict = u, newnode(env, DICT_, env->bucket, r))
+#define SEQ_NEWNODE(u, r)                                                     \
+    (env->bucket.lis = u, newnode(env, SEQ_, env->bucket, r))
 #ifdef JOY_NATIVE_TYPES
 #define VECTOR_NEWNODE(u, r)                                                  \
     (env->bucket.vec = u, newnode(env, VECTOR_, env->bucket, r))
 #define MATRIX_NEWNODE(u, r)                                                  \
     (env->bucket.mat = u, newnode(env, MATRIX_, env->bucket, r))
+#define SPARSE_NEWNODE(u, r)                                                  \
+    (env->bucket.spm = u, newnode(env, SPARSE_, env->bucket, r))
 #endif
 
 /*
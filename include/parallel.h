@@ -90,6 +90,8 @@ static inline void env_clone_for_parallel(pEnv parent, pEnv child)
     child->io.write_char = NULL;
     child->io.write_string = NULL;
     child->io.on_error = NULL;
+    child->io.write_bytes = NULL;
+    child->io.read_bytes = NULL;
 }
 
 /*
@@ -103,6 +105,16 @@ static inline void env_destroy_parallel(pEnv child)
         free(child->memory);
         child->memory = NULL;
     }
+    /* Free table of shared list nodes */
+    hashcons_free(child);
+    /* Free cache of memo and memorec */
+    memo_free(child);
+    /* Free compiled patterns of match and cases */
+    pattern_free(child);
+    /* Free data of native vectors and matrices */
+    native_free(child);
+    /* Free the set of tables of dictionaries */
+    dict_free(child);
     /* Destroy GC context */
     if (child->gc_ctx) {
         gc_ctx_destroy(child->gc_ctx);
@@ -140,10 +152,20 @@ static inline Index copy_single_node(pEnv parent, pEnv child, Index node)
         break;
 
     case LIST_:
+    case SEQ_:
         /* Recursively copy list contents (depth-bounded by actual nesting) */
         u.lis = copy_node_to_parent(parent, child, child->memory[node].u.lis);
         break;
 
+#ifdef JOY_NATIVE_TYPES
+    case VECTOR_:
+    case MATRIX_:
+    case SPARSE_:
+        /* Copy the data into parent's blocks */
+        u.vec = native_copy(parent, child->memory[node].u.vec);
+        break;
+#endif
+
     case USR_:
         /* User symbols are shared via symtab, just copy the index */
         u = child->memory[node].u;
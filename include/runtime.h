@@ -241,6 +241,16 @@
         execerror(env, "list as second parameter", NAME);                     \
         return;                                                               \
     }
+#define SEQUENCE(NAME)                                                        \
+    if (nodetype(env->stck) != SEQ_) {                                        \
+        execerror(env, "sequence", NAME);                                     \
+        return;                                                               \
+    }
+#define CHECKEMPTYSEQ(NAME)                                                   \
+    if (!seq_uncons(env)) {                                                   \
+        execerror(env, "non-empty sequence", NAME);                           \
+        return;                                                               \
+    }
 #define USERDEF(NAME)                                                         \
     if (nodetype(env->stck) != USR_) {                                        \
         execerror(env, "user defined symbol", NAME);                          \
@@ -361,6 +371,8 @@
 #define CHECKDIVISOR(NAME)
 #define LIST(NAME)
 #define LIST2(NAME)
+#define SEQUENCE(NAME)
+#define CHECKEMPTYSEQ(NAME) seq_uncons(env);
 #define USERDEF(NAME)
 #define USERDEF2(NODE, NAME)
 #define CHECKLIST(OPR, NAME)
@@ -1,11 +1,11 @@
 /*
  *  module  : aggregate.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.3
+ *  date    : 10/18/26
  *
  *  Grouped aggregate/list builtins: assign, at, concat, cons, drop, enconcat,
- *  first, list, null, of, rest, size, small, split, swons, take, unassign,
- *  uncons, unswons
+ *  first, hcons, list, null, of, rest, share, size, small, split, swons,
+ *  take, unassign, uncons, unswons
  */
 #include "globals.h"
 
@@ -64,6 +64,10 @@ void concat_(pEnv env)
         break;
     case STRING_:
         leng = nodeleng(nextnode1(env->stck)) + nodeleng(env->stck) + 1;
+        if (leng - 1 > MAX_STRING_LEN) { /* before str is allocated */
+            execerror(env, "smaller size", "concat");
+            return;
+        }
         str = malloc(leng);
         snprintf(str, leng, "%s%s", (char*)&nodevalue(nextnode1(env->stck)),
                  (char*)&nodevalue(env->stck));
@@ -184,6 +188,10 @@ void first_(pEnv env)
         CHECKEMPTYLIST(nodevalue(env->stck).lis, "first");
         GUNARY(nodevalue(env->stck).lis);
         break;
+    case SEQ_:
+        CHECKEMPTYSEQ("first");
+        POP(env->stck); /* the rest */
+        break;
     case STRING_:
         str = GETSTRING(env->stck);
         CHECKEMPTYSTRING(str, "first");
@@ -200,6 +208,18 @@ void first_(pEnv env)
     }
 }
 
+/**
+Q0  OK  2024  hcons  :  X A  ->  B
+List B is the shared version of list A with a new first member X.
+*/
+void hcons_(pEnv env)
+{
+    TWOPARAMS("hcons");
+    LIST("hcons");
+    cons_(env);
+    share_(env);
+}
+
 /**
 Q0  OK  2200  null  :  X  ->  B
 Tests for empty aggregate X or zero numeric.
@@ -234,6 +254,12 @@ void null_(pEnv env)
     case LIST_:
         UNARY(BOOLEAN_NEWNODE, (!nodevalue(env->stck).lis));
         break;
+    case SEQ_:
+        if (seq_uncons(env))
+            env->stck = BOOLEAN_NEWNODE(0, nextnode2(env->stck));
+        else
+            NULLARY(BOOLEAN_NEWNODE, 1);
+        break;
     case FLOAT_:
         UNARY(BOOLEAN_NEWNODE, (!nodevalue(env->stck).dbl));
         break;
@@ -284,11 +310,31 @@ void rest_(pEnv env)
         CHECKEMPTYLIST(nodevalue(env->stck).lis, "rest");
         UNARY(LIST_NEWNODE, nextnode1(nodevalue(env->stck).lis));
         break;
+    case SEQ_:
+        CHECKEMPTYSEQ("rest");
+        env->stck = newnode2(env, env->stck, nextnode2(env->stck));
+        break;
     default:
         BADAGGREGATE("rest");
     }
 }
 
+/**
+Q0  OK  2022  share  :  A  ->  B
+List B is equal to list A, built from shared nodes. Shared lists that are
+equal are identical, so that equal compares them in constant time.
+*/
+void share_(pEnv env)
+{
+    Index list;
+
+    ONEPARAM("share");
+    LIST("share");
+    ensure_capacity(env, hashcons_need(env, nodevalue(env->stck).lis) + 1);
+    list = hashcons_list(env, nodevalue(env->stck).lis);
+    UNARY(LIST_NEWNODE, list);
+}
+
 /**
 Q0  OK  2080  size  :  A  ->  I
 Integer I is the number of elements of aggregate A.
@@ -296,7 +342,8 @@ Integer I is the number of elements of aggregate A.
 void size_(pEnv env)
 {
     Index list;
-    int i, size = 0;
+    int i;
+    int64_t size = 0;
 
     ONEPARAM("size");
     switch (nodetype(env->stck)) {
@@ -316,6 +363,15 @@ void size_(pEnv env)
         for (list = nodevalue(env->stck).lis; list; list = nextnode1(list))
             size++;
         break;
+    case SEQ_:
+        for (; seq_uncons(env); size++)
+            env->stck = newnode2(env, env->stck, nextnode2(env->stck));
+        NULLARY(INTEGER_NEWNODE, size);
+        return;
+    case VECTOR_:
+        if (nodevalue(env->stck).vec)
+            size = nodevalue(env->stck).vec->len;
+        break;
     default:
         BADAGGREGATE("size");
     }
@@ -515,6 +571,13 @@ void take_(pEnv env)
         POP(env->dump2);
         POP(env->dump3);
         break;
+    case SEQ_:
+        ensure_capacity(env, 2); /* no gc below */
+        temp = env->stck;
+        env->stck = INTEGER_NEWNODE(n, nextnode1(temp));
+        GNULLARY(temp);
+        seq_make(env, SEQ_TAKE, 2);
+        break;
     default:
         BADAGGREGATE("take");
     }
@@ -577,6 +640,9 @@ void uncons_(pEnv env)
         NULLARY(LIST_NEWNODE, nextnode1(nodevalue(SAVED1).lis));
         POP(env->dump);
         break;
+    case SEQ_:
+        CHECKEMPTYSEQ("uncons");
+        break;
     default:
         BADAGGREGATE("uncons");
     }
@@ -1,7 +1,7 @@
 /*
  *  module  : builtin_macros.h
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Consolidated macro definitions for Joy builtins.
  *  IMPORTANT: Requires globals.h to be included first.
@@ -366,6 +366,10 @@ cmpstr:
             break;                                                            \
         case STRING_:                                                         \
             CHECKCHARACTER(ELEM, NAME);                                       \
+            if ((unsigned)nodeleng(AGGR) + 1 > MAX_STRING_LEN) {              \
+                execerror(env, "smaller size", NAME);                         \
+                return;                                                       \
+            }                                                                 \
             str = malloc(nodeleng(AGGR) + 2);                                 \
             str[0] = (char)nodevalue(ELEM).num;                               \
             strcpy(str + 1, (char*)&nodevalue(AGGR));                         \
@@ -598,15 +602,35 @@ static void decode_time(pEnv env, struct tm* t)
 /* ======== of_at.h ======== */
 /*
     module  : of_at.h
-    version : 1.11
-    date    : 09/17/24
+    version : 1.12
+    date    : 10/18/26
 */
+/*
+ * Element indx of native vector vec, for at and of: an integer for integer
+ * elements and a float for the others.
+ */
+static void native_at(pEnv env, VectorData* vec, int64_t indx, char* name)
+{
+    void* a;
+
+    if (!vec || indx >= vec->len) {
+        execerror(env, "smaller index", name);
+        return;
+    }
+    a = vector_force(vec);
+    if (vec->dtype == DT_F64 || vec->dtype == DT_F32)
+        BINARY(FLOAT_NEWNODE, kernel_get(vec->dtype, a, indx * vec->inc));
+    else
+        BINARY(INTEGER_NEWNODE, kernel_geti(vec->dtype, a, indx * vec->inc));
+}
+
 #define OF_AT(PROCEDURE, NAME, AGGR, INDEX)                                   \
     void PROCEDURE(pEnv env)                                                  \
     {                                                                         \
         Index n;                                                              \
         char* str;                                                            \
-        int i, indx;                                                          \
+        int i;                                                                \
+        int64_t indx;                                                         \
         TWOPARAMS(NAME);                                                      \
         POSITIVEINDEX(INDEX, NAME);                                           \
         indx = nodevalue(INDEX).num;                                          \
@@ -641,6 +665,9 @@ static void decode_time(pEnv env, struct tm* t)
             }                                                                 \
             GBINARY(n);                                                       \
             break;                                                            \
+        case VECTOR_:                                                         \
+            native_at(env, nodevalue(AGGR).vec, indx, NAME);                  \
+            break;                                                            \
         default:                                                              \
             BADAGGREGATE(NAME);                                               \
         }                                                                     \
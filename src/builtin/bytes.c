@@ -0,0 +1,195 @@
+/*
+ *  module  : bytes.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Files as native vectors of bytes: fmmap nfind nsplit nstring.
+ *
+ *  The mapping is in src/bytes.c. fmmap gives a uint8 view of a file in
+ *  memory, that size and at read and nvslice cuts into substrings. nfind and
+ *  nsplit search it, and nsplit gives the lines or fields as views as well:
+ *  nothing is copied until nstring makes a string of a part.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+/*
+ * The native vector of bytes in node p, or 0 after an error. An empty vector
+ * without elements is given as empty.
+ */
+static VectorData* bytes_vector(pEnv env, Index p, VectorData* empty,
+                                char* name)
+{
+    VectorData* vec;
+
+    if (nodetype(p) != VECTOR_) {
+        execerror(env, "native vector of bytes", name);
+        return 0;
+    }
+    if ((vec = nodevalue(p).vec) == 0) {
+        memset(empty, 0, sizeof(VectorData));
+        empty->dtype = DT_U8;
+        empty->kind = VX_NONE;
+        empty->inc = 1;
+        return empty;
+    }
+    if (vec->dtype != DT_U8) {
+        execerror(env, "native vector of bytes", name);
+        return 0;
+    }
+    return vec;
+}
+
+/*
+ * The bytes of vector vec, adjacent: its own, or a copy that the caller
+ * frees when it is not vec->data.
+ */
+static char* bytes_adjacent(VectorData* vec)
+{
+    char* a;
+
+    if (vec->inc == 1)
+        return vector_force(vec);
+    a = check_malloc(vec->len ? vec->len : 1);
+    vector_cast(DT_U8, a, vec);
+    return a;
+}
+
+/**
+Q0  OK  4590  fmmap  :  P  ->  V
+[NATIVE] V is the native vector of the bytes, as uint8, of the file with
+pathname P. The file is mapped into memory, read only, and V refers to its
+bytes without copying them; pages are read when they are used.
+*/
+void fmmap_(pEnv env)
+{
+    char* msg;
+    VectorData* vec;
+
+    ONEPARAM("fmmap");
+    STRING("fmmap");
+    if ((msg = bytes_map(env, GETSTRING(env->stck), &vec)) != 0) {
+        execerror(env, msg, "fmmap");
+        return;
+    }
+    UNARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4600  nfind  :  V S  ->  I
+[NATIVE] I is the position of the first occurrence of the bytes of string S
+in native vector of bytes V, or -1 if there is none. S can also be a native
+vector of bytes.
+*/
+void nfind_(pEnv env)
+{
+    int64_t m, pos;
+    char *a, *s, *b = 0;
+    VectorData empty, empty2, *vec, *pat = 0;
+
+    TWOPARAMS("nfind");
+    if ((vec = bytes_vector(env, nextnode1(env->stck), &empty, "nfind")) == 0)
+        return;
+    if (nodetype(env->stck) == VECTOR_) {
+        if ((pat = bytes_vector(env, env->stck, &empty2, "nfind")) == 0)
+            return;
+        s = b = bytes_adjacent(pat);
+        m = pat->len;
+    } else {
+        STRING("nfind");
+        s = GETSTRING(env->stck);
+        m = strlen(s);
+    }
+    a = bytes_adjacent(vec);
+    pos = bytes_find(a, vec->len, s, m);
+    if (a != vec->data)
+        free(a);
+    if (pat && b != pat->data)
+        free(b);
+    BINARY(INTEGER_NEWNODE, pos);
+}
+
+/**
+Q0  OK  4610  nsplit  :  V C  ->  L
+[NATIVE] L is the list of the parts of native vector of bytes V between
+occurrences of character C, as views that share the bytes of V. A last empty
+part, after a C at the end of V, is left out: '\n splits lines.
+*/
+void nsplit_(pEnv env)
+{
+    char *a, *p;
+    int sep;
+    Index list = 0;
+    VectorData empty, *vec, *res;
+    int64_t n = 0, room = 0, start, *ends = 0;
+
+    TWOPARAMS("nsplit");
+    if (nodetype(env->stck) != CHAR_ && nodetype(env->stck) != INTEGER_) {
+        execerror(env, "character", "nsplit");
+        return;
+    }
+    if ((vec = bytes_vector(env, nextnode1(env->stck), &empty, "nsplit")) == 0)
+        return;
+    sep = (unsigned char)nodevalue(env->stck).num;
+    a = bytes_adjacent(vec);
+    for (p = a; p < a + vec->len; p++) {
+        if ((p = memchr(p, sep, a + vec->len - p)) == 0)
+            p = a + vec->len;
+        if (n == room) {
+            room = room * 2 + 64;
+            ends = realloc(ends, room * sizeof(int64_t));
+#ifdef TEST_MALLOC_RETURN
+            if (!ends)
+                fatal("memory exhausted");
+#endif
+        }
+        ends[n++] = p - a;
+    }
+    if (a != vec->data)
+        free(a);
+    /*
+     * The views are consed in reverse: newnode keeps the list when it
+     * collects, and the vector in its node on the stack keeps the bytes.
+     */
+    while (n-- > 0) {
+        start = n ? ends[n - 1] + 1 : 0;
+        res = native_vector_view(env, vec,
+                                 (char*)vec->data + start * vec->inc,
+                                 ends[n] - start, vec->inc);
+        list = VECTOR_NEWNODE(res, list);
+    }
+    free(ends);
+    BINARY(LIST_NEWNODE, list);
+}
+
+/**
+Q0  OK  4620  nstring  :  V  ->  S
+[NATIVE] S is the string of the bytes of native vector of bytes V, that are
+copied. A zero byte ends S.
+*/
+void nstring_(pEnv env)
+{
+    char *a, *buf;
+    VectorData empty, *vec;
+
+    ONEPARAM("nstring");
+    if ((vec = bytes_vector(env, env->stck, &empty, "nstring")) == 0)
+        return;
+    if ((size_t)vec->len > MAX_STRING_LEN) {
+        execerror(env, "smaller size", "nstring");
+        return;
+    }
+    buf = check_malloc(vec->len + 1);
+    a = bytes_adjacent(vec);
+    memcpy(buf, a, vec->len);
+    buf[vec->len] = 0;
+    if (a != vec->data)
+        free(a);
+#ifdef NOBDW
+    UNARY(STRING_NEWNODE, buf);
+#else
+    UNARY(STRING_NEWNODE, GC_strdup(buf));
+#endif
+    free(buf);
+}
+#endif /* JOY_NATIVE_TYPES */
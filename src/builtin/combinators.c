@@ -4,7 +4,7 @@
  *  date    : 01/22/26
  *
  *  Grouped combinator builtins: app1, app11, app12, app2, app3, app4, cleave,
- *  construct, dip, filter, fold, infra, map, step, times, while
+ *  construct, dip, filter, fold, fuse, infra, map, step, times, while
  */
 #include "globals.h"
 
@@ -198,6 +198,9 @@ void filter_(pEnv env)
         POP(env->dump2);
         POP(env->dump1);
         break;
+    case SEQ_:
+        seq_make(env, SEQ_FILTER, 2);
+        break;
     default:
         BADAGGREGATE("filter");
     }
@@ -216,6 +219,167 @@ void fold_(pEnv env)
     step_(env);
 }
 
+/*
+ * Locate the stage of fuse that starts at node n: [P] map, [P] filter,
+ * [P] step, [P] fold or V [P] fold. The node of [P] is returned and the
+ * builtin is stored in proc; init tells whether V is present. 0 is returned
+ * when n does not start a stage.
+ */
+static Index fuse_stage(pEnv env, Index n, proc_t* proc, int* init)
+{
+    Index q;
+
+    *proc = 0;
+    for (*init = 0; *init < 2; (*init)++, n = nextnode1(n)) {
+        if (!n || nodetype(n) != LIST_ || !(q = nextnode1(n))
+            || nodetype(q) != ANON_FUNCT_)
+            continue;
+        *proc = nodevalue(q).proc;
+        if (*proc == fold_ || (!*init && (*proc == map_ || *proc == filter_
+                                          || *proc == step_)))
+            return n;
+    }
+    return 0;
+}
+
+/*
+ * Run the stages of fuse on the element that is on top of the stack below
+ * the aggregate. The element is dropped by a failing filter, combined into
+ * DMP4 by fold or step, or appended to the list in DMP4/DMP5.
+ */
+static void fuse_element(pEnv env)
+{
+    int init, result;
+    Index temp;
+    proc_t proc;
+
+    for (DMP2 = nodevalue(SAVED1).lis; DMP2;) {
+        fuse_stage(env, DMP2, &proc, &init);
+        if (proc == map_) {
+            exec_term(env, nodevalue(fuse_stage(env, DMP2, &proc, &init)).lis);
+            CHECKSTACK("fuse");
+            if (nextnode1(env->stck) != SAVED3) /* only the top is used */
+                env->stck = newnode2(env, env->stck, SAVED3);
+        } else if (proc == filter_) {
+            DMP3 = env->stck;
+            exec_term(env, nodevalue(fuse_stage(env, DMP2, &proc, &init)).lis);
+            CHECKSTACK("fuse");
+            result = get_boolean(env, env->stck);
+            env->stck = DMP3;
+            if (!result)
+                return;
+        } else { /* fold or step, the last stage */
+            if (proc == fold_ && !DMP4) { /* the first member starts fold */
+                temp = newnode2(env, env->stck, SAVED3);
+                DMP4 = temp;
+                return;
+            }
+            env->stck = newnode2(env, env->stck, DMP4);
+            exec_term(env, nodevalue(fuse_stage(env, DMP2, &proc, &init)).lis);
+            DMP4 = env->stck;
+            return;
+        }
+        temp = fuse_stage(env, DMP2, &proc, &init);
+        DMP2 = nextnode2(temp);
+    }
+    temp = newnode2(env, env->stck, 0);
+    if (!DMP4) { /* first */
+        DMP4 = temp;
+        DMP5 = DMP4;
+    } else { /* further */
+        nextnode1(DMP5) = temp;
+        DMP5 = nextnode1(DMP5);
+    }
+}
+
+/**
+Q1  OK  2795  fuse  :  A [S]  ->  B
+Passes the members of aggregate A one at a time through the stages S,
+without intermediate aggregates. A stage is [P] map, [P] filter, [P] step
+or V [P] fold, where V may be left out to start with the first member;
+step and fold end S. B is the list of results, or what step or fold leaves.
+*/
+void fuse_(pEnv env)
+{
+    int i = 0, init = 0;
+    char* str;
+    Index n, q = 0, v = 0, temp;
+    proc_t proc = map_;
+
+    TWOPARAMS("fuse");
+    ONEQUOTE("fuse");
+    for (n = nodevalue(env->stck).lis; n; n = nextnode2(q)) {
+        if (proc == fold_ || proc == step_)
+            execerror(env, "fold or step as last stage", "fuse");
+        if ((q = fuse_stage(env, n, &proc, &init)) == 0)
+            execerror(env, "map, filter, fold or step stages", "fuse");
+    }
+    SAVESTACK;
+    env->dump2 = LIST_NEWNODE(0, env->dump2); /* current stage */
+    env->dump3 = LIST_NEWNODE(0, env->dump3); /* member before filter */
+    env->dump4 = LIST_NEWNODE(0, env->dump4); /* head new or stack */
+    env->dump5 = LIST_NEWNODE(0, env->dump5); /* last new */
+    if (proc == step_)
+        DMP4 = SAVED3;
+    else if (proc == fold_ && init) { /* locate V again, after gc */
+        for (n = nodevalue(SAVED1).lis; n; n = nextnode2(q)) {
+            v = n;
+            q = fuse_stage(env, n, &proc, &init);
+        }
+        temp = newnode2(env, v, SAVED3);
+        DMP4 = temp;
+    }
+    switch (nodetype(SAVED2)) {
+    case LIST_:
+        env->dump1 = LIST_NEWNODE(nodevalue(SAVED2).lis, env->dump1);
+        for (; DMP1; DMP1 = nextnode1(DMP1)) {
+            env->stck = newnode2(env, DMP1, SAVED3);
+            fuse_element(env);
+        }
+        POP(env->dump1);
+        break;
+    case STRING_:
+        for (str = strdup((char*)&nodevalue(SAVED2)); str[i]; i++) {
+            env->stck = CHAR_NEWNODE(str[i], SAVED3);
+            fuse_element(env);
+        }
+        free(str);
+        break;
+    case SET_:
+        for (; i < SETSIZE; i++)
+            if (nodevalue(SAVED2).set & ((int64_t)1 << i)) {
+                env->stck = INTEGER_NEWNODE(i, SAVED3);
+                fuse_element(env);
+            }
+        break;
+    case SEQ_:
+        env->dump1 = LIST_NEWNODE(SAVED2, env->dump1);
+        for (;;) {
+            env->stck = newnode2(env, DMP1, SAVED3);
+            if (!seq_uncons(env))
+                break;
+            DMP1 = env->stck; /* the rest */
+            POP(env->stck);
+            fuse_element(env);
+        }
+        POP(env->dump1);
+        break;
+    default:
+        BADAGGREGATE("fuse");
+    }
+    if (proc == fold_ && !DMP4)
+        execerror(env, "non-empty aggregate", "fuse");
+    if (proc == fold_ || proc == step_)
+        env->stck = DMP4;
+    else
+        env->stck = LIST_NEWNODE(DMP4, SAVED3);
+    POP(env->dump5);
+    POP(env->dump4);
+    POP(env->dump3);
+    POP(env->dump2);
+    POP(env->dump);
+}
+
 /**
 Q1  OK  2810  infra  :  L1 [P]  ->  L2
 Using list L1 as stack, executes P and returns a new list L2.
@@ -293,6 +457,9 @@ void map_(pEnv env)
             }
         env->stck = SET_NEWNODE(set, SAVED3);
         break;
+    case SEQ_:
+        seq_make(env, SEQ_MAP, 2);
+        break;
     default:
         BADAGGREGATE("map");
     }
@@ -336,6 +503,18 @@ void step_(pEnv env)
                 exec_term(env, nodevalue(SAVED1).lis);
             }
         break;
+    case SEQ_:
+        env->dump1 = LIST_NEWNODE(SAVED2, env->dump1);
+        for (;;) {
+            env->stck = newnode2(env, DMP1, env->stck);
+            if (!seq_uncons(env))
+                break;
+            DMP1 = env->stck; /* the rest */
+            POP(env->stck);
+            exec_term(env, nodevalue(SAVED1).lis);
+        }
+        POP(env->dump1);
+        break;
     default:
         BADAGGREGATE("step");
     }
@@ -33,7 +33,7 @@ static int equal_aux(pEnv env, Index n1, Index n2); /* forward */
 
 static int equal_list_aux(pEnv env, Index n1, Index n2)
 {
-    if (!n1 && !n2)
+    if (n1 == n2) /* identical, also when shared */
         return 1;
     if (!n1 || !n2)
         return 0;
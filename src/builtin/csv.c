@@ -0,0 +1,44 @@
+/*
+ *  module  : csv.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Numeric tables of CSV and TSV files as native matrices: ncsvread.
+ *
+ *  The reader is in src/csv.c. The file is mapped into memory and its fields
+ *  are parsed straight into the elements of the matrix, without strings,
+ *  lists or a conversion with >mat in between.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+/**
+Q0  OK  4630  ncsvread  :  P C  ->  M
+[NATIVE] M is the native matrix of float64 of the numeric table in the file
+with pathname P, with fields separated by character C: ', for CSV, '\t for
+TSV. A first line that is not numeric is skipped as a header, and so are
+empty lines; empty fields are NaN. All rows have the same number of fields.
+*/
+void ncsvread_(pEnv env)
+{
+    char* msg;
+    MatrixData* mat;
+
+    TWOPARAMS("ncsvread");
+    if (nodetype(env->stck) != CHAR_) {
+        execerror(env, "character", "ncsvread");
+        return;
+    }
+    if (nodetype(nextnode1(env->stck)) != STRING_) {
+        execerror(env, "string", "ncsvread");
+        return;
+    }
+    if ((msg = csv_read(env, GETSTRING(nextnode1(env->stck)),
+                        (unsigned char)nodevalue(env->stck).num, &mat))
+        != 0) {
+        execerror(env, msg, "ncsvread");
+        return;
+    }
+    BINARY(MATRIX_NEWNODE, mat);
+}
+#endif /* JOY_NATIVE_TYPES */
@@ -0,0 +1,49 @@
+/*
+ *  module  : data.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Reading data files without the parser: fparse readdata.
+ *
+ *  The reader is in src/data.c. It only knows literals, so reading a file of
+ *  lists and numbers does not look up or enter names, qualify them in
+ *  modules or execute anything, as include and get do.
+ */
+#include "globals.h"
+
+/**
+Q0  OK  1895  fparse  :  S  ->  S L
+[FOREIGN] L is the list of the values of the literals in the rest of stream
+S: numbers, characters, strings, sets, lists, true and false, and v[ and m[[
+literals. Comments and full stops are skipped; names are not allowed.
+*/
+void fparse_(pEnv env)
+{
+    char* msg;
+
+    ONEPARAM("fparse");
+    ISFILE("fparse");
+    if ((msg = data_fread(env, nodevalue(env->stck).fil)) != 0)
+        execerror(env, msg, "fparse");
+}
+
+/**
+Q0  OK  3075  readdata  :  "text"  ->  L
+L is the list of the values of the literals in "text", that are read as
+fparse reads them from a stream.
+*/
+void readdata_(pEnv env)
+{
+    char *str, *msg;
+
+    ONEPARAM("readdata");
+    STRING("readdata");
+    str = check_strdup(GETSTRING(env->stck)); /* nodes move while reading */
+    msg = data_read(env, str, strlen(str));
+    free(str);
+    if (msg) {
+        execerror(env, msg, "readdata");
+        return;
+    }
+    BINARY(LIST_NEWNODE, nodevalue(env->stck).lis);
+}
@@ -1,10 +1,12 @@
 /*
  *  module  : dict.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Dictionary operations for Joy.
  *  Dictionaries are hash maps with string keys and arbitrary Joy values.
+ *  A table owns its keys, that are allocated with check_strdup, and the
+ *  collector releases both when no node refers to the table.
  */
 #include "globals.h"
 #include "runtime.h"
@@ -49,7 +51,7 @@ static khash_t(Dict)* dict_copy(pEnv env, khash_t(Dict)* src)
 
     for (k = kh_begin(src); k != kh_end(src); ++k) {
         if (kh_exist(src, k)) {
-            khint_t key = kh_put(Dict, dst, GC_strdup(kh_key(src, k)), &ret);
+            khint_t key = kh_put(Dict, dst, check_strdup((char*)kh_key(src, k)), &ret);
             kh_value(dst, key) = kh_value(src, k);
         }
     }
@@ -82,14 +84,19 @@ void dput_(pEnv env)
     DICT3("dput");
     STRING2("dput");
 
+#ifdef NOBDW
+    ensure_capacity(env, 2); /* value and d2 stay where they are */
+#endif
     value = env->stck;
-    key = GC_strdup(GETSTRING(nextnode1(env->stck)));
+    key = check_strdup(GETSTRING(nextnode1(env->stck)));
     d = (khash_t(Dict)*)nodevalue(nextnode2(env->stck)).dict;
 
     /* Create a copy for immutable semantics */
     d2 = dict_copy(env, d);
 
     k = kh_put(Dict, d2, key, &ret);
+    if (!ret) /* the table has the key */
+        free(key);
     kh_value(d2, k) = newnode2(env, value, 0);
 
     env->stck = DICT_NEWNODE(d2, nextnode3(env->stck));
@@ -178,6 +185,7 @@ void ddel_(pEnv env)
 
     k = kh_get(Dict, d2, key);
     if (k != kh_end(d2)) {
+        free((char*)kh_key(d2, k));
         kh_del(Dict, d2, k);
     }
 
@@ -302,11 +310,17 @@ void todict_(pEnv env)
     Index lis, pair, key_node, val_node;
     char* key;
     khint_t k;
-    int ret;
+    int ret, count = 0;
 
     ONEPARAM(">dict");
     ONEQUOTE(">dict");
 
+    /* Count pairs first for ensure_capacity */
+    for (lis = nodevalue(env->stck).lis; lis; lis = nextnode1(lis))
+        count++;
+#ifdef NOBDW
+    ensure_capacity(env, count + 1);
+#endif
     d = dict_new();
     lis = nodevalue(env->stck).lis;
 
@@ -328,8 +342,10 @@ void todict_(pEnv env)
             return;
         }
 
-        key = GC_strdup(GETSTRING(key_node));
+        key = check_strdup(GETSTRING(key_node));
         k = kh_put(Dict, d, key, &ret);
+        if (!ret)
+            free(key);
         kh_value(d, k) = newnode2(env, val_node, 0);
 
         lis = nextnode1(lis);
@@ -426,7 +442,9 @@ void dmerge_(pEnv env)
     if (d2) {
         for (k = kh_begin(d2); k != kh_end(d2); ++k) {
             if (kh_exist(d2, k)) {
-                khint_t key = kh_put(Dict, d3, GC_strdup(kh_key(d2, k)), &ret);
+                khint_t key = kh_get(Dict, d3, kh_key(d2, k));
+                if (key == kh_end(d3))
+                    key = kh_put(Dict, d3, check_strdup((char*)kh_key(d2, k)), &ret);
                 kh_value(d3, key) = kh_value(d2, k);
             }
         }
@@ -451,6 +469,9 @@ void dgetd_(pEnv env)
     STRING2("dgetd");
     DICT3("dgetd");
 
+#ifdef NOBDW
+    ensure_capacity(env, 1);
+#endif
     defval = env->stck;
     key = GETSTRING(nextnode1(env->stck));
     d = (khash_t(Dict)*)nodevalue(nextnode2(env->stck)).dict;
@@ -0,0 +1,150 @@
+/*
+ *  module  : fft.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Fourier transforms and convolution of native vectors: nfft nifft nconv.
+ *
+ *  The transforms are in src/fft.c. There is no complex element type: a
+ *  sequence of complex numbers is a native matrix of two float64 columns,
+ *  the real and the imaginary parts. The transform of a real vector only
+ *  has the first half of the complex numbers, as the others are conjugates.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+/*
+ * The complex numbers in native matrix mat of two columns, as pairs of
+ * doubles in x.
+ */
+static void fft_pairs(MatrixData* mat, double* x)
+{
+    int64_t i;
+    size_t width = kernel_width(mat->dtype);
+
+    for (i = 0; i < mat->rows; i++)
+        kernel_cast(DT_F64, x + 2 * i, mat->dtype,
+                    (char*)mat->data + i * mat->ld * width, 2);
+}
+
+/*
+ * The native matrix in node p of two columns, or 0 after an error.
+ */
+static MatrixData* fft_complex_matrix(pEnv env, Index p, char* name)
+{
+    MatrixData* mat;
+
+    if (nodetype(p) != MATRIX_ || (mat = nodevalue(p).mat) == 0
+        || mat->cols != 2) {
+        execerror(env, "native vector or matrix of two columns", name);
+        return 0;
+    }
+    return mat;
+}
+
+/**
+Q0  OK  4530  nfft  :  X  ->  M
+[NATIVE] M is the discrete Fourier transform of native vector X, as a matrix
+of the real and imaginary parts in two columns. For a vector of N elements,
+M has the first N / 2 + 1 rows; the others are their conjugates. X can also
+be a matrix of two columns of complex numbers, that gives all rows.
+*/
+void nfft_(pEnv env)
+{
+    double* x;
+    VectorData* vec;
+    MatrixData *mat, *res;
+
+    ONEPARAM("nfft");
+    if (nodetype(env->stck) == VECTOR_) {
+        if ((vec = nodevalue(env->stck).vec) == 0 || !vec->len) {
+            execerror(env, "non-empty native vector", "nfft");
+            return;
+        }
+        res = native_matrix(env, DT_F64, vec->len / 2 + 1, 2);
+        x = check_malloc(vec->len * sizeof(double));
+        vector_cast(DT_F64, x, vec);
+        fft_real(x, vec->len, res->data);
+        free(x);
+    } else {
+        if ((mat = fft_complex_matrix(env, env->stck, "nfft")) == 0)
+            return;
+        res = native_matrix(env, DT_F64, mat->rows, 2);
+        fft_pairs(mat, res->data);
+        fft_complex(res->data, res->rows, 0);
+    }
+    UNARY(MATRIX_NEWNODE, res);
+}
+
+/**
+Q0  OK  4540  nifft  :  M  ->  M2  |  M N  ->  V
+[NATIVE] M2 is the inverse discrete Fourier transform of native matrix M of
+two columns of complex numbers. With N, V is the vector of N float64 values
+whose transform, as given by nfft, is M of N / 2 + 1 rows.
+*/
+void nifft_(pEnv env)
+{
+    int64_t n;
+    VectorData* vec;
+    MatrixData *mat, *res;
+
+    ONEPARAM("nifft");
+    if (nodetype(env->stck) == INTEGER_) {
+        TWOPARAMS("nifft");
+        if ((mat = fft_complex_matrix(env, nextnode1(env->stck), "nifft")) == 0)
+            return;
+        if ((n = nodevalue(env->stck).num) < 1 || n / 2 + 1 != mat->rows) {
+            execerror(env, "length with N / 2 + 1 rows", "nifft");
+            return;
+        }
+        res = native_matrix(env, DT_F64, mat->rows, 2);
+        fft_pairs(mat, res->data);
+        vec = native_vector(env, DT_F64, n);
+        fft_ireal(res->data, n, vec->data);
+        native_store(res); /* no longer needed */
+        BINARY(VECTOR_NEWNODE, vec);
+        return;
+    }
+    if ((mat = fft_complex_matrix(env, env->stck, "nifft")) == 0)
+        return;
+    res = native_matrix(env, DT_F64, mat->rows, 2);
+    fft_pairs(mat, res->data);
+    fft_complex(res->data, res->rows, 1);
+    UNARY(MATRIX_NEWNODE, res);
+}
+
+/**
+Q0  OK  4550  nconv  :  V1 V2  ->  V3
+[NATIVE] V3 is the convolution of native vectors V1 and V2, as float64: its
+element K is the sum of the products of elements I of V1 and J of V2 with I
++ J = K. A short V1 or V2 is applied directly, and long ones by their
+Fourier transforms.
+*/
+void nconv_(pEnv env)
+{
+    double *a, *b;
+    VectorData *va, *vb, *res;
+
+    TWOPARAMS("nconv");
+    if (nodetype(env->stck) != VECTOR_
+        || nodetype(nextnode1(env->stck)) != VECTOR_) {
+        execerror(env, "two native vectors", "nconv");
+        return;
+    }
+    va = nodevalue(nextnode1(env->stck)).vec;
+    vb = nodevalue(env->stck).vec;
+    if (!va || !vb || !va->len || !vb->len) {
+        execerror(env, "non-empty native vectors", "nconv");
+        return;
+    }
+    res = native_vector(env, DT_F64, va->len + vb->len - 1);
+    a = check_malloc(va->len * sizeof(double));
+    b = check_malloc(vb->len * sizeof(double));
+    vector_cast(DT_F64, a, va);
+    vector_cast(DT_F64, b, vb);
+    fft_convolve(a, va->len, b, vb->len, res->data);
+    free(a);
+    free(b);
+    BINARY(VECTOR_NEWNODE, res);
+}
+#endif /* JOY_NATIVE_TYPES */
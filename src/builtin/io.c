@@ -1,12 +1,12 @@
 /*
  *  module  : io.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.4
+ *  date    : 10/18/26
  *
  *  Grouped I/O builtins: fclose, feof, ferror, fflush, fgetch, fgets,
- *  finclude, fopen, format, formatf, fput, fputch, fputchars, fputstring,
- *  fread, fremove, frename, fseek, ftell, fwrite, get, put, putch, putchars,
- *  stderr, stdin, stdout
+ *  flines, finclude, fopen, format, formatf, fput, fputch, fputchars,
+ *  fputstring, fread, freadstr, fremove, frename, fseek, ftell, fwrite, get,
+ *  put, putch, putchars, stderr, stdin, stdout
  */
 #include "globals.h"
 
@@ -45,7 +45,10 @@ void fflush_(pEnv env)
 {
     ONEPARAM("fflush");
     ISFILE("fflush");
-    fflush(nodevalue(env->stck).fil);
+    if (nodevalue(env->stck).fil == stdout)
+        joy_flush(env);
+    else
+        fflush(nodevalue(env->stck).fil);
 }
 
 /**
@@ -75,7 +78,14 @@ void fgets_(pEnv env)
 #endif
     buf[leng = 0] = 0;
     while (fgets(buf + leng, size - leng, nodevalue(env->stck).fil)) {
-        if ((leng = strlen(buf)) > 0 && buf[leng - 1] == '\n')
+        if ((leng = strlen(buf)) > MAX_STRING_LEN) {
+#ifdef NOBDW
+            free(buf);
+#endif
+            execerror(env, "smaller size", "fgets");
+            return;
+        }
+        if (leng > 0 && buf[leng - 1] == '\n')
             break;
 #ifdef NOBDW
         if ((tmp = realloc(buf, size <<= 1)) == 0)
@@ -91,6 +101,120 @@ void fgets_(pEnv env)
 #endif
 }
 
+/*
+ * Size of the blocks that flines and freadstr read at once.
+ */
+#define LINESMAX 65536
+
+/*
+ * lines_grow - room for size characters and a terminator in buf, that has
+ *		leng characters and room for *room.
+ */
+static char* lines_grow(char* buf, size_t leng, size_t* room, size_t size)
+{
+    char* tmp;
+
+    if (size < *room)
+        return buf;
+    *room = size * 2 + INPLINEMAX;
+    tmp = check_malloc(*room);
+    if (leng)
+        memcpy(tmp, buf, leng);
+    free(buf);
+    return tmp;
+}
+
+/*
+ * The block and the line of flines, released when execution is aborted.
+ */
+typedef struct Lines {
+    char *buf, *line;
+} Lines;
+
+/*
+ * lines_free - release the block and the line.
+ */
+static void lines_free(void* data)
+{
+    Lines* lines = data;
+
+    free(lines->line);
+    free(lines->buf);
+    free(lines);
+}
+
+/*
+ * lines_push - push line with leng characters, terminated, and execute the
+ *		quotation that was saved.
+ */
+static void lines_push(pEnv env, char* line, size_t leng)
+{
+    if (leng && line[leng - 1] == '\r') /* also CR LF */
+        line[leng - 1] = 0;
+#ifdef NOBDW
+    NULLARY(STRING_NEWNODE, line);
+#else
+    NULLARY(STRING_NEWNODE, GC_strdup(line));
+#endif
+    exec_term(env, nodevalue(SAVED1).lis);
+}
+
+/**
+Q1  OK  1885  flines  :  S [P]  ->  ... S
+[FOREIGN] Executes P for each line of stream S, from the current position to
+the end, with the line as a string on top of the stack, without its newline.
+S is not on the stack while P is executed.
+*/
+void flines_(pEnv env)
+{
+    FILE* fp;
+    Lines* lines;
+    char *ptr, *end, *nl;
+    size_t n, k, leng = 0, room = 0;
+
+    TWOPARAMS("flines");
+    ONEQUOTE("flines");
+    if (nodetype(nextnode1(env->stck)) != FILE_
+        || !nodevalue(nextnode1(env->stck)).fil) {
+        execerror(env, "file", "flines");
+        return;
+    }
+    SAVESTACK;
+    fp = nodevalue(SAVED2).fil;
+    env->stck = nextnode2(env->stck);
+    lines = check_malloc(sizeof(Lines));
+    lines->buf = check_malloc(LINESMAX + 1);
+    lines->line = 0;
+    cleanup_push(env, lines_free, lines);
+    while ((n = fread(lines->buf, 1, LINESMAX, fp)) > 0)
+        for (ptr = lines->buf, end = ptr + n; ptr < end; ptr = nl + 1) {
+            nl = memchr(ptr, '\n', end - ptr);
+            k = nl ? (size_t)(nl - ptr) : (size_t)(end - ptr);
+            if (nl && !leng) { /* the whole line is in buf */
+                *nl = 0;
+                lines_push(env, ptr, k);
+                continue;
+            }
+            if (leng + k > MAX_STRING_LEN) /* lines in buf are shorter */
+                execerror(env, "smaller size", "flines");
+            lines->line = lines_grow(lines->line, leng, &room, leng + k);
+            memcpy(lines->line + leng, ptr, k);
+            leng += k;
+            if (!nl) /* continued in the next block */
+                break;
+            lines->line[leng] = 0;
+            lines_push(env, lines->line, leng);
+            leng = 0;
+        }
+    if (leng) { /* without newline at the end */
+        lines->line[leng] = 0;
+        lines_push(env, lines->line, leng);
+    }
+    cleanup_pop(env);
+    GNULLARY(SAVED2);
+    POP(env->dump);
+}
+
 /**
 Q0  OK  3170  finclude  :  S  ->  F ...
 [FOREIGN] Reads Joy source code from stream S and pushes it onto stack.
@@ -239,7 +363,7 @@ void fputch_(pEnv env)
     ch = nodevalue(env->stck).num;
     POP(env->stck);
     ISFILE("fputch");
-    putc(ch, nodevalue(env->stck).fil);
+    joy_putc(env, ch, nodevalue(env->stck).fil);
 }
 
 /**
@@ -258,7 +382,7 @@ void fputchars_(pEnv env) /* suggested by Heiko Kuhrt, as "fputstring_" */
     POP(env->stck);
     ISFILE("fputchars");
     fp = nodevalue(env->stck).fil;
-    fputs(str, fp);
+    joy_fputs(env, str, fp);
 }
 
 /**
@@ -292,6 +416,53 @@ void fread_(pEnv env)
     free(buf);
 }
 
+/**
+Q0  OK  1905  freadstr  :  S I  ->  S L
+[FOREIGN] L is a string of the next I bytes from stream S, or less at the end
+of S; a negative I reads all bytes to the end. A zero byte ends L.
+*/
+void freadstr_(pEnv env)
+{
+    FILE* fp;
+    char* buf;
+    int64_t count;
+    size_t n, want, leng = 0, room = 0;
+
+    TWOPARAMS("freadstr");
+    INTEGER("freadstr");
+    count = nodevalue(env->stck).num;
+    POP(env->stck);
+    ISFILE("freadstr");
+    fp = nodevalue(env->stck).fil;
+    if (count > (int64_t)MAX_STRING_LEN) {
+        execerror(env, "smaller size", "freadstr");
+        return;
+    }
+    want = count < 0 ? MAX_STRING_LEN + 1 : (size_t)count;
+    buf = lines_grow(0, 0, &room, want < LINESMAX ? want : LINESMAX);
+    while (leng < want) {
+        if (leng == room - 1) /* full, except the terminator */
+            buf = lines_grow(buf, leng, &room, leng + 1);
+        n = room - 1 - leng;
+        if ((n = fread(buf + leng, 1, n < want - leng ? n : want - leng, fp))
+            == 0)
+            break;
+        leng += n;
+    }
+    if (leng > MAX_STRING_LEN) { /* not all bytes to the end */
+        free(buf);
+        execerror(env, "smaller size", "freadstr");
+        return;
+    }
+    buf[leng] = 0;
+#ifdef NOBDW
+    NULLARY(STRING_NEWNODE, buf);
+#else
+    NULLARY(STRING_NEWNODE, GC_strdup(buf));
+#endif
+    free(buf);
+}
+
 /**
 Q0  OK  1920  fremove  :  P  ->  B
 [FOREIGN] The file system object with pathname P is removed from the file
@@ -407,14 +578,14 @@ Q0  IGNORE_POP  3090  putch  :  N  ->
 [IMPURE] N : numeric, writes character whose ASCII is N.
 */
 USETOP(putch_, "putch", NUMERICTYPE,
-       printf("%c", (int)nodevalue(env->stck).num))
+       joy_putchar(env, (int)nodevalue(env->stck).num))
 
 /**
 Q0  IGNORE_POP  3100  putchars  :  "abc.."  ->
 [IMPURE] Writes abc.. (without quotes)
 */
 USETOP(putchars_, "putchars", STRING,
-       printf("%s", (char*)&nodevalue(env->stck)))
+       joy_puts(env, (char*)&nodevalue(env->stck)))
 
 /**
 Q0  IMMEDIATE  1190  stderr  :  ->  S
@@ -1,298 +1,16 @@
 /*
  *  module  : json.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.3
+ *  date    : 10/18/26
  *
  *  JSON parsing and emitting for Joy.
  *  Converts between JSON strings and Joy values (dict, list, etc.)
+ *  JSON is read by src/json.c, from strings and from streams.
  */
 #include "globals.h"
 #include "runtime.h"
 #include "builtin_macros.h"
 
-/* Forward declarations for recursive parser */
-static Index parse_value(pEnv env, const char **p);
-static Index parse_object(pEnv env, const char **p);
-static Index parse_array(pEnv env, const char **p);
-static Index parse_string(pEnv env, const char **p);
-static Index parse_number(pEnv env, const char **p);
-
-/* Helper: skip whitespace */
-static void skip_ws(const char **p)
-{
-    while (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r')
-        (*p)++;
-}
-
-/* Helper: parse a JSON string (assumes we're at the opening quote) */
-static char* parse_string_value(pEnv env, const char **p)
-{
-    const char *start;
-    char *result, *dst;
-    size_t len;
-
-    (void)env;
-    if (**p != '"')
-        return NULL;
-    (*p)++;  /* skip opening quote */
-    start = *p;
-
-    /* First pass: count length (accounting for escapes) */
-    len = 0;
-    while (**p && **p != '"') {
-        if (**p == '\\') {
-            (*p)++;
-            if (**p == 'u') {
-                (*p) += 4;  /* \uXXXX */
-                len++;  /* simplified: just count as 1 char */
-            } else {
-                (*p)++;
-                len++;
-            }
-        } else {
-            (*p)++;
-            len++;
-        }
-    }
-
-    /* Allocate and copy */
-    result = GC_malloc_atomic(len + 1);
-    *p = start;
-    dst = result;
-
-    while (**p && **p != '"') {
-        if (**p == '\\') {
-            (*p)++;
-            switch (**p) {
-            case '"':  *dst++ = '"';  break;
-            case '\\': *dst++ = '\\'; break;
-            case '/':  *dst++ = '/';  break;
-            case 'b':  *dst++ = '\b'; break;
-            case 'f':  *dst++ = '\f'; break;
-            case 'n':  *dst++ = '\n'; break;
-            case 'r':  *dst++ = '\r'; break;
-            case 't':  *dst++ = '\t'; break;
-            case 'u':
-                /* Simplified: just skip \uXXXX and insert '?' */
-                (*p) += 4;
-                *dst++ = '?';
-                break;
-            default:
-                *dst++ = **p;
-            }
-            (*p)++;
-        } else {
-            *dst++ = **p;
-            (*p)++;
-        }
-    }
-    *dst = '\0';
-
-    if (**p == '"')
-        (*p)++;  /* skip closing quote */
-
-    return result;
-}
-
-/* Parse a JSON number */
-static Index parse_number(pEnv env, const char **p)
-{
-    const char *start = *p;
-    int is_float = 0;
-    int64_t int_val;
-    double float_val;
-    char *end;
-
-    /* Skip leading minus */
-    if (**p == '-')
-        (*p)++;
-
-    /* Skip digits */
-    while (**p >= '0' && **p <= '9')
-        (*p)++;
-
-    /* Check for decimal point */
-    if (**p == '.') {
-        is_float = 1;
-        (*p)++;
-        while (**p >= '0' && **p <= '9')
-            (*p)++;
-    }
-
-    /* Check for exponent */
-    if (**p == 'e' || **p == 'E') {
-        is_float = 1;
-        (*p)++;
-        if (**p == '+' || **p == '-')
-            (*p)++;
-        while (**p >= '0' && **p <= '9')
-            (*p)++;
-    }
-
-    if (is_float) {
-        float_val = strtod(start, &end);
-        return FLOAT_NEWNODE(float_val, 0);
-    } else {
-        int_val = strtoll(start, &end, 10);
-        return INTEGER_NEWNODE(int_val, 0);
-    }
-}
-
-/* Parse a JSON string into a STRING_ node */
-static Index parse_string(pEnv env, const char **p)
-{
-    char *str = parse_string_value(env, p);
-    if (!str)
-        return 0;
-    return STRING_NEWNODE(str, 0);
-}
-
-/* Parse a JSON array into a LIST_ node */
-static Index parse_array(pEnv env, const char **p)
-{
-    Index head = 0, tail = 0, elem;
-
-    if (**p != '[')
-        return 0;
-    (*p)++;  /* skip '[' */
-
-    skip_ws(p);
-    if (**p == ']') {
-        (*p)++;
-        return LIST_NEWNODE(0, 0);  /* empty list */
-    }
-
-    while (1) {
-        skip_ws(p);
-        elem = parse_value(env, p);
-        if (!elem)
-            return 0;
-
-        if (!head) {
-            head = elem;
-            tail = elem;
-        } else {
-            nextnode1(tail) = elem;
-            tail = elem;
-        }
-
-        skip_ws(p);
-        if (**p == ']') {
-            (*p)++;
-            break;
-        }
-        if (**p == ',') {
-            (*p)++;
-        } else {
-            return 0;  /* parse error */
-        }
-    }
-
-    return LIST_NEWNODE(head, 0);
-}
-
-/* Parse a JSON object into a DICT_ node */
-static Index parse_object(pEnv env, const char **p)
-{
-    khash_t(Dict)* d;
-    char* key;
-    Index value;
-    khint_t k;
-    int ret;
-
-    if (**p != '{')
-        return 0;
-    (*p)++;  /* skip '{' */
-
-    d = kh_init(Dict);
-
-    skip_ws(p);
-    if (**p == '}') {
-        (*p)++;
-        return DICT_NEWNODE(d, 0);  /* empty dict */
-    }
-
-    while (1) {
-        skip_ws(p);
-        if (**p != '"') {
-            return 0;  /* keys must be strings */
-        }
-
-        key = parse_string_value(env, p);
-        if (!key)
-            return 0;
-
-        skip_ws(p);
-        if (**p != ':')
-            return 0;
-        (*p)++;  /* skip ':' */
-
-        skip_ws(p);
-        value = parse_value(env, p);
-        if (!value)
-            return 0;
-
-        k = kh_put(Dict, d, key, &ret);
-        kh_value(d, k) = value;
-
-        skip_ws(p);
-        if (**p == '}') {
-            (*p)++;
-            break;
-        }
-        if (**p == ',') {
-            (*p)++;
-        } else {
-            return 0;  /* parse error */
-        }
-    }
-
-    return DICT_NEWNODE(d, 0);
-}
-
-/* Parse any JSON value */
-static Index parse_value(pEnv env, const char **p)
-{
-    int index;
-
-    skip_ws(p);
-
-    switch (**p) {
-    case '{':
-        return parse_object(env, p);
-    case '[':
-        return parse_array(env, p);
-    case '"':
-        return parse_string(env, p);
-    case 't':  /* true */
-        if (strncmp(*p, "true", 4) == 0) {
-            *p += 4;
-            return BOOLEAN_NEWNODE(1, 0);
-        }
-        return 0;
-    case 'f':  /* false */
-        if (strncmp(*p, "false", 5) == 0) {
-            *p += 5;
-            return BOOLEAN_NEWNODE(0, 0);
-        }
-        return 0;
-    case 'n':  /* null */
-        if (strncmp(*p, "null", 4) == 0) {
-            *p += 4;
-            /* Return a USR_ node for "null" symbol */
-            index = enteratom(env, "null");
-            return USR_NEWNODE(index, 0);
-        }
-        return 0;
-    case '-':
-    case '0': case '1': case '2': case '3': case '4':
-    case '5': case '6': case '7': case '8': case '9':
-        return parse_number(env, p);
-    default:
-        return 0;  /* parse error */
-    }
-}
-
 /**
 Q0  OK  3820  json>\0fromjson  :  S  ->  V
 V is a Joy value parsed from JSON string S.
@@ -300,52 +18,80 @@ JSON objects become dictionaries, arrays become lists.
 */
 void fromjson_(pEnv env)
 {
+    int rv;
     char* str;
-    const char* p;
-    Index result;
+    JsonReader js;
 
     ONEPARAM("json>");
     STRING("json>");
 
-    str = GETSTRING(env->stck);
-    p = str;
-
-    result = parse_value(env, &p);
-    if (!result) {
+    str = check_strdup(GETSTRING(env->stck)); /* nodes move while reading */
+    json_open(&js, 0, str, strlen(str));
+    rv = json_read(env, &js);
+    json_close(&js);
+    free(str);
+    if (rv != 1) {
         execerror(env, "valid JSON", "json>");
         return;
     }
 
-    GUNARY(result);
+    /* unlink S from below V */
+    nextnode1(env->stck) = nextnode2(env->stck);
 }
 
-/* Simple dynamic string buffer for JSON emission */
+/*
+ * Buffer for JSON emission: it grows for a string, and for a stream it has a
+ * fixed size and is written out with joy_fwrite when it is full.
+ */
 typedef struct {
+    pEnv env;
+    FILE* fp;
     char* data;
     size_t len;
     size_t cap;
 } JsonBuf;
 
-static void jbuf_init(JsonBuf* b)
+static void jbuf_init(JsonBuf* b, pEnv env, FILE* fp)
 {
-    b->cap = 256;
+    b->env = env;
+    b->fp = fp;
+    b->cap = fp ? OUTPUTMAX : 256;
     b->len = 0;
-    b->data = malloc(b->cap);
+    b->data = check_malloc(b->cap);
 }
 
-static void jbuf_push(JsonBuf* b, char c)
+static void jbuf_write(JsonBuf* b, const char* s, size_t n)
 {
-    if (b->len >= b->cap - 1) {
-        b->cap *= 2;
-        b->data = realloc(b->data, b->cap);
+    size_t k;
+
+    for (; n; s += k, n -= k) {
+        if (b->len == b->cap - 1) {
+            if (b->fp) {
+                joy_fwrite(b->env, b->data, b->len, b->fp);
+                b->len = 0;
+            } else {
+                b->cap *= 2;
+                b->data = realloc(b->data, b->cap);
+            }
+        }
+        if ((k = b->cap - 1 - b->len) > n)
+            k = n;
+        memcpy(b->data + b->len, s, k);
+        b->len += k;
     }
-    b->data[b->len++] = c;
+}
+
+static void jbuf_push(JsonBuf* b, char c)
+{
+    if (b->len < b->cap - 1)
+        b->data[b->len++] = c;
+    else
+        jbuf_write(b, &c, 1);
 }
 
 static void jbuf_str(JsonBuf* b, const char* s)
 {
-    while (*s)
-        jbuf_push(b, *s++);
+    jbuf_write(b, s, strlen(s));
 }
 
 static char* jbuf_finish(JsonBuf* b)
@@ -357,15 +103,30 @@ static char* jbuf_finish(JsonBuf* b)
     return result;
 }
 
+/* Write what is left in the buffer of a stream */
+static void jbuf_close(JsonBuf* b)
+{
+    joy_fwrite(b->env, b->data, b->len, b->fp);
+    free(b->data);
+}
+
 /* Forward declaration for recursive emit */
 static void emit_value(pEnv env, Index node, JsonBuf* out);
 
-/* Helper: append an escaped JSON string */
+/* Helper: append an escaped JSON string, with runs copied at once */
 static void emit_json_string(pEnv env, const char* s, JsonBuf* out)
 {
+    const char* q;
+    char buf[8];
+
     (void)env;
     jbuf_push(out, '"');
-    while (*s) {
+    for (;;) {
+        for (q = s; (unsigned char)*q >= 32 && *q != '"' && *q != '\\'; q++)
+            ;
+        jbuf_write(out, s, q - s);
+        if (!*(s = q))
+            break;
         switch (*s) {
         case '"':  jbuf_str(out, "\\\""); break;
         case '\\': jbuf_str(out, "\\\\"); break;
@@ -375,13 +136,8 @@ static void emit_json_string(pEnv env, const char* s, JsonBuf* out)
         case '\r': jbuf_str(out, "\\r");  break;
         case '\t': jbuf_str(out, "\\t");  break;
         default:
-            if ((unsigned char)*s < 32) {
-                char buf[8];
-                snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)*s);
-                jbuf_str(out, buf);
-            } else {
-                jbuf_push(out, *s);
-            }
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)*s);
+            jbuf_str(out, buf);
         }
         s++;
     }
@@ -403,13 +159,11 @@ static void emit_value(pEnv env, Index node, JsonBuf* out)
         break;
 
     case INTEGER_:
-        snprintf(buf, sizeof(buf), "%" PRId64, nodevalue(node).num);
-        jbuf_str(out, buf);
+        jbuf_write(out, buf, writeinteger(buf, nodevalue(node).num));
         break;
 
     case FLOAT_:
-        snprintf(buf, sizeof(buf), "%g", nodevalue(node).dbl);
-        jbuf_str(out, buf);
+        jbuf_write(out, buf, writedouble(buf, nodevalue(node).dbl));
         break;
 
     case STRING_:
@@ -478,8 +232,7 @@ static void emit_value(pEnv env, Index node, JsonBuf* out)
                     if (!first)
                         jbuf_push(out, ',');
                     first = 0;
-                    snprintf(buf, sizeof(buf), "%d", i);
-                    jbuf_str(out, buf);
+                    jbuf_write(out, buf, writeinteger(buf, i));
                 }
             }
             jbuf_push(out, ']');
@@ -504,8 +257,135 @@ void tojson_(pEnv env)
 
     ONEPARAM(">json");
 
-    jbuf_init(&out);
+    jbuf_init(&out, env, 0);
     emit_value(env, env->stck, &out);
 
     UNARY(STRING_NEWNODE, jbuf_finish(&out));
 }
+
+/**
+Q0  OK  3822  fjson  :  S  ->  S V
+[FOREIGN] V is the Joy value of the next JSON value read from stream S, as
+json> gives it. A regular file is read in blocks, and left after the value.
+*/
+void fjson_(pEnv env)
+{
+    int rv;
+    JsonReader js;
+
+    ONEPARAM("fjson");
+    ISFILE("fjson");
+    json_open(&js, nodevalue(env->stck).fil, 0, 0);
+    rv = json_read(env, &js);
+    json_close(&js);
+    if (rv != 1)
+        execerror(env, "valid JSON", "fjson");
+}
+
+/*
+ * json_free - release the reader of fjsonl or fjsonevents, also when P
+ *	       raised an error.
+ */
+static void json_free(void* data)
+{
+    json_close(data);
+    free(data);
+}
+
+/**
+Q1  OK  3823  fjsonl  :  S [P]  ->  ... S
+[FOREIGN] Executes P for each JSON value in stream S, from the current
+position to the end, with the Joy value on top of the stack. The values are
+separated by white space, as the lines of NDJSON. S is not on the stack while
+P is executed.
+*/
+void fjsonl_(pEnv env)
+{
+    int rv;
+    JsonReader* js;
+
+    TWOPARAMS("fjsonl");
+    ONEQUOTE("fjsonl");
+    if (nodetype(nextnode1(env->stck)) != FILE_
+        || !nodevalue(nextnode1(env->stck)).fil) {
+        execerror(env, "file", "fjsonl");
+        return;
+    }
+    SAVESTACK;
+    env->stck = nextnode2(env->stck);
+    js = check_malloc(sizeof(JsonReader));
+    json_open(js, nodevalue(SAVED2).fil, 0, INPBLOCKMAX);
+    cleanup_push(env, json_free, js);
+    while ((rv = json_read(env, js)) == 1)
+        exec_term(env, nodevalue(SAVED1).lis);
+    cleanup_pop(env);
+    if (rv) {
+        execerror(env, "valid JSON", "fjsonl");
+        return;
+    }
+    GNULLARY(SAVED2);
+    POP(env->dump);
+}
+
+/**
+Q1  OK  3824  fjsonevents  :  S [P]  ->  ... S
+[FOREIGN] Executes P for each event of the JSON in stream S, without making
+its arrays and objects, with X and C on top of the stack: C is '[ '{ '] or
+'} at the start and the end of an array or object, with X its depth; ': for
+a key, with X the string; and '= for another value, with X the value.
+*/
+void fjsonevents_(pEnv env)
+{
+    Types u;
+    int ev, type;
+    JsonReader* js;
+
+    TWOPARAMS("fjsonevents");
+    ONEQUOTE("fjsonevents");
+    if (nodetype(nextnode1(env->stck)) != FILE_
+        || !nodevalue(nextnode1(env->stck)).fil) {
+        execerror(env, "file", "fjsonevents");
+        return;
+    }
+    SAVESTACK;
+    env->stck = nextnode2(env->stck);
+    js = check_malloc(sizeof(JsonReader));
+    json_open(js, nodevalue(SAVED2).fil, 0, INPBLOCKMAX);
+    cleanup_push(env, json_free, js);
+    while ((ev = json_event(js, &u, &type)) > 0) {
+        if (ev == ':' || ev == '=')
+            json_push(env, &u, type);
+        else /* the depth inside */
+            NULLARY(INTEGER_NEWNODE, js->depth + (ev == ']' || ev == '}'));
+        NULLARY(CHAR_NEWNODE, ev);
+        exec_term(env, nodevalue(SAVED1).lis);
+    }
+    cleanup_pop(env);
+    if (ev) {
+        execerror(env, "valid JSON", "fjsonevents");
+        return;
+    }
+    GNULLARY(SAVED2);
+    POP(env->dump);
+}
+
+/**
+Q0  OK  3825  ftojson  :  S V  ->  S
+[FOREIGN] Writes Joy value V as JSON to stream S, as >json gives it, through
+a buffer of fixed size instead of a string.
+*/
+void ftojson_(pEnv env)
+{
+    JsonBuf out;
+
+    TWOPARAMS("ftojson");
+    if (nodetype(nextnode1(env->stck)) != FILE_
+        || !nodevalue(nextnode1(env->stck)).fil) {
+        execerror(env, "file", "ftojson");
+        return;
+    }
+    jbuf_init(&out, env, nodevalue(nextnode1(env->stck)).fil);
+    emit_value(env, env->stck, &out);
+    jbuf_close(&out);
+    POP(env->stck);
+}
@@ -0,0 +1,97 @@
+/*
+ *  module  : memo.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Memoization builtins: memo, memoclear, memolimit, memorec, memosize
+ *
+ *  The cache itself is in src/memo.c. Results are only valid when the
+ *  quotation computes its result from the argument alone.
+ */
+#include "globals.h"
+
+/*
+ * Shared code of memo and memorec. The key is the quotation, the argument
+ * and the kind of combinator; the value is the result of the quotation.
+ */
+static void memo_aux(pEnv env, int rec, char* name)
+{
+    int i;
+    uint64_t hash;
+    Index quote, arg, value;
+
+    TWOPARAMS(name);
+    ONEQUOTE(name);
+    hash = hash_value(env, env->stck) * 31
+           + hash_value(env, nextnode1(env->stck)) + rec;
+    if ((i = memo_lookup(env, hash, env->stck, nextnode1(env->stck), rec))
+        >= 0) {
+        env->stck
+            = newnode2(env, env->memo->entry[i].value, nextnode2(env->stck));
+        return;
+    }
+    SAVESTACK;
+    POP(env->stck);
+    if (rec) { /* push [[P] memorec] */
+        ensure_capacity(env, 3);
+        value = ANON_FUNCT_NEWNODE(memorec_, 0);
+        value = LIST_NEWNODE(nodevalue(SAVED1).lis, value);
+        env->stck = LIST_NEWNODE(value, env->stck);
+    }
+    exec_term(env, nodevalue(SAVED1).lis);
+    CHECKVALUE(name);
+    ensure_capacity(env, nodesize(env, SAVED1) + nodesize(env, SAVED2)
+                             + 2 * nodesize(env, env->stck));
+    quote = newnode2(env, SAVED1, 0);
+    arg = newnode2(env, SAVED2, 0);
+    value = newnode2(env, env->stck, 0);
+    memo_insert(env, hash, quote, arg, value, rec);
+    env->stck = newnode2(env, value, SAVED3);
+    POP(env->dump);
+}
+
+/**
+Q1  OK  2762  memo  :  X [P]  ->  R
+Executes P on X, as unary does, and caches the result R. When memo is
+called again with an equal X and an equal P, R is taken from the cache.
+P must compute R from X alone: the values below X are not part of the key.
+*/
+void memo_(pEnv env) { memo_aux(env, 0, "memo"); }
+
+/**
+Q0  OK  3012  memoclear  :  ->
+Removes all results from the cache of memo and memorec.
+*/
+void memoclear_(pEnv env) { memo_clear(env); }
+
+/**
+Q0  IGNORE_POP  3014  memolimit  :  I  ->
+Sets the maximum number of results in the cache of memo and memorec to I.
+The least recently used results are removed first. 0 disables the cache.
+*/
+void memolimit_(pEnv env)
+{
+    ONEPARAM("memolimit");
+    POSITIVEINDEX(env->stck, "memolimit");
+    memo_setlimit(env, nodevalue(env->stck).num > INT_MAX
+                           ? INT_MAX
+                           : (int)nodevalue(env->stck).num);
+    POP(env->stck);
+}
+
+/**
+Q1  OK  2764  memorec  :  X [P]  ->  R
+Executes P on X [C], and caches the result R. C is [[P] memorec], such that
+X' C i computes the result for X' through the cache as well. As with memo,
+P must compute R from X alone.
+*/
+void memorec_(pEnv env) { memo_aux(env, 1, "memorec"); }
+
+/**
+Q0  IGNORE_PUSH  3016  memosize  :  ->  I
+Pushes the number of results in the cache of memo and memorec.
+*/
+void memosize_(pEnv env)
+{
+    NULLARY(INTEGER_NEWNODE, env->memo ? env->memo->count : 0);
+}
@@ -0,0 +1,1415 @@
+/*
+ *  module  : native.c
+ *  version : 1.2
+ *  date    : 10/18/26
+ *
+ *  Kernels of the native vector and matrix types.
+ *
+ *    Element-wise: nv+ nv- nv* nv/ (vectors), nm+ nm- nm* nm/ (matrices)
+ *    Scalar: nvscale nmscale, and a number as either operand of the above
+ *    Reductions: nsum nprod nmin nmax nmean nnorm, nargmin nargmax, of all
+ *    elements or along an axis of a matrix
+ *    Vectors: nvnormalize nvcross nvrange nvlinspace
+ *    Matrices: ntranspose ntrace
+ *    Maps: nabs nsqrt nexp nlog
+ *    Comparisons: n= n!= n< n<= n> n>=, giving 1 or 0 per element
+ *    Element types: ncast ndtype
+ *    Views: nrow ncol nvslice nmblock, sharing the elements; nshape
+ *
+ *  These are the native counterparts of the list operations of vector.c.
+ *  The kernels are in src/kernel.c. Element-wise operations and maps on
+ *  vectors are deferred, such that a chain of them is evaluated in one pass
+ *  when the result is needed; on matrices they are computed at once. The
+ *  data of the operands is read only. Operands have the same element type;
+ *  a number is converted to it, and integer elements need an integer.
+ *  Matrices of different shapes, and a matrix and a vector, are broadcast as
+ *  in NumPy.
+ */
+#include "globals.h"
+#include <math.h>
+
+#ifdef JOY_NATIVE_TYPES
+
+/*
+ * Elements of the native value in node p, as rows of cols elements that are
+ * ld elements apart. A vector is one row, or a column when its elements are
+ * not adjacent. The elements of a deferred vector are computed.
+ */
+static char* native_rows(pEnv env, Index p, int64_t* rows, int64_t* cols,
+                         int64_t* ld)
+{
+    VectorData* vec;
+    MatrixData* mat;
+
+    if (nodetype(p) == VECTOR_) {
+        if ((vec = nodevalue(p).vec) == 0) {
+            *rows = *cols = *ld = 0;
+            return 0;
+        }
+        vector_force(vec);
+        if (vec->inc == 1) {
+            *rows = 1;
+            *cols = *ld = vec->len;
+        } else {
+            *rows = vec->len;
+            *cols = 1;
+            *ld = vec->inc;
+        }
+        return vec->data;
+    }
+    if ((mat = nodevalue(p).mat) == 0) {
+        *rows = *cols = *ld = 0;
+        return 0;
+    }
+    *rows = mat->rows;
+    *cols = mat->cols;
+    *ld = mat->ld;
+    return mat->data;
+}
+
+/*
+ * Element type of the native value in node p.
+ */
+static int native_dtype(pEnv env, Index p)
+{
+    if (nodetype(p) == VECTOR_)
+        return nodevalue(p).vec ? nodevalue(p).vec->dtype : DT_F64;
+    return nodevalue(p).mat ? nodevalue(p).mat->dtype : DT_F64;
+}
+
+/*
+ * Whether the elements of the native value in node p are floats.
+ */
+static int native_float(pEnv env, Index p)
+{
+    return native_dtype(env, p) == DT_F64 || native_dtype(env, p) == DT_F32;
+}
+
+/*
+ * Number of elements of the native value in node p, that is not computed.
+ */
+static size_t native_count(pEnv env, Index p)
+{
+    if (nodetype(p) == VECTOR_)
+        return nodevalue(p).vec ? nodevalue(p).vec->len : 0;
+    if (!nodevalue(p).mat)
+        return 0;
+    return nodevalue(p).mat->rows * nodevalue(p).mat->cols;
+}
+
+/*
+ * Native values in nodes p and q have the same shape.
+ */
+static int native_same(pEnv env, Index p, Index q)
+{
+    MatrixData *a, *b;
+
+    if (nodetype(p) == VECTOR_)
+        return native_count(env, p) == native_count(env, q);
+    a = nodevalue(p).mat;
+    b = nodevalue(q).mat;
+    return (a ? a->rows : 0) == (b ? b->rows : 0)
+           && (a ? a->cols : 0) == (b ? b->cols : 0);
+}
+
+/*
+ * Allocate a native value of the type, element type and shape of node p.
+ * The value is stored in u and its elements are returned.
+ */
+static void* native_like(pEnv env, Index p, Types* u)
+{
+    MatrixData* mat;
+
+    if (nodetype(p) == VECTOR_) {
+        u->vec = native_vector(env, native_dtype(env, p), native_count(env, p));
+        return u->vec->data;
+    }
+    mat = nodevalue(p).mat;
+    u->mat = native_matrix(env, native_dtype(env, p), mat ? mat->rows : 0,
+                           mat ? mat->cols : 0);
+    return u->mat->data;
+}
+
+/*
+ * The type of the native operands of a comparison, or 0. That is a matrix
+ * when either of them is one, such that a vector is broadcast.
+ */
+static Operator native_type(pEnv env)
+{
+    int i;
+    Index p;
+    Operator op, type = 0;
+
+    for (i = 0, p = env->stck; i < 2 && p; i++, p = nextnode1(p))
+        if ((op = nodetype(p)) == MATRIX_)
+            return op;
+        else if (op == VECTOR_)
+            type = op;
+    return type;
+}
+
+/*
+ * Whether the result of an operation on node p can be deferred.
+ */
+static int native_lazy(pEnv env, Index p)
+{
+    return nodetype(p) == VECTOR_ && nodevalue(p).vec;
+}
+
+/*
+ * Whether the top num members of the stack are integers.
+ */
+static int native_integers(pEnv env, int num, char* name)
+{
+    Index p;
+
+    for (p = env->stck; num > 0; num--, p = nextnode1(p))
+        if (nodetype(p) != INTEGER_) {
+            execerror(env, "integers", name);
+            return 0;
+        }
+    return 1;
+}
+
+/*
+ * Convert the number in node p to element type dtype, in s. Integer
+ * elements require an integer, that wraps around as the elements do.
+ */
+static int native_scalar(pEnv env, Index p, int dtype, NativeScalar* s,
+                         char* name)
+{
+    switch (dtype) {
+    case DT_F64:
+        s->f64 = nodetype(p) == FLOAT_ ? nodevalue(p).dbl : nodevalue(p).num;
+        return 1;
+    case DT_F32:
+        s->f32 = nodetype(p) == FLOAT_ ? nodevalue(p).dbl : nodevalue(p).num;
+        return 1;
+    }
+    if (nodetype(p) != INTEGER_) {
+        execerror(env, "integer for integer elements", name);
+        return 0;
+    }
+    switch (dtype) {
+    case DT_I32:
+        s->i32 = (int32_t)(uint32_t)nodevalue(p).num;
+        break;
+    case DT_U8:
+        s->u8 = (uint8_t)nodevalue(p).num;
+        break;
+    default:
+        s->i64 = nodevalue(p).num;
+        break;
+    }
+    return 1;
+}
+
+/*
+ * Compute c = a op b, c = a op s or c = f(a), per kind, at once and row by
+ * row, for native values x and y that are not deferred. The result, of the
+ * shape of x, is stored in u.
+ */
+static void native_compute(pEnv env, Index x, Index y, int kind, int op,
+                           const NativeScalar* s, Types* u)
+{
+    size_t w;
+    int dtype;
+    char *a, *b = 0, *c;
+    int64_t rows, cols, lda, ldb, r;
+
+    dtype = native_dtype(env, x);
+    w = kernel_width(dtype);
+    a = native_rows(env, x, &rows, &cols, &lda);
+    if (kind == VX_BINARY)
+        b = native_rows(env, y, &rows, &cols, &ldb);
+    else
+        ldb = cols;
+    c = native_like(env, x, u);
+    if (rows <= 1 || (lda == cols && ldb == cols)) { /* as one row */
+        cols *= rows;
+        rows = 1;
+    }
+    for (r = 0; r < rows; r++)
+        switch (kind) {
+        case VX_BINARY:
+            kernel_binary(dtype, op, c + r * cols * w, a + r * lda * w,
+                          b + r * ldb * w, cols);
+            break;
+        case VX_SCALAR:
+            kernel_scalar(dtype, op, c + r * cols * w, a + r * lda * w, s,
+                          cols);
+            break;
+        default:
+            kernel_map(dtype, op, c + r * cols * w, a + r * lda * w, cols);
+            break;
+        }
+}
+
+/*
+ * The operator such that b op a is a op b.
+ */
+static int native_reverse(int op)
+{
+    switch (op) {
+    case NK_SUB:
+        return NK_RSUB;
+    case NK_DIV:
+        return NK_RDIV;
+    case NK_LT:
+        return NK_GT;
+    case NK_LE:
+        return NK_GE;
+    case NK_GT:
+        return NK_LT;
+    case NK_GE:
+        return NK_LE;
+    }
+    return op;
+}
+
+/*
+ * Rows and columns of the native value in node p when broadcast: a vector is
+ * one row.
+ */
+static void native_shape(pEnv env, Index p, int64_t* rows, int64_t* cols)
+{
+    if (nodetype(p) == VECTOR_) {
+        *rows = 1;
+        *cols = native_count(env, p);
+    } else {
+        *rows = nodevalue(p).mat ? nodevalue(p).mat->rows : 0;
+        *cols = nodevalue(p).mat ? nodevalue(p).mat->cols : 0;
+    }
+}
+
+/*
+ * Elements of the native value in node p as in native_rows, except that a
+ * vector is one row. When its elements are not adjacent, they are gathered
+ * in *copy, that the caller frees.
+ */
+static char* native_operand(pEnv env, Index p, int64_t* ld, void** copy)
+{
+    int64_t rows, cols;
+    VectorData* vec;
+
+    *copy = 0;
+    if (nodetype(p) == MATRIX_)
+        return native_rows(env, p, &rows, &cols, ld);
+    if ((vec = nodevalue(p).vec) == 0) {
+        *ld = 0;
+        return 0;
+    }
+    *ld = vec->len;
+    if (vec->inc == 1)
+        return vector_force(vec);
+    *copy = check_malloc((vec->len ? vec->len : 1) * kernel_width(vec->dtype));
+    vector_cast(vec->dtype, *copy, vec);
+    return *copy;
+}
+
+/*
+ * The size of a dimension of m and n elements after broadcasting, in d: a
+ * dimension of one element is repeated to the other size.
+ */
+static int native_dim(int64_t m, int64_t n, int64_t* d)
+{
+    if (m == n || n == 1)
+        *d = m;
+    else if (m == 1)
+        *d = n;
+    else
+        return 0;
+    return 1;
+}
+
+/*
+ * x op y, element by element, for native values of different shapes, as in
+ * NumPy: a vector is a row, and a row or column of one element is repeated
+ * to the size of the other operand. Each row of the result is one pass of
+ * kernel_binary, or of kernel_scalar when a column is repeated. The result,
+ * a matrix, is stored in u.
+ */
+static void native_broadcast(pEnv env, Index x, Index y, int op, char* name,
+                             Types* u)
+{
+    size_t w;
+    int dtype;
+    NativeScalar s;
+    MatrixData* res;
+    void *copyx, *copyy;
+    char *a, *b, *c, *pa, *pb;
+    int64_t xr, xc, yr, yc, lda, ldb, rows, cols, r;
+
+    native_shape(env, x, &xr, &xc);
+    native_shape(env, y, &yr, &yc);
+    if (!native_dim(xr, yr, &rows) || !native_dim(xc, yc, &cols)) {
+        execerror(env, "broadcastable shapes", name);
+        return;
+    }
+    if ((dtype = native_dtype(env, x)) != native_dtype(env, y)) {
+        execerror(env, "equal element types", name);
+        return;
+    }
+    w = kernel_width(dtype);
+    u->mat = res = native_matrix(env, dtype, rows, cols); /* before copies */
+    a = native_operand(env, x, &lda, &copyx);
+    b = native_operand(env, y, &ldb, &copyy);
+    for (c = res->data, r = 0; r < rows; r++, c += cols * w) {
+        pa = a + (xr == 1 ? 0 : r) * lda * w;
+        pb = b + (yr == 1 ? 0 : r) * ldb * w;
+        if (xc == yc)
+            kernel_binary(dtype, op, c, pa, pb, cols);
+        else if (yc == 1) {
+            memcpy(&s, pb, w);
+            kernel_scalar(dtype, op, c, pa, &s, cols);
+        } else {
+            memcpy(&s, pa, w);
+            kernel_scalar(dtype, native_reverse(op), c, pb, &s, cols);
+        }
+    }
+    free(copyx);
+    free(copyy);
+}
+
+/*
+ * Shared code of the element-wise operators: two native values of the given
+ * type, shape and element type, or one of them and a number. Matrices of
+ * different shapes, and a matrix and a vector, are broadcast.
+ */
+static void native_binary(pEnv env, Operator type, int op, char* name)
+{
+    Types u;
+    Index x, y;
+    NativeScalar s;
+
+    TWOPARAMS(name);
+    y = env->stck;
+    x = nextnode1(env->stck);
+    if (nodetype(x) == type && nodetype(y) == type
+        && (type == VECTOR_ || native_same(env, x, y))) {
+        if (!native_same(env, x, y)) {
+            execerror(env, "vectors of equal length", name);
+            return;
+        }
+        if (native_dtype(env, x) != native_dtype(env, y)) {
+            execerror(env, "equal element types", name);
+            return;
+        }
+        if (native_lazy(env, x) && native_lazy(env, y))
+            u.vec = vector_defer(env, VX_BINARY, op, nodevalue(x).vec,
+                                 nodevalue(y).vec, 0);
+        else
+            native_compute(env, x, y, VX_BINARY, op, 0, &u);
+    } else if (type == MATRIX_
+               && (nodetype(x) == MATRIX_ || nodetype(y) == MATRIX_)
+               && (nodetype(x) == MATRIX_ || nodetype(x) == VECTOR_)
+               && (nodetype(y) == MATRIX_ || nodetype(y) == VECTOR_)) {
+        native_broadcast(env, x, y, op, name, &u);
+    } else if (nodetype(x) == type
+               && (nodetype(y) == FLOAT_ || nodetype(y) == INTEGER_)) {
+        if (!native_scalar(env, y, native_dtype(env, x), &s, name))
+            return;
+        if (native_lazy(env, x))
+            u.vec = vector_defer(env, VX_SCALAR, op, nodevalue(x).vec, 0, &s);
+        else
+            native_compute(env, x, 0, VX_SCALAR, op, &s, &u);
+    } else if (nodetype(y) == type
+               && (nodetype(x) == FLOAT_ || nodetype(x) == INTEGER_)) {
+        op = native_reverse(op); /* the scalar is the left operand */
+        if (!native_scalar(env, x, native_dtype(env, y), &s, name))
+            return;
+        if (native_lazy(env, y))
+            u.vec = vector_defer(env, VX_SCALAR, op, nodevalue(y).vec, 0, &s);
+        else
+            native_compute(env, y, 0, VX_SCALAR, op, &s, &u);
+    } else {
+        execerror(env,
+                  type == VECTOR_   ? "native vector and vector or number"
+                  : type == MATRIX_ ? "native matrix and matrix, vector or number"
+                                    : "native vector or matrix",
+                  name);
+        return;
+    }
+    env->stck = newnode(env, type, u, nextnode2(env->stck));
+}
+
+/*
+ * The reduction of the elements of the native value in node p, as a double.
+ */
+static double native_reduction(pEnv env, Index p, int op)
+{
+    size_t w;
+    char* a;
+    double x, result = 0.0;
+    int64_t rows, cols, ld, r;
+
+    if (native_lazy(env, p))
+        return vector_reduce(op, nodevalue(p).vec);
+    w = kernel_width(native_dtype(env, p));
+    a = native_rows(env, p, &rows, &cols, &ld);
+    if (rows <= 1 || ld == cols) { /* as one row */
+        cols *= rows;
+        rows = 1;
+    }
+    for (r = 0; r < rows; r++) {
+        x = kernel_reduce(native_dtype(env, p), op, a + r * ld * w, cols);
+        result = r ? kernel_combine(op, result, x) : x;
+    }
+    return result;
+}
+
+/*
+ * The reduction of the integer elements of the native value in node p.
+ */
+static int64_t native_ireduction(pEnv env, Index p, int op)
+{
+    size_t w;
+    char* a;
+    int64_t rows, cols, ld, r, x, result = 0;
+
+    if (native_lazy(env, p))
+        return vector_ireduce(op, nodevalue(p).vec);
+    w = kernel_width(native_dtype(env, p));
+    a = native_rows(env, p, &rows, &cols, &ld);
+    if (rows <= 1 || ld == cols) { /* as one row */
+        cols *= rows;
+        rows = 1;
+    }
+    for (r = 0; r < rows; r++) {
+        x = kernel_ireduce(native_dtype(env, p), op, a + r * ld * w, cols);
+        result = r ? kernel_icombine(op, result, x) : x;
+    }
+    return result;
+}
+
+/*
+ * Whether an axis is given: an integer on top of a native value.
+ */
+static int native_axis_given(pEnv env)
+{
+    return nodetype(env->stck) == INTEGER_ && nextnode1(env->stck)
+           && (nodetype(nextnode1(env->stck)) == VECTOR_
+               || nodetype(nextnode1(env->stck)) == MATRIX_);
+}
+
+/*
+ * The reduction op of native matrix mat along axis 0, of each column, or
+ * axis 1, of each row, in r: doubles for float elements and 64-bit integers
+ * otherwise. Rows are reduced by kernel_reduce; columns by kernel_accumulate,
+ * that adds one row at a time to r, such that both read the elements in the
+ * order in which they are stored.
+ */
+static void native_axis(MatrixData* mat, int op, int axis, void* r)
+{
+    size_t w;
+    char* a;
+    int64_t i;
+    int dtype, fl;
+
+    dtype = mat->dtype;
+    fl = dtype == DT_F64 || dtype == DT_F32;
+    w = kernel_width(dtype);
+    a = mat->data;
+    if (axis) {
+        for (i = 0; i < mat->rows; i++, a += mat->ld * w)
+            if (fl)
+                ((double*)r)[i] = kernel_reduce(dtype, op, a, mat->cols);
+            else
+                ((int64_t*)r)[i] = kernel_ireduce(dtype, op, a, mat->cols);
+        return;
+    }
+    if (!mat->rows) { /* sum or product of nothing */
+        for (i = 0; i < mat->cols; i++)
+            if (fl)
+                ((double*)r)[i] = op == NK_PROD;
+            else
+                ((int64_t*)r)[i] = op == NK_PROD;
+        return;
+    }
+    kernel_cast(fl ? DT_F64 : DT_I64, r, dtype, a, mat->cols);
+    for (i = 1; i < mat->rows; i++)
+        kernel_accumulate(dtype, op, r, a + i * mat->ld * w, mat->cols);
+}
+
+/*
+ * Reduction op, or the mean, of the native value below axis A on top of the
+ * stack. A matrix gives a vector: of the reductions of its columns for axis
+ * 0, or of its rows for axis 1. Its elements are doubles for float elements
+ * and for the mean, and integers otherwise. The only axis of a vector is 0;
+ * then the axis is popped and 0 is returned, for the reduction of all its
+ * elements.
+ */
+static int native_reduce_axis(pEnv env, int op, int mean, char* name)
+{
+    int fl;
+    void* r;
+    int64_t axis, n, size, i;
+    MatrixData* mat;
+    VectorData* vec;
+
+    axis = nodevalue(env->stck).num;
+    if (nodetype(nextnode1(env->stck)) == VECTOR_ && axis == 0) {
+        POP(env->stck);
+        return 0;
+    }
+    if (nodetype(nextnode1(env->stck)) != MATRIX_ || (axis != 0 && axis != 1)) {
+        execerror(env, "axis 0 or 1 of a native matrix", name);
+        return 1;
+    }
+    mat = nodevalue(nextnode1(env->stck)).mat;
+    n = mat ? (axis ? mat->rows : mat->cols) : 0;
+    size = mat ? (axis ? mat->cols : mat->rows) : 0;
+    if (n && !size && (mean || op == NK_MIN || op == NK_MAX)) {
+        execerror(env, "non-empty axis", name);
+        return 1;
+    }
+    fl = native_float(env, nextnode1(env->stck));
+    vec = native_vector(env, mean || fl ? DT_F64 : DT_I64, n);
+    r = vec->data;
+    if (mean && !fl) /* the sums are integers */
+        r = check_malloc((n ? n : 1) * sizeof(int64_t));
+    if (n)
+        native_axis(mat, mean ? NK_SUM : op, axis, r);
+    if (mean) {
+        if (r != vec->data) {
+            kernel_cast(DT_F64, vec->data, DT_I64, r, n);
+            free(r);
+        }
+        for (i = 0; i < n; i++)
+            ((double*)vec->data)[i] /= size;
+    }
+    POP(env->stck);
+    UNARY(VECTOR_NEWNODE, vec);
+    return 1;
+}
+
+/*
+ * Shared code of the reductions of all elements of a vector or matrix, or
+ * along an axis. The result is an integer for integer elements, except for
+ * NK_SUMSQ.
+ */
+static void native_reduce(pEnv env, int op, char* name)
+{
+    ONEPARAM(name);
+    if (op != NK_SUMSQ && native_axis_given(env)
+        && native_reduce_axis(env, op, 0, name))
+        return;
+    if (nodetype(env->stck) != VECTOR_ && nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native vector or matrix", name);
+        return;
+    }
+    if (!native_count(env, env->stck) && (op == NK_MIN || op == NK_MAX)) {
+        execerror(env, "non-empty native vector or matrix", name);
+        return;
+    }
+    if (native_float(env, env->stck) || op == NK_SUMSQ)
+        UNARY(FLOAT_NEWNODE, native_reduction(env, env->stck, op));
+    else
+        UNARY(INTEGER_NEWNODE, native_ireduction(env, env->stck, op));
+}
+
+/*
+ * Shared code of the maps. Only nabs accepts integer elements.
+ */
+static void native_map(pEnv env, int op, char* name)
+{
+    Types u;
+
+    ONEPARAM(name);
+    if (nodetype(env->stck) != VECTOR_ && nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native vector or matrix", name);
+        return;
+    }
+    if (op != NK_ABS && !native_float(env, env->stck)) {
+        execerror(env, "float elements", name);
+        return;
+    }
+    if (native_lazy(env, env->stck))
+        u.vec = vector_defer(env, VX_MAP, op, nodevalue(env->stck).vec, 0, 0);
+    else
+        native_compute(env, env->stck, 0, VX_MAP, op, 0, &u);
+    env->stck = newnode(env, nodetype(env->stck), u, nextnode1(env->stck));
+}
+
+/**
+Q0  OK  3850  nv+\0nvplus  :  V1 V2  ->  V3
+[NATIVE] V3 is the element-wise sum of native vectors V1 and V2.
+Either of them can also be a number, that is added to each element.
+*/
+void nvplus_(pEnv env) { native_binary(env, VECTOR_, NK_ADD, "nv+"); }
+
+/**
+Q0  OK  3860  nv-\0nvminus  :  V1 V2  ->  V3
+[NATIVE] V3 is the element-wise difference of native vectors V1 and V2.
+Either of them can also be a number.
+*/
+void nvminus_(pEnv env) { native_binary(env, VECTOR_, NK_SUB, "nv-"); }
+
+/**
+Q0  OK  3870  nv*\0nvmul  :  V1 V2  ->  V3
+[NATIVE] V3 is the element-wise product of native vectors V1 and V2.
+Either of them can also be a number.
+*/
+void nvmul_(pEnv env) { native_binary(env, VECTOR_, NK_MUL, "nv*"); }
+
+/**
+Q0  OK  3880  nv/\0nvdiv  :  V1 V2  ->  V3
+[NATIVE] V3 is the element-wise quotient of native vectors V1 and V2.
+Either of them can also be a number. Division by zero yields infinity.
+*/
+void nvdiv_(pEnv env) { native_binary(env, VECTOR_, NK_DIV, "nv/"); }
+
+/**
+Q0  OK  3890  nvscale  :  V S  ->  V2
+[NATIVE] V2 is native vector V scaled by scalar S.
+*/
+void nvscale_(pEnv env)
+{
+    TWOPARAMS("nvscale");
+    FLOAT("nvscale");
+    native_binary(env, VECTOR_, NK_MUL, "nvscale");
+}
+
+/**
+Q0  OK  3900  nm+\0nmplus  :  M1 M2  ->  M3
+[NATIVE] M3 is the element-wise sum of native matrices M1 and M2.
+Either of them can also be a number, that is added to each element, or a
+vector, that is added to each row. A matrix of one row or column is added
+to each row or column of the other.
+*/
+void nmplus_(pEnv env) { native_binary(env, MATRIX_, NK_ADD, "nm+"); }
+
+/**
+Q0  OK  3910  nm-\0nmminus  :  M1 M2  ->  M3
+[NATIVE] M3 is the element-wise difference of native matrices M1 and M2.
+Either of them can also be a number or vector, broadcast as for nm+.
+*/
+void nmminus_(pEnv env) { native_binary(env, MATRIX_, NK_SUB, "nm-"); }
+
+/**
+Q0  OK  3920  nm*\0nmmul  :  M1 M2  ->  M3
+[NATIVE] M3 is the element-wise product of native matrices M1 and M2.
+Either of them can also be a number or vector, broadcast as for nm+.
+*/
+void nmmul_(pEnv env) { native_binary(env, MATRIX_, NK_MUL, "nm*"); }
+
+/**
+Q0  OK  3930  nm/\0nmdiv  :  M1 M2  ->  M3
+[NATIVE] M3 is the element-wise quotient of native matrices M1 and M2.
+Either of them can also be a number or vector, broadcast as for nm+.
+Division by zero yields infinity.
+*/
+void nmdiv_(pEnv env) { native_binary(env, MATRIX_, NK_DIV, "nm/"); }
+
+/**
+Q0  OK  3940  nmscale  :  M S  ->  M2
+[NATIVE] M2 is native matrix M scaled by scalar S.
+*/
+void nmscale_(pEnv env)
+{
+    TWOPARAMS("nmscale");
+    FLOAT("nmscale");
+    native_binary(env, MATRIX_, NK_MUL, "nmscale");
+}
+
+/**
+Q0  OK  3950  nsum  :  X  ->  N
+[NATIVE] N is the sum of the elements of native vector or matrix X. With an
+integer A on top, X A -> V gives the sums along axis A: of each column of
+matrix X for 0, of each row for 1.
+*/
+void nsum_(pEnv env) { native_reduce(env, NK_SUM, "nsum"); }
+
+/**
+Q0  OK  3960  nprod  :  X  ->  N
+[NATIVE] N is the product of the elements of native vector or matrix X.
+With an axis A, as for nsum, it is a vector of products.
+*/
+void nprod_(pEnv env) { native_reduce(env, NK_PROD, "nprod"); }
+
+/**
+Q0  OK  3970  nmin  :  X  ->  N
+[NATIVE] N is the smallest element of native vector or matrix X. With an
+axis A, as for nsum, it is a vector of the smallest elements.
+*/
+void nmin_(pEnv env) { native_reduce(env, NK_MIN, "nmin"); }
+
+/**
+Q0  OK  3980  nmax  :  X  ->  N
+[NATIVE] N is the largest element of native vector or matrix X. With an
+axis A, as for nsum, it is a vector of the largest elements.
+*/
+void nmax_(pEnv env) { native_reduce(env, NK_MAX, "nmax"); }
+
+/**
+Q0  OK  3990  nmean  :  X  ->  N
+[NATIVE] N is the arithmetic mean of the elements of native vector or
+matrix X. With an axis A, as for nsum, it is a vector of means.
+*/
+void nmean_(pEnv env)
+{
+    size_t n;
+
+    ONEPARAM("nmean");
+    if (native_axis_given(env) && native_reduce_axis(env, NK_SUM, 1, "nmean"))
+        return;
+    if (nodetype(env->stck) != VECTOR_ && nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native vector or matrix", "nmean");
+        return;
+    }
+    if ((n = native_count(env, env->stck)) == 0) {
+        execerror(env, "non-empty native vector or matrix", "nmean");
+        return;
+    }
+    UNARY(FLOAT_NEWNODE, native_reduction(env, env->stck, NK_SUM) / n);
+}
+
+/**
+Q0  OK  4000  nnorm  :  X  ->  N
+[NATIVE] N is the Euclidean norm of native vector X, or the Frobenius norm
+of native matrix X.
+*/
+void nnorm_(pEnv env)
+{
+    native_reduce(env, NK_SUMSQ, "nnorm");
+    env->stck = FLOAT_NEWNODE(sqrt(nodevalue(env->stck).dbl),
+                              nextnode1(env->stck));
+}
+
+/**
+Q0  OK  4010  nvnormalize  :  V  ->  V2
+[NATIVE] V2 is the unit vector in the direction of native vector V.
+Returns zero vector if V has zero magnitude.
+*/
+void nvnormalize_(pEnv env)
+{
+    NativeScalar s;
+    VectorData *vec, *res;
+
+    ONEPARAM("nvnormalize");
+    if (!native_lazy(env, env->stck)) {
+        execerror(env, "native vector", "nvnormalize");
+        return;
+    }
+    if (!native_float(env, env->stck)) {
+        execerror(env, "float elements", "nvnormalize");
+        return;
+    }
+    vec = nodevalue(env->stck).vec;
+    s.f64 = sqrt(vector_reduce(NK_SUMSQ, vec));
+    if (s.f64 > 1e-15) {
+        if (vec->dtype == DT_F32)
+            s.f32 = s.f64;
+        res = vector_defer(env, VX_SCALAR, NK_DIV, vec, 0, &s);
+    } else {
+        s.i64 = 0; /* 0.0 in either float type */
+        res = vector_defer(env, VX_SCALAR, NK_MUL, vec, 0, &s);
+    }
+    UNARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4020  nvcross  :  V1 V2  ->  V3
+[NATIVE] V3 is the cross product of native 3D vectors V1 and V2.
+*/
+void nvcross_(pEnv env)
+{
+    int dtype;
+    size_t n;
+    VectorData *a, *b, *vec;
+    double x[3], y[3];
+
+    TWOPARAMS("nvcross");
+    if (nodetype(env->stck) != VECTOR_
+        || nodetype(nextnode1(env->stck)) != VECTOR_) {
+        execerror(env, "two native vectors", "nvcross");
+        return;
+    }
+    if ((dtype = native_dtype(env, env->stck))
+        != native_dtype(env, nextnode1(env->stck))) {
+        execerror(env, "equal element types", "nvcross");
+        return;
+    }
+    b = nodevalue(env->stck).vec;
+    a = nodevalue(nextnode1(env->stck)).vec;
+    if (!a || !b || a->len != 3 || b->len != 3) {
+        execerror(env, "3-element vectors", "nvcross");
+        return;
+    }
+    vector_force(a);
+    vector_force(b);
+    for (n = 0; n < 3; n++) {
+        x[n] = kernel_get(dtype, a->data, n * a->inc);
+        y[n] = kernel_get(dtype, b->data, n * b->inc);
+    }
+    vec = native_vector(env, dtype, 3);
+    kernel_set(dtype, vec->data, 0, x[1] * y[2] - x[2] * y[1]);
+    kernel_set(dtype, vec->data, 1, x[2] * y[0] - x[0] * y[2]);
+    kernel_set(dtype, vec->data, 2, x[0] * y[1] - x[1] * y[0]);
+    BINARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4030  nvrange  :  A B  ->  V
+[NATIVE] V is a native vector of the integers from A to B inclusive.
+*/
+void nvrange_(pEnv env)
+{
+    int64_t a, b, i, n;
+    double* data;
+    VectorData* vec;
+
+    TWOPARAMS("nvrange");
+    INTEGER("nvrange");
+    INTEGER2("nvrange");
+    b = nodevalue(env->stck).num;
+    a = nodevalue(nextnode1(env->stck)).num;
+    if (b >= a && (uint64_t)b - (uint64_t)a >= NATIVE_MAX_LEN) {
+        execerror(env, "smaller range", "nvrange");
+        return;
+    }
+    n = b < a ? 0 : b - a + 1;
+    vec = native_vector(env, DT_F64, n);
+    data = vec->data;
+#pragma omp simd
+    for (i = 0; i < n; i++)
+        data[i] = (double)(a + i);
+    BINARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4040  nvlinspace  :  A B N  ->  V
+[NATIVE] V is a native vector of N linearly spaced values from A to B
+inclusive.
+*/
+void nvlinspace_(pEnv env)
+{
+    int64_t i, n;
+    double a, b, step, *data;
+    VectorData* vec;
+
+    THREEPARAMS("nvlinspace");
+    POSITIVEINDEX(env->stck, "nvlinspace");
+    if (nodevalue(env->stck).num > NATIVE_MAX_LEN) {
+        execerror(env, "smaller size", "nvlinspace");
+        return;
+    }
+    n = nodevalue(env->stck).num;
+    POP(env->stck);
+    FLOAT2("nvlinspace");
+    b = FLOATVAL;
+    a = FLOATVAL2;
+    vec = native_vector(env, DT_F64, n);
+    data = vec->data;
+    step = n > 1 ? (b - a) / (n - 1) : 0.0;
+#pragma omp simd
+    for (i = 0; i < n; i++)
+        data[i] = a + i * step;
+    if (n > 1)
+        data[n - 1] = b; /* no floating point drift at the end */
+    BINARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4050  ntranspose  :  M  ->  M2
+[NATIVE] M2 is the transpose of native matrix M.
+*/
+void ntranspose_(pEnv env)
+{
+    size_t width;
+    int64_t rows, cols, i, j, ii, jj;
+    MatrixData *mat, *res;
+    unsigned char *src, *dst;
+
+    ONEPARAM("ntranspose");
+    if (nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native matrix", "ntranspose");
+        return;
+    }
+    mat = nodevalue(env->stck).mat;
+    rows = mat ? mat->rows : 0;
+    cols = mat ? mat->cols : 0;
+    res = native_matrix(env, native_dtype(env, env->stck), cols, rows);
+    width = kernel_width(res->dtype);
+    src = mat ? mat->data : 0;
+    dst = res->data;
+    /*
+     * Tiles of 32 x 32 keep both the rows that are read and the rows that
+     * are written in the cache.
+     */
+    for (ii = 0; ii < rows; ii += 32)
+        for (jj = 0; jj < cols; jj += 32)
+            for (i = ii; i < rows && i < ii + 32; i++)
+                for (j = jj; j < cols && j < jj + 32; j++)
+                    memcpy(dst + (j * rows + i) * width,
+                           src + (i * mat->ld + j) * width, width);
+    UNARY(MATRIX_NEWNODE, res);
+}
+
+/**
+Q0  OK  4060  ntrace  :  M  ->  N
+[NATIVE] N is the trace (sum of diagonal elements) of square native matrix M.
+The trace of integer elements is an integer.
+*/
+void ntrace_(pEnv env)
+{
+    int64_t i, k = 0;
+    double r = 0.0;
+    MatrixData* mat;
+
+    ONEPARAM("ntrace");
+    if (nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native matrix", "ntrace");
+        return;
+    }
+    mat = nodevalue(env->stck).mat;
+    if (mat && mat->rows != mat->cols) {
+        execerror(env, "square matrix", "ntrace");
+        return;
+    }
+    if (!native_float(env, env->stck)) {
+        for (i = 0; mat && i < mat->rows; i++)
+            k = (int64_t)((uint64_t)k
+                          + kernel_geti(mat->dtype, mat->data,
+                                        i * mat->ld + i));
+        UNARY(INTEGER_NEWNODE, k);
+        return;
+    }
+    for (i = 0; mat && i < mat->rows; i++)
+        r += kernel_get(mat->dtype, mat->data, i * mat->ld + i);
+    UNARY(FLOAT_NEWNODE, r);
+}
+
+/**
+Q0  OK  4070  nabs  :  X  ->  X2
+[NATIVE] X2 has the absolute values of the elements of native vector or
+matrix X.
+*/
+void nabs_(pEnv env) { native_map(env, NK_ABS, "nabs"); }
+
+/**
+Q0  OK  4080  nsqrt  :  X  ->  X2
+[NATIVE] X2 has the square roots of the elements of native vector or
+matrix X.
+*/
+void nsqrt_(pEnv env) { native_map(env, NK_SQRT, "nsqrt"); }
+
+/**
+Q0  OK  4090  nexp  :  X  ->  X2
+[NATIVE] X2 has e raised to the elements of native vector or matrix X.
+*/
+void nexp_(pEnv env) { native_map(env, NK_EXP, "nexp"); }
+
+/**
+Q0  OK  4100  nlog  :  X  ->  X2
+[NATIVE] X2 has the natural logarithms of the elements of native vector or
+matrix X.
+*/
+void nlog_(pEnv env) { native_map(env, NK_LOG, "nlog"); }
+
+/**
+Q0  OK  4110  n=\0ncmpeq  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native values X and Y are equal,
+and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmpeq_(pEnv env) { native_binary(env, native_type(env), NK_EQ, "n="); }
+
+/**
+Q0  OK  4120  n!=\0ncmpne  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native values X and Y differ,
+and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmpne_(pEnv env)
+{
+    native_binary(env, native_type(env), NK_NE, "n!=");
+}
+
+/**
+Q0  OK  4130  n<\0ncmplt  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native value X are less than those
+of Y, and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmplt_(pEnv env) { native_binary(env, native_type(env), NK_LT, "n<"); }
+
+/**
+Q0  OK  4140  n<=\0ncmple  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native value X are less than or
+equal to those of Y, and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmple_(pEnv env)
+{
+    native_binary(env, native_type(env), NK_LE, "n<=");
+}
+
+/**
+Q0  OK  4150  n>\0ncmpgt  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native value X are greater than
+those of Y, and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmpgt_(pEnv env) { native_binary(env, native_type(env), NK_GT, "n>"); }
+
+/**
+Q0  OK  4160  n>=\0ncmpge  :  X Y  ->  Z
+[NATIVE] Z has 1.0 where the elements of native value X are greater than or
+equal to those of Y, and 0.0 elsewhere. Either of them can also be a number.
+*/
+void ncmpge_(pEnv env)
+{
+    native_binary(env, native_type(env), NK_GE, "n>=");
+}
+
+/**
+Q0  OK  4170  ncast  :  X S  ->  X2
+[NATIVE] X2 has the elements of native vector or matrix X, converted to the
+element type named by string S: "float64", "float32", "int64", "int32" or
+"uint8". Conversion to integers truncates and saturates.
+*/
+void ncast_(pEnv env)
+{
+    Types u;
+    int dtype;
+    char *a, *c;
+    int64_t rows, cols, ld, r;
+    VectorData* vec;
+    MatrixData* mat;
+
+    TWOPARAMS("ncast");
+    STRING("ncast");
+    if (nodetype(nextnode1(env->stck)) != VECTOR_
+        && nodetype(nextnode1(env->stck)) != MATRIX_) {
+        execerror(env, "native vector or matrix", "ncast");
+        return;
+    }
+    if ((dtype = kernel_dtype(GETSTRING(env->stck))) < 0) {
+        execerror(env, "element type name", "ncast");
+        return;
+    }
+    POP(env->stck);
+    if (dtype == native_dtype(env, env->stck))
+        return; /* values are never modified, so no copy is needed */
+    if (nodetype(env->stck) == VECTOR_) {
+        vec = nodevalue(env->stck).vec;
+        u.vec = native_vector(env, dtype, vec ? vec->len : 0);
+        if (vec)
+            vector_cast(dtype, u.vec->data, vec);
+    } else {
+        mat = nodevalue(env->stck).mat;
+        u.mat = native_matrix(env, dtype, mat ? mat->rows : 0,
+                              mat ? mat->cols : 0);
+        a = native_rows(env, env->stck, &rows, &cols, &ld);
+        c = u.mat->data;
+        for (r = 0; r < rows; r++)
+            kernel_cast(dtype, c + r * cols * kernel_width(dtype),
+                        native_dtype(env, env->stck),
+                        a + r * ld * kernel_width(mat->dtype), cols);
+    }
+    env->stck = newnode(env, nodetype(env->stck), u, nextnode1(env->stck));
+}
+
+/**
+Q0  OK  4180  ndtype  :  X  ->  S
+[NATIVE] S is the name of the element type of native vector or matrix X.
+*/
+void ndtype_(pEnv env)
+{
+    ONEPARAM("ndtype");
+    if (nodetype(env->stck) != VECTOR_ && nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native vector or matrix", "ndtype");
+        return;
+    }
+    UNARY(STRING_NEWNODE, (char*)kernel_name(native_dtype(env, env->stck)));
+}
+/**
+Q0  OK  4190  nrow  :  M I  ->  V
+[NATIVE] V is row I of native matrix M, counting from 0. V shares the
+elements of M.
+*/
+void nrow_(pEnv env)
+{
+    int64_t i;
+    MatrixData* mat;
+    VectorData* vec;
+
+    TWOPARAMS("nrow");
+    INTEGER("nrow");
+    if (nodetype(nextnode1(env->stck)) != MATRIX_) {
+        execerror(env, "native matrix", "nrow");
+        return;
+    }
+    i = nodevalue(env->stck).num;
+    mat = nodevalue(nextnode1(env->stck)).mat;
+    if (!mat || i < 0 || i >= mat->rows) {
+        execerror(env, "valid row index", "nrow");
+        return;
+    }
+    vec = native_vector_view(env, mat,
+                             (char*)mat->data
+                                 + i * mat->ld * kernel_width(mat->dtype),
+                             mat->cols, 1);
+    BINARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4200  ncol  :  M J  ->  V
+[NATIVE] V is column J of native matrix M, counting from 0. V shares the
+elements of M.
+*/
+void ncol_(pEnv env)
+{
+    int64_t j;
+    MatrixData* mat;
+    VectorData* vec;
+
+    TWOPARAMS("ncol");
+    INTEGER("ncol");
+    if (nodetype(nextnode1(env->stck)) != MATRIX_) {
+        execerror(env, "native matrix", "ncol");
+        return;
+    }
+    j = nodevalue(env->stck).num;
+    mat = nodevalue(nextnode1(env->stck)).mat;
+    if (!mat || j < 0 || j >= mat->cols) {
+        execerror(env, "valid column index", "ncol");
+        return;
+    }
+    vec = native_vector_view(env, mat,
+                             (char*)mat->data + j * kernel_width(mat->dtype),
+                             mat->rows, mat->ld);
+    BINARY(VECTOR_NEWNODE, vec);
+}
+
+/**
+Q0  OK  4210  nvslice  :  V I J K  ->  V2
+[NATIVE] V2 has the elements of native vector V from index I up to, but not
+including, index J, taking every K-th. I and J are limited to the length of
+V. V2 shares the elements of V.
+*/
+void nvslice_(pEnv env)
+{
+    int64_t i, j, k, n;
+    VectorData *vec, *res;
+
+    FOURPARAMS("nvslice");
+    if (!native_integers(env, 3, "nvslice"))
+        return;
+    if (nodetype(nextnode3(env->stck)) != VECTOR_) {
+        execerror(env, "native vector", "nvslice");
+        return;
+    }
+    if ((k = nodevalue(env->stck).num) <= 0) {
+        execerror(env, "positive step", "nvslice");
+        return;
+    }
+    j = nodevalue(nextnode1(env->stck)).num;
+    i = nodevalue(nextnode2(env->stck)).num;
+    vec = nodevalue(nextnode3(env->stck)).vec;
+    n = vec ? vec->len : 0;
+    i = i < 0 ? 0 : i > n ? n : i;
+    j = j < i ? i : j > n ? n : j;
+    if (!vec) {
+        env->stck = nextnode3(env->stck);
+        return;
+    }
+    vector_force(vec);
+    res = native_vector_view(env, vec,
+                             (char*)vec->data
+                                 + i * vec->inc * kernel_width(vec->dtype),
+                             (j - i + k - 1) / k, vec->inc * k);
+    env->stck = VECTOR_NEWNODE(res, nextnode4(env->stck));
+}
+
+/**
+Q0  OK  4220  nmblock  :  M I J R C  ->  M2
+[NATIVE] M2 is the R x C block of native matrix M that starts at row I and
+column J, counting from 0. M2 shares the elements of M.
+*/
+void nmblock_(pEnv env)
+{
+    int64_t i, j, r, c;
+    MatrixData *mat, *res;
+
+    FIVEPARAMS("nmblock");
+    if (!native_integers(env, 4, "nmblock"))
+        return;
+    if (nodetype(nextnode4(env->stck)) != MATRIX_) {
+        execerror(env, "native matrix", "nmblock");
+        return;
+    }
+    c = nodevalue(env->stck).num;
+    r = nodevalue(nextnode1(env->stck)).num;
+    j = nodevalue(nextnode2(env->stck)).num;
+    i = nodevalue(nextnode3(env->stck)).num;
+    mat = nodevalue(nextnode4(env->stck)).mat;
+    if (i < 0 || j < 0 || r < 0 || c < 0 || i + r > (mat ? mat->rows : 0)
+        || j + c > (mat ? mat->cols : 0)) {
+        execerror(env, "block within matrix", "nmblock");
+        return;
+    }
+    if (!mat) {
+        env->stck = nextnode4(env->stck);
+        return;
+    }
+    res = native_matrix_view(env, mat,
+                             (char*)mat->data
+                                 + (i * mat->ld + j) * kernel_width(mat->dtype),
+                             r, c, mat->ld);
+    env->stck = MATRIX_NEWNODE(res, nextnode5(env->stck));
+}
+
+/**
+Q0  OK  4230  nshape  :  X  ->  L
+[NATIVE] L is [N] for a native vector X of N elements, and [R C] for a
+native or sparse matrix X of R rows and C columns.
+*/
+void nshape_(pEnv env)
+{
+    Index list;
+    MatrixData* mat;
+
+    ONEPARAM("nshape");
+    ensure_capacity(env, 3); /* no gc below */
+    if (nodetype(env->stck) == VECTOR_)
+        list = INTEGER_NEWNODE(native_count(env, env->stck), 0);
+    else if (nodetype(env->stck) == MATRIX_) {
+        mat = nodevalue(env->stck).mat;
+        list = INTEGER_NEWNODE(mat ? mat->cols : 0, 0);
+        list = INTEGER_NEWNODE(mat ? mat->rows : 0, list);
+    } else if (nodetype(env->stck) == SPARSE_) {
+        list = INTEGER_NEWNODE(nodevalue(env->stck).spm->cols, 0);
+        list = INTEGER_NEWNODE(nodevalue(env->stck).spm->rows, list);
+    } else {
+        execerror(env, "native vector or matrix", "nshape");
+        return;
+    }
+    UNARY(LIST_NEWNODE, list);
+}
+
+/*
+ * The position of the first smallest (NK_MIN) or largest (NK_MAX) element
+ * of the native value in node p, counting the elements of a matrix row by
+ * row.
+ */
+static int64_t native_position(pEnv env, Index p, int op)
+{
+    size_t w;
+    char* a;
+    int dtype, fl;
+    double x = 0, best = 0;
+    int64_t rows, cols, ld, r, j, k = 0, ix = 0, ibest = 0;
+
+    dtype = native_dtype(env, p);
+    fl = native_float(env, p);
+    w = kernel_width(dtype);
+    a = native_rows(env, p, &rows, &cols, &ld);
+    if (rows <= 1 || ld == cols) { /* as one row */
+        cols *= rows;
+        rows = 1;
+    }
+    for (r = 0; r < rows; r++, a += ld * w) {
+        j = kernel_argreduce(dtype, op, a, cols);
+        if (fl)
+            x = kernel_get(dtype, a, j);
+        else
+            ix = kernel_geti(dtype, a, j);
+        if (!r || (fl ? (op == NK_MIN ? x < best : x > best)
+                      : (op == NK_MIN ? ix < ibest : ix > ibest))) {
+            best = x;
+            ibest = ix;
+            k = r * cols + j;
+        }
+    }
+    return k;
+}
+
+/*
+ * The positions of the first smallest (NK_MIN) or largest (NK_MAX) elements
+ * of native matrix mat along axis 0, in each column, or axis 1, in each row,
+ * in k. Columns are searched by kernel_argaccumulate, one row at a time.
+ */
+static void native_positions(MatrixData* mat, int op, int axis, int64_t* k)
+{
+    size_t w;
+    char* a;
+    void* r;
+    int64_t i;
+    int dtype, fl;
+
+    dtype = mat->dtype;
+    fl = dtype == DT_F64 || dtype == DT_F32;
+    w = kernel_width(dtype);
+    a = mat->data;
+    if (axis) {
+        for (i = 0; i < mat->rows; i++, a += mat->ld * w)
+            k[i] = kernel_argreduce(dtype, op, a, mat->cols);
+        return;
+    }
+    r = check_malloc(mat->cols * (fl ? sizeof(double) : sizeof(int64_t)));
+    kernel_cast(fl ? DT_F64 : DT_I64, r, dtype, a, mat->cols);
+    memset(k, 0, mat->cols * sizeof(int64_t));
+    for (i = 1; i < mat->rows; i++)
+        kernel_argaccumulate(dtype, op, r, k, i, a + i * mat->ld * w,
+                             mat->cols);
+    free(r);
+}
+
+/*
+ * Shared code of nargmin and nargmax.
+ */
+static void native_arg(pEnv env, int op, char* name)
+{
+    int64_t axis, n, size;
+    MatrixData* mat;
+    VectorData* vec;
+
+    ONEPARAM(name);
+    if (native_axis_given(env)) {
+        axis = nodevalue(env->stck).num;
+        if (nodetype(nextnode1(env->stck)) == VECTOR_ && axis == 0)
+            POP(env->stck);
+        else if (nodetype(nextnode1(env->stck)) != MATRIX_
+                 || (axis != 0 && axis != 1)) {
+            execerror(env, "axis 0 or 1 of a native matrix", name);
+            return;
+        } else {
+            mat = nodevalue(nextnode1(env->stck)).mat;
+            n = mat ? (axis ? mat->rows : mat->cols) : 0;
+            size = mat ? (axis ? mat->cols : mat->rows) : 0;
+            if (n && !size) {
+                execerror(env, "non-empty axis", name);
+                return;
+            }
+            vec = native_vector(env, DT_I64, n);
+            if (n)
+                native_positions(mat, op, axis, vec->data);
+            POP(env->stck);
+            UNARY(VECTOR_NEWNODE, vec);
+            return;
+        }
+    }
+    if (nodetype(env->stck) != VECTOR_ && nodetype(env->stck) != MATRIX_) {
+        execerror(env, "native vector or matrix", name);
+        return;
+    }
+    if (!native_count(env, env->stck)) {
+        execerror(env, "non-empty native vector or matrix", name);
+        return;
+    }
+    UNARY(INTEGER_NEWNODE, native_position(env, env->stck, op));
+}
+
+/**
+Q0  OK  4430  nargmin  :  X  ->  I
+[NATIVE] I is the position of the first smallest element of native vector or
+matrix X, counting row by row. With an axis A, as for nmin, it is a vector
+of the positions in each column (0) or row (1) of matrix X.
+*/
+void nargmin_(pEnv env) { native_arg(env, NK_MIN, "nargmin"); }
+
+/**
+Q0  OK  4440  nargmax  :  X  ->  I
+[NATIVE] I is the position of the first largest element of native vector or
+matrix X, counting row by row. With an axis A, as for nmax, it is a vector
+of the positions in each column (0) or row (1) of matrix X.
+*/
+void nargmax_(pEnv env) { native_arg(env, NK_MAX, "nargmax"); }
+#endif /* JOY_NATIVE_TYPES */
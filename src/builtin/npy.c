@@ -0,0 +1,62 @@
+/*
+ *  module  : npy.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Native vectors and matrices in .npy files of NumPy: nload nsave.
+ *
+ *  The format is in src/npy.c. nload maps the file into memory, such that a
+ *  large file is available at once and its pages are read when they are
+ *  used; the result is a view of the mapped elements.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+/**
+Q0  OK  4450  nload  :  P  ->  X
+[NATIVE] X is the native vector or matrix in the .npy file with pathname P.
+The file is mapped into memory and X refers to its elements, without
+copying them. Elements are float64, float32, int64, int32 or uint8.
+*/
+void nload_(pEnv env)
+{
+    Types u;
+    char* msg;
+    Operator type;
+
+    ONEPARAM("nload");
+    STRING("nload");
+    if ((msg = npy_load(env, GETSTRING(env->stck), &type, &u)) != 0) {
+        execerror(env, msg, "nload");
+        return;
+    }
+    env->stck = newnode(env, type, u, nextnode1(env->stck));
+}
+
+/**
+Q0  OK  4460  nsave  :  X P  ->
+[NATIVE] Native vector or matrix X is written to a .npy file with pathname
+P, that NumPy and nload read.
+*/
+void nsave_(pEnv env)
+{
+    char* msg;
+
+    TWOPARAMS("nsave");
+    STRING("nsave");
+    if (nodetype(nextnode1(env->stck)) != VECTOR_
+        && nodetype(nextnode1(env->stck)) != MATRIX_) {
+        execerror(env, "native vector or matrix", "nsave");
+        return;
+    }
+    if ((msg = npy_save(env, GETSTRING(env->stck),
+                        nodetype(nextnode1(env->stck)),
+                        nodevalue(nextnode1(env->stck))))
+        != 0) {
+        execerror(env, msg, "nsave");
+        return;
+    }
+    POP(env->stck);
+    POP(env->stck);
+}
+#endif /* JOY_NATIVE_TYPES */
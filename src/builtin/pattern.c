@@ -1,7 +1,7 @@
 /*
  *  module  : pattern.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Pattern matching combinators: match, cases
  *
@@ -12,23 +12,27 @@
  *    - [] : matches empty list
  *    - [x : xs] : cons pattern, matches non-empty list (head x, tail xs)
  *    - [a b c] : exact list pattern, matches list of exactly that length
+ *
+ *  Patterns are compiled once into instructions (see globals.h), and cached
+ *  by the index of the pattern or the cases list (see src/pattern.c). The
+ *  wildcard and the cons separator are recognized while compiling, so that
+ *  matching does not look at names. Matching does not allocate: variables
+ *  are collected first, and bound when the match has succeeded.
  */
 #include "globals.h"
 
 /* Maximum number of bindings per pattern */
 #define MAX_BINDINGS 64
 
+/* Minimum number of integer literal clauses that get a jump table */
+#define MIN_RUN 4
+
 /* Binding: maps a symbol table index to a value */
 typedef struct {
     int sym_index;      /* Index into symtab */
-    Index value;        /* Value to bind */
-    Entry saved_entry;  /* Original entry for restoration */
+    PatValue value;     /* Value to bind */
 } Binding;
 
-/* Forward declarations */
-static int pattern_match(pEnv env, Index pattern, Index value,
-                         Binding* bindings, int* num_bindings);
-
 /*
  * Check if a USR_ node is the wildcard "_"
  */
@@ -66,192 +70,339 @@ static int find_cons_separator(pEnv env, Index list)
 }
 
 /*
- * Add a binding (if not wildcard)
+ * Append an instruction to a program under construction
  */
-static void add_binding(pEnv env, Index pattern_var, Index value,
-                        Binding* bindings, int* num_bindings)
+static void emit(PatProgram* prog, int* max, int code, int arg, Index lit)
 {
-    if (*num_bindings >= MAX_BINDINGS) {
-        execerror(env, "match", "too many pattern variables");
-        return;
+    if (prog->instrs == *max) {
+        *max = *max ? 2 * *max : 16;
+        prog->instr = realloc(prog->instr, *max * sizeof(PatInstr));
+#ifdef TEST_MALLOC_RETURN
+        if (!prog->instr)
+            fatal("memory exhausted");
+#endif
     }
-    int idx = nodevalue(pattern_var).ent;
-    bindings[*num_bindings].sym_index = idx;
-    bindings[*num_bindings].value = value;
-    bindings[*num_bindings].saved_entry = vec_at(env->symtab, idx);
-    (*num_bindings)++;
+    prog->instr[prog->instrs].code = code;
+    prog->instr[prog->instrs].arg = arg;
+    prog->instr[prog->instrs++].lit = lit;
 }
 
 /*
- * Match a cons pattern [head_pat : tail_pat] against a value
+ * Compile a pattern; the number of variables is added to binds
  */
-static int match_cons_pattern(pEnv env, Index pattern_list, int colon_pos,
-                              Index value, Binding* bindings, int* num_bindings)
+static void compile_pattern(pEnv env, PatProgram* prog, int* max,
+                            Index pattern, int* binds)
 {
-    /* Value must be a non-empty list */
-    if (nodetype(value) != LIST_ || !nodevalue(value).lis)
-        return 0;
+    int num, colon_pos;
+    Index cur;
+
+    switch (nodetype(pattern)) {
+    case USR_:
+        if (is_wildcard(env, pattern))
+            emit(prog, max, PAT_ANY, 0, 0);
+        else {
+            emit(prog, max, PAT_BIND, nodevalue(pattern).ent, 0);
+            (*binds)++;
+        }
+        break;
+
+    case LIST_:
+        cur = nodevalue(pattern).lis;
+        if ((colon_pos = find_cons_separator(env, cur)) > 0) {
+            /* Heads before the colon, exactly one tail after it */
+            Index tail = cur;
+            for (int i = 1; i <= colon_pos; i++)
+                tail = nextnode1(tail);
+            if (!tail || nextnode1(tail)) {
+                emit(prog, max, PAT_BAD, 0, 0);
+                break;
+            }
+            emit(prog, max, PAT_CONS, colon_pos - 1, 0);
+            for (int i = 1; i < colon_pos; i++, cur = nextnode1(cur))
+                compile_pattern(env, prog, max, cur, binds);
+            compile_pattern(env, prog, max, tail, binds);
+            break;
+        }
+        /* Exact list pattern, [] included */
+        for (num = 0; cur; cur = nextnode1(cur))
+            num++;
+        emit(prog, max, PAT_LIST, num, 0);
+        for (cur = nodevalue(pattern).lis; cur; cur = nextnode1(cur))
+            compile_pattern(env, prog, max, cur, binds);
+        break;
 
-    Index value_list = nodevalue(value).lis;
-    Index head_value = value_list;
-    Index tail_value_list = nextnode1(value_list);
+    /* Literals: match by equality */
+    case INTEGER_:
+    case FLOAT_:
+    case STRING_:
+    case CHAR_:
+    case BOOLEAN_:
+    case SET_:
+        emit(prog, max, PAT_LIT, 0, pattern);
+        break;
 
-    /* Collect head patterns (before the colon) */
-    Index head_patterns[MAX_BINDINGS];
-    int num_head_pats = 0;
-    Index cur = pattern_list;
-    for (int i = 1; i < colon_pos && cur; i++, cur = nextnode1(cur)) {
-        head_patterns[num_head_pats++] = cur;
+    default:
+        /* Unsupported pattern type */
+        emit(prog, max, PAT_NONE, 0, 0);
+        break;
     }
+}
 
-    /* Skip the colon */
-    if (cur)
-        cur = nextnode1(cur);
+/*
+ * Create an empty program for key
+ */
+static PatProgram* new_program(Index key, int kind, int clauses)
+{
+    PatProgram* prog;
+
+    prog = check_malloc(sizeof(PatProgram));
+    memset(prog, 0, sizeof(PatProgram));
+    prog->key = key;
+    prog->kind = kind;
+    prog->clause = calloc(clauses ? clauses : 1, sizeof(PatClause));
+#ifdef TEST_MALLOC_RETURN
+    if (!prog->clause)
+        fatal("memory exhausted");
+#endif
+    return prog;
+}
 
-    /* Collect tail patterns (after the colon) - should be exactly one */
-    Index tail_pattern = cur;
-    if (!tail_pattern || nextnode1(tail_pattern)) {
-        /* Either no tail pattern or more than one - invalid */
-        execerror(env, "match", "cons pattern requires exactly one tail pattern after :");
-        return 0;
-    }
+/*
+ * Compile the pattern of match
+ */
+static PatProgram* compile_match(pEnv env, Index pattern)
+{
+    int max = 0, binds = 0;
+    PatProgram* prog = new_program(pattern, 1, 1);
+
+    compile_pattern(env, prog, &max, pattern, &binds);
+    prog->clause[0].stop = prog->instrs;
+    prog->clauses = 1;
+    if (binds > MAX_BINDINGS)
+        prog->clause[0].error = "too many pattern variables";
+    prog->binds = binds;
+    return prog;
+}
 
-    /* For simple [h : t] pattern (1 head pattern) */
-    if (num_head_pats == 1) {
-        /* Match head pattern against first element */
-        if (!pattern_match(env, head_patterns[0], head_value, bindings, num_bindings))
-            return 0;
+/*
+ * Order of the jump table: by literal, then by clause
+ */
+static int jump_compare(const void* a, const void* b)
+{
+    const PatJump *x = a, *y = b;
 
-        /* Create a list node containing the tail for matching */
-        Index tail_value = LIST_NEWNODE(tail_value_list, 0);
-        if (!pattern_match(env, tail_pattern, tail_value, bindings, num_bindings))
-            return 0;
+    if (x->num != y->num)
+        return x->num < y->num ? -1 : 1;
+    return x->clause - y->clause;
+}
 
-        return 1;
-    }
+/*
+ * Check if a clause is a single integer literal
+ */
+static int is_int_clause(pEnv env, PatProgram* prog, PatClause* cl)
+{
+    return !cl->error && cl->stop - cl->start == 1
+        && prog->instr[cl->start].code == PAT_LIT
+        && nodetype(prog->instr[cl->start].lit) == INTEGER_;
+}
 
-    /* For patterns like [a b : rest] - match multiple heads */
-    Index val_cur = value_list;
-    for (int i = 0; i < num_head_pats; i++) {
-        if (!val_cur)
-            return 0; /* Not enough elements */
-        if (!pattern_match(env, head_patterns[i], val_cur, bindings, num_bindings))
-            return 0;
-        val_cur = nextnode1(val_cur);
+/*
+ * Give runs of at least MIN_RUN integer literal clauses a jump table
+ */
+static void compile_runs(pEnv env, PatProgram* prog)
+{
+    int i, j, k;
+
+    prog->jump = malloc((prog->clauses ? prog->clauses : 1) * sizeof(PatJump));
+#ifdef TEST_MALLOC_RETURN
+    if (!prog->jump)
+        fatal("memory exhausted");
+#endif
+    for (i = 0; i < prog->clauses; i = j) {
+        for (j = i; j < prog->clauses
+             && is_int_clause(env, prog, &prog->clause[j]); j++)
+            ;
+        if (j - i < MIN_RUN) {
+            j = j > i ? j : i + 1;
+            continue;
+        }
+        prog->clause[i].run = j - i;
+        prog->clause[i].jump = prog->jumps;
+        for (k = i; k < j; k++) {
+            prog->jump[prog->jumps].num
+                = nodevalue(prog->instr[prog->clause[k].start].lit).num;
+            prog->jump[prog->jumps++].clause = k;
+        }
+        qsort(&prog->jump[prog->clause[i].jump], j - i, sizeof(PatJump),
+              jump_compare);
     }
-
-    /* Match tail pattern against remaining list */
-    Index remaining = LIST_NEWNODE(val_cur, 0);
-    if (!pattern_match(env, tail_pattern, remaining, bindings, num_bindings))
-        return 0;
-
-    return 1;
 }
 
 /*
- * Match an exact list pattern [p1 p2 ... pn] against a value
+ * Compile a cases list. A malformed clause ends the program; the error is
+ * reported when the clause is reached.
  */
-static int match_exact_list(pEnv env, Index pattern_list, Index value,
-                            Binding* bindings, int* num_bindings)
+static PatProgram* compile_cases(pEnv env, Index list)
 {
-    /* Value must be a list */
-    if (nodetype(value) != LIST_)
-        return 0;
+    int num = 0, max = 0, binds;
+    Index cur, case_pair, pattern;
+    PatClause* cl;
+    PatProgram* prog;
+
+    for (cur = list; cur; cur = nextnode1(cur))
+        num++;
+    prog = new_program(list, 0, num);
+    for (cur = list; cur; cur = nextnode1(cur)) {
+        cl = &prog->clause[prog->clauses++];
+        cl->start = cl->stop = prog->instrs;
 
-    Index val_cur = nodevalue(value).lis;
-    Index pat_cur = pattern_list;
+        /* Each case should be a list [pattern action] */
+        if (nodetype(cur) != LIST_) {
+            cl->error = "each case must be a quotation";
+            break;
+        }
+        case_pair = nodevalue(cur).lis;
+        if (!case_pair || nodetype(case_pair) != LIST_) {
+            cl->error = "case must be [[pattern] [action]]";
+            break;
+        }
+        if (!nextnode1(case_pair) || nodetype(nextnode1(case_pair)) != LIST_) {
+            cl->error = "case must have [pattern] and [action]";
+            break;
+        }
+        cl->action = nodevalue(nextnode1(case_pair)).lis;
 
-    /* Match each element */
-    while (pat_cur && val_cur) {
-        if (!pattern_match(env, pat_cur, val_cur, bindings, num_bindings))
-            return 0;
-        pat_cur = nextnode1(pat_cur);
-        val_cur = nextnode1(val_cur);
+        /* Empty pattern matches anything */
+        if ((pattern = nodevalue(case_pair).lis) == 0)
+            continue;
+        binds = 0;
+        compile_pattern(env, prog, &max, pattern, &binds);
+        cl->stop = prog->instrs;
+        if (binds > MAX_BINDINGS) {
+            cl->error = "too many pattern variables";
+            break;
+        }
+        if (prog->binds < binds)
+            prog->binds = binds;
     }
+    compile_runs(env, prog);
+    return prog;
+}
 
-    /* Both must be exhausted */
-    return !pat_cur && !val_cur;
+/*
+ * Compare a literal pattern with a value
+ */
+static int same_literal(pEnv env, Index pattern, Index value)
+{
+    if (nodetype(pattern) == INTEGER_ && nodetype(value) == INTEGER_)
+        return nodevalue(pattern).num == nodevalue(value).num;
+    return Compare(env, pattern, value) == 0;
 }
 
 /*
- * Main pattern matching function
+ * Run the instructions of a clause against a value
  *
  * Returns 1 on match, 0 on failure
  * Populates bindings array with variable->value pairs
  */
-static int pattern_match(pEnv env, Index pattern, Index value,
-                         Binding* bindings, int* num_bindings)
+static int pattern_match(pEnv env, PatProgram* prog, PatClause* cl,
+                         Index value, Binding* bindings, int* num_bindings)
 {
-    Operator pat_type = nodetype(pattern);
-
-    switch (pat_type) {
-    case USR_: {
-        /* Could be wildcard "_", or a variable name */
-        if (is_wildcard(env, pattern)) {
-            /* Wildcard matches anything, binds nothing */
-            return 1;
-        }
-        /* Variable: matches anything, binds the value */
-        add_binding(env, pattern, value, bindings, num_bindings);
-        return 1;
-    }
-
-    case LIST_: {
-        Index pat_list = nodevalue(pattern).lis;
-
-        /* Empty list pattern matches empty list */
-        if (!pat_list) {
-            if (nodetype(value) != LIST_)
+    int pc, sp = 0, top, num;
+    Index list, cur;
+    PatValue val, *pend;
+    PatInstr* ins;
+
+    pend = pattern_stack(env, cl->stop - cl->start + 1);
+    pend[sp].node = value;
+    pend[sp++].tail = 0;
+    for (pc = cl->start; pc < cl->stop; pc++) {
+        ins = &prog->instr[pc];
+        val = pend[--sp];
+        switch (ins->code) {
+        case PAT_ANY:
+            break;
+
+        case PAT_BIND:
+            bindings[*num_bindings].sym_index = ins->arg;
+            bindings[(*num_bindings)++].value = val;
+            break;
+
+        case PAT_LIT:
+            /* A tail is a list, that only equals a null literal when empty */
+            if (val.tail ? val.node || !is_null(env, ins->lit)
+                         : !same_literal(env, ins->lit, val.node))
                 return 0;
-            return nodevalue(value).lis == 0;
-        }
-
-        /* Check for cons pattern */
-        int colon_pos = find_cons_separator(env, pat_list);
-        if (colon_pos > 0) {
-            return match_cons_pattern(env, pat_list, colon_pos, value,
-                                      bindings, num_bindings);
+            break;
+
+        case PAT_LIST:
+        case PAT_CONS:
+        case PAT_BAD:
+            if (val.tail)
+                list = val.node;
+            else if (nodetype(val.node) != LIST_)
+                return 0;
+            else
+                list = nodevalue(val.node).lis;
+            /* Cons patterns need a non-empty list */
+            if (ins->code != PAT_LIST && !list)
+                return 0;
+            if (ins->code == PAT_BAD) {
+                execerror(env, "match",
+                          "cons pattern requires exactly one tail pattern after :");
+                return 0;
+            }
+            for (num = 0, cur = list; num < ins->arg && cur; num++)
+                cur = nextnode1(cur);
+            if (num < ins->arg || (ins->code == PAT_LIST && cur))
+                return 0;
+            /* The first member is matched first, the tail last */
+            top = sp;
+            if (ins->code == PAT_CONS) {
+                pend[sp].node = cur;
+                pend[sp].tail = 1;
+                top++;
+            }
+            for (num = ins->arg, cur = list; num > 0; cur = nextnode1(cur)) {
+                pend[top + --num].node = cur;
+                pend[top + num].tail = 0;
+            }
+            sp = top + ins->arg;
+            break;
+
+        default:
+            return 0;
         }
-
-        /* Exact list pattern */
-        return match_exact_list(env, pat_list, value, bindings, num_bindings);
-    }
-
-    /* Literals: match by equality */
-    case INTEGER_:
-    case FLOAT_:
-    case STRING_:
-    case CHAR_:
-    case BOOLEAN_:
-    case SET_:
-        return Compare(env, pattern, value) == 0;
-
-    default:
-        /* Unsupported pattern type */
-        return 0;
     }
+    return 1;
 }
 
 /*
- * Apply bindings to symbol table
+ * Number of nodes needed to bind the values
  */
-static void apply_bindings(pEnv env, Binding* bindings, int num_bindings)
+static int binding_size(pEnv env, Binding* bindings, int num_bindings)
 {
-    for (int i = 0; i < num_bindings; i++) {
-        Entry ent = bindings[i].saved_entry;
-        ent.is_user = 1;
-        ent.u.body = newnode2(env, bindings[i].value, 0);
-        vec_at(env->symtab, bindings[i].sym_index) = ent;
-    }
+    int i, size = 0;
+
+    for (i = 0; i < num_bindings; i++)
+        size += bindings[i].value.tail ? 1
+                                       : nodesize(env, bindings[i].value.node);
+    return size;
 }
 
 /*
- * Restore original symbol table entries
+ * Apply bindings to symbol table; capacity must have been reserved
  */
-static void restore_bindings(pEnv env, Binding* bindings, int num_bindings)
+static void apply_bindings(pEnv env, Binding* bindings, int num_bindings)
 {
+    Index body;
+
     for (int i = 0; i < num_bindings; i++) {
-        vec_at(env->symtab, bindings[i].sym_index) = bindings[i].saved_entry;
+        if (bindings[i].value.tail)
+            body = LIST_NEWNODE(bindings[i].value.node, 0);
+        else
+            body = newnode2(env, bindings[i].value.node, 0);
+        pattern_bind(env, bindings[i].sym_index, body);
     }
 }
 
@@ -273,9 +424,10 @@ Example: [1 2 3] [[h : t]] [h] match  =>  1
 */
 void match_(pEnv env)
 {
-    Index pattern, action, value;
+    Index pattern, action;
     Binding bindings[MAX_BINDINGS];
-    int num_bindings = 0;
+    int num_bindings = 0, depth, size, result;
+    PatProgram* prog;
 
     THREEPARAMS("match");
     TWOQUOTES("match");
@@ -283,30 +435,89 @@ void match_(pEnv env)
     /* Get action and pattern quotations */
     action = nodevalue(env->stck).lis;
     pattern = nodevalue(nextnode1(env->stck)).lis;
-    value = nextnode2(env->stck);
-    env->stck = nextnode3(env->stck);
 
     /* Empty pattern matches anything */
     if (!pattern) {
+        env->stck = nextnode3(env->stck);
         exec_term(env, action);
         return;
     }
 
-    /* Pattern should be a single element for matching */
-    Index pat = pattern;
+    /* Compile the pattern, once */
+    if ((prog = pattern_lookup(env, pattern, 1)) == 0)
+        prog = pattern_insert(env, compile_match(env, pattern));
+    if (prog->clause[0].error)
+        execerror(env, "match", prog->clause[0].error);
 
     /* Attempt pattern match */
-    if (pattern_match(env, pat, value, bindings, &num_bindings)) {
+    result = pattern_match(env, prog, &prog->clause[0], nextnode2(env->stck),
+                           bindings, &num_bindings);
+    if (result) {
+        /* A collection moves the value: match again */
+        size = binding_size(env, bindings, num_bindings);
+        if (env->memoryindex + size >= env->memorymax) {
+            ensure_capacity(env, size);
+            num_bindings = 0;
+            pattern_match(env, prog, &prog->clause[0], nextnode2(env->stck),
+                          bindings, &num_bindings);
+        }
+        action = nodevalue(env->stck).lis;
+    }
+    env->stck = nextnode3(env->stck);
+    if (result) {
         /* Match succeeded: apply bindings, execute action, restore */
+        depth = pattern_depth(env);
         apply_bindings(env, bindings, num_bindings);
         exec_term(env, action);
-        restore_bindings(env, bindings, num_bindings);
+        pattern_unbind(env, depth);
     } else {
         /* Match failed: push false */
         NULLARY(BOOLEAN_NEWNODE, 0);
     }
 }
 
+/*
+ * Locate the first clause of cases that matches value, or return -1
+ */
+static int cases_match(pEnv env, PatProgram* prog, Index value,
+                       Binding* bindings, int* num_bindings)
+{
+    int i, lo, hi, mid;
+    PatClause* cl;
+
+    for (i = 0; i < prog->clauses; i++) {
+        cl = &prog->clause[i];
+        if (cl->error)
+            execerror(env, "cases", cl->error);
+
+        /* Runs of integer literals: binary search */
+        if (cl->run && nodetype(value) == INTEGER_) {
+            lo = cl->jump;
+            hi = cl->jump + cl->run;
+            while (lo < hi) {
+                mid = (lo + hi) / 2;
+                if (prog->jump[mid].num < nodevalue(value).num)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if (lo < cl->jump + cl->run
+                && prog->jump[lo].num == nodevalue(value).num) {
+                *num_bindings = 0;
+                return prog->jump[lo].clause;
+            }
+            i += cl->run - 1;
+            continue;
+        }
+
+        /* Reset bindings for this attempt */
+        *num_bindings = 0;
+        if (pattern_match(env, prog, cl, value, bindings, num_bindings))
+            return i;
+    }
+    return -1;
+}
+
 /**
 Q2  OK  2396  cases  :  X [[pat1] [act1]] [[pat2] [act2]] ...  ->  result
 Multi-pattern dispatch combinator. Tries each pattern in order against X.
@@ -322,62 +533,41 @@ Example:
 */
 void cases_(pEnv env)
 {
-    Index cases_list, value, cur;
+    Index cases_list, action;
     Binding bindings[MAX_BINDINGS];
-    int num_bindings;
+    int num_bindings = 0, depth, size, i;
+    PatProgram* prog;
 
     TWOPARAMS("cases");
     ONEQUOTE("cases");
 
-    /* Get cases list */
+    /* Compile the cases list, once */
     cases_list = nodevalue(env->stck).lis;
-    value = nextnode1(env->stck);
-    env->stck = nextnode2(env->stck);
+    if ((prog = pattern_lookup(env, cases_list, 0)) == 0)
+        prog = pattern_insert(env, compile_cases(env, cases_list));
 
     /* Try each case */
-    for (cur = cases_list; cur; cur = nextnode1(cur)) {
-        Index case_pair;
-        Index pattern, action;
-
-        /* Each case should be a list [pattern action] */
-        if (nodetype(cur) != LIST_) {
-            execerror(env, "cases", "each case must be a quotation");
-            return;
-        }
-
-        case_pair = nodevalue(cur).lis;
-        if (!case_pair || nodetype(case_pair) != LIST_) {
-            execerror(env, "cases", "case must be [[pattern] [action]]");
-            return;
-        }
-
-        /* Get pattern and action */
-        pattern = nodevalue(case_pair).lis;
-        if (!nextnode1(case_pair) || nodetype(nextnode1(case_pair)) != LIST_) {
-            execerror(env, "cases", "case must have [pattern] and [action]");
-            return;
-        }
-        action = nodevalue(nextnode1(case_pair)).lis;
+    i = cases_match(env, prog, nextnode1(env->stck), bindings, &num_bindings);
+    if (i < 0) {
+        /* No pattern matched */
+        execerror(env, "cases", "no matching pattern");
+        return;
+    }
 
-        /* Reset bindings for this attempt */
+    /* A collection moves the value: match again */
+    size = binding_size(env, bindings, num_bindings);
+    if (env->memoryindex + size >= env->memorymax) {
+        ensure_capacity(env, size);
         num_bindings = 0;
-
-        /* Empty pattern matches anything */
-        if (!pattern) {
-            exec_term(env, action);
-            return;
-        }
-
-        /* Attempt pattern match */
-        if (pattern_match(env, pattern, value, bindings, &num_bindings)) {
-            /* Match succeeded */
-            apply_bindings(env, bindings, num_bindings);
-            exec_term(env, action);
-            restore_bindings(env, bindings, num_bindings);
-            return;
-        }
+        pattern_match(env, prog, &prog->clause[i], nextnode1(env->stck),
+                      bindings, &num_bindings);
     }
+    action = prog->clause[i].action;
+    env->stck = nextnode2(env->stck);
 
-    /* No pattern matched */
-    execerror(env, "cases", "no matching pattern");
+    /* Match succeeded */
+    depth = pattern_depth(env);
+    apply_bindings(env, bindings, num_bindings);
+    exec_term(env, action);
+    pattern_unbind(env, depth);
 }
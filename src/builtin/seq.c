@@ -0,0 +1,323 @@
+/*
+ *  module  : seq.c
+ *  version : 1.2
+ *  date    : 10/18/26
+ *
+ *  Lazy sequences: cycle, force, iterate, range, repeatseq, seq?, takewhile
+ *
+ *  A sequence is a SEQ_ node. Its state is a list that starts with the kind
+ *  of sequence (see globals.h), followed by the parameters of that kind.
+ *  States are never modified: seq_uncons computes the first member and a
+ *  new state for the rest, so sequences are values like lists are.
+ *  first, rest, uncons, null, size, take, map, filter, step and fold accept
+ *  sequences as well; map, filter and take return sequences.
+ */
+#include "globals.h"
+
+/*
+ * Parameter i of the state of sequence q.
+ */
+static Index seq_item(pEnv env, Index q, int i)
+{
+    for (q = nextnode1(nodevalue(q).lis); i > 0; i--)
+        q = nextnode1(q);
+    return q;
+}
+
+/*
+ * seq_make - replace the top num members of the stack by a sequence of
+ *	      kind, with these members as parameters, the deepest first.
+ */
+void seq_make(pEnv env, int kind, int num)
+{
+    int i, need = 2;
+    Index n, list = 0;
+
+    for (i = 0, n = env->stck; i < num; i++, n = nextnode1(n))
+        need += nodesize(env, n);
+    ensure_capacity(env, need); /* no gc below */
+    for (i = 0, n = env->stck; i < num; i++, n = nextnode1(n))
+        list = newnode2(env, n, list);
+    list = INTEGER_NEWNODE(kind, list);
+    env->stck = SEQ_NEWNODE(list, n);
+}
+
+/*
+ * Check that a quotation of a sequence left a value on the stack.
+ */
+static void seq_value(pEnv env)
+{
+    if (!env->stck)
+        execerror(env, "non-empty stack", "seq");
+}
+
+/*
+ * seq_uncons - replace the sequence on top of the stack by its first member
+ *		and the sequence of the remaining members, and return 1; or
+ *		remove it and return 0, if there are no members. Quotations
+ *		are executed with the stack below the sequence.
+ */
+int seq_uncons(pEnv env)
+{
+    int result = 0;
+    int64_t i, j;
+
+    if (!nodevalue(env->stck).lis) {
+        POP(env->stck);
+        return 0;
+    }
+    SAVESTACK;
+    switch (nodevalue(nodevalue(SAVED1).lis).num) {
+    case SEQ_ITERATE:
+        env->stck = newnode2(env, seq_item(env, SAVED1, 0), SAVED2);
+        if (nodevalue(seq_item(env, SAVED1, 2)).num) { /* x was the last */
+            exec_term(env, nodevalue(seq_item(env, SAVED1, 1)).lis);
+            seq_value(env);
+            env->stck = newnode2(env, env->stck, SAVED2);
+        }
+        GNULLARY(env->stck);
+        GNULLARY(seq_item(env, SAVED1, 1));
+        NULLARY(BOOLEAN_NEWNODE, 1);
+        seq_make(env, SEQ_ITERATE, 3);
+        result = 1;
+        break;
+    case SEQ_RANGE:
+        i = nodevalue(seq_item(env, SAVED1, 0)).num;
+        j = nodevalue(seq_item(env, SAVED1, 1)).num;
+        if (i > j)
+            break;
+        env->stck = INTEGER_NEWNODE(i, SAVED2);
+        NULLARY(INTEGER_NEWNODE, i < j ? i + 1 : 1); /* empty after j, */
+        NULLARY(INTEGER_NEWNODE, i < j ? j : 0);     /* also at INT64_MAX */
+        seq_make(env, SEQ_RANGE, 2);
+        result = 1;
+        break;
+    case SEQ_REPEAT:
+        env->stck = newnode2(env, seq_item(env, SAVED1, 0), SAVED2);
+        GNULLARY(SAVED1); /* the rest is the same sequence */
+        result = 1;
+        break;
+    case SEQ_CYCLE:
+        if (!nodevalue(seq_item(env, SAVED1, 0)).lis) {
+            if (!nodevalue(seq_item(env, SAVED1, 1)).lis)
+                break;
+            env->stck = newnode2(env, seq_item(env, SAVED1, 1), SAVED2);
+        } else
+            env->stck = newnode2(env, seq_item(env, SAVED1, 0), SAVED2);
+        env->dump1 = LIST_NEWNODE(nodevalue(env->stck).lis, env->dump1);
+        env->stck = newnode2(env, DMP1, nextnode1(env->stck));
+        NULLARY(LIST_NEWNODE, nextnode1(DMP1));
+        GNULLARY(seq_item(env, SAVED1, 1));
+        seq_make(env, SEQ_CYCLE, 2);
+        POP(env->dump1);
+        result = 1;
+        break;
+    case SEQ_MAP:
+        env->stck = newnode2(env, seq_item(env, SAVED1, 0), SAVED2);
+        if (!seq_uncons(env))
+            break;
+        env->dump1 = LIST_NEWNODE(env->stck, env->dump1);
+        POP(env->stck);
+        exec_term(env, nodevalue(seq_item(env, SAVED1, 1)).lis);
+        seq_value(env);
+        env->stck = newnode2(env, env->stck, SAVED2);
+        GNULLARY(DMP1);
+        GNULLARY(seq_item(env, SAVED1, 1));
+        seq_make(env, SEQ_MAP, 2);
+        POP(env->dump1);
+        result = 1;
+        break;
+    case SEQ_FILTER:
+        env->dump1 = LIST_NEWNODE(seq_item(env, SAVED1, 0), env->dump1);
+        env->dump2 = LIST_NEWNODE(0, env->dump2);
+        for (;;) {
+            env->stck = newnode2(env, DMP1, SAVED2);
+            if (!seq_uncons(env))
+                break;
+            DMP1 = env->stck;
+            DMP2 = env->stck = nextnode1(env->stck);
+            exec_term(env, nodevalue(seq_item(env, SAVED1, 1)).lis);
+            seq_value(env);
+            if (get_boolean(env, env->stck)) {
+                env->stck = DMP2;
+                GNULLARY(DMP1);
+                GNULLARY(seq_item(env, SAVED1, 1));
+                seq_make(env, SEQ_FILTER, 2);
+                result = 1;
+                break;
+            }
+        }
+        POP(env->dump2);
+        POP(env->dump1);
+        break;
+    case SEQ_TAKE:
+        if (nodevalue(seq_item(env, SAVED1, 0)).num <= 0)
+            break;
+        env->stck = newnode2(env, seq_item(env, SAVED1, 1), SAVED2);
+        if (!seq_uncons(env))
+            break;
+        env->dump1 = LIST_NEWNODE(env->stck, env->dump1);
+        POP(env->stck);
+        NULLARY(INTEGER_NEWNODE, nodevalue(seq_item(env, SAVED1, 0)).num - 1);
+        GNULLARY(DMP1);
+        seq_make(env, SEQ_TAKE, 2);
+        POP(env->dump1);
+        result = 1;
+        break;
+    case SEQ_TAKEWHILE:
+        env->stck = newnode2(env, seq_item(env, SAVED1, 0), SAVED2);
+        if (!seq_uncons(env))
+            break;
+        env->dump1 = LIST_NEWNODE(env->stck, env->dump1);
+        env->dump2 = LIST_NEWNODE(nextnode1(env->stck), env->dump2);
+        env->stck = DMP2;
+        exec_term(env, nodevalue(seq_item(env, SAVED1, 1)).lis);
+        seq_value(env);
+        if ((result = get_boolean(env, env->stck)) != 0) {
+            env->stck = DMP2;
+            GNULLARY(DMP1);
+            GNULLARY(seq_item(env, SAVED1, 1));
+            seq_make(env, SEQ_TAKEWHILE, 2);
+        }
+        POP(env->dump2);
+        POP(env->dump1);
+        break;
+    }
+    if (!result)
+        env->stck = SAVED2;
+    POP(env->dump);
+    return result;
+}
+
+/**
+Q0  OK  2895  cycle  :  L  ->  S
+S is the sequence of the members of list L, repeated without end.
+*/
+void cycle_(pEnv env)
+{
+    ONEPARAM("cycle");
+    LIST("cycle");
+    GNULLARY(env->stck);
+    seq_make(env, SEQ_CYCLE, 2);
+}
+
+/**
+Q0  OK  2897  force  :  S  ->  L
+L is the list of the members of the finite sequence S.
+*/
+void force_(pEnv env)
+{
+    Index temp;
+
+    ONEPARAM("force");
+    SEQUENCE("force");
+    SAVESTACK;
+    env->dump1 = LIST_NEWNODE(SAVED1, env->dump1); /* sequence */
+    env->dump2 = LIST_NEWNODE(0, env->dump2);      /* head new */
+    env->dump3 = LIST_NEWNODE(0, env->dump3);      /* last new */
+    for (;;) {
+        env->stck = newnode2(env, DMP1, SAVED2);
+        if (!seq_uncons(env))
+            break;
+        DMP1 = env->stck;
+        temp = newnode2(env, nextnode1(env->stck), 0);
+        if (!DMP2) { /* first */
+            DMP2 = temp;
+            DMP3 = DMP2;
+        } else { /* further */
+            nextnode1(DMP3) = temp;
+            DMP3 = nextnode1(DMP3);
+        }
+    }
+    env->stck = LIST_NEWNODE(DMP2, SAVED2);
+    POP(env->dump3);
+    POP(env->dump2);
+    POP(env->dump1);
+    POP(env->dump);
+}
+
+/**
+Q1  OK  2892  iterate  :  X [P]  ->  S
+S is the sequence X, X', X'', ..., where each member is computed by
+executing P on the previous one, when it is needed.
+*/
+void iterate_(pEnv env)
+{
+    TWOPARAMS("iterate");
+    ONEQUOTE("iterate");
+    NULLARY(BOOLEAN_NEWNODE, 0);
+    seq_make(env, SEQ_ITERATE, 3);
+}
+
+/**
+Q0  OK  2893  range  :  I J  ->  S
+S is the sequence of integers from I to J inclusive.
+*/
+void range_(pEnv env)
+{
+    TWOPARAMS("range");
+    INTEGERS2("range");
+    seq_make(env, SEQ_RANGE, 2);
+}
+
+/**
+Q0  OK  2894  repeatseq  :  X  ->  S
+S is the sequence X, X, X, ... without end.
+*/
+void repeatseq_(pEnv env)
+{
+    ONEPARAM("repeatseq");
+    seq_make(env, SEQ_REPEAT, 1);
+}
+
+/**
+Q0  OK  2891  seq?\0seq_p  :  X  ->  B
+Tests whether X is a sequence.
+*/
+void seq_p_(pEnv env)
+{
+    ONEPARAM("seq?");
+    UNARY(BOOLEAN_NEWNODE, nodetype(env->stck) == SEQ_);
+}
+
+/**
+Q1  OK  2896  takewhile  :  A [B]  ->  A1
+A1 is the longest prefix of list or sequence A whose members satisfy B.
+For a sequence, A1 is a sequence that tests the members when needed.
+*/
+void takewhile_(pEnv env)
+{
+    Index temp;
+
+    TWOPARAMS("takewhile");
+    ONEQUOTE("takewhile");
+    if (nodetype(nextnode1(env->stck)) == SEQ_) {
+        seq_make(env, SEQ_TAKEWHILE, 2);
+        return;
+    }
+    LIST2("takewhile");
+    SAVESTACK;
+    env->dump1 = LIST_NEWNODE(nodevalue(SAVED2).lis, env->dump1);
+    env->dump2 = LIST_NEWNODE(0, env->dump2); /* head new */
+    env->dump3 = LIST_NEWNODE(0, env->dump3); /* last new */
+    for (; DMP1; DMP1 = nextnode1(DMP1)) {
+        env->stck = newnode2(env, DMP1, SAVED3);
+        exec_term(env, nodevalue(SAVED1).lis);
+        CHECKSTACK("takewhile");
+        if (!get_boolean(env, env->stck))
+            break;
+        temp = newnode2(env, DMP1, 0);
+        if (!DMP2) { /* first */
+            DMP2 = temp;
+            DMP3 = DMP2;
+        } else { /* further */
+            nextnode1(DMP3) = temp;
+            DMP3 = nextnode1(DMP3);
+        }
+    }
+    env->stck = LIST_NEWNODE(DMP2, SAVED3);
+    POP(env->dump3);
+    POP(env->dump2);
+    POP(env->dump1);
+    POP(env->dump);
+}
@@ -1,7 +1,7 @@
 /*
  *  module  : session.c
- *  version : 1.0
- *  date    : 01/24/26
+ *  version : 1.2
+ *  date    : 10/18/26
  *
  *  Persistent session operations for Joy using SQLite.
  *  Guarded by JOY_SESSION compile-time option.
@@ -50,6 +50,7 @@ static Index deserialize_value(pEnv env, const char* str);
 static void session_close_internal(pEnv env);
 static void invalidate_cache(Session* s, const char* name);
 static Index reverse_list(pEnv env, Index head);
+static void push_names(pEnv env, sqlite3_stmt* stmt);
 
 /* Helper: initialize schema */
 static void ensure_schema(Session* s)
@@ -159,6 +160,38 @@ static Index reverse_list(pEnv env, Index head)
     return prev;
 }
 
+/* Helper: prepend the first column of each row to the list on the stack */
+static void push_names(pEnv env, sqlite3_stmt* stmt)
+{
+    Index p;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        p = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, 0)),
+                           nodevalue(env->stck).lis);
+        nodevalue(env->stck).lis = p;
+    }
+    sqlite3_finalize(stmt);
+}
+
+#ifdef NOBDW
+/* Helper: the nodes that newnode takes for column c of the current row */
+static int column_nodes(sqlite3_stmt* stmt, int c)
+{
+    int num = 1, size;
+
+    switch (sqlite3_column_type(stmt, c)) {
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+        sqlite3_column_text(stmt, c); /* the size of the text */
+        size = sqlite3_column_bytes(stmt, c) + 1;
+        if ((size -= sizeof(Types)) > 0) /* first part in Types */
+            num += (size + sizeof(Node) - 1) / sizeof(Node);
+        break;
+    }
+    return num;
+}
+#endif
+
 /* Helper: close session internals */
 static void session_close_internal(pEnv env)
 {
@@ -604,7 +637,7 @@ void session_diff_(pEnv env)
     char path[PATH_MAX];
     char* attach_sql;
     sqlite3_stmt* stmt;
-    Index added = 0, modified = 0, removed = 0;
+    Index added, modified, removed;
     khash_t(Dict)* dict;
     khint_t k;
     int ret;
@@ -629,47 +662,53 @@ void session_diff_(pEnv env)
     }
     sqlite3_free(attach_sql);
 
-    /* Added: in other but not in current */
+    /*
+     * The lists are built on the stack, where the collector sees them:
+     * added, in other but not in current; modified, in both but different;
+     * removed, in current but not in other.
+     */
+    NULLARY(LIST_NEWNODE, 0);
     sqlite3_prepare_v2(current->db,
         "SELECT name FROM other.symbols WHERE name NOT IN (SELECT name FROM symbols)",
         -1, &stmt, NULL);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        added = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, 0)), added);
-    }
-    sqlite3_finalize(stmt);
+    push_names(env, stmt);
 
-    /* Modified: in both but different */
+    NULLARY(LIST_NEWNODE, 0);
     sqlite3_prepare_v2(current->db,
         "SELECT o.name FROM other.symbols o "
         "JOIN symbols s ON o.name = s.name WHERE o.body != s.body",
         -1, &stmt, NULL);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        modified = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, 0)), modified);
-    }
-    sqlite3_finalize(stmt);
+    push_names(env, stmt);
 
-    /* Removed: in current but not in other */
+    NULLARY(LIST_NEWNODE, 0);
     sqlite3_prepare_v2(current->db,
         "SELECT name FROM symbols WHERE name NOT IN (SELECT name FROM other.symbols)",
         -1, &stmt, NULL);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        removed = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, 0)), removed);
-    }
-    sqlite3_finalize(stmt);
+    push_names(env, stmt);
 
     sqlite3_exec(current->db, "DETACH DATABASE other", NULL, NULL, NULL);
 
+#ifdef NOBDW
+    ensure_capacity(env, 4); /* the lists stay where they are */
+#endif
+    removed = reverse_list(env, nodevalue(env->stck).lis);
+    POP(env->stck);
+    modified = reverse_list(env, nodevalue(env->stck).lis);
+    POP(env->stck);
+    added = reverse_list(env, nodevalue(env->stck).lis);
+    POP(env->stck);
+
     /* Build result dict */
     dict = kh_init(Dict);
 
-    k = kh_put(Dict, dict, GC_strdup("added"), &ret);
-    kh_val(dict, k) = LIST_NEWNODE(reverse_list(env, added), 0);
+    k = kh_put(Dict, dict, check_strdup("added"), &ret);
+    kh_val(dict, k) = LIST_NEWNODE(added, 0);
 
-    k = kh_put(Dict, dict, GC_strdup("modified"), &ret);
-    kh_val(dict, k) = LIST_NEWNODE(reverse_list(env, modified), 0);
+    k = kh_put(Dict, dict, check_strdup("modified"), &ret);
+    kh_val(dict, k) = LIST_NEWNODE(modified, 0);
 
-    k = kh_put(Dict, dict, GC_strdup("removed"), &ret);
-    kh_val(dict, k) = LIST_NEWNODE(reverse_list(env, removed), 0);
+    k = kh_put(Dict, dict, check_strdup("removed"), &ret);
+    kh_val(dict, k) = LIST_NEWNODE(removed, 0);
 
     NULLARY(DICT_NEWNODE, dict);
 }
@@ -810,13 +849,23 @@ void sql_(pEnv env)
         }
     }
 
-    /* Collect results */
+    /* Collect results, on the stack where the collector sees them */
     col_count = sqlite3_column_count(stmt);
+    NULLARY(LIST_NEWNODE, 0);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        /* Each row becomes a dict */
-        khash_t(Dict)* dict = kh_init(Dict);
+        khash_t(Dict)* dict;
         int c;
+#ifdef NOBDW
+        int num = 1;
+
+        /* The values and the dict, before the table is in a node */
+        for (c = 0; c < col_count; c++)
+            num += column_nodes(stmt, c);
+        ensure_capacity(env, num);
+#endif
+        /* Each row becomes a dict */
+        dict = kh_init(Dict);
 
         for (c = 0; c < col_count; c++) {
             const char* col_name = sqlite3_column_name(stmt, c);
@@ -836,8 +885,8 @@ void sql_(pEnv env)
                 val = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, c)), 0);
                 break;
             case SQLITE_BLOB:
-                /* Treat blob as string for now */
-                val = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_blob(stmt, c)), 0);
+                /* Treat blob as string for now, terminated as text */
+                val = STRING_NEWNODE(GC_strdup((const char*)sqlite3_column_text(stmt, c)), 0);
                 break;
             case SQLITE_NULL:
             default:
@@ -845,16 +894,16 @@ void sql_(pEnv env)
                 break;
             }
 
-            k = kh_put(Dict, dict, GC_strdup(col_name), &ret);
+            k = kh_put(Dict, dict, check_strdup((char*)col_name), &ret);
             kh_val(dict, k) = val;
         }
 
-        results = DICT_NEWNODE(dict, results);
+        results = DICT_NEWNODE(dict, nodevalue(env->stck).lis);
+        nodevalue(env->stck).lis = results;
     }
     sqlite3_finalize(stmt);
 
-    results = reverse_list(env, results);
-    NULLARY(LIST_NEWNODE, results);
+    nodevalue(env->stck).lis = reverse_list(env, nodevalue(env->stck).lis);
 }
 
 #endif /* JOY_SESSION */
@@ -0,0 +1,319 @@
+/*
+ *  module  : sparse.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Native sparse matrices, with compressed rows (CSR) or columns (CSC).
+ *
+ *    Creation: nsparse (from triplets), >csr >csc (from native matrices or
+ *    the other format), ndense, nnz
+ *    Products: nspmv (with a vector), nspmm (with a dense matrix)
+ *    Element-wise: nsp+ nsp- nsp*, nspscale; nsptranspose
+ *
+ *  The matrices are in src/sparse.c. Elements are doubles; zeros are not
+ *  stored, such that memory and time depend on the number of nonzeros. nshape
+ *  gives the dimensions.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+
+/*
+ * The sparse matrix in node p, or 0 after an error.
+ */
+static SparseData* sparse_arg(pEnv env, Index p, char* name)
+{
+    if (nodetype(p) != SPARSE_) {
+        execerror(env, "native sparse matrix", name);
+        return 0;
+    }
+    return nodevalue(p).spm;
+}
+
+/*
+ * The elements of native matrix mat as doubles, with rows *ld apart. They are
+ * the elements of mat, or a copy that the caller frees when it is not mat.
+ */
+static double* sparse_elements(MatrixData* mat, int64_t* ld)
+{
+    double* m;
+    int64_t r, size;
+
+    if (mat->dtype == DT_F64) {
+        *ld = mat->ld;
+        return mat->data;
+    }
+    size = mat->rows * mat->cols;
+    m = check_malloc((size ? size : 1) * sizeof(double));
+    for (r = 0; r < mat->rows; r++)
+        kernel_cast(DT_F64, m + r * mat->cols, mat->dtype,
+                    (char*)mat->data + r * mat->ld * kernel_width(mat->dtype),
+                    mat->cols);
+    *ld = mat->cols;
+    return m;
+}
+
+/*
+ * Convert the native matrix or sparse matrix on top of the stack to format.
+ */
+static void sparse_format(pEnv env, int format, char* name)
+{
+    MatrixData* mat;
+    SparseData* spm;
+    double* m;
+    int64_t ld;
+
+    ONEPARAM(name);
+    if (nodetype(env->stck) == SPARSE_)
+        spm = sparse_convert(env, nodevalue(env->stck).spm, format);
+    else if (nodetype(env->stck) == MATRIX_) {
+        if ((mat = nodevalue(env->stck).mat) == 0)
+            spm = native_sparse(env, 0, 0, 0, format);
+        else {
+            m = sparse_elements(mat, &ld);
+            spm = sparse_dense(env, m, mat->rows, mat->cols, ld, format);
+            if (m != mat->data)
+                free(m);
+        }
+    } else {
+        execerror(env, "native matrix or sparse matrix", name);
+        return;
+    }
+    UNARY(SPARSE_NEWNODE, spm);
+}
+
+/**
+Q0  OK  4310  nsparse  :  R C L  ->  S
+[NATIVE] S is the R x C sparse matrix with compressed rows whose elements are
+given by the triplets [I J X] in list L. Duplicates are added.
+*/
+void nsparse_(pEnv env)
+{
+    Index list, t;
+    int64_t rows, cols, n, k, *ri, *ci;
+    double* x;
+    SparseData* spm;
+
+    THREEPARAMS("nsparse");
+    LIST("nsparse");
+    if (nodetype(nextnode1(env->stck)) != INTEGER_
+        || nodetype(nextnode2(env->stck)) != INTEGER_) {
+        execerror(env, "integer dimensions", "nsparse");
+        return;
+    }
+    rows = nodevalue(nextnode2(env->stck)).num;
+    cols = nodevalue(nextnode1(env->stck)).num;
+    if (rows < 0 || cols < 0) {
+        execerror(env, "non-negative dimensions", "nsparse");
+        return;
+    }
+    for (n = 0, list = nodevalue(env->stck).lis; list; list = nextnode1(list))
+        n++;
+    ri = check_malloc((n ? n : 1) * sizeof(int64_t));
+    ci = check_malloc((n ? n : 1) * sizeof(int64_t));
+    x = check_malloc((n ? n : 1) * sizeof(double));
+    list = nodevalue(env->stck).lis;
+    for (k = 0; k < n; k++, list = nextnode1(list)) {
+        if (nodetype(list) != LIST_ || (t = nodevalue(list).lis) == 0
+            || nodetype(t) != INTEGER_ || !nextnode1(t)
+            || nodetype(nextnode1(t)) != INTEGER_ || !nextnode2(t)
+            || (nodetype(nextnode2(t)) != INTEGER_
+                && nodetype(nextnode2(t)) != FLOAT_)
+            || nextnode3(t))
+            break;
+        ri[k] = nodevalue(t).num;
+        ci[k] = nodevalue(nextnode1(t)).num;
+        t = nextnode2(t);
+        x[k] = nodetype(t) == FLOAT_ ? nodevalue(t).dbl : nodevalue(t).num;
+        if (ri[k] < 0 || ri[k] >= rows || ci[k] < 0 || ci[k] >= cols)
+            break;
+    }
+    if (k < n) {
+        free(ri);
+        free(ci);
+        free(x);
+        execerror(env, "triplets [I J X] within the dimensions", "nsparse");
+        return;
+    }
+    spm = sparse_build(env, rows, cols, n, ri, ci, x, SP_CSR);
+    free(ri);
+    free(ci);
+    free(x);
+    POP(env->stck);
+    BINARY(SPARSE_NEWNODE, spm);
+}
+
+/**
+Q0  OK  4320  >csr\0tocsr  :  X  ->  S
+[NATIVE] S is native matrix or sparse matrix X as a sparse matrix with
+compressed rows, of which only the nonzero elements are stored.
+*/
+void tocsr_(pEnv env) { sparse_format(env, SP_CSR, ">csr"); }
+
+/**
+Q0  OK  4330  >csc\0tocsc  :  X  ->  S
+[NATIVE] S is native matrix or sparse matrix X as a sparse matrix with
+compressed columns, of which only the nonzero elements are stored.
+*/
+void tocsc_(pEnv env) { sparse_format(env, SP_CSC, ">csc"); }
+
+/**
+Q0  OK  4340  ndense  :  S  ->  M
+[NATIVE] M is sparse matrix S as a native matrix, with all its elements.
+*/
+void ndense_(pEnv env)
+{
+    SparseData* spm;
+    MatrixData* mat;
+
+    ONEPARAM("ndense");
+    if ((spm = sparse_arg(env, env->stck, "ndense")) == 0)
+        return;
+    mat = native_matrix(env, DT_F64, spm->rows, spm->cols);
+    sparse_todense(spm, mat->data);
+    UNARY(MATRIX_NEWNODE, mat);
+}
+
+/**
+Q0  OK  4350  nnz  :  S  ->  I
+[NATIVE] I is the number of nonzero elements of sparse matrix S.
+*/
+void nnz_(pEnv env)
+{
+    SparseData* spm;
+
+    ONEPARAM("nnz");
+    if ((spm = sparse_arg(env, env->stck, "nnz")) == 0)
+        return;
+    UNARY(INTEGER_NEWNODE, spm->nnz);
+}
+
+/**
+Q0  OK  4360  nspmv  :  S V  ->  V2
+[NATIVE] V2 is the product of R x C sparse matrix S and native vector V of C
+elements. With compressed rows, the rows are computed in parallel.
+*/
+void nspmv_(pEnv env)
+{
+    SparseData* spm;
+    VectorData *vec, *res;
+    double* x;
+
+    TWOPARAMS("nspmv");
+    if ((spm = sparse_arg(env, nextnode1(env->stck), "nspmv")) == 0)
+        return;
+    if (nodetype(env->stck) != VECTOR_ || !nodevalue(env->stck).vec
+        || nodevalue(env->stck).vec->len != spm->cols) {
+        execerror(env, "native vector of as many elements as columns", "nspmv");
+        return;
+    }
+    vec = nodevalue(env->stck).vec;
+    res = native_vector(env, DT_F64, spm->rows);
+    if (vec->dtype == DT_F64 && vec->inc == 1)
+        x = vector_force(vec);
+    else {
+        x = check_malloc((vec->len ? vec->len : 1) * sizeof(double));
+        vector_cast(DT_F64, x, vec);
+    }
+    sparse_spmv(spm, x, res->data);
+    if (x != vec->data)
+        free(x);
+    BINARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4370  nspmm  :  S M  ->  M2
+[NATIVE] M2 is the product of R x C sparse matrix S and native matrix M of C
+rows. With compressed rows, the rows are computed in parallel.
+*/
+void nspmm_(pEnv env)
+{
+    SparseData* spm;
+    MatrixData *mat, *res;
+    double* b;
+    int64_t ld;
+
+    TWOPARAMS("nspmm");
+    if ((spm = sparse_arg(env, nextnode1(env->stck), "nspmm")) == 0)
+        return;
+    if (nodetype(env->stck) != MATRIX_ || !nodevalue(env->stck).mat
+        || nodevalue(env->stck).mat->rows != spm->cols) {
+        execerror(env, "native matrix of as many rows as columns", "nspmm");
+        return;
+    }
+    mat = nodevalue(env->stck).mat;
+    res = native_matrix(env, DT_F64, spm->rows, mat->cols);
+    b = sparse_elements(mat, &ld);
+    sparse_spmm(spm, b, ld, mat->cols, res->data);
+    if (b != mat->data)
+        free(b);
+    BINARY(MATRIX_NEWNODE, res);
+}
+
+/**
+Q0  OK  4380  nsptranspose  :  S  ->  S2
+[NATIVE] S2 is the transpose of sparse matrix S, in the same format.
+*/
+void nsptranspose_(pEnv env)
+{
+    SparseData* spm;
+
+    ONEPARAM("nsptranspose");
+    if ((spm = sparse_arg(env, env->stck, "nsptranspose")) == 0)
+        return;
+    UNARY(SPARSE_NEWNODE, sparse_transpose(env, spm));
+}
+
+/*
+ * S1 op S2, element by element, for sparse matrices of the same dimensions.
+ */
+static void sparse_binary(pEnv env, int op, char* name)
+{
+    SparseData *a, *b;
+
+    TWOPARAMS(name);
+    if ((a = sparse_arg(env, nextnode1(env->stck), name)) == 0
+        || (b = sparse_arg(env, env->stck, name)) == 0)
+        return;
+    if (a->rows != b->rows || a->cols != b->cols) {
+        execerror(env, "sparse matrices of the same dimensions", name);
+        return;
+    }
+    BINARY(SPARSE_NEWNODE, sparse_combine(env, op, a, b));
+}
+
+/**
+Q0  OK  4390  nsp+\0nspplus  :  S1 S2  ->  S3
+[NATIVE] S3 is the sum of sparse matrices S1 and S2, in the format of S1.
+*/
+void nspplus_(pEnv env) { sparse_binary(env, NK_ADD, "nsp+"); }
+
+/**
+Q0  OK  4400  nsp-\0nspminus  :  S1 S2  ->  S3
+[NATIVE] S3 is the difference of sparse matrices S1 and S2, in the format of
+S1.
+*/
+void nspminus_(pEnv env) { sparse_binary(env, NK_SUB, "nsp-"); }
+
+/**
+Q0  OK  4410  nsp*\0nspmul  :  S1 S2  ->  S3
+[NATIVE] S3 is the element-wise product of sparse matrices S1 and S2, in the
+format of S1.
+*/
+void nspmul_(pEnv env) { sparse_binary(env, NK_MUL, "nsp*"); }
+
+/**
+Q0  OK  4420  nspscale  :  S N  ->  S2
+[NATIVE] S2 is sparse matrix S with each element multiplied by number N.
+*/
+void nspscale_(pEnv env)
+{
+    SparseData* spm;
+
+    TWOPARAMS("nspscale");
+    FLOAT("nspscale");
+    if ((spm = sparse_arg(env, nextnode1(env->stck), "nspscale")) == 0)
+        return;
+    BINARY(SPARSE_NEWNODE, sparse_scale(env, spm, FLOATVAL));
+}
+#endif /* JOY_NATIVE_TYPES */
@@ -0,0 +1,338 @@
+/*
+ *  module  : stats.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Statistics of native vectors: nsort nargsort nquantile nhist ncumsum
+ *  nunique nrollsum nrollmean nrollmax.
+ *
+ *  The kernels are in src/stats.c and work on adjacent elements: the
+ *  elements of a view or a deferred vector are gathered first. Sorting puts
+ *  NaNs last; a quantile is found by selection, without sorting all
+ *  elements.
+ */
+#include "globals.h"
+
+#ifdef JOY_NATIVE_TYPES
+
+/*
+ * The native vector in node p, or 0 after an error. An empty vector without
+ * elements is given as empty.
+ */
+static VectorData* stats_vector(pEnv env, Index p, VectorData* empty,
+                                char* name)
+{
+    if (nodetype(p) != VECTOR_) {
+        execerror(env, "native vector", name);
+        return 0;
+    }
+    if (nodevalue(p).vec)
+        return nodevalue(p).vec;
+    memset(empty, 0, sizeof(VectorData));
+    empty->dtype = DT_F64;
+    empty->kind = VX_NONE;
+    empty->inc = 1;
+    return empty;
+}
+
+/*
+ * The elements of vector vec, adjacent: its own, or a copy that the caller
+ * frees when it is not vec->data.
+ */
+static void* stats_elements(VectorData* vec)
+{
+    void* a;
+
+    if (vec->inc == 1)
+        return vector_force(vec);
+    a = check_malloc((vec->len ? vec->len : 1) * kernel_width(vec->dtype));
+    vector_cast(vec->dtype, a, vec);
+    return a;
+}
+
+/*
+ * A copy of vector vec, with adjacent elements, to be reordered.
+ */
+static VectorData* stats_copy(pEnv env, VectorData* vec)
+{
+    VectorData* res;
+
+    res = native_vector(env, vec->dtype, vec->len);
+    vector_cast(vec->dtype, res->data, vec);
+    return res;
+}
+
+/**
+Q0  OK  4470  nsort  :  V  ->  V2
+[NATIVE] V2 has the elements of native vector V in increasing order, with
+NaNs last.
+*/
+void nsort_(pEnv env)
+{
+    VectorData empty, *vec, *res;
+
+    ONEPARAM("nsort");
+    if ((vec = stats_vector(env, env->stck, &empty, "nsort")) == 0)
+        return;
+    res = stats_copy(env, vec);
+    stats_sort(res->dtype, res->data, res->len);
+    UNARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4480  nargsort  :  V  ->  V2
+[NATIVE] V2 has the positions of the elements of native vector V in
+increasing order of the elements, as int64. Equal elements keep their order.
+*/
+void nargsort_(pEnv env)
+{
+    void* a;
+    VectorData empty, *vec, *res;
+
+    ONEPARAM("nargsort");
+    if ((vec = stats_vector(env, env->stck, &empty, "nargsort")) == 0)
+        return;
+    res = native_vector(env, DT_I64, vec->len);
+    a = stats_elements(vec);
+    stats_argsort(vec->dtype, a, res->data, vec->len);
+    if (a != vec->data)
+        free(a);
+    UNARY(VECTOR_NEWNODE, res);
+}
+
+/*
+ * Quantile q of the n elements of a, with linear interpolation between the
+ * elements below and above it. The elements are reordered.
+ */
+static double stats_quantile(int dtype, char* a, int64_t n, double q)
+{
+    int64_t k;
+    double x, y, pos;
+
+    pos = q * (n - 1);
+    k = (int64_t)pos;
+    x = stats_select(dtype, a, n, k);
+    if (pos == k)
+        return x;
+    y = stats_select(dtype, a + (k + 1) * kernel_width(dtype), n - k - 1, 0);
+    return x + (pos - k) * (y - x);
+}
+
+/**
+Q0  OK  4490  nquantile  :  V Q  ->  N
+[NATIVE] N is quantile Q, between 0 and 1, of the elements of native vector
+V, interpolating between elements; 0.5 gives the median. Q can also be a
+native vector of quantiles, that gives a vector. N is NaN if V has NaNs.
+*/
+void nquantile_(pEnv env)
+{
+    char* a;
+    double* q;
+    int64_t i, nq;
+    int nan = 0;
+    VectorData empty, *vec, *qs = 0, *res = 0;
+
+    TWOPARAMS("nquantile");
+    if ((vec = stats_vector(env, nextnode1(env->stck), &empty, "nquantile"))
+        == 0)
+        return;
+    if (!vec->len) {
+        execerror(env, "non-empty native vector", "nquantile");
+        return;
+    }
+    if (nodetype(env->stck) == VECTOR_ && nodevalue(env->stck).vec) {
+        qs = nodevalue(env->stck).vec;
+        nq = qs->len;
+        q = check_malloc((nq ? nq : 1) * sizeof(double));
+        vector_cast(DT_F64, q, qs);
+    } else {
+        FLOAT("nquantile");
+        nq = 1;
+        q = check_malloc(sizeof(double));
+        q[0] = FLOATVAL;
+    }
+    for (i = 0; i < nq; i++)
+        if (!(q[i] >= 0 && q[i] <= 1)) {
+            free(q);
+            execerror(env, "quantiles between 0 and 1", "nquantile");
+            return;
+        }
+    a = check_malloc(vec->len * kernel_width(vec->dtype));
+    vector_cast(vec->dtype, a, vec);
+    if (vec->dtype == DT_F64 || vec->dtype == DT_F32)
+        for (i = 0; i < vec->len && !nan; i++)
+            nan = isnan(kernel_get(vec->dtype, a, i));
+    if (qs)
+        res = native_vector(env, DT_F64, nq);
+    for (i = 0; i < nq; i++) {
+        q[i] = nan ? NAN : stats_quantile(vec->dtype, a, vec->len, q[i]);
+        if (res)
+            ((double*)res->data)[i] = q[i];
+    }
+    free(a);
+    if (res)
+        BINARY(VECTOR_NEWNODE, res);
+    else
+        BINARY(FLOAT_NEWNODE, q[0]);
+    free(q);
+}
+
+/**
+Q0  OK  4500  nhist  :  V B  ->  V2
+[NATIVE] V2 has the number of elements of native vector V in each bin, as
+int64. B is the number of bins, of equal width over the range of V, or a
+native vector of the increasing edges of the bins. A bin includes its lower
+edge, and the last also its upper edge; other elements are not counted.
+*/
+void nhist_(pEnv env)
+{
+    void* a;
+    double* edges = 0;
+    int64_t i, bins;
+    VectorData empty, *vec, *res, *e;
+
+    TWOPARAMS("nhist");
+    if ((vec = stats_vector(env, nextnode1(env->stck), &empty, "nhist")) == 0)
+        return;
+    if (nodetype(env->stck) == INTEGER_) {
+        if ((bins = nodevalue(env->stck).num) < 1) {
+            execerror(env, "positive number of bins", "nhist");
+            return;
+        }
+    } else if (nodetype(env->stck) == VECTOR_ && (e = nodevalue(env->stck).vec)
+               && e->len > 1) {
+        bins = e->len - 1;
+        edges = check_malloc(e->len * sizeof(double));
+        vector_cast(DT_F64, edges, e);
+        for (i = 0; i < bins; i++)
+            if (!(edges[i] < edges[i + 1])) {
+                free(edges);
+                execerror(env, "increasing edges", "nhist");
+                return;
+            }
+    } else {
+        execerror(env, "number of bins or native vector of edges", "nhist");
+        return;
+    }
+    res = native_vector(env, DT_I64, bins);
+    a = stats_elements(vec);
+    stats_hist(vec->dtype, a, vec->len, edges, bins, res->data);
+    if (a != vec->data)
+        free(a);
+    free(edges);
+    BINARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4510  ncumsum  :  V  ->  V2
+[NATIVE] V2 has the running sums of the elements of native vector V: float64
+for float elements, and int64 for integer elements.
+*/
+void ncumsum_(pEnv env)
+{
+    void* a;
+    int dtype;
+    VectorData empty, *vec, *res;
+
+    ONEPARAM("ncumsum");
+    if ((vec = stats_vector(env, env->stck, &empty, "ncumsum")) == 0)
+        return;
+    dtype = vec->dtype == DT_F64 || vec->dtype == DT_F32 ? DT_F64 : DT_I64;
+    res = native_vector(env, dtype, vec->len);
+    a = stats_elements(vec);
+    stats_cumsum(vec->dtype, res->data, a, vec->len);
+    if (a != vec->data)
+        free(a);
+    UNARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4520  nunique  :  V  ->  V2
+[NATIVE] V2 has the distinct elements of native vector V, in increasing
+order.
+*/
+void nunique_(pEnv env)
+{
+    VectorData empty, *vec, *res;
+
+    ONEPARAM("nunique");
+    if ((vec = stats_vector(env, env->stck, &empty, "nunique")) == 0)
+        return;
+    res = stats_copy(env, vec);
+    stats_sort(res->dtype, res->data, res->len);
+    res->len = stats_unique(res->dtype, res->data, res->len);
+    UNARY(VECTOR_NEWNODE, res);
+}
+
+/*
+ * The windows of W elements of the native vector below the top of the
+ * stack, summed by stats_rollsum or maximized by stats_rollmax: float64 for
+ * float elements and int64 for integer elements, or float64 means.
+ */
+static void stats_rolling(pEnv env, int max, int mean, char* name)
+{
+    void* a;
+    int dtype;
+    int64_t i, w;
+    VectorData empty, *vec, *res;
+
+    TWOPARAMS(name);
+    INTEGER(name);
+    if ((vec = stats_vector(env, nextnode1(env->stck), &empty, name)) == 0)
+        return;
+    if ((w = nodevalue(env->stck).num) < 1 || w > vec->len) {
+        execerror(env, "window within the native vector", name);
+        return;
+    }
+    dtype = vec->dtype == DT_F64 || vec->dtype == DT_F32 ? DT_F64 : DT_I64;
+    res = native_vector(env, dtype, vec->len - w + 1);
+    a = stats_elements(vec);
+    if (max)
+        stats_rollmax(vec->dtype, res->data, a, vec->len, w);
+    else
+        stats_rollsum(vec->dtype, res->data, a, vec->len, w);
+    if (a != vec->data)
+        free(a);
+    if (mean) {
+        if (dtype == DT_I64) /* convert in place: same width */
+            for (i = 0; i < res->len; i++)
+                ((double*)res->data)[i] = ((int64_t*)res->data)[i];
+        res->dtype = DT_F64;
+        for (i = 0; i < res->len; i++)
+            ((double*)res->data)[i] /= w;
+    }
+    BINARY(VECTOR_NEWNODE, res);
+}
+
+/**
+Q0  OK  4560  nrollsum  :  V W  ->  V2
+[NATIVE] V2 has the sums of the windows of W adjacent elements of native
+vector V, one for each position of the window: float64 for float elements,
+and int64 for integer elements.
+*/
+void nrollsum_(pEnv env)
+{
+    stats_rolling(env, 0, 0, "nrollsum");
+}
+
+/**
+Q0  OK  4570  nrollmean  :  V W  ->  V2
+[NATIVE] V2 has the means of the windows of W adjacent elements of native
+vector V, as float64.
+*/
+void nrollmean_(pEnv env)
+{
+    stats_rolling(env, 0, 1, "nrollmean");
+}
+
+/**
+Q0  OK  4580  nrollmax  :  V W  ->  V2
+[NATIVE] V2 has the maxima of the windows of W adjacent elements of native
+vector V: float64 for float elements, and int64 for integer elements. A
+window with a NaN has maximum NaN.
+*/
+void nrollmax_(pEnv env)
+{
+    stats_rolling(env, 1, 0, "nrollmax");
+}
+#endif /* JOY_NATIVE_TYPES */
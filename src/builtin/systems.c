@@ -1,7 +1,7 @@
 /*
  *  module  : systems.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Grouped system builtins: abort, argc, argv, body, clock, conts, filetime,
  *  gc, getenv, gmtime, include, intern, localtime, mktime, name, quit, rand,
@@ -314,6 +314,7 @@ void system_(pEnv env)
     STRING("system");
 #ifndef WINDOWS_S
     str = GETSTRING(env->stck);
+    joy_flush(env); /* before the output of the command */
     (void)system(str);
 #endif
     POP(env->stck);
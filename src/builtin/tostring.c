@@ -1,41 +1,69 @@
 /*
  *  module  : tostring.c
- *  version : 1.0
- *  date    : 01/22/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  toString operator - converts any Joy value to its string representation.
+ *  fwriteterm writes the same representation to a stream.
  */
 #include "globals.h"
 #include "runtime.h"
 #include "builtin_macros.h"
 
-/* Simple dynamic string buffer */
+/*
+ * Buffer for the string representation: it grows for a string, and for a
+ * stream it has a fixed size and is written out with joy_fwrite when it is
+ * full.
+ */
 typedef struct {
+    pEnv env;
+    FILE* fp;
     char* data;
     size_t len;
     size_t cap;
 } StrBuf;
 
-static void sbuf_init(StrBuf* b)
+static void sbuf_init(StrBuf* b, pEnv env, FILE* fp)
 {
-    b->cap = 64;
+    b->env = env;
+    b->fp = fp;
+    b->cap = fp ? OUTPUTMAX : 64;
     b->len = 0;
-    b->data = malloc(b->cap);
+    b->data = check_malloc(b->cap);
 }
 
-static void sbuf_push(StrBuf* b, char c)
+static void sbuf_write(StrBuf* b, const char* s, size_t n)
 {
-    if (b->len >= b->cap - 1) {
-        b->cap *= 2;
-        b->data = realloc(b->data, b->cap);
+    size_t k;
+
+    for (; n; s += k, n -= k) {
+        if (b->len == b->cap - 1) {
+            if (b->fp) {
+                joy_fwrite(b->env, b->data, b->len, b->fp);
+                b->len = 0;
+            } else {
+                b->cap *= 2;
+                b->data = realloc(b->data, b->cap);
+            }
+        }
+        if ((k = b->cap - 1 - b->len) > n)
+            k = n;
+        memcpy(b->data + b->len, s, k);
+        b->len += k;
     }
-    b->data[b->len++] = c;
+}
+
+static void sbuf_push(StrBuf* b, char c)
+{
+    if (b->len < b->cap - 1)
+        b->data[b->len++] = c;
+    else
+        sbuf_write(b, &c, 1);
 }
 
 static void sbuf_str(StrBuf* b, const char* s)
 {
-    while (*s)
-        sbuf_push(b, *s++);
+    sbuf_write(b, s, strlen(s));
 }
 
 static char* sbuf_finish(StrBuf* b)
@@ -47,6 +75,13 @@ static char* sbuf_finish(StrBuf* b)
     return result;
 }
 
+/* Write what is left in the buffer of a stream */
+static void sbuf_close(StrBuf* b)
+{
+    joy_fwrite(b->env, b->data, b->len, b->fp);
+    free(b->data);
+}
+
 /* Forward declaration for recursive stringify */
 static void stringify_value(pEnv env, Index node, StrBuf* out);
 static void stringify_term(pEnv env, Index node, StrBuf* out);
@@ -68,7 +103,7 @@ static void stringify_term(pEnv env, Index node, StrBuf* out)
 static void stringify_value(pEnv env, Index node, StrBuf* out)
 {
     char buf[64];
-    char* ptr;
+    char *ptr, *ptr2;
     khash_t(Dict)* d;
     khint_t k;
     int first;
@@ -97,8 +132,7 @@ static void stringify_value(pEnv env, Index node, StrBuf* out)
         break;
 
     case INTEGER_:
-        snprintf(buf, sizeof(buf), "%" PRId64, nodevalue(node).num);
-        sbuf_str(out, buf);
+        sbuf_write(out, buf, writeinteger(buf, nodevalue(node).num));
         break;
 
     case SET_: {
@@ -111,8 +145,7 @@ static void stringify_value(pEnv env, Index node, StrBuf* out)
                 if (!first)
                     sbuf_push(out, ' ');
                 first = 0;
-                snprintf(buf, sizeof(buf), "%d", i);
-                sbuf_str(out, buf);
+                sbuf_write(out, buf, writeinteger(buf, i));
             }
         }
         sbuf_push(out, '}');
@@ -122,16 +155,19 @@ static void stringify_value(pEnv env, Index node, StrBuf* out)
     case STRING_:
         sbuf_push(out, '"');
         for (ptr = GETSTRING(node); *ptr; ptr++) {
+            for (ptr2 = ptr; *ptr2 && !strchr("\"\\\n\t", *ptr2); ptr2++)
+                ;
+            sbuf_write(out, ptr, ptr2 - ptr);
+            if (!*(ptr = ptr2))
+                break;
             if (*ptr == '"')
                 sbuf_str(out, "\\\"");
             else if (*ptr == '\\')
                 sbuf_str(out, "\\\\");
             else if (*ptr == '\n')
                 sbuf_str(out, "\\n");
-            else if (*ptr == '\t')
-                sbuf_str(out, "\\t");
             else
-                sbuf_push(out, *ptr);
+                sbuf_str(out, "\\t");
         }
         sbuf_push(out, '"');
         break;
@@ -142,16 +178,13 @@ static void stringify_value(pEnv env, Index node, StrBuf* out)
         sbuf_push(out, ']');
         break;
 
-    case FLOAT_: {
-        double val = nodevalue(node).dbl;
-        snprintf(buf, sizeof(buf), "%g", val);
-        sbuf_str(out, buf);
+    case FLOAT_:
+        sbuf_write(out, buf, writedouble(buf, nodevalue(node).dbl));
         /* Add .0 if no decimal point */
-        if (!strchr(buf, '.') && !strchr(buf, 'e') && !strchr(buf, 'E')) {
+        if (!strchr(buf, '.') && !strchr(buf, 'e')
+            && isdigit((int)buf[strlen(buf) - 1]))
             sbuf_str(out, ".0");
-        }
         break;
-    }
 
     case FILE_:
         if (nodevalue(node).fil == stdin)
@@ -218,7 +251,7 @@ void toString_(pEnv env)
         return;
     }
 
-    sbuf_init(&out);
+    sbuf_init(&out, env, 0);
     stringify_value(env, env->stck, &out);
 
     UNARY(STRING_NEWNODE, sbuf_finish(&out));
@@ -241,7 +274,7 @@ void unquoted_(pEnv env)
         return;
     }
 
-    sbuf_init(&out);
+    sbuf_init(&out, env, 0);
 
     /* For characters, don't include the quote marks */
     if (nodetype(env->stck) == CHAR_) {
@@ -253,3 +286,27 @@ void unquoted_(pEnv env)
 
     UNARY(STRING_NEWNODE, sbuf_finish(&out));
 }
+
+/**
+Q0  OK  3832  fwriteterm  :  S X  ->  S
+[FOREIGN] Writes the string representation of X, as toString gives it, to
+stream S, through a buffer of fixed size instead of a string.
+*/
+void fwriteterm_(pEnv env)
+{
+    StrBuf out;
+
+    TWOPARAMS("fwriteterm");
+    if (nodetype(nextnode1(env->stck)) != FILE_
+        || !nodevalue(nextnode1(env->stck)).fil) {
+        execerror(env, "file", "fwriteterm");
+        return;
+    }
+    sbuf_init(&out, env, nodevalue(nextnode1(env->stck)).fil);
+    if (nodetype(env->stck) == STRING_) /* without quotes */
+        sbuf_str(&out, GETSTRING(env->stck));
+    else
+        stringify_value(env, env->stck, &out);
+    sbuf_close(&out);
+    POP(env->stck);
+}
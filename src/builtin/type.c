@@ -23,8 +23,8 @@ void casting_(pEnv env)
     TWOPARAMS("casting");
     node.op = nodevalue(env->stck).num;
 #ifdef JOY_NATIVE_TYPES
-    /* VECTOR_ and MATRIX_ require special allocation, cannot be cast to */
-    if (node.op == VECTOR_ || node.op == MATRIX_) {
+    /* Native values require special allocation, cannot be cast to */
+    if (node.op == VECTOR_ || node.op == MATRIX_ || node.op == SPARSE_) {
         execerror(env, "non-native type for casting", "casting");
         return;
     }
@@ -20,6 +20,11 @@
  *    Properties: det, inv, trace
  *    Creation: meye (identity matrix)
  *
+ *  Native matrices:
+ *    Factorizations: nlu, nqr, nchol
+ *    Solves: nsolve, nlstsq, ndet, ninv
+ *    The factorizations are in linalg.c, which det and inv use as well.
+ *
  *  Optional BLAS support (-DJOY_BLAS=ON):
  *    Uses cblas_dgemm for matrix multiply, cblas_dgemv for matrix-vector.
  *    Enabled above BLAS_THRESHOLD to amortize list-to-array conversion cost.
@@ -1256,7 +1261,7 @@ Result M3 has dimensions (m x p).
 void mm_(pEnv env)
 {
     Index mat1, mat2;
-    int rows1, cols1, rows2, cols2, i, j, k;
+    int rows1, cols1, rows2, cols2;
     double *a, *b, *result;
 
     TWOPARAMS("mm");
@@ -1297,17 +1302,8 @@ void mm_(pEnv env)
     } else
 #endif
     {
-        /* Fallback: manual matrix multiplication */
-        for (i = 0; i < rows1; i++) {
-            for (j = 0; j < cols2; j++) {
-                double sum = 0.0;
-                #pragma omp simd reduction(+:sum)
-                for (k = 0; k < cols1; k++) {
-                    sum += a[i * cols1 + k] * b[k * cols2 + j];
-                }
-                result[i * cols2 + j] = sum;
-            }
-        }
+        /* Fallback: packed, cache-blocked multiply */
+        gemm_f64(rows1, cols2, cols1, 1.0, a, cols1, b, cols2, result, cols2);
     }
 
     BINARY(LIST_NEWNODE, build_matrix(env, result, rows1, cols2));
@@ -1455,55 +1451,6 @@ void trace_(pEnv env)
     free(m);
 }
 
-/*
- * Helper: Compute determinant of a square matrix using LU decomposition.
- * Modifies the input matrix in place.
- * Returns the determinant.
- */
-static double compute_determinant(double* m, int n)
-{
-    int i, j, k, max_row;
-    double det = 1.0;
-    double temp;
-
-    for (i = 0; i < n; i++) {
-        /* Find pivot */
-        max_row = i;
-        for (k = i + 1; k < n; k++) {
-            if (fabs(m[k * n + i]) > fabs(m[max_row * n + i])) {
-                max_row = k;
-            }
-        }
-
-        /* Swap rows if needed */
-        if (max_row != i) {
-            for (j = 0; j < n; j++) {
-                temp = m[i * n + j];
-                m[i * n + j] = m[max_row * n + j];
-                m[max_row * n + j] = temp;
-            }
-            det = -det;  /* Row swap changes sign */
-        }
-
-        /* Check for zero pivot */
-        if (fabs(m[i * n + i]) < 1e-15) {
-            return 0.0;  /* Singular matrix */
-        }
-
-        det *= m[i * n + i];
-
-        /* Eliminate below */
-        for (k = i + 1; k < n; k++) {
-            double factor = m[k * n + i] / m[i * n + i];
-            for (j = i; j < n; j++) {
-                m[k * n + j] -= factor * m[i * n + j];
-            }
-        }
-    }
-
-    return det;
-}
-
 /**
 Q0  OK  3690  det  :  M  ->  N
 N is the determinant of square matrix M.
@@ -1535,79 +1482,13 @@ void det_(pEnv env)
     m = malloc(size * sizeof(double));
     extract_matrix(env, mat, m, rows, cols);
 
-    result = compute_determinant(m, rows);
+    result = linalg_det(m, rows);
 
     UNARY(FLOAT_NEWNODE, result);
 
     free(m);
 }
 
-/*
- * Helper: Compute matrix inverse using Gauss-Jordan elimination.
- * Returns 0 on success, -1 if matrix is singular.
- */
-static int compute_inverse(double* m, double* inv, int n)
-{
-    int i, j, k, max_row;
-    double temp, factor;
-
-    /* Initialize inverse as identity */
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < n; j++) {
-            inv[i * n + j] = (i == j) ? 1.0 : 0.0;
-        }
-    }
-
-    /* Forward elimination */
-    for (i = 0; i < n; i++) {
-        /* Find pivot */
-        max_row = i;
-        for (k = i + 1; k < n; k++) {
-            if (fabs(m[k * n + i]) > fabs(m[max_row * n + i])) {
-                max_row = k;
-            }
-        }
-
-        /* Swap rows */
-        if (max_row != i) {
-            for (j = 0; j < n; j++) {
-                temp = m[i * n + j];
-                m[i * n + j] = m[max_row * n + j];
-                m[max_row * n + j] = temp;
-
-                temp = inv[i * n + j];
-                inv[i * n + j] = inv[max_row * n + j];
-                inv[max_row * n + j] = temp;
-            }
-        }
-
-        /* Check for zero pivot */
-        if (fabs(m[i * n + i]) < 1e-15) {
-            return -1;  /* Singular matrix */
-        }
-
-        /* Scale pivot row */
-        factor = m[i * n + i];
-        for (j = 0; j < n; j++) {
-            m[i * n + j] /= factor;
-            inv[i * n + j] /= factor;
-        }
-
-        /* Eliminate column */
-        for (k = 0; k < n; k++) {
-            if (k != i) {
-                factor = m[k * n + i];
-                for (j = 0; j < n; j++) {
-                    m[k * n + j] -= factor * m[i * n + j];
-                    inv[k * n + j] -= factor * inv[i * n + j];
-                }
-            }
-        }
-    }
-
-    return 0;
-}
-
 /**
 Q0  OK  3700  inv  :  M  ->  M2
 Matrix M2 is the inverse of square matrix M.
@@ -1616,7 +1497,7 @@ Error if M is singular (non-invertible).
 void inv_(pEnv env)
 {
     Index mat;
-    int rows, cols, size;
+    int i, rows, cols, size;
     double *m, *result;
 
     ONEPARAM("inv");
@@ -1640,8 +1521,12 @@ void inv_(pEnv env)
     result = malloc(size * sizeof(double));
 
     extract_matrix(env, mat, m, rows, cols);
+    for (i = 0; i < size; i++)
+        result[i] = 0.0;
+    for (i = 0; i < rows; i++)
+        result[i * rows + i] = 1.0;
 
-    if (compute_inverse(m, result, rows) < 0) {
+    if (linalg_solve(m, rows, result, rows)) {
         free(m);
         free(result);
         execerror(env, "non-singular matrix", "inv");
@@ -1720,6 +1605,7 @@ void tovec_(pEnv env)
     Index list;
     int len, i;
     VectorData* vec;
+    double* data;
     int ok;
     Index node;
 
@@ -1735,13 +1621,13 @@ void tovec_(pEnv env)
     len = check_numeric_list(env, list, ">vec");
     if (len < 0) return;
 
-    /* Allocate VectorData with flexible array */
-    vec = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData) + len * sizeof(double));
-    vec->len = len;
+    /* Allocate VectorData of doubles */
+    vec = native_vector(env, DT_F64, len);
+    data = vec->data;
 
     /* Extract values */
     for (i = 0, node = list; node && i < len; node = nextnode1(node), i++) {
-        vec->data[i] = get_numeric(env, node, &ok);
+        data[i] = get_numeric(env, node, &ok);
     }
 
     UNARY(VECTOR_NEWNODE, vec);
@@ -1756,6 +1642,7 @@ void tomat_(pEnv env)
     Index mat;
     int rows, cols, r, c;
     MatrixData* result;
+    double* data;
     Index row_node, cell_node;
     int ok;
 
@@ -1771,10 +1658,9 @@ void tomat_(pEnv env)
 
     if (check_matrix(env, mat, &rows, &cols, ">mat") < 0) return;
 
-    /* Allocate MatrixData with flexible array */
-    result = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + rows * cols * sizeof(double));
-    result->rows = rows;
-    result->cols = cols;
+    /* Allocate MatrixData of doubles */
+    result = native_matrix(env, DT_F64, rows, cols);
+    data = result->data;
 
     /* Extract values row by row */
     r = 0;
@@ -1782,19 +1668,54 @@ void tomat_(pEnv env)
         Index row = nodevalue(row_node).lis;
         c = 0;
         for (cell_node = row; cell_node && c < cols; cell_node = nextnode1(cell_node), c++) {
-            result->data[r * cols + c] = get_numeric(env, cell_node, &ok);
+            data[(size_t)r * cols + c] = get_numeric(env, cell_node, &ok);
         }
     }
 
     UNARY(MATRIX_NEWNODE, result);
 }
 
+/*
+ * Helper: Build a list from len native elements of type dtype, inc apart
+ * from element start. Integer elements give INTEGER_ nodes, floats FLOAT_
+ * nodes. The caller has reserved the nodes with ensure_capacity.
+ */
+static Index build_native_list(pEnv env, int dtype, const void* data,
+                               int64_t start, int64_t inc, int64_t len)
+{
+    Index head = 0;
+    Index tail = 0;
+    Index node;
+    int64_t i;
+
+    for (i = start; len-- > 0; i += inc) {
+        if (dtype == DT_F64 || dtype == DT_F32)
+            node = FLOAT_NEWNODE(kernel_get(dtype, data, i), 0);
+        else
+            node = INTEGER_NEWNODE(kernel_geti(dtype, data, i), 0);
+        if (!head) {
+            head = node;
+            tail = node;
+        } else {
+            nextnode1(tail) = node;
+            tail = node;
+        }
+    }
+    return head;
+}
+
 /**
 Q0  OK  3760  >list\0tolist  :  X  ->  L
 [NATIVE] Converts native vector or matrix X back to a linked list.
+Integer elements become integers, the others floats.
 */
 void tolist_(pEnv env)
 {
+    Index head = 0;
+    Index tail = 0;
+    Index row_node;
+    int64_t r;
+
     ONEPARAM(">list");
 
     if (nodetype(env->stck) == VECTOR_) {
@@ -1803,7 +1724,12 @@ void tolist_(pEnv env)
             UNARY(LIST_NEWNODE, 0);
             return;
         }
-        UNARY(LIST_NEWNODE, build_float_list(env, vec->data, vec->len));
+        vector_force(vec);
+        /* Pre-allocate to avoid GC during the build */
+        ensure_capacity(env, vec->len + 1);
+        UNARY(LIST_NEWNODE,
+              build_native_list(env, vec->dtype, vec->data, 0, vec->inc,
+                                vec->len));
         return;
     }
 
@@ -1813,7 +1739,19 @@ void tolist_(pEnv env)
             UNARY(LIST_NEWNODE, 0);
             return;
         }
-        UNARY(LIST_NEWNODE, build_matrix(env, mat->data, mat->rows, mat->cols));
+        ensure_capacity(env, mat->rows * (mat->cols + 1) + 1);
+        for (r = 0; r < mat->rows; r++) {
+            row_node = LIST_NEWNODE(build_native_list(env, mat->dtype,
+                                    mat->data, r * mat->ld, 1, mat->cols), 0);
+            if (!head) {
+                head = row_node;
+                tail = row_node;
+            } else {
+                nextnode1(tail) = row_node;
+                tail = row_node;
+            }
+        }
+        UNARY(LIST_NEWNODE, head);
         return;
     }
 
@@ -1827,6 +1765,23 @@ void tolist_(pEnv env)
 
 /* ========== Native BLAS operations ========== */
 
+/*
+ * Helper: Check that the operands of a BLAS operation have the same float
+ * element type, and return it. Integer elements must be cast first.
+ */
+static int check_blas_dtype(pEnv env, int dtype1, int dtype2, char* name)
+{
+    if (dtype1 != dtype2) {
+        execerror(env, "equal element types", name);
+        return -1;
+    }
+    if (dtype1 != DT_F64 && dtype1 != DT_F32) {
+        execerror(env, "float elements", name);
+        return -1;
+    }
+    return dtype1;
+}
+
 /**
 Q0  OK  3770  ndot  :  V1 V2  ->  N
 [NATIVE] Dot product of two native vectors. Uses BLAS cblas_ddot when available.
@@ -1835,7 +1790,10 @@ void ndot_(pEnv env)
 {
     VectorData *v1, *v2;
     double result = 0.0;
-    int i;
+#ifndef JOY_BLAS
+    int64_t i;
+#endif
+    int dtype;
 
     TWOPARAMS("ndot");
 
@@ -1851,20 +1809,37 @@ void ndot_(pEnv env)
         execerror(env, "vectors of equal length", "ndot");
         return;
     }
+    if ((dtype = check_blas_dtype(env, v1->dtype, v2->dtype, "ndot")) < 0)
+        return;
 
     if (v1->len == 0) {
         BINARY(FLOAT_NEWNODE, 0.0);
         return;
     }
+    vector_force(v1);
+    vector_force(v2);
 
+    if (dtype == DT_F32) {
+        const float *x = v1->data, *y = v2->data;
 #ifdef JOY_BLAS
-    result = cblas_ddot(v1->len, v1->data, 1, v2->data, 1);
+        result = cblas_sdot(v1->len, x, v1->inc, y, v2->inc);
 #else
-    #pragma omp simd reduction(+:result)
-    for (i = 0; i < v1->len; i++) {
-        result += v1->data[i] * v2->data[i];
-    }
+        #pragma omp simd reduction(+:result)
+        for (i = 0; i < v1->len; i++) {
+            result += (double)x[i * v1->inc] * y[i * v2->inc];
+        }
 #endif
+    } else {
+        const double *x = v1->data, *y = v2->data;
+#ifdef JOY_BLAS
+        result = cblas_ddot(v1->len, x, v1->inc, y, v2->inc);
+#else
+        #pragma omp simd reduction(+:result)
+        for (i = 0; i < v1->len; i++) {
+            result += x[i * v1->inc] * y[i * v2->inc];
+        }
+#endif
+    }
 
     BINARY(FLOAT_NEWNODE, result);
 }
@@ -1879,7 +1854,10 @@ void nmv_(pEnv env)
     MatrixData* mat;
     VectorData* vec;
     VectorData* result;
-    int i, k;
+#ifndef JOY_BLAS
+    int64_t i, k;
+#endif
+    int dtype;
 
     TWOPARAMS("nmv");
 
@@ -1899,33 +1877,57 @@ void nmv_(pEnv env)
         execerror(env, "matrix columns equal to vector length", "nmv");
         return;
     }
+    if ((dtype = check_blas_dtype(env, mat->dtype, vec->dtype, "nmv")) < 0)
+        return;
 
     if (mat->rows == 0) {
-        result = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData));
-        result->len = 0;
+        result = native_vector(env, dtype, 0);
         BINARY(VECTOR_NEWNODE, result);
         return;
     }
 
-    result = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData) + mat->rows * sizeof(double));
-    result->len = mat->rows;
+    result = native_vector(env, dtype, mat->rows);
+    vector_force(vec);
 
+    if (dtype == DT_F32) {
+        const float *a = mat->data, *x = vec->data;
+        float* y = result->data;
 #ifdef JOY_BLAS
-    cblas_dgemv(CblasRowMajor, CblasNoTrans,
-                mat->rows, mat->cols,
-                1.0, mat->data, mat->cols,
-                vec->data, 1,
-                0.0, result->data, 1);
+        cblas_sgemv(CblasRowMajor, CblasNoTrans,
+                    mat->rows, mat->cols,
+                    1.0f, a, mat->ld,
+                    x, vec->inc,
+                    0.0f, y, 1);
 #else
-    for (i = 0; i < mat->rows; i++) {
-        double sum = 0.0;
-        #pragma omp simd reduction(+:sum)
-        for (k = 0; k < mat->cols; k++) {
-            sum += mat->data[i * mat->cols + k] * vec->data[k];
+        for (i = 0; i < mat->rows; i++) {
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (k = 0; k < mat->cols; k++) {
+                sum += (double)a[i * mat->ld + k] * x[k * vec->inc];
+            }
+            y[i] = sum;
         }
-        result->data[i] = sum;
-    }
 #endif
+    } else {
+        const double *a = mat->data, *x = vec->data;
+        double* y = result->data;
+#ifdef JOY_BLAS
+        cblas_dgemv(CblasRowMajor, CblasNoTrans,
+                    mat->rows, mat->cols,
+                    1.0, a, mat->ld,
+                    x, vec->inc,
+                    0.0, y, 1);
+#else
+        for (i = 0; i < mat->rows; i++) {
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (k = 0; k < mat->cols; k++) {
+                sum += a[i * mat->ld + k] * x[k * vec->inc];
+            }
+            y[i] = sum;
+        }
+#endif
+    }
 
     BINARY(VECTOR_NEWNODE, result);
 }
@@ -1938,7 +1940,7 @@ Both M1 and M2 must be native matrices.
 void nmm_(pEnv env)
 {
     MatrixData *m1, *m2, *result;
-    int i, j, k;
+    int dtype;
 
     TWOPARAMS("nmm");
 
@@ -1954,48 +1956,397 @@ void nmm_(pEnv env)
         execerror(env, "compatible matrix dimensions", "nmm");
         return;
     }
+    if ((dtype = check_blas_dtype(env, m1->dtype, m2->dtype, "nmm")) < 0)
+        return;
 
+    result = native_matrix(env, dtype, m1->rows, m2->cols);
     if (m1->rows == 0 || m2->cols == 0) {
-        result = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData));
-        result->rows = m1->rows;
-        result->cols = m2->cols;
         BINARY(MATRIX_NEWNODE, result);
         return;
     }
 
-    result = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + m1->rows * m2->cols * sizeof(double));
-    result->rows = m1->rows;
-    result->cols = m2->cols;
-
+    if (dtype == DT_F32) {
+        const float *a = m1->data, *b = m2->data;
+        float* c = result->data;
+#ifdef JOY_BLAS
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    m1->rows, m2->cols, m1->cols,
+                    1.0f, a, m1->ld,
+                    b, m2->ld,
+                    0.0f, c, m2->cols);
+#else
+        memset(c, 0, m1->rows * m2->cols * sizeof(float));
+        gemm_f32(m1->rows, m2->cols, m1->cols, 1.0f, a, m1->ld, b, m2->ld,
+                 c, m2->cols);
+#endif
+    } else {
+        const double *a = m1->data, *b = m2->data;
+        double* c = result->data;
 #ifdef JOY_BLAS
-    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                m1->rows, m2->cols, m1->cols,
-                1.0, m1->data, m1->cols,
-                m2->data, m2->cols,
-                0.0, result->data, m2->cols);
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    m1->rows, m2->cols, m1->cols,
+                    1.0, a, m1->ld,
+                    b, m2->ld,
+                    0.0, c, m2->cols);
 #else
-    /* Initialize result to zero */
-    for (i = 0; i < m1->rows * m2->cols; i++) {
-        result->data[i] = 0.0;
+        /* Packed, cache-blocked multiply */
+        memset(c, 0, m1->rows * m2->cols * sizeof(double));
+        gemm_f64(m1->rows, m2->cols, m1->cols, 1.0, a, m1->ld, b, m2->ld,
+                 c, m2->cols);
+#endif
     }
-    /* Manual matrix multiplication */
-    for (i = 0; i < m1->rows; i++) {
-        for (j = 0; j < m2->cols; j++) {
-            double sum = 0.0;
-            #pragma omp simd reduction(+:sum)
-            for (k = 0; k < m1->cols; k++) {
-                sum += m1->data[i * m1->cols + k] * m2->data[k * m2->cols + j];
-            }
-            result->data[i * m2->cols + j] = sum;
+
+    BINARY(MATRIX_NEWNODE, result);
+}
+
+/* ========== Native factorizations and linear systems ========== */
+
+/*
+ * Helper: Copy the elements of native matrix mat to a new array of doubles,
+ * rows * cols without gaps, that the caller frees. Views and other element
+ * types are converted.
+ */
+static double* native_matrix_doubles(MatrixData* mat)
+{
+    double* m;
+    int64_t r, size;
+
+    size = mat->rows * mat->cols;
+    m = check_malloc((size ? size : 1) * sizeof(double));
+    for (r = 0; r < mat->rows; r++)
+        kernel_cast(DT_F64, m + r * mat->cols, mat->dtype,
+                    (char*)mat->data + r * mat->ld * kernel_width(mat->dtype),
+                    mat->cols);
+    return m;
+}
+
+/*
+ * Helper: The native matrix in node p, that must be square unless any is
+ * set, or 0.
+ */
+static MatrixData* check_native_matrix(pEnv env, Index p, int any, char* name)
+{
+    MatrixData* mat;
+
+    if (nodetype(p) != MATRIX_ || !(mat = nodevalue(p).mat)) {
+        execerror(env, "native matrix", name);
+        return 0;
+    }
+    if (!any && mat->rows != mat->cols) {
+        execerror(env, "square matrix", name);
+        return 0;
+    }
+    return mat;
+}
+
+/*
+ * Helper: A new native matrix of doubles with the rows x cols elements of m.
+ */
+static MatrixData* native_from_doubles(pEnv env, const double* m,
+                                       int64_t rows, int64_t cols)
+{
+    MatrixData* mat;
+
+    mat = native_matrix(env, DT_F64, rows, cols);
+    if (rows && cols)
+        memcpy(mat->data, m, rows * cols * sizeof(double));
+    return mat;
+}
+
+/**
+Q0  OK  4240  nlu  :  M  ->  L U P
+[NATIVE] L U is the LU factorization of square native matrix M with partial
+pivoting: L is unit lower triangular, U upper triangular, and row I of L U is
+row P[I] of M, with P a native vector of integers.
+*/
+void nlu_(pEnv env)
+{
+    MatrixData *mat, *l, *u;
+    VectorData* p;
+    double* m;
+    int64_t *piv, *perm, i, j, n, x;
+
+    ONEPARAM("nlu");
+    if (!(mat = check_native_matrix(env, env->stck, 0, "nlu"))) return;
+
+    n = mat->rows;
+    m = native_matrix_doubles(mat);
+    piv = check_malloc((n ? n : 1) * sizeof(int64_t));
+    linalg_lu(m, n, piv);
+
+    l = native_matrix(env, DT_F64, n, n);
+    u = native_matrix(env, DT_F64, n, n);
+    p = native_vector(env, DT_I64, n);
+    perm = p->data;
+    for (i = 0; i < n; i++) {
+        perm[i] = i;
+        for (j = 0; j < n; j++) {
+            ((double*)l->data)[i * n + j] = j < i ? m[i * n + j] : j == i;
+            ((double*)u->data)[i * n + j] = j >= i ? m[i * n + j] : 0.0;
         }
     }
-#endif
+    /* The swaps, in order, give the permutation */
+    for (i = 0; i < n; i++) {
+        x = perm[i];
+        perm[i] = perm[piv[i]];
+        perm[piv[i]] = x;
+    }
+    free(piv);
+    free(m);
 
-    BINARY(MATRIX_NEWNODE, result);
+    UNARY(MATRIX_NEWNODE, l);
+    NULLARY(MATRIX_NEWNODE, u);
+    NULLARY(VECTOR_NEWNODE, p);
+}
+
+/**
+Q0  OK  4250  nqr  :  M  ->  Q R
+[NATIVE] Q R is the QR factorization of native R x C matrix M, using
+Householder reflections: Q is R x K with orthonormal columns, and R is K x C
+upper triangular, where K is the smaller of R and C.
+*/
+void nqr_(pEnv env)
+{
+    MatrixData *mat, *q, *r;
+    double *m, *tau;
+    int64_t i, j, rows, cols, k;
+
+    ONEPARAM("nqr");
+    if (!(mat = check_native_matrix(env, env->stck, 1, "nqr"))) return;
+
+    rows = mat->rows;
+    cols = mat->cols;
+    k = rows < cols ? rows : cols;
+    m = native_matrix_doubles(mat);
+    tau = check_malloc((k ? k : 1) * sizeof(double));
+    linalg_qr(m, rows, cols, tau);
+
+    q = native_matrix(env, DT_F64, rows, k);
+    r = native_matrix(env, DT_F64, k, cols);
+    linalg_qr_q(m, rows, cols, tau, q->data);
+    for (i = 0; i < k; i++)
+        for (j = 0; j < cols; j++)
+            ((double*)r->data)[i * cols + j] = j >= i ? m[i * cols + j] : 0.0;
+    free(tau);
+    free(m);
+
+    UNARY(MATRIX_NEWNODE, q);
+    NULLARY(MATRIX_NEWNODE, r);
+}
+
+/**
+Q0  OK  4260  nchol  :  M  ->  L
+[NATIVE] L is the lower triangular Cholesky factor of symmetric positive
+definite native matrix M, such that L times its transpose is M. Only the
+lower triangle of M is used.
+*/
+void nchol_(pEnv env)
+{
+    MatrixData* mat;
+    double* m;
+
+    ONEPARAM("nchol");
+    if (!(mat = check_native_matrix(env, env->stck, 0, "nchol"))) return;
+
+    m = native_matrix_doubles(mat);
+    if (linalg_cholesky(m, mat->rows)) {
+        free(m);
+        execerror(env, "positive definite matrix", "nchol");
+        return;
+    }
+    mat = native_from_doubles(env, m, mat->rows, mat->cols);
+    free(m);
+
+    UNARY(MATRIX_NEWNODE, mat);
+}
+
+/*
+ * Helper: The right-hand side B on top of the stack, for a system with rows
+ * equations: a native vector, or a native matrix of columns. Returns its
+ * elements as doubles, in rows x *nrhs without gaps, or 0.
+ */
+static double* native_rhs(pEnv env, int64_t rows, int64_t* nrhs, char* name)
+{
+    VectorData* vec;
+    MatrixData* mat;
+    double* b;
+
+    if (nodetype(env->stck) == VECTOR_ && (vec = nodevalue(env->stck).vec)
+        && vec->len == rows) {
+        *nrhs = 1;
+        b = check_malloc((rows ? rows : 1) * sizeof(double));
+        vector_cast(DT_F64, b, vec);
+        return b;
+    }
+    if (nodetype(env->stck) == MATRIX_ && (mat = nodevalue(env->stck).mat)
+        && mat->rows == rows) {
+        *nrhs = mat->cols;
+        return native_matrix_doubles(mat);
+    }
+    execerror(env, "native vector or matrix with as many rows", name);
+    return 0;
+}
+
+/*
+ * Helper: Replace A and B on the stack by the first rows of solution x, a
+ * vector when B is a vector.
+ */
+static void native_solution(pEnv env, const double* x, int64_t rows,
+                            int64_t nrhs)
+{
+    VectorData* vec;
+
+    if (nodetype(env->stck) == VECTOR_) {
+        vec = native_vector(env, DT_F64, rows);
+        if (rows)
+            memcpy(vec->data, x, rows * sizeof(double));
+        BINARY(VECTOR_NEWNODE, vec);
+    } else
+        BINARY(MATRIX_NEWNODE, native_from_doubles(env, x, rows, nrhs));
+}
+
+/**
+Q0  OK  4270  nsolve  :  A B  ->  X
+[NATIVE] X solves A X = B, for square native matrix A and native vector or
+matrix B, using the LU factorization of A. Error if A is singular.
+*/
+void nsolve_(pEnv env)
+{
+    MatrixData* mat;
+    double *a, *b;
+    int64_t nrhs;
+
+    TWOPARAMS("nsolve");
+    mat = check_native_matrix(env, nextnode1(env->stck), 0, "nsolve");
+    if (!mat) return;
+    if (!(b = native_rhs(env, mat->rows, &nrhs, "nsolve"))) return;
+
+    a = native_matrix_doubles(mat);
+    if (linalg_solve(a, mat->rows, b, nrhs)) {
+        free(a);
+        free(b);
+        execerror(env, "non-singular matrix", "nsolve");
+        return;
+    }
+    native_solution(env, b, mat->rows, nrhs);
+    free(a);
+    free(b);
+}
+
+/**
+Q0  OK  4280  nlstsq  :  A B  ->  X
+[NATIVE] X minimizes the length of A X - B, for native R x C matrix A with
+R >= C and independent columns, and native vector or matrix B of R rows,
+using the QR factorization of A.
+*/
+void nlstsq_(pEnv env)
+{
+    MatrixData* mat;
+    double *a, *b;
+    int64_t nrhs;
+
+    TWOPARAMS("nlstsq");
+    mat = check_native_matrix(env, nextnode1(env->stck), 1, "nlstsq");
+    if (!mat) return;
+    if (mat->rows < mat->cols) {
+        execerror(env, "at least as many rows as columns", "nlstsq");
+        return;
+    }
+    if (!(b = native_rhs(env, mat->rows, &nrhs, "nlstsq"))) return;
+
+    a = native_matrix_doubles(mat);
+    if (linalg_lstsq(a, mat->rows, mat->cols, b, nrhs)) {
+        free(a);
+        free(b);
+        execerror(env, "matrix of full column rank", "nlstsq");
+        return;
+    }
+    native_solution(env, b, mat->cols, nrhs);
+    free(a);
+    free(b);
+}
+
+/**
+Q0  OK  4290  ndet  :  M  ->  N
+[NATIVE] N is the determinant of square native matrix M, using its LU
+factorization.
+*/
+void ndet_(pEnv env)
+{
+    MatrixData* mat;
+    double *m, det;
+
+    ONEPARAM("ndet");
+    if (!(mat = check_native_matrix(env, env->stck, 0, "ndet"))) return;
+
+    m = native_matrix_doubles(mat);
+    det = linalg_det(m, mat->rows);
+    free(m);
+
+    UNARY(FLOAT_NEWNODE, det);
+}
+
+/**
+Q0  OK  4300  ninv  :  M  ->  M2
+[NATIVE] M2 is the inverse of square native matrix M. Error if M is
+singular. To solve a system, nsolve is faster and more accurate.
+*/
+void ninv_(pEnv env)
+{
+    MatrixData* mat;
+    double *a, *b;
+    int64_t i, n;
+
+    ONEPARAM("ninv");
+    if (!(mat = check_native_matrix(env, env->stck, 0, "ninv"))) return;
+
+    n = mat->rows;
+    a = native_matrix_doubles(mat);
+    b = check_malloc((n ? n * n : 1) * sizeof(double));
+    for (i = 0; i < n * n; i++)
+        b[i] = 0.0;
+    for (i = 0; i < n; i++)
+        b[i * n + i] = 1.0;
+    if (linalg_solve(a, n, b, n)) {
+        free(a);
+        free(b);
+        execerror(env, "non-singular matrix", "ninv");
+        return;
+    }
+    mat = native_from_doubles(env, b, n, n);
+    free(a);
+    free(b);
+
+    UNARY(MATRIX_NEWNODE, mat);
 }
 
 /* ========== Native creation functions ========== */
 
+/*
+ * Helper: Fill n doubles with x.
+ */
+static void fill_native(double* data, int64_t n, double x)
+{
+    int64_t i;
+
+    #pragma omp simd
+    for (i = 0; i < n; i++) {
+        data[i] = x;
+    }
+}
+
+/*
+ * Helper: Check that a matrix of r x c elements is not too large.
+ */
+static int check_native_size(pEnv env, int64_t r, int64_t c, char* name)
+{
+    if (c && r > NATIVE_MAX_LEN / c) {
+        execerror(env, "smaller size", name);
+        return 0;
+    }
+    return 1;
+}
+
 /**
 Q0  OK  3800  nvzeros  :  N  ->  V
 [NATIVE] V is a native vector of N zeros.
@@ -2004,19 +2355,15 @@ void nvzeros_(pEnv env)
 {
     int64_t n;
     VectorData* vec;
-    int i;
 
     ONEPARAM("nvzeros");
     POSITIVEINDEX(env->stck, "nvzeros");
 
     n = nodevalue(env->stck).num;
+    if (!check_native_size(env, n, 1, "nvzeros")) return;
 
-    vec = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData) + n * sizeof(double));
-    vec->len = (int)n;
-
-    for (i = 0; i < n; i++) {
-        vec->data[i] = 0.0;
-    }
+    vec = native_vector(env, DT_F64, n);
+    fill_native(vec->data, n, 0.0);
 
     UNARY(VECTOR_NEWNODE, vec);
 }
@@ -2029,19 +2376,15 @@ void nvones_(pEnv env)
 {
     int64_t n;
     VectorData* vec;
-    int i;
 
     ONEPARAM("nvones");
     POSITIVEINDEX(env->stck, "nvones");
 
     n = nodevalue(env->stck).num;
+    if (!check_native_size(env, n, 1, "nvones")) return;
 
-    vec = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData) + n * sizeof(double));
-    vec->len = (int)n;
-
-    for (i = 0; i < n; i++) {
-        vec->data[i] = 1.0;
-    }
+    vec = native_vector(env, DT_F64, n);
+    fill_native(vec->data, n, 1.0);
 
     UNARY(VECTOR_NEWNODE, vec);
 }
@@ -2053,7 +2396,6 @@ Q0  OK  3820  nmzeros  :  R C  ->  M
 void nmzeros_(pEnv env)
 {
     int64_t r, c;
-    int size, i;
     MatrixData* mat;
 
     TWOPARAMS("nmzeros");
@@ -2062,15 +2404,10 @@ void nmzeros_(pEnv env)
 
     c = nodevalue(env->stck).num;
     r = nodevalue(nextnode1(env->stck)).num;
+    if (!check_native_size(env, r, c, "nmzeros")) return;
 
-    size = (int)(r * c);
-    mat = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + size * sizeof(double));
-    mat->rows = (int)r;
-    mat->cols = (int)c;
-
-    for (i = 0; i < size; i++) {
-        mat->data[i] = 0.0;
-    }
+    mat = native_matrix(env, DT_F64, r, c);
+    fill_native(mat->data, r * c, 0.0);
 
     BINARY(MATRIX_NEWNODE, mat);
 }
@@ -2082,7 +2419,6 @@ Q0  OK  3830  nmones  :  R C  ->  M
 void nmones_(pEnv env)
 {
     int64_t r, c;
-    int size, i;
     MatrixData* mat;
 
     TWOPARAMS("nmones");
@@ -2091,15 +2427,10 @@ void nmones_(pEnv env)
 
     c = nodevalue(env->stck).num;
     r = nodevalue(nextnode1(env->stck)).num;
+    if (!check_native_size(env, r, c, "nmones")) return;
 
-    size = (int)(r * c);
-    mat = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + size * sizeof(double));
-    mat->rows = (int)r;
-    mat->cols = (int)c;
-
-    for (i = 0; i < size; i++) {
-        mat->data[i] = 1.0;
-    }
+    mat = native_matrix(env, DT_F64, r, c);
+    fill_native(mat->data, r * c, 1.0);
 
     BINARY(MATRIX_NEWNODE, mat);
 }
@@ -2110,26 +2441,23 @@ Q0  OK  3840  nmeye  :  N  ->  M
 */
 void nmeye_(pEnv env)
 {
-    int64_t n;
-    int size, i;
+    int64_t n, i;
     MatrixData* mat;
+    double* data;
 
     ONEPARAM("nmeye");
     POSITIVEINDEX(env->stck, "nmeye");
 
     n = nodevalue(env->stck).num;
+    if (!check_native_size(env, n, n, "nmeye")) return;
 
-    size = (int)(n * n);
-    mat = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + size * sizeof(double));
-    mat->rows = (int)n;
-    mat->cols = (int)n;
+    mat = native_matrix(env, DT_F64, n, n);
+    data = mat->data;
 
     /* Initialize to zeros then set diagonal */
-    for (i = 0; i < size; i++) {
-        mat->data[i] = 0.0;
-    }
+    fill_native(data, n * n, 0.0);
     for (i = 0; i < n; i++) {
-        mat->data[i * n + i] = 1.0;
+        data[i * n + i] = 1.0;
     }
 
     UNARY(MATRIX_NEWNODE, mat);
@@ -0,0 +1,88 @@
+/*
+ *  module  : bytes.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Files as native vectors of bytes, and searching in bytes.
+ *
+ *  bytes_map maps a whole file into memory and returns a uint8 view of the
+ *  mapping, as npy_load does for the elements of a .npy file: pages are read
+ *  when they are used and are shared with the page cache, and the view is not
+ *  moved or copied by the collector. The mapping is read only. Without mmap,
+ *  or when it fails, the file is read into a vector instead.
+ */
+#include "globals.h"
+#include <sys/stat.h>
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#endif
+
+/*
+ * bytes_map - the bytes of the file at path, as a native vector in res, or
+ *	       an error message.
+ */
+char* bytes_map(pEnv env, char* path, VectorData** res)
+{
+    FILE* fp;
+    size_t size;
+    struct stat st;
+#ifndef _MSC_VER
+    void *addr, *file;
+#endif
+
+    if ((fp = fopen(path, "rb")) == 0)
+        return "readable file";
+    if (fstat(fileno(fp), &st) || st.st_size < 0) {
+        fclose(fp);
+        return "readable file";
+    }
+    if ((uint64_t)st.st_size > (uint64_t)NATIVE_MAX_LEN) {
+        fclose(fp);
+        return "smaller size";
+    }
+    size = st.st_size;
+#ifndef _MSC_VER
+    if (size) {
+        addr = mmap(0, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (addr != MAP_FAILED) {
+            fclose(fp);
+            file = native_file(env, addr, size);
+            *res = native_vector(env, DT_U8, 0);
+            (*res)->len = size;
+            (*res)->base = file;
+            (*res)->data = addr;
+            native_store(file); /* the view keeps it */
+            return 0;
+        }
+    }
+#endif
+    *res = native_vector(env, DT_U8, size);
+    if (fread((*res)->data, 1, size, fp) != size) {
+        fclose(fp);
+        native_store(*res); /* released by the collector */
+        return "complete file";
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*
+ * bytes_find - the position of the first m bytes s in the n bytes a, or -1.
+ *		Candidates are found with memchr on the first byte of s.
+ */
+int64_t bytes_find(const char* a, int64_t n, const char* s, int64_t m)
+{
+    const char *p, *end;
+
+    if (!m)
+        return 0;
+    if (m > n)
+        return -1;
+    for (p = a, end = a + n - m + 1; p < end; p++) {
+        if ((p = memchr(p, *s, end - p)) == 0)
+            break;
+        if (!memcmp(p + 1, s + 1, m - 1))
+            return p - a;
+    }
+    return -1;
+}
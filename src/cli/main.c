@@ -1,8 +1,8 @@
 /* FILE: main.c */
 /*
  *  module  : main.c
- *  version : 1.110
- *  date    : 01/20/26
+ *  version : 1.112
+ *  date    : 10/18/26
  */
 
 #ifdef USE_LINENOISE
@@ -238,6 +238,7 @@ static void options(int verbose)
     printf("  -v : print a small banner at startup\n");
     printf("  -w : no warnings: overwriting, arities\n");
     printf("  -x : print statistics at end of program\n");
+    printf("  -y : set the output flush policy (0-4)\n");
 }
 
 /*
@@ -400,6 +401,7 @@ static void linenoise_repl(pEnv env)
                     exec_term(env, env->prog);
                 }
                 print(env);
+                joy_flush_term(env); /* before the next prompt */
                 if (env->scanner.sym == '.')
                     break;
                 ch = getsym(env, ch);
@@ -425,9 +427,10 @@ static void my_main(int argc, char** argv)
 #endif
     Env env; /* global variables */
     int i, j, ch;
+    long num;
     char *ptr, *tmp, *exe;
     unsigned char helping = 0, unknown = 0, mustinclude = 1, verbose = 0,
-                  raw = 0;
+                  raw = 0, flush = FLUSH_AUTO;
 #ifdef BYTECODE
     FILE* fp = 0;
     unsigned char listing = 0, lining = 0, quick = 0;
@@ -569,6 +572,15 @@ static void my_main(int argc, char** argv)
                 case 'x':
                     pstats = 1;
                     break;
+                case 'y':
+                    ptr = &argv[i][j + 1];
+                    num = strtol(ptr, &tmp, 0);
+                    j += tmp - ptr;
+                    if (tmp == ptr || num < FLUSH_AUTO || num > FLUSH_NONE)
+                        unknown = 'y'; /* not a flush policy */
+                    else
+                        flush = num;
+                    break;
                 default:
                     unknown = argv[i][j];
                     break;
@@ -583,6 +595,12 @@ static void my_main(int argc, char** argv)
                 argv[j] = argv[j + 1];
         } /* end if */
     } /* end for */
+    /*
+     * Buffer stdout by policy, before anything is written to it. Raw mode
+     * keeps the buffering of stdio.
+     */
+    if (!raw)
+        joy_stdout(flush);
     /*
      * Handle the banner now, before a possible error message is generated.
      */
@@ -662,7 +680,7 @@ start:
         inimem2(&env);        /* store initial stack in definition space */
 #endif
     } else
-        setbuf(stdout, 0); /* disable output buffering (pipe) */
+        joy_output(&env, flush, 0); /* buffer output, by policy */
     /*
      * read initial library.
      */
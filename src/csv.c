@@ -0,0 +1,285 @@
+/*
+ *  module  : csv.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Numeric tables in CSV and TSV files, read into native matrices.
+ *
+ *  csv_read maps the file with bytes_map and reads it in two passes over
+ *  chunks of lines. The chunks start after a newline at about equal
+ *  distances; the first pass counts the lines of each chunk, which gives the
+ *  row where each chunk starts, and the second parses the fields of each
+ *  chunk into its rows of the matrix. With JOY_PARALLEL, the chunks of both
+ *  passes are divided over the threads. Numbers of up to 15 digits with an
+ *  exponent up to 22 are converted exactly with one multiply or divide; the
+ *  others, and nan and inf, are given to strtod. A first line that is not
+ *  numeric is a header and is skipped; empty lines are skipped as well, and
+ *  empty fields are NaN.
+ */
+#include "globals.h"
+#ifdef JOY_PARALLEL
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include <omp.h>
+#pragma GCC diagnostic pop
+#endif
+
+#define CSV_CHUNK (1 << 20) /* bytes in a chunk, at least */
+#define CSV_FIELD 64        /* characters of a field that strtod reads */
+
+/*
+ * A chunk of lines: its text, the row where it starts, and its first error.
+ */
+typedef struct CsvChunk {
+    const char *p, *end;
+    int64_t row, rows;
+    char* msg;
+} CsvChunk;
+
+static const double csv_tens[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * csv_line - the end of the line at p, before its newline and carriage
+ *	      return; *next is where the next line starts.
+ */
+static const char* csv_line(const char* p, const char* end, const char** next)
+{
+    const char* q;
+
+    if ((q = memchr(p, '\n', end - p)) == 0)
+        *next = q = end;
+    else
+        *next = q + 1;
+    if (q > p && q[-1] == '\r')
+        q--;
+    return q;
+}
+
+/*
+ * csv_blank - whether the line from p to q has only white space.
+ */
+static int csv_blank(const char* p, const char* q)
+{
+    for (; p < q; p++)
+        if (*p != ' ' && *p != '\t')
+            return 0;
+    return 1;
+}
+
+/*
+ * csv_number - the number in the field from p to q in *x, surrounded by
+ *		spaces and quotes, or NaN when it is empty. Returns 0 when
+ *		the field is not numeric.
+ */
+static int csv_number(const char* p, const char* q, double* x)
+{
+    char buf[CSV_FIELD], *ptr;
+    const char* s;
+    uint64_t m = 0;
+    int neg = 0, any = 0, digits = 0, exp = 0, e = 0, eneg;
+
+    while (p < q && (*p == ' ' || *p == '\t' || *p == '"'))
+        p++;
+    while (q > p && (q[-1] == ' ' || q[-1] == '\t' || q[-1] == '"'))
+        q--;
+    if (p == q) {
+        *x = NAN;
+        return 1;
+    }
+    s = p;
+    if (*s == '-' || *s == '+')
+        neg = *s++ == '-';
+    for (; s < q && *s >= '0' && *s <= '9'; s++, any = 1)
+        if (digits < 19) {
+            m = m * 10 + (*s - '0');
+            digits += m != 0;
+        } else
+            exp++;
+    if (s < q && *s == '.')
+        for (s++; s < q && *s >= '0' && *s <= '9'; s++, any = 1)
+            if (digits < 19) {
+                m = m * 10 + (*s - '0');
+                digits += m != 0;
+                exp--;
+            }
+    if (any && s < q && (*s == 'e' || *s == 'E')) {
+        s++;
+        eneg = s < q && *s == '-';
+        if (s < q && (*s == '-' || *s == '+'))
+            s++;
+        for (any = 0; s < q && *s >= '0' && *s <= '9'; s++, any = 1)
+            if (e < 10000)
+                e = e * 10 + (*s - '0');
+        exp += eneg ? -e : e;
+    }
+    if (any && s == q && digits <= 15 && exp >= -22 && exp <= 22) {
+        *x = exp < 0 ? (double)m / csv_tens[-exp] : (double)m * csv_tens[exp];
+        if (neg)
+            *x = -*x;
+        return 1;
+    }
+    if (q - p >= CSV_FIELD) /* not a number that strtod reads either */
+        return 0;
+    memcpy(buf, p, q - p);
+    buf[q - p] = 0;
+    *x = strtod(buf, &ptr);
+    return ptr == buf + (q - p);
+}
+
+/*
+ * csv_fields - the number of fields of the line from p to q.
+ */
+static int64_t csv_fields(const char* p, const char* q, int sep)
+{
+    int64_t n = 1;
+
+    for (; (p = memchr(p, sep, q - p)) != 0; p++)
+        n++;
+    return n;
+}
+
+/*
+ * csv_numeric - whether all fields of the line from p to q are numeric.
+ */
+static int csv_numeric(const char* p, const char* q, int sep)
+{
+    const char* f;
+    double x;
+
+    for (;; p = f + 1) {
+        if ((f = memchr(p, sep, q - p)) == 0)
+            f = q;
+        if (!csv_number(p, f, &x))
+            return 0;
+        if (f == q)
+            return 1;
+    }
+}
+
+/*
+ * csv_count - count the lines of a chunk that are not blank.
+ */
+static void csv_count(CsvChunk* ch)
+{
+    const char *p, *q, *next;
+
+    for (p = ch->p; p < ch->end; p = next) {
+        q = csv_line(p, ch->end, &next);
+        if (!csv_blank(p, q))
+            ch->rows++;
+    }
+}
+
+/*
+ * csv_parse - parse the lines of a chunk into rows of cols elements of mat,
+ *	       from the row where the chunk starts.
+ */
+static void csv_parse(CsvChunk* ch, double* mat, int64_t cols, int sep)
+{
+    int64_t j;
+    double* row = mat + ch->row * cols;
+    const char *p, *q, *f, *next;
+
+    for (p = ch->p; p < ch->end; p = next) {
+        q = csv_line(p, ch->end, &next);
+        if (csv_blank(p, q))
+            continue;
+        for (j = 0;; j++, p = f + 1) {
+            if ((f = memchr(p, sep, q - p)) == 0)
+                f = q;
+            if (j == cols || (f == q && j < cols - 1)) {
+                ch->msg = "rows with the same number of fields";
+                return;
+            }
+            if (!csv_number(p, f, &row[j])) {
+                ch->msg = "numeric fields";
+                return;
+            }
+            if (f == q)
+                break;
+        }
+        row += cols;
+    }
+}
+
+/*
+ * csv_read - the matrix of doubles of the numeric table in the file at
+ *	      path, with fields separated by sep, in res, or an error message.
+ */
+char* csv_read(pEnv env, char* path, int sep, MatrixData** res)
+{
+    char* msg;
+    VectorData* vec;
+    CsvChunk* chunk;
+    const char *p, *q = 0, *end, *next;
+    int64_t i, n, rows = 0, cols = 0;
+
+    if ((msg = bytes_map(env, path, &vec)) != 0)
+        return msg;
+    native_store(vec); /* nothing is collected before the end */
+    p = vec->data;
+    end = p + vec->len;
+    for (; p < end; p = next) { /* the first line that is not blank */
+        q = csv_line(p, end, &next);
+        if (!csv_blank(p, q))
+            break;
+    }
+    if (p < end) {
+        if (!csv_numeric(p, q, sep)) { /* a header */
+            for (p = next; p < end; p = next) {
+                q = csv_line(p, end, &next);
+                if (!csv_blank(p, q))
+                    break;
+            }
+        }
+        if (p < end)
+            cols = csv_fields(p, q, sep);
+    }
+    /*
+     * Chunks start after the newline that follows an equal share of the
+     * text; a chunk can be empty.
+     */
+    n = (end - p) / CSV_CHUNK + 1;
+    chunk = check_malloc(n * sizeof(CsvChunk));
+    for (i = 0; i < n; i++) {
+        chunk[i].p = i ? chunk[i - 1].end : p;
+        if (i == n - 1)
+            chunk[i].end = end;
+        else {
+            q = p + (end - p) / n * (i + 1);
+            if (q < chunk[i].p)
+                q = chunk[i].p;
+            csv_line(q, end, &chunk[i].end);
+        }
+        chunk[i].row = chunk[i].rows = 0;
+        chunk[i].msg = 0;
+    }
+#ifdef JOY_PARALLEL
+#pragma omp parallel for schedule(dynamic) if (n > 1)
+#endif
+    for (i = 0; i < n; i++)
+        csv_count(&chunk[i]);
+    for (i = 0; i < n; i++) {
+        chunk[i].row = rows;
+        rows += chunk[i].rows;
+    }
+    if (cols && rows > NATIVE_MAX_LEN / cols) {
+        free(chunk);
+        return "smaller size";
+    }
+    *res = native_matrix(env, DT_F64, rows, cols);
+#ifdef JOY_PARALLEL
+#pragma omp parallel for schedule(dynamic) if (n > 1)
+#endif
+    for (i = 0; i < n; i++)
+        csv_parse(&chunk[i], (*res)->data, cols, sep);
+    for (i = 0; i < n && !msg; i++)
+        msg = chunk[i].msg;
+    free(chunk);
+    if (msg) /* released by the collector */
+        native_store(*res);
+    return msg;
+}
@@ -0,0 +1,410 @@
+/*
+ *  module  : data.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Reading Joy literals without the parser.
+ *
+ *  data_read reads numbers, characters, strings, sets, lists, true and false
+ *  and the v[ and m[[ literals of native values from text in memory, as
+ *  writefactor writes them, in one pass. Names are not looked up and nothing
+ *  is defined: any other name is an error. The values are pushed on the stack
+ *  as they are read, where the collector sees them, and the nodes of a list
+ *  are linked in place when its ] is read.
+ */
+#include "globals.h"
+
+typedef struct Data {
+    const char *p, *end; /* text that is left */
+    char* buf;           /* characters of a string */
+    int64_t room;
+    int64_t* count;      /* values read in each open list */
+    int64_t depth, size;
+#ifdef JOY_NATIVE_TYPES
+    double* num;         /* elements of a native literal */
+    int64_t leng, max;
+#endif
+} Data;
+
+/*
+ * data_grow - room for size elements of width bytes in ptr, that has room
+ *	       for *max.
+ */
+static void* data_grow(void* ptr, int64_t* max, int64_t size, size_t width)
+{
+    if (size < *max)
+        return ptr;
+    *max = size * 2 + 64;
+    ptr = realloc(ptr, *max * width);
+#ifdef TEST_MALLOC_RETURN
+    if (!ptr)
+        fatal("memory exhausted");
+#endif
+    return ptr;
+}
+
+/*
+ * data_stop - whether ch ends a number or a name.
+ */
+static int data_stop(int ch)
+{
+    return ch <= ' ' || strchr("\"#'().;[]{}", ch);
+}
+
+/*
+ * data_skip - skip white space, comments and full stops.
+ */
+static void data_skip(Data* d)
+{
+    for (; d->p < d->end; d->p++)
+        if (*d->p == '#') {
+            while (d->p < d->end && *d->p != '\n')
+                d->p++;
+            if (d->p == d->end)
+                return;
+        } else if (*d->p == '(' && d->p + 1 < d->end && d->p[1] == '*') {
+            for (d->p += 2; d->p + 1 < d->end; d->p++)
+                if (*d->p == '*' && d->p[1] == ')')
+                    break;
+            if (++d->p >= d->end) {
+                d->p = d->end;
+                return;
+            }
+        } else if (*d->p > ' ' && *d->p != '.')
+            return;
+}
+
+/*
+ * data_special - the character after a backslash, as special in scan.c.
+ */
+static int data_special(Data* d)
+{
+    int ch, i;
+
+    if (d->p == d->end)
+        return '\\';
+    switch (ch = (unsigned char)*d->p++) {
+    case 'b':
+        return '\b';
+    case 't':
+        return '\t';
+    case 'n':
+        return '\n';
+    case 'v':
+        return '\v';
+    case 'f':
+        return '\f';
+    case 'r':
+        return '\r';
+    default:
+        if (isdigit(ch)) {
+            ch -= '0';
+            for (i = 0; i < 2 && d->p < d->end && isdigit((int)*d->p); i++)
+                ch = 10 * ch + *d->p++ - '0';
+        }
+        return ch;
+    }
+}
+
+/*
+ * data_number - read the number at d->p into u, and return its type, or 0
+ *		 when there is no number. Floats have a decimal point or an
+ *		 exponent, and integers that are too large become floats.
+ */
+static int data_number(Data* d, Types* u)
+{
+    char* ptr;
+    const char* q = d->p;
+    int neg = *q == '-', type = INTEGER_;
+
+    if (!isdigit((int)q[neg]))
+        return 0;
+    for (q += neg; q < d->end; q++)
+        if (*q == '.' && q + 1 < d->end && isdigit((int)q[1]))
+            type = FLOAT_;
+        else if (data_stop(*q))
+            break;
+    if (type == INTEGER_) {
+        u->num = strtoll(d->p + neg, &ptr, 0);
+        if (u->num == MAXINT_ || ptr != q)
+            type = FLOAT_;
+        else if (neg)
+            u->num = -u->num;
+    }
+    if (type == FLOAT_)
+        u->dbl = strtod(d->p, &ptr);
+    if (ptr != q)
+        return 0;
+    d->p = q;
+    return type;
+}
+
+/*
+ * data_string - push the string at d->p, after its opening quote.
+ */
+static char* data_string(pEnv env, Data* d)
+{
+    size_t leng = 0;
+    const char* q;
+    int ch;
+
+    for (;;) {
+        for (q = d->p; q < d->end && *q != '"' && *q != '\\'; q++)
+            ;
+        d->buf = data_grow(d->buf, &d->room, leng + (q - d->p) + 2, 1);
+        memcpy(d->buf + leng, d->p, q - d->p);
+        leng += q - d->p;
+        if ((d->p = q) == d->end)
+            return "closing quote";
+        if (*d->p++ == '"')
+            break;
+        ch = data_special(d);
+        d->buf[leng++] = ch;
+    }
+    if (leng > MAX_STRING_LEN) /* raised after d->buf is released */
+        return "smaller size";
+    d->buf[leng] = 0;
+#ifdef NOBDW
+    NULLARY(STRING_NEWNODE, d->buf);
+#else
+    NULLARY(STRING_NEWNODE, GC_strdup(d->buf));
+#endif
+    return 0;
+}
+
+/*
+ * data_set - push the set at d->p, after its {.
+ */
+static char* data_set(pEnv env, Data* d)
+{
+    Types u;
+    uint64_t set = 0;
+
+    for (;;) {
+        data_skip(d);
+        if (d->p == d->end)
+            return "closing }";
+        if (*d->p == '}')
+            break;
+        if (*d->p == '\'' && d->p + 1 < d->end) {
+            d->p++;
+            if ((u.num = (unsigned char)*d->p++) == '\\')
+                u.num = data_special(d);
+        } else if (data_number(d, &u) != INTEGER_)
+            return "small numeric in set";
+        if (u.num < 0 || u.num >= SETSIZE)
+            return "small numeric in set";
+        set |= (uint64_t)1 << u.num;
+    }
+    d->p++;
+    NULLARY(SET_NEWNODE, set);
+    return 0;
+}
+
+#ifdef JOY_NATIVE_TYPES
+/*
+ * data_row - read the numbers of a native literal up to and past ].
+ */
+static char* data_row(Data* d)
+{
+    Types u;
+    int type;
+
+    u.num = 0;
+    for (;;) {
+        data_skip(d);
+        if (d->p == d->end)
+            return "closing ]";
+        if (*d->p == ']')
+            break;
+        if ((type = data_number(d, &u)) == 0)
+            return "number in native literal";
+        d->num = data_grow(d->num, &d->max, d->leng + 1, sizeof(double));
+        d->num[d->leng++] = type == FLOAT_ ? u.dbl : (double)u.num;
+    }
+    d->p++;
+    return 0;
+}
+
+/*
+ * data_native - push the vector or matrix at d->p, after v[ or m[.
+ */
+static char* data_native(pEnv env, Data* d, int matrix)
+{
+    char* msg;
+    VectorData* vec;
+    MatrixData* mat;
+    int64_t rows = 0, cols = 0;
+
+    d->leng = 0;
+    if (!matrix) {
+        if ((msg = data_row(d)) != 0)
+            return msg;
+        vec = native_vector(env, DT_F64, d->leng);
+        if (d->leng)
+            memcpy(vec->data, d->num, d->leng * sizeof(double));
+        NULLARY(VECTOR_NEWNODE, vec);
+        return 0;
+    }
+    for (;;) {
+        data_skip(d);
+        if (d->p < d->end && *d->p == ']')
+            break;
+        if (d->p == d->end || *d->p++ != '[')
+            return "'[' or ']' in matrix literal";
+        if ((msg = data_row(d)) != 0)
+            return msg;
+        if (!rows++)
+            cols = d->leng;
+        else if (d->leng != rows * cols)
+            return "matrix rows of equal length";
+    }
+    d->p++;
+    mat = native_matrix(env, DT_F64, rows, cols);
+    if (d->leng)
+        memcpy(mat->data, d->num, d->leng * sizeof(double));
+    NULLARY(MATRIX_NEWNODE, mat);
+    return 0;
+}
+#endif
+
+/*
+ * data_name - push true or false, or a native literal.
+ */
+static char* data_name(pEnv env, Data* d)
+{
+    const char* q;
+    size_t leng;
+
+    for (q = d->p; q < d->end && !data_stop(*q); q++)
+        ;
+    leng = q - d->p;
+#ifdef JOY_NATIVE_TYPES
+    if (leng == 1 && q < d->end && *q == '['
+        && (*d->p == 'v' || *d->p == 'm')) {
+        d->p = q + 1;
+        return data_native(env, d, q[-1] == 'm');
+    }
+#endif
+    if (leng == 4 && !strncmp(d->p, "true", 4))
+        NULLARY(BOOLEAN_NEWNODE, 1);
+    else if (leng == 5 && !strncmp(d->p, "false", 5))
+        NULLARY(BOOLEAN_NEWNODE, 0);
+    else
+        return "literal";
+    d->p = q;
+    return 0;
+}
+
+/*
+ * data_list - make a list of the top n values of the stack, that are
+ *	       linked in place, and push it.
+ */
+static void data_list(pEnv env, int64_t n)
+{
+    Index list = 0, next;
+
+    while (n-- > 0) {
+        next = nextnode1(env->stck);
+        nextnode1(env->stck) = list;
+        list = env->stck;
+        env->stck = next;
+    }
+    NULLARY(LIST_NEWNODE, list);
+}
+
+/*
+ * data_read - push the list of the values of the literals in the n
+ *	       characters s, or return an error message. s[n] is 0.
+ */
+char* data_read(pEnv env, const char* s, size_t n)
+{
+    Data d;
+    Types u;
+    char* msg = 0;
+    int type;
+
+    memset(&d, 0, sizeof(Data));
+    d.p = s;
+    d.end = s + n;
+    d.count = data_grow(d.count, &d.size, 0, sizeof(int64_t));
+    d.count[0] = 0;
+    for (;;) {
+        data_skip(&d);
+        if (d.p == d.end)
+            break;
+        switch (*d.p++) {
+        case '[':
+            d.count = data_grow(d.count, &d.size, ++d.depth, sizeof(int64_t));
+            d.count[d.depth] = 0;
+            continue;
+        case ']':
+            if (d.depth)
+                data_list(env, d.count[d.depth--]);
+            else
+                msg = "literal";
+            break;
+        case '{':
+            msg = data_set(env, &d);
+            break;
+        case '"':
+            msg = data_string(env, &d);
+            break;
+        case '\'':
+            if (d.p == d.end) {
+                msg = "character";
+                break;
+            }
+            if ((u.num = (unsigned char)*d.p++) == '\\')
+                u.num = data_special(&d);
+            NULLARY(CHAR_NEWNODE, u.num);
+            break;
+        default:
+            d.p--;
+            if ((type = data_number(&d, &u)) == INTEGER_)
+                NULLARY(INTEGER_NEWNODE, u.num);
+            else if (type == FLOAT_)
+                NULLARY(FLOAT_NEWNODE, u.dbl);
+            else
+                msg = data_name(env, &d);
+            break;
+        }
+        if (msg)
+            break;
+        d.count[d.depth]++;
+    }
+    if (!msg && d.depth)
+        msg = "closing ]";
+    if (msg) /* drop the values that were read */
+        for (; d.depth >= 0; d.depth--)
+            while (d.count[d.depth]--)
+                POP(env->stck);
+    else
+        data_list(env, d.count[0]);
+    free(d.buf);
+    free(d.count);
+#ifdef JOY_NATIVE_TYPES
+    free(d.num);
+#endif
+    return msg;
+}
+
+/*
+ * data_fread - push the list of the values of the literals in the rest of
+ *		file fp, or return an error message.
+ */
+char* data_fread(pEnv env, FILE* fp)
+{
+    char *buf = 0, *msg;
+    size_t leng = 0, got;
+    int64_t room = 0;
+
+    do {
+        buf = data_grow(buf, &room, leng + INPBLOCKMAX + 1, 1);
+        leng += got = fread(buf + leng, 1, INPBLOCKMAX, fp);
+    } while (got == INPBLOCKMAX);
+    buf[leng] = 0;
+    msg = ferror(fp) ? "readable stream" : data_read(env, buf, leng);
+    free(buf);
+    return msg;
+}
@@ -1,7 +1,7 @@
 /*
  *  module  : error.c
- *  version : 1.6
- *  date    : 01/21/26
+ *  version : 1.7
+ *  date    : 10/18/26
  */
 #include "globals.h"
 
@@ -16,6 +16,32 @@ void fatal(char *str)
     exit(EXIT_FAILURE);
 }
 
+/*
+ * cleanup_push - have proc called with data at the end of the builtin that
+ *		  holds it, or when execution is aborted before that.
+ */
+void cleanup_push(pEnv env, void (*proc)(void* data), void* data)
+{
+    Cleanup clean;
+
+    if (!env->cleanups)
+        vec_init(env->cleanups);
+    clean.proc = proc;
+    clean.data = data;
+    vec_push(env->cleanups, clean);
+}
+
+/*
+ * cleanup_pop - call the procedure that was pushed last, and remove it.
+ */
+void cleanup_pop(pEnv env)
+{
+    Cleanup clean;
+
+    clean = vec_pop(env->cleanups);
+    clean.proc(clean.data);
+}
+
 /*
  * abort execution and restart reading from srcfile; the stack is not cleared.
  */
@@ -23,6 +49,11 @@ void abortexecution_(pEnv env, int num)
 {
     fflush(stdin);
     env->finclude_busy = 0; /* Reset finclude state on abort */
+    while (vec_size(env->cleanups)) /* memory held by builtins */
+        cleanup_pop(env);
+#ifdef NOBDW
+    pattern_unbind(env, 0); /* restore variables of match and cases */
+#endif
     longjmp(env->error_jmp, num);
 }
 
@@ -139,10 +139,9 @@ int readfactor(pEnv env, int ch, int* rv) /* read a JOY factor */
             ch = getsym(env, ch);
         }
         /* Create VectorData */
-        vec = GC_CTX_MALLOC_ATOMIC(env, sizeof(VectorData) + len * sizeof(double));
-        vec->len = len;
-        for (index = 0; index < len; index++)
-            vec->data[index] = values[index];
+        vec = native_vector(env, DT_F64, len);
+        if (len)
+            memcpy(vec->data, values, len * sizeof(double));
         free(values);
         NULLARY(VECTOR_NEWNODE, vec);
         break;
@@ -229,11 +228,9 @@ int readfactor(pEnv env, int ch, int* rv) /* read a JOY factor */
 
         if (cols == -1) cols = 0;  /* empty matrix */
         /* Create MatrixData */
-        mat = GC_CTX_MALLOC_ATOMIC(env, sizeof(MatrixData) + rows * cols * sizeof(double));
-        mat->rows = rows;
-        mat->cols = cols;
-        for (index = 0; index < rows * cols; index++)
-            mat->data[index] = values[index];
+        mat = native_matrix(env, DT_F64, rows, cols);
+        if (rows && cols)
+            memcpy(mat->data, values, (size_t)rows * cols * sizeof(double));
         free(values);
         NULLARY(MATRIX_NEWNODE, mat);
         break;
@@ -0,0 +1,438 @@
+/*
+ *  module  : fft.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Fast Fourier transforms and convolution of doubles.
+ *
+ *  Complex numbers are pairs of doubles, the real part first. The transform
+ *  is a mixed-radix Cooley-Tukey decimation in time: the length is factored
+ *  into 4, 2, 3, 5 and other primes, and each stage combines the transforms
+ *  of the previous one with a butterfly of that radix. The stages work on
+ *  adjacent blocks of the output, that become larger with each stage, such
+ *  that small transforms stay in the caches. A length with a prime factor
+ *  above FFT_PRIME is transformed by Bluestein's algorithm, as a convolution
+ *  of a power of two length. A real input of even length is transformed as
+ *  a complex input of half that length, of which the halves are separated
+ *  afterwards. Inverse transforms are scaled by 1 / n.
+ */
+#include "globals.h"
+
+#define FFT_PRIME 64   /* larger prime factors use Bluestein's algorithm */
+#define FFT_DIRECT 64  /* shorter kernels are convolved directly */
+#define FFT_FACTORS 64 /* room for factors, in pairs */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct FftComplex {
+    double re, im;
+} FftComplex;
+
+/*
+ * The factors of a length n, and the twiddle factors exp(-2 pi i k / n).
+ */
+typedef struct FftPlan {
+    int64_t n;
+    int64_t factor[2 * FFT_FACTORS]; /* radix p and remaining length m */
+    FftComplex* tw;
+    FftComplex scratch[FFT_PRIME];
+} FftPlan;
+
+/*
+ * Factor n into radices, 4 first. The result is 0 if a factor is too large.
+ */
+static int fft_factor(int64_t n, int64_t* factor)
+{
+    int64_t p = 4;
+
+    while (n > 1) {
+        while (n % p) {
+            p = p == 4 ? 2 : p == 2 ? 3 : p + 2;
+            if (p * p > n)
+                p = n;
+            if (p > FFT_PRIME)
+                return 0;
+        }
+        n /= p;
+        *factor++ = p;
+        *factor++ = n;
+    }
+    return 1;
+}
+
+/*
+ * Prepare plan for a transform of length n, if it can be factored.
+ */
+static int fft_plan(FftPlan* plan, int64_t n)
+{
+    int64_t k;
+
+    plan->n = n;
+    if (!fft_factor(n, plan->factor))
+        return 0;
+    plan->tw = check_malloc(n * sizeof(FftComplex));
+    for (k = 0; k < n; k++) {
+        plan->tw[k].re = cos(2 * M_PI * k / n);
+        plan->tw[k].im = -sin(2 * M_PI * k / n);
+    }
+    return 1;
+}
+
+/*
+ * Radix 2: combine the transforms of length m at out and out + m.
+ */
+static void fft_radix2(FftPlan* plan, FftComplex* out, int64_t stride,
+                       int64_t m)
+{
+    int64_t k;
+    FftComplex t, *a = out, *b = out + m, *tw = plan->tw;
+
+    for (k = 0; k < m; k++, tw += stride) {
+        t.re = b[k].re * tw->re - b[k].im * tw->im;
+        t.im = b[k].re * tw->im + b[k].im * tw->re;
+        b[k].re = a[k].re - t.re;
+        b[k].im = a[k].im - t.im;
+        a[k].re += t.re;
+        a[k].im += t.im;
+    }
+}
+
+/*
+ * Radix 4: combine four transforms of length m, m apart.
+ */
+static void fft_radix4(FftPlan* plan, FftComplex* out, int64_t stride,
+                       int64_t m)
+{
+    int64_t k;
+    FftComplex s0, s1, s2, s3, s4, s5, *w1, *w2, *w3;
+
+    for (k = 0; k < m; k++, out++) {
+        w1 = plan->tw + k * stride;
+        w2 = plan->tw + 2 * k * stride;
+        w3 = plan->tw + 3 * k * stride;
+        s0.re = out[m].re * w1->re - out[m].im * w1->im;
+        s0.im = out[m].re * w1->im + out[m].im * w1->re;
+        s1.re = out[2 * m].re * w2->re - out[2 * m].im * w2->im;
+        s1.im = out[2 * m].re * w2->im + out[2 * m].im * w2->re;
+        s2.re = out[3 * m].re * w3->re - out[3 * m].im * w3->im;
+        s2.im = out[3 * m].re * w3->im + out[3 * m].im * w3->re;
+        s5.re = out->re - s1.re;
+        s5.im = out->im - s1.im;
+        out->re += s1.re;
+        out->im += s1.im;
+        s3.re = s0.re + s2.re;
+        s3.im = s0.im + s2.im;
+        s4.re = s0.re - s2.re;
+        s4.im = s0.im - s2.im;
+        out[2 * m].re = out->re - s3.re;
+        out[2 * m].im = out->im - s3.im;
+        out->re += s3.re;
+        out->im += s3.im;
+        out[m].re = s5.re + s4.im;
+        out[m].im = s5.im - s4.re;
+        out[3 * m].re = s5.re - s4.im;
+        out[3 * m].im = s5.im + s4.re;
+    }
+}
+
+/*
+ * Other radices p: combine p transforms of length m, m apart.
+ */
+static void fft_radix(FftPlan* plan, FftComplex* out, int64_t stride,
+                      int64_t m, int64_t p)
+{
+    FftComplex *w, *s = plan->scratch;
+    int64_t u, k, q, q1, t;
+
+    for (u = 0; u < m; u++) {
+        for (q1 = 0, k = u; q1 < p; q1++, k += m)
+            s[q1] = out[k];
+        for (q1 = 0, k = u; q1 < p; q1++, k += m) {
+            out[k] = s[0];
+            for (q = 1, t = 0; q < p; q++) {
+                if ((t += stride * k) >= plan->n)
+                    t -= plan->n;
+                w = plan->tw + t;
+                out[k].re += s[q].re * w->re - s[q].im * w->im;
+                out[k].im += s[q].re * w->im + s[q].im * w->re;
+            }
+        }
+    }
+}
+
+/*
+ * Transform the elements of in, stride apart, to out, by the factors.
+ */
+static void fft_work(FftPlan* plan, FftComplex* out, const FftComplex* in,
+                     int64_t stride, const int64_t* factor)
+{
+    int64_t p, m, i;
+
+    p = *factor++;
+    m = *factor++;
+    if (m == 1)
+        for (i = 0; i < p; i++)
+            out[i] = in[i * stride];
+    else
+        for (i = 0; i < p; i++)
+            fft_work(plan, out + i * m, in + i * stride, stride * p, factor);
+    switch (p) {
+    case 2:
+        fft_radix2(plan, out, stride, m);
+        break;
+    case 4:
+        fft_radix4(plan, out, stride, m);
+        break;
+    default:
+        fft_radix(plan, out, stride, m, p);
+        break;
+    }
+}
+
+/*
+ * The smallest power of two of at least n.
+ */
+static int64_t fft_pow2(int64_t n)
+{
+    int64_t m = 1;
+
+    while (m < n)
+        m *= 2;
+    return m;
+}
+
+/*
+ * Forward transform of length n by Bluestein's algorithm: x_k is multiplied
+ * by the chirp w_k = exp(-pi i k^2 / n), convolved with its conjugate, and
+ * multiplied by w_k again.
+ */
+static void fft_bluestein(FftComplex* x, int64_t n)
+{
+    double re;
+    int64_t k, m, q;
+    FftComplex *w, *a, *b;
+
+    m = fft_pow2(2 * n - 1);
+    w = check_malloc(n * sizeof(FftComplex));
+    a = check_malloc(m * sizeof(FftComplex));
+    b = check_malloc(m * sizeof(FftComplex));
+    memset(a, 0, m * sizeof(FftComplex));
+    memset(b, 0, m * sizeof(FftComplex));
+    for (k = q = 0; k < n; k++) { /* q is k^2 modulo 2n */
+        w[k].re = cos(M_PI * q / n);
+        w[k].im = -sin(M_PI * q / n);
+        if ((q += 2 * k + 1) >= 2 * n)
+            q -= 2 * n;
+        a[k].re = x[k].re * w[k].re - x[k].im * w[k].im;
+        a[k].im = x[k].re * w[k].im + x[k].im * w[k].re;
+        b[k].re = w[k].re;
+        b[k].im = -w[k].im;
+        if (k)
+            b[m - k] = b[k];
+    }
+    fft_complex((double*)a, m, 0);
+    fft_complex((double*)b, m, 0);
+    for (k = 0; k < m; k++) {
+        re = a[k].re * b[k].re - a[k].im * b[k].im;
+        a[k].im = a[k].re * b[k].im + a[k].im * b[k].re;
+        a[k].re = re;
+    }
+    fft_complex((double*)a, m, 1);
+    for (k = 0; k < n; k++) {
+        x[k].re = a[k].re * w[k].re - a[k].im * w[k].im;
+        x[k].im = a[k].re * w[k].im + a[k].im * w[k].re;
+    }
+    free(w);
+    free(a);
+    free(b);
+}
+
+/*
+ * fft_complex - transform the n complex numbers at x in place, forward or,
+ *		 when inverse, backward and divided by n.
+ */
+void fft_complex(double* x, int64_t n, int inverse)
+{
+    int64_t k;
+    FftPlan plan;
+    FftComplex* out;
+
+    if (n <= 1)
+        return;
+    if (inverse) /* by conjugating the forward transform */
+        for (k = 0; k < n; k++)
+            x[2 * k + 1] = -x[2 * k + 1];
+    if (fft_plan(&plan, n)) {
+        out = check_malloc(n * sizeof(FftComplex));
+        fft_work(&plan, out, (FftComplex*)x, 1, plan.factor);
+        memcpy(x, out, n * sizeof(FftComplex));
+        free(out);
+        free(plan.tw);
+    } else
+        fft_bluestein((FftComplex*)x, n);
+    if (inverse)
+        for (k = 0; k < n; k++) {
+            x[2 * k] /= n;
+            x[2 * k + 1] /= -n;
+        }
+}
+
+/*
+ * fft_real - transform the n doubles at x to the n / 2 + 1 complex numbers
+ *	      at c, the others being their conjugates.
+ */
+void fft_real(const double* x, int64_t n, double* c)
+{
+    int64_t h, k;
+    double wr, wi, er, ei, orr, oi;
+    FftComplex *z, *out = (FftComplex*)c;
+
+    if (n % 2 || n < 4) { /* as complex numbers */
+        z = check_malloc((n ? n : 1) * sizeof(FftComplex));
+        for (k = 0; k < n; k++) {
+            z[k].re = x[k];
+            z[k].im = 0;
+        }
+        fft_complex((double*)z, n, 0);
+        memcpy(c, z, (n / 2 + 1) * sizeof(FftComplex));
+        free(z);
+        return;
+    }
+    h = n / 2; /* even and odd elements as one complex number */
+    z = check_malloc(h * sizeof(FftComplex));
+    memcpy(z, x, n * sizeof(double));
+    fft_complex((double*)z, h, 0);
+    out[0].re = z[0].re + z[0].im; /* both real */
+    out[0].im = 0;
+    out[h].re = z[0].re - z[0].im;
+    out[h].im = 0;
+    for (k = 1; k < h; k++) {
+        er = (z[k].re + z[h - k].re) / 2;
+        ei = (z[k].im - z[h - k].im) / 2;
+        orr = (z[k].im + z[h - k].im) / 2;
+        oi = -(z[k].re - z[h - k].re) / 2;
+        wr = cos(2 * M_PI * k / n);
+        wi = -sin(2 * M_PI * k / n);
+        out[k].re = er + orr * wr - oi * wi;
+        out[k].im = ei + orr * wi + oi * wr;
+    }
+    free(z);
+}
+
+/*
+ * fft_ireal - the n doubles at x whose transform has the n / 2 + 1 complex
+ *	       numbers at c; the inverse of fft_real.
+ */
+void fft_ireal(const double* c, int64_t n, double* x)
+{
+    int64_t h, k;
+    double wr, wi, er, ei, orr, oi;
+    const FftComplex* in = (const FftComplex*)c;
+    FftComplex* z;
+
+    if (n % 2 || n < 4) { /* from all complex numbers */
+        z = check_malloc((n ? n : 1) * sizeof(FftComplex));
+        for (k = 0; k < n; k++)
+            if (k <= n / 2)
+                z[k] = in[k];
+            else {
+                z[k].re = in[n - k].re;
+                z[k].im = -in[n - k].im;
+            }
+        fft_complex((double*)z, n, 1);
+        for (k = 0; k < n; k++)
+            x[k] = z[k].re;
+        free(z);
+        return;
+    }
+    h = n / 2;
+    z = check_malloc(h * sizeof(FftComplex));
+    for (k = 0; k < h; k++) {
+        er = (in[k].re + in[h - k].re) / 2;
+        ei = (in[k].im - in[h - k].im) / 2;
+        orr = (in[k].re - in[h - k].re) / 2;
+        oi = (in[k].im + in[h - k].im) / 2;
+        wr = cos(2 * M_PI * k / n);
+        wi = sin(2 * M_PI * k / n);
+        z[k].re = er - (orr * wi + oi * wr);
+        z[k].im = ei + orr * wr - oi * wi;
+    }
+    fft_complex((double*)z, h, 1);
+    memcpy(x, z, n * sizeof(double));
+    free(z);
+}
+
+/*
+ * The smallest length of at least n whose factors are 2, 3 and 5, and that
+ * is even.
+ */
+static int64_t fft_size(int64_t n)
+{
+    int64_t m, best = fft_pow2(n), p3, p5;
+
+    for (p5 = 1; p5 < best; p5 *= 5)
+        for (p3 = p5; p3 < best; p3 *= 3) {
+            for (m = 2 * p3; m < n; m *= 2)
+                ;
+            if (m < best)
+                best = m;
+        }
+    return best;
+}
+
+/*
+ * fft_convolve - the na + nb - 1 elements of the convolution of a and b in
+ *		  c. A short kernel is applied directly, one pass over a for
+ *		  each of its elements; otherwise, the transforms of a and b
+ *		  are multiplied.
+ */
+void fft_convolve(const double* a, int64_t na, const double* b, int64_t nb,
+                  double* c)
+{
+    double x, re, *fa, *fb, *t;
+    const double* s;
+    int64_t i, j, n, size;
+
+    if (!na || !nb)
+        return;
+    if (na < nb) { /* b is the shorter */
+        s = a;
+        a = b;
+        b = s;
+        n = na;
+        na = nb;
+        nb = n;
+    }
+    if (nb <= FFT_DIRECT) {
+        memset(c, 0, (na + nb - 1) * sizeof(double));
+        for (j = 0; j < nb; j++) {
+            x = b[j];
+            t = c + j;
+            _Pragma("omp simd") for (i = 0; i < na; i++) t[i] += x * a[i];
+        }
+        return;
+    }
+    n = fft_size(na + nb - 1);
+    size = (n / 2 + 1) * 2;
+    t = check_malloc(n * sizeof(double));
+    fa = check_malloc(size * sizeof(double));
+    fb = check_malloc(size * sizeof(double));
+    memcpy(t, a, na * sizeof(double));
+    memset(t + na, 0, (n - na) * sizeof(double));
+    fft_real(t, n, fa);
+    memcpy(t, b, nb * sizeof(double));
+    memset(t + nb, 0, (n - nb) * sizeof(double));
+    fft_real(t, n, fb);
+    for (i = 0; i < size; i += 2) {
+        re = fa[i] * fb[i] - fa[i + 1] * fb[i + 1];
+        fa[i + 1] = fa[i] * fb[i + 1] + fa[i + 1] * fb[i];
+        fa[i] = re;
+    }
+    fft_ireal(fa, n, t);
+    memcpy(c, t, (na + nb - 1) * sizeof(double));
+    free(t);
+    free(fa);
+    free(fb);
+}
@@ -0,0 +1,203 @@
+/*
+ *  module  : gemm.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Matrix multiply of doubles and floats, used when there is no BLAS.
+ *
+ *  c += alpha * a * b is computed in blocks that fit in the caches: a panel
+ *  of GEMM_KC rows of b is copied to a packed buffer that stays in the L2/L3
+ *  cache, and for each block of GEMM_MC rows of a, a packed copy of that
+ *  block stays in the L2 cache while the panel is swept. The packed copies
+ *  hold slivers of GEMM_MR rows of a and GEMM_NR columns of b, stored such
+ *  that the micro kernel reads both in order. The micro kernel keeps a
+ *  GEMM_MR x GEMM_NR tile of c in registers for the whole depth of the
+ *  panel, so each element of a and b that is loaded is used GEMM_NR or
+ *  GEMM_MR times. Slivers at the edges are padded with zeros.
+ *
+ *  With JOY_PARALLEL, the blocks of rows of a are divided over the threads,
+ *  that share the packed panel of b; each thread packs its own blocks of a.
+ */
+#include "globals.h"
+#ifdef JOY_PARALLEL
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include <omp.h>
+#pragma GCC diagnostic pop
+#endif
+
+#define GEMM_MR 4      /* rows of the register tile */
+#define GEMM_NR 8      /* columns of the register tile */
+#define GEMM_MC 128    /* rows of a block of a */
+#define GEMM_KC 256    /* depth of a panel */
+#define GEMM_NC 2048   /* columns of a panel of b */
+#define GEMM_SMALL 32768 /* below m * n * k, multiply directly */
+#define GEMM_SPLIT 2097152 /* from m * n * k, use more than one thread */
+
+#define GEMM_MIN(x, y) ((x) < (y) ? (x) : (y))
+
+/*
+ * A version of the multiply for elements of type T, named gemm_SUF.
+ */
+#define GEMM(SUF, T)                                                          \
+    /*                                                                        \
+     * Copy mc x kc elements of a to ap, by slivers of GEMM_MR rows.          \
+     */                                                                       \
+    static void pack_a_##SUF(int64_t mc, int64_t kc, const T* a, int64_t lda, \
+                             T* restrict ap)                                  \
+    {                                                                         \
+        int64_t i, ir, p, mr;                                                 \
+                                                                              \
+        for (ir = 0; ir < mc; ir += GEMM_MR) {                                \
+            mr = GEMM_MIN(GEMM_MR, mc - ir);                                  \
+            for (p = 0; p < kc; p++) {                                        \
+                for (i = 0; i < mr; i++)                                      \
+                    ap[i] = a[(ir + i) * lda + p];                            \
+                for (; i < GEMM_MR; i++)                                      \
+                    ap[i] = 0;                                                \
+                ap += GEMM_MR;                                                \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * Copy kc x nc elements of b to bp, by slivers of GEMM_NR columns.       \
+     */                                                                       \
+    static void pack_b_##SUF(int64_t kc, int64_t nc, const T* b, int64_t ldb, \
+                             T* restrict bp)                                  \
+    {                                                                         \
+        int64_t j, jr, p, nr;                                                 \
+                                                                              \
+        for (jr = 0; jr < nc; jr += GEMM_NR) {                                \
+            nr = GEMM_MIN(GEMM_NR, nc - jr);                                  \
+            for (p = 0; p < kc; p++) {                                        \
+                for (j = 0; j < nr; j++)                                      \
+                    bp[j] = b[p * ldb + jr + j];                              \
+                for (; j < GEMM_NR; j++)                                      \
+                    bp[j] = 0;                                                \
+                bp += GEMM_NR;                                                \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * c += alpha * ap * bp for one tile, of which mr x nr elements exist.    \
+     */                                                                       \
+    static void micro_##SUF(int64_t kc, const T* restrict ap,                 \
+                            const T* restrict bp, T alpha, T* c, int64_t ldc, \
+                            int64_t mr, int64_t nr)                           \
+    {                                                                         \
+        int64_t i, j, p;                                                      \
+        T ab[GEMM_MR * GEMM_NR] = { 0 };                                      \
+                                                                              \
+        for (p = 0; p < kc; p++) {                                            \
+            for (i = 0; i < GEMM_MR; i++)                                     \
+                _Pragma("omp simd") for (j = 0; j < GEMM_NR; j++)             \
+                    ab[i * GEMM_NR + j] += ap[i] * bp[j];                     \
+            ap += GEMM_MR;                                                    \
+            bp += GEMM_NR;                                                    \
+        }                                                                     \
+        for (i = 0; i < mr; i++)                                              \
+            for (j = 0; j < nr; j++)                                          \
+                c[i * ldc + j] += alpha * ab[i * GEMM_NR + j];                \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * c += alpha * a * b for mc rows of a, packed in ap, and the panel bp.   \
+     */                                                                       \
+    static void block_##SUF(int64_t mc, int64_t nc, int64_t kc, T alpha,      \
+                            const T* ap, const T* bp, T* c, int64_t ldc)      \
+    {                                                                         \
+        int64_t ir, jr;                                                       \
+                                                                              \
+        for (jr = 0; jr < nc; jr += GEMM_NR)                                  \
+            for (ir = 0; ir < mc; ir += GEMM_MR)                              \
+                micro_##SUF(kc, ap + ir * kc, bp + jr * kc, alpha,            \
+                            c + ir * ldc + jr, ldc,                           \
+                            GEMM_MIN(GEMM_MR, mc - ir),                       \
+                            GEMM_MIN(GEMM_NR, nc - jr));                      \
+    }                                                                         \
+                                                                              \
+    void gemm_##SUF(int64_t m, int64_t n, int64_t k, T alpha, const T* a,     \
+                    int64_t lda, const T* b, int64_t ldb, T* c, int64_t ldc)  \
+    {                                                                         \
+        int64_t i, j, p, ic, jc, pc, mc, nc, kc, rows;                        \
+        T x, *ap, *bp;                                                        \
+                                                                              \
+        if (!m || !n || !k)                                                   \
+            return;                                                           \
+        if (m * n * k < GEMM_SMALL) {                                         \
+            for (i = 0; i < m; i++)                                           \
+                for (p = 0; p < k; p++) {                                     \
+                    x = alpha * a[i * lda + p];                               \
+                    _Pragma("omp simd") for (j = 0; j < n; j++)               \
+                        c[i * ldc + j] += x * b[p * ldb + j];                 \
+                }                                                             \
+            return;                                                           \
+        }                                                                     \
+        rows = gemm_rows(m, n, k);                                            \
+        kc = GEMM_MIN(GEMM_KC, k);                                            \
+        nc = GEMM_MIN(GEMM_NC, n);                                            \
+        bp = check_malloc(kc * (nc + GEMM_NR) * sizeof(T));                   \
+        for (jc = 0; jc < n; jc += GEMM_NC) {                                 \
+            nc = GEMM_MIN(GEMM_NC, n - jc);                                   \
+            for (pc = 0; pc < k; pc += GEMM_KC) {                             \
+                kc = GEMM_MIN(GEMM_KC, k - pc);                               \
+                pack_b_##SUF(kc, nc, b + pc * ldb + jc, ldb, bp);             \
+                GEMM_PARALLEL(m, rows)                                        \
+                {                                                             \
+                    ap = check_malloc(kc * (rows + GEMM_MR) * sizeof(T));     \
+                    GEMM_FOR                                                  \
+                    for (ic = 0; ic < m; ic += rows) {                        \
+                        mc = GEMM_MIN(rows, m - ic);                          \
+                        pack_a_##SUF(mc, kc, a + ic * lda + pc, lda, ap);     \
+                        block_##SUF(mc, nc, kc, alpha, ap, bp,                \
+                                    c + ic * ldc + jc, ldc);                  \
+                    }                                                         \
+                    free(ap);                                                 \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+        free(bp);                                                             \
+    }
+
+#ifdef JOY_PARALLEL
+/*
+ * The blocks of rows are divided over the threads, if there is enough work.
+ */
+#define GEMM_PARALLEL(m, rows)                                                \
+    _Pragma("omp parallel private(ap, ic, mc) if (m > rows)")
+#define GEMM_FOR _Pragma("omp for schedule(dynamic)")
+
+/*
+ * Rows of a block of a: GEMM_MC, or fewer such that each thread gets one.
+ */
+static int64_t gemm_rows(int64_t m, int64_t n, int64_t k)
+{
+    int64_t rows, threads = omp_get_max_threads();
+
+    if (threads < 2 || m * n * k < GEMM_SPLIT || m >= threads * GEMM_MC)
+        return GEMM_MC;
+    rows = (m + threads - 1) / threads;
+    rows = (rows + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+    return rows;
+}
+#else
+#define GEMM_PARALLEL(m, rows)
+#define GEMM_FOR
+
+static int64_t gemm_rows(int64_t m, int64_t n, int64_t k)
+{
+    (void)m;
+    (void)n;
+    (void)k;
+    return GEMM_MC;
+}
+#endif
+
+/*
+ * gemm_f64, gemm_f32 - c += alpha * a * b, with a m x k, b k x n and c m x n,
+ *			whose rows are lda, ldb and ldc apart.
+ */
+GEMM(f64, double)
+GEMM(f32, float)
@@ -0,0 +1,385 @@
+/*
+ *  module  : hashcons.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Hash-consing of list structure.
+ *
+ *  Lists that are built through share or hcons are entered in a table of
+ *  canonical nodes, keyed by type, value and next pointer. A node is only
+ *  entered when its next pointer and, for a LIST_ node, its contents are
+ *  canonical too, so that two structurally equal shared lists are always
+ *  represented by the same index and can be compared in O(1).
+ *
+ *  The table is weak: it does not keep nodes alive. The copying collector
+ *  calls hashcons_forward after all roots have been copied; surviving nodes
+ *  are re-entered at their new index and the others are dropped.
+ *
+ *  The structural hash and identity of values, hash_value and same_value,
+ *  are also used by the cache of memo and memorec.
+ */
+#include "globals.h"
+
+#define HC_MIN_SIZE 256 /* initial number of slots */
+
+/*
+ * The value of a node as 64 bits. Union members that are smaller than 64
+ * bits are widened, because the remaining bits of the union are undefined.
+ */
+static uint64_t node_bits(pEnv env, Index n)
+{
+    switch (nodetype(n)) {
+    case USR_:
+        return (uint64_t)nodevalue(n).ent;
+    case ANON_FUNCT_:
+        return (uint64_t)(uintptr_t)nodevalue(n).proc;
+    case SET_:
+        return nodevalue(n).set;
+    case LIST_:
+    case SEQ_:
+        return (uint64_t)nodevalue(n).lis;
+    case FLOAT_: {
+        uint64_t bits;
+        memcpy(&bits, &nodevalue(n).dbl, sizeof(bits));
+        return bits;
+    }
+    case FILE_:
+        return (uint64_t)(uintptr_t)nodevalue(n).fil;
+    case DICT_:
+        return (uint64_t)(uintptr_t)nodevalue(n).dict;
+#ifdef JOY_NATIVE_TYPES
+    case VECTOR_:
+        return (uint64_t)(uintptr_t)nodevalue(n).vec;
+    case MATRIX_:
+        return (uint64_t)(uintptr_t)nodevalue(n).mat;
+    case SPARSE_:
+        return (uint64_t)(uintptr_t)nodevalue(n).spm;
+#endif
+    default: /* BOOLEAN_, CHAR_, INTEGER_ */
+        return (uint64_t)nodevalue(n).num;
+    }
+}
+
+/*
+ * Finalizer of splitmix64, used to combine the parts of a key.
+ */
+static uint64_t mix64(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/*
+ * FNV-1a over the bytes of a string.
+ */
+static uint64_t str_hash(const char* str, size_t leng)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (leng--) {
+        h ^= (unsigned char)*str++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*
+ * Hash of a single node: type, value and next pointer.
+ */
+static uint64_t hash_node(pEnv env, Index n)
+{
+    uint64_t h;
+    Operator op = nodetype(n);
+
+    if (op == STRING_ || op == BIGNUM_)
+        h = str_hash((char*)&nodevalue(n), nodeleng(n));
+    else
+        h = node_bits(env, n);
+    return mix64(h ^ mix64(((uint64_t)op << 32) | nextnode1(n)));
+}
+
+/*
+ * hash_value - structural hash of the value of node n, not including the
+ *		next pointer. The contents of a list are included.
+ */
+uint64_t hash_value(pEnv env, Index n)
+{
+    uint64_t h;
+    Operator op = nodetype(n);
+
+    if (op == STRING_ || op == BIGNUM_)
+        h = str_hash((char*)&nodevalue(n), nodeleng(n));
+    else if (op == LIST_)
+        for (h = 0, n = nodevalue(n).lis; n; n = nextnode1(n))
+            h = mix64(h ^ hash_value(env, n));
+    else
+        h = node_bits(env, n);
+    return mix64(h ^ op);
+}
+
+/*
+ * same_value - structural identity of the values of nodes a and b: same
+ *		types and same values, with lists compared member by member.
+ *		Unlike equal, 1 and 1.0 are not the same.
+ */
+int same_value(pEnv env, Index a, Index b)
+{
+    Operator op;
+
+    if (a == b)
+        return 1;
+    if ((op = nodetype(a)) != nodetype(b))
+        return 0;
+    if (op == STRING_ || op == BIGNUM_)
+        return nodeleng(a) == nodeleng(b)
+            && !memcmp(&nodevalue(a), &nodevalue(b), nodeleng(a));
+    if (op != LIST_)
+        return node_bits(env, a) == node_bits(env, b);
+    for (a = nodevalue(a).lis, b = nodevalue(b).lis; a && b && a != b;
+         a = nextnode1(a), b = nextnode1(b))
+        if (!same_value(env, a, b))
+            return 0;
+    return a == b;
+}
+
+/*
+ * Two nodes are the same key when type, value and next pointer are equal.
+ * The contents of a LIST_ are compared by index, as they are canonical.
+ */
+static int same_node(pEnv env, Index a, Index b)
+{
+    Operator op;
+
+    if ((op = nodetype(a)) != nodetype(b) || nextnode1(a) != nextnode1(b))
+        return 0;
+    if (op == STRING_ || op == BIGNUM_)
+        return nodeleng(a) == nodeleng(b)
+            && !memcmp(&nodevalue(a), &nodevalue(b), nodeleng(a));
+    return node_bits(env, a) == node_bits(env, b);
+}
+
+/*
+ * Insert a node that is known not to be present yet.
+ */
+static void insert(pEnv env, HashCons* hc, Index n)
+{
+    size_t i, mask = hc->size - 1;
+
+    for (i = hash_node(env, n) & mask; hc->slot[i]; i = (i + 1) & mask)
+        ;
+    hc->slot[i] = n;
+    hc->count++;
+}
+
+/*
+ * Allocate an empty table with at least room for num canonical nodes.
+ */
+static HashCons* hashcons_new(size_t num)
+{
+    HashCons* hc;
+    size_t size = HC_MIN_SIZE;
+
+    while (size < 2 * num)
+        size *= 2;
+    hc = check_malloc(sizeof(HashCons));
+    hc->slot = calloc(size, sizeof(Index));
+#ifdef TEST_MALLOC_RETURN
+    if (!hc->slot)
+        fatal("memory exhausted");
+#endif
+    hc->size = size;
+    hc->count = 0;
+    return hc;
+}
+
+/*
+ * Double the number of slots when the table is more than half full.
+ */
+static void grow(pEnv env)
+{
+    size_t i;
+    HashCons *hc = env->hcons, *nhc;
+
+    if (2 * (hc->count + 1) <= hc->size)
+        return;
+    nhc = hashcons_new(hc->count + 1);
+    for (i = 0; i < hc->size; i++)
+        if (hc->slot[i])
+            insert(env, nhc, hc->slot[i]);
+    free(hc->slot);
+    free(hc);
+    env->hcons = nhc;
+}
+
+/*
+ * Locate the canonical node that equals node n, or return 0.
+ */
+static Index find(pEnv env, Index n)
+{
+    size_t i, mask;
+    HashCons* hc = env->hcons;
+
+    if (!hc)
+        return 0;
+    mask = hc->size - 1;
+    for (i = hash_node(env, n) & mask; hc->slot[i]; i = (i + 1) & mask)
+        if (hc->slot[i] == n || same_node(env, hc->slot[i], n))
+            return hc->slot[i];
+    return 0;
+}
+
+/*
+ * A node is canonical when it is the one that is registered in the table.
+ * The empty list is canonical by definition.
+ */
+static int is_canonical(pEnv env, Index n)
+{
+    return !n || find(env, n) == n;
+}
+
+/*
+ * hashcons_need - upper bound of the number of nodes that hashcons_list
+ *		   allocates for list. Canonical parts are not counted, so
+ *		   the count does not explode on structure that is already
+ *		   shared. The caller passes the sum to ensure_capacity.
+ */
+size_t hashcons_need(pEnv env, Index list)
+{
+    size_t num = 0;
+
+    for (; !is_canonical(env, list); list = nextnode1(list)) {
+        num += nodesize(env, list);
+        if (nodetype(list) == LIST_)
+            num += hashcons_need(env, nodevalue(list).lis);
+    }
+    return num;
+}
+
+/*
+ * hashcons_node - return the canonical node with type op, value u and next
+ *		   pointer r, creating it when needed. A LIST_ value and r must
+ *		   already be canonical. For strings, u.str points to the text.
+ */
+static Index hashcons_node(pEnv env, Operator op, Types u, Index r)
+{
+    Index p, q;
+
+    p = newnode(env, op, u, r); /* candidate, at the top of memory */
+    if ((q = find(env, p)) != 0) {
+        env->memoryindex -= nodesize(env, p); /* give the candidate back */
+        env->stats.nodes -= nodesize(env, p);
+        return q;
+    }
+    if (!env->hcons)
+        env->hcons = hashcons_new(0);
+    grow(env);
+    insert(env, env->hcons, p);
+    return p;
+}
+
+/*
+ * hashcons_list - return the canonical version of list. Capacity must have
+ *		   been reserved with hashcons_need, because the collector
+ *		   does not know about the indices that are held here.
+ */
+Index hashcons_list(pEnv env, Index list)
+{
+    Types u;
+    Index *nodes, next = 0;
+    size_t i, num = 0, max = 0;
+
+    /*
+     * Collect the non-canonical prefix; it is rebuilt from the back, so
+     * that each node is entered after its successor.
+     */
+    for (nodes = 0; !is_canonical(env, list); list = nextnode1(list)) {
+        if (num == max) {
+            max = max ? 2 * max : 16;
+            nodes = realloc(nodes, max * sizeof(Index));
+#ifdef TEST_MALLOC_RETURN
+            if (!nodes)
+                fatal("memory exhausted");
+#endif
+        }
+        nodes[num++] = list;
+    }
+    next = list;
+    for (i = num; i-- > 0;) {
+        u = nodevalue(nodes[i]);
+        if (nodetype(nodes[i]) == LIST_)
+            u.lis = hashcons_list(env, u.lis);
+        else if (nodetype(nodes[i]) == STRING_
+                 || nodetype(nodes[i]) == BIGNUM_)
+            u.str = (char*)&nodevalue(nodes[i]);
+        next = hashcons_node(env, nodetype(nodes[i]), u, next);
+    }
+    free(nodes);
+    return next;
+}
+
+/*
+ * hashcons_forward - called by the collector after all roots have been
+ *		      copied. Canonical nodes that were copied are entered at
+ *		      their new location; nodes that were not copied are dead.
+ */
+void hashcons_forward(pEnv env)
+{
+    size_t i;
+    Index n;
+    HashCons *hc = env->hcons, *nhc;
+
+    if (!hc)
+        return;
+    nhc = hashcons_new(hc->count);
+    for (i = 0; i < hc->size; i++) {
+        if ((n = hc->slot[i]) == 0)
+            continue;
+        if (n >= env->mem_low) {
+            if (env->old_memory[n].op != COPIED_)
+                continue;
+            n = env->old_memory[n].u.lis;
+        }
+        insert(env, nhc, n);
+    }
+    free(hc->slot);
+    free(hc);
+    env->hcons = nhc;
+}
+
+/*
+ * hashcons_reset - forget the canonical nodes above mem_low. Called when
+ *		    memory above mem_low is released without collection.
+ */
+void hashcons_reset(pEnv env)
+{
+    size_t i;
+    HashCons *hc = env->hcons, *nhc;
+
+    if (!hc)
+        return;
+    nhc = hashcons_new(0);
+    env->hcons = nhc;
+    for (i = 0; i < hc->size; i++)
+        if (hc->slot[i] && hc->slot[i] < env->mem_low) {
+            grow(env);
+            insert(env, env->hcons, hc->slot[i]);
+        }
+    free(hc->slot);
+    free(hc);
+}
+
+/*
+ * hashcons_free - release the table.
+ */
+void hashcons_free(pEnv env)
+{
+    if (env->hcons) {
+        free(env->hcons->slot);
+        free(env->hcons);
+        env->hcons = 0;
+    }
+}
@@ -1,21 +1,43 @@
 /*
  *  module  : iolib.c
- *  version : 1.0
- *  date    : 01/20/26
+ *  version : 1.2
+ *  date    : 10/18/26
  *
  *  I/O abstraction layer for embedding support.
  *  Functions check for callbacks and fall back to stdio if not set.
+ *  Output is buffered, and flushed according to a flush policy. The bulk
+ *  callbacks write_bytes and read_bytes are preferred over the others.
  */
 #include "globals.h"
 #include <stdarg.h>
 
+/*
+ * input_read - the next character from read_bytes, that fills env->in when
+ *		it has been used up.
+ */
+static int input_read(pEnv env)
+{
+    if (env->in.pos == env->in.len) {
+        if (!env->in.buf && (env->in.buf = malloc(INPUTMAX)) == 0)
+            return EOF;
+        env->in.pos = 0;
+        env->in.len = env->io.read_bytes(env->io.user_data, env->in.buf,
+                                         INPUTMAX);
+        if (!env->in.len)
+            return EOF;
+    }
+    return (unsigned char)env->in.buf[env->in.pos++];
+}
+
 /*
  * joy_getchar - read a single character from input.
  * Uses callback if set, otherwise reads from stdin.
  */
 int joy_getchar(pEnv env)
 {
-    if (env->io.read_char) {
+    if (env->io.read_bytes) {
+        return input_read(env);
+    } else if (env->io.read_char) {
         return env->io.read_char(env->io.user_data);
     } else {
         return getchar();
@@ -28,23 +50,122 @@ int joy_getchar(pEnv env)
  */
 int joy_getc(pEnv env, FILE* fp)
 {
-    if (fp == stdin && env->io.read_char) {
-        return env->io.read_char(env->io.user_data);
+    if (fp == stdin && (env->io.read_bytes || env->io.read_char)) {
+        return joy_getchar(env);
     } else {
         return fgetc(fp);
     }
 }
 
+/*
+ * joy_ungetc - unread a character, that is read again by joy_getc.
+ * Uses the buffer of read_bytes if fp is stdin, otherwise uses ungetc.
+ */
+void joy_ungetc(pEnv env, int ch, FILE* fp)
+{
+    if (fp == stdin && env->io.read_bytes) {
+        if (env->in.pos && ch != EOF)
+            env->in.buf[--env->in.pos] = ch;
+    } else {
+        ungetc(ch, fp);
+    }
+}
+
+/*
+ * joy_input_free - release the buffer of read_bytes.
+ */
+void joy_input_free(pEnv env)
+{
+    free(env->in.buf);
+    env->in.buf = 0;
+    env->in.pos = env->in.len = 0;
+}
+
+/*
+ * Output for the callbacks is collected in env->out and passed on by
+ * joy_flush, when the buffer is full and otherwise as the flush policy says.
+ * Output to stdout without callbacks uses the buffer of stdio, that the
+ * command line sets up with joy_stdout according to the same policy.
+ */
+#define CALLBACKS(env)                                                        \
+    ((env)->io.write_bytes || (env)->io.write_char || (env)->io.write_string)
+
+/*
+ * output_send - pass n characters to the callbacks at once: to write_bytes
+ *		 when set, a single character to write_char when set, and
+ *		 otherwise to write_string.
+ */
+static void output_send(pEnv env, const char* s, size_t n)
+{
+    size_t i, k;
+    char chunk[BUFFERMAX + 1];
+
+    if (env->io.write_bytes) {
+        env->io.write_bytes(env->io.user_data, s, n);
+        return;
+    }
+    if (!env->io.write_string || (n == 1 && env->io.write_char)) {
+        for (i = 0; i < n; i++)
+            env->io.write_char(env->io.user_data, (unsigned char)s[i]);
+        return;
+    }
+    for (; n; s += k, n -= k) { /* write_string needs a terminator */
+        k = n < BUFFERMAX ? n : BUFFERMAX;
+        memcpy(chunk, s, k);
+        chunk[k] = 0;
+        env->io.write_string(env->io.user_data, chunk);
+    }
+}
+
+/*
+ * output_write - write n characters to the callbacks, through the buffer
+ *		  when there is one.
+ */
+static void output_write(pEnv env, const char* s, size_t n)
+{
+    size_t k;
+    int line;
+
+    if (!env->out.buf) {
+        output_send(env, s, n);
+        return;
+    }
+    line = env->out.policy == FLUSH_LINE && memchr(s, '\n', n);
+    for (; n; s += k, n -= k) {
+        if ((k = env->out.size - env->out.len) > n)
+            k = n;
+        memcpy(env->out.buf + env->out.len, s, k);
+        if ((env->out.len += k) == env->out.size)
+            joy_flush(env);
+    }
+    if (line)
+        joy_flush(env);
+}
+
+/*
+ * output_unbuffered - flush stdout after a write to fp, when the policy is
+ *		       not to buffer output; the buffer of stdout itself is
+ *		       left as the program set it up.
+ */
+static void output_unbuffered(pEnv env, FILE* fp)
+{
+    if (fp == stdout && env->out.policy == FLUSH_NONE)
+        fflush(stdout);
+}
+
 /*
  * joy_putchar - write a single character to output.
  * Uses callback if set, otherwise writes to stdout.
  */
 void joy_putchar(pEnv env, int ch)
 {
-    if (env->io.write_char) {
-        env->io.write_char(env->io.user_data, ch);
+    char c = ch;
+
+    if (CALLBACKS(env)) {
+        output_write(env, &c, 1);
     } else {
         putchar(ch);
+        output_unbuffered(env, stdout);
     }
 }
 
@@ -54,10 +175,13 @@ void joy_putchar(pEnv env, int ch)
  */
 void joy_putc(pEnv env, int ch, FILE* fp)
 {
-    if (fp == stdout && env->io.write_char) {
-        env->io.write_char(env->io.user_data, ch);
+    char c = ch;
+
+    if (fp == stdout && CALLBACKS(env)) {
+        output_write(env, &c, 1);
     } else {
         putc(ch, fp);
+        output_unbuffered(env, fp);
     }
 }
 
@@ -67,10 +191,11 @@ void joy_putc(pEnv env, int ch, FILE* fp)
  */
 void joy_fputs(pEnv env, const char* s, FILE* fp)
 {
-    if (fp == stdout && env->io.write_string) {
-        env->io.write_string(env->io.user_data, s);
+    if (fp == stdout && CALLBACKS(env)) {
+        output_write(env, s, strlen(s));
     } else {
         fputs(s, fp);
+        output_unbuffered(env, fp);
     }
 }
 
@@ -80,17 +205,11 @@ void joy_fputs(pEnv env, const char* s, FILE* fp)
  */
 void joy_fwrite(pEnv env, const char* s, size_t len, FILE* fp)
 {
-    if (fp == stdout && env->io.write_string) {
-        /* For callback, we need a null-terminated string */
-        char* buf = malloc(len + 1);
-        if (buf) {
-            memcpy(buf, s, len);
-            buf[len] = '\0';
-            env->io.write_string(env->io.user_data, buf);
-            free(buf);
-        }
+    if (fp == stdout && CALLBACKS(env)) {
+        output_write(env, s, len);
     } else {
         fwrite(s, 1, len, fp);
+        output_unbuffered(env, fp);
     }
 }
 
@@ -126,10 +245,11 @@ void joy_fprintf(pEnv env, FILE* fp, const char* fmt, ...)
     va_end(ap);
 
     /* Output using callback or stdio */
-    if (fp == stdout && env->io.write_string) {
-        env->io.write_string(env->io.user_data, buffer);
+    if (fp == stdout && CALLBACKS(env)) {
+        output_write(env, buffer, size - 1);
     } else {
         fwrite(buffer, 1, size - 1, fp);
+        output_unbuffered(env, fp);
     }
 
     free(buffer);
@@ -141,10 +261,11 @@ void joy_fprintf(pEnv env, FILE* fp, const char* fmt, ...)
  */
 void joy_puts(pEnv env, const char* s)
 {
-    if (env->io.write_string) {
-        env->io.write_string(env->io.user_data, s);
+    if (CALLBACKS(env)) {
+        output_write(env, s, strlen(s));
     } else {
         fputs(s, stdout);
+        output_unbuffered(env, stdout);
     }
 }
 
@@ -180,25 +301,101 @@ void joy_printf(pEnv env, const char* fmt, ...)
     va_end(ap);
 
     /* Output using callback or stdio */
-    if (env->io.write_string) {
-        env->io.write_string(env->io.user_data, buffer);
+    if (CALLBACKS(env)) {
+        output_write(env, buffer, size - 1);
     } else {
         fputs(buffer, stdout);
+        output_unbuffered(env, stdout);
     }
 
     free(buffer);
 }
 
 /*
- * joy_flush - flush output.
- * Only affects stdio; callbacks handle their own buffering.
+ * joy_output - set up the buffering of output with a flush policy and, with
+ * callbacks, a buffer of size characters, OUTPUTMAX if 0. FLUSH_AUTO becomes
+ * FLUSH_LINE when stdout is a terminal, FLUSH_TERM with callbacks and
+ * FLUSH_SIZE otherwise. The buffer of stdout belongs to the program: setvbuf
+ * is only allowed before the first output, and affects all contexts, so
+ * here the policy only tells when stdout is flushed.
+ */
+void joy_output(pEnv env, int policy, size_t size)
+{
+    if (!size)
+        size = OUTPUTMAX;
+    if (policy == FLUSH_AUTO)
+        policy = CALLBACKS(env)       ? FLUSH_TERM
+                 : isatty(fileno(stdout)) ? FLUSH_LINE
+                                          : FLUSH_SIZE;
+    joy_output_free(env);
+    env->out.policy = policy;
+    if (CALLBACKS(env) && policy != FLUSH_NONE
+        && (env->out.buf = malloc(size + 1)) != 0)
+        env->out.size = size;
+}
+
+/*
+ * joy_stdout - set up the buffer of stdout by policy, once, before anything
+ * is written to it. The command line calls this; a program that embeds Joy
+ * buffers stdout as it likes.
+ */
+void joy_stdout(int policy)
+{
+    static char buffer[OUTPUTMAX];
+
+    if (policy == FLUSH_AUTO)
+        policy = isatty(fileno(stdout)) ? FLUSH_LINE : FLUSH_SIZE;
+    if (policy == FLUSH_NONE)
+        setvbuf(stdout, 0, _IONBF, 0);
+    else
+        setvbuf(stdout, buffer, policy == FLUSH_LINE ? _IOLBF : _IOFBF,
+                sizeof(buffer));
+}
+
+/*
+ * joy_flush - flush output: the buffer of the callbacks, or stdout.
  */
 void joy_flush(pEnv env)
 {
-    if (!env->io.write_char && !env->io.write_string) {
+    size_t i;
+
+    if (!CALLBACKS(env)) {
         fflush(stdout);
+        return;
     }
-    /* Note: If using callbacks, assume the callback handles buffering */
+    if (!env->out.len)
+        return;
+    env->out.buf[env->out.len] = 0;
+    if (env->io.write_bytes)
+        env->io.write_bytes(env->io.user_data, env->out.buf, env->out.len);
+    else if (env->io.write_string)
+        env->io.write_string(env->io.user_data, env->out.buf);
+    else
+        for (i = 0; i < env->out.len; i++)
+            env->io.write_char(env->io.user_data,
+                               (unsigned char)env->out.buf[i]);
+    env->out.len = 0;
+}
+
+/*
+ * joy_flush_term - flush output after a term at top level has been
+ * evaluated, unless the policy is to flush only when the buffer is full.
+ */
+void joy_flush_term(pEnv env)
+{
+    if (env->out.policy != FLUSH_SIZE)
+        joy_flush(env);
+}
+
+/*
+ * joy_output_free - flush output and release the buffer of the callbacks.
+ */
+void joy_output_free(pEnv env)
+{
+    joy_flush(env);
+    free(env->out.buf);
+    env->out.buf = 0;
+    env->out.len = env->out.size = 0;
 }
 
 /*
@@ -207,12 +404,12 @@ void joy_flush(pEnv env)
  */
 void joy_report_error(pEnv env, int code, const char* msg)
 {
+    joy_flush(env); /* output that came before the error */
     if (env->io.on_error) {
         env->io.on_error(env->io.user_data, code, msg,
                          env->scanner.srcfilename, env->scanner.linenum, env->scanner.linepos);
     } else {
         /* Default: write to stderr */
-        fflush(stdout);
         fprintf(stderr, "%s", msg);
     }
 
@@ -1,7 +1,7 @@
 /*
  *  module  : joy.c
- *  version : 1.0
- *  date    : 01/20/26
+ *  version : 1.1
+ *  date    : 10/18/26
  *
  *  Implementation of the public Joy library API.
  *  This file wraps the internal interpreter with a clean public interface.
@@ -127,6 +127,8 @@ JoyContext* joy_create(const JoyConfig* config)
             env->io.read_char = config->io->read_char;
             env->io.write_char = config->io->write_char;
             env->io.write_string = config->io->write_string;
+            env->io.write_bytes = config->io->write_bytes;
+            env->io.read_bytes = config->io->read_bytes;
             /* Cast needed: JoyResult is int-compatible but types differ */
             env->io.on_error = (void (*)(void*, int, const char*, const char*, int, int))
                                config->io->on_error;
@@ -141,8 +143,11 @@ JoyContext* joy_create(const JoyConfig* config)
     env->config.undeferror = INIUNDEFERROR;
     env->config.overwrite = INIWARNING;
 
-    /* Disable output buffering */
-    setbuf(stdout, 0);
+    /* Buffer output, flushed according to the policy */
+    if (config)
+        joy_output(env, config->flush_policy, config->output_buffer_size);
+    else
+        joy_output(env, FLUSH_AUTO, 0);
 
     return ctx;
 }
@@ -159,6 +164,11 @@ void joy_destroy(JoyContext* ctx)
 
     active_context_count--;
 
+    /* Write pending output, release the buffers of the callbacks */
+    joy_output_free(&ctx->env);
+    joy_input_free(&ctx->env);
+    exitlinebuffer(&ctx->env);
+
     /* Free hash tables */
     if (ctx->env.hash)
         kh_destroy(Symtab, ctx->env.hash);
@@ -171,6 +181,16 @@ void joy_destroy(JoyContext* ctx)
         free(ctx->env.memory);
         ctx->env.memory = NULL;
     }
+    /* Release the table of shared list nodes */
+    hashcons_free(&ctx->env);
+    /* Release the cache of memo and memorec */
+    memo_free(&ctx->env);
+    /* Release the compiled patterns of match and cases */
+    pattern_free(&ctx->env);
+    /* Release the data of native vectors and matrices */
+    native_free(&ctx->env);
+    /* Release the tables of dictionaries */
+    dict_free(&ctx->env);
     /* Destroy per-context conservative GC (Phase 3) */
     if (ctx->env.gc_ctx) {
         gc_ctx_destroy(ctx->env.gc_ctx);
@@ -200,10 +220,12 @@ JoyResult joy_eval_string(JoyContext* ctx, const char* source)
     /* Set up error recovery */
     err = setjmp(env->error_jmp);
     if (err == ABORT_QUIT) {
+        joy_flush(env);
         ctx->last_result = JOY_ERROR_QUIT;
         return JOY_ERROR_QUIT;
     }
     if (err == ABORT_RETRY) {
+        joy_flush(env);
         ctx->last_result = JOY_ERROR_ABORT;
         return JOY_ERROR_ABORT;
     }
@@ -239,6 +261,7 @@ JoyResult joy_eval_string(JoyContext* ctx, const char* source)
             if (env->stck) {
                 exec_term(env, nodevalue(env->stck).lis);
                 env->stck = nextnode1(env->stck);
+                joy_flush_term(env);
             }
             /* readterm reads until terminator, check if it's '.' */
             if (env->scanner.sym == '.')
@@ -247,6 +270,7 @@ JoyResult joy_eval_string(JoyContext* ctx, const char* source)
         }
     }
 
+    joy_flush(env);
     ctx->last_result = JOY_OK;
     return JOY_OK;
 }
@@ -265,15 +289,18 @@ JoyResult joy_eval_file(JoyContext* ctx, FILE* fp, const char* filename)
     /* Set up error recovery */
     err = setjmp(env->error_jmp);
     if (err == ABORT_QUIT) {
+        joy_flush(env);
         ctx->last_result = JOY_ERROR_QUIT;
         return JOY_ERROR_QUIT;
     }
     if (err == ABORT_RETRY) {
+        joy_flush(env);
         ctx->last_result = JOY_ERROR_ABORT;
         return JOY_ERROR_ABORT;
     }
 
-    /* Set up source file */
+    /* Set up source file, without a block read ahead of another */
+    exitlinebuffer(env);
     env->scanner.srcfile = fp;
     env->scanner.srcfilename = (char*)filename;
     env->scanner.linenum = 0;
@@ -283,6 +310,7 @@ JoyResult joy_eval_file(JoyContext* ctx, FILE* fp, const char* filename)
     /* Use repl to process the file */
     repl(env);
 
+    joy_flush(env);
     ctx->last_result = JOY_OK;
     return JOY_OK;
 }
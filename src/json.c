@@ -0,0 +1,516 @@
+/*
+ *  module  : json.c
+ *  version : 1.2
+ *  date    : 10/18/26
+ *
+ *  Reading JSON from a stream or a string, in one pass.
+ *
+ *  A stream is read in blocks, such that a document or a file of records is
+ *  never held in memory as a whole. json_event gives the structure as events,
+ *  and json_read builds the next value from them: objects become dictionaries
+ *  and arrays lists, as json> does. The values are pushed on the stack while
+ *  they are read, where the collector sees them, and the nodes of an array
+ *  are linked in place when its ] is read.
+ */
+#include "globals.h"
+#include <sys/stat.h>
+
+/*
+ * What json_event allows next: a value, a value or ] after [, a key or }
+ * after {, a key after a comma, or a comma or the end after a member.
+ */
+enum { JS_VALUE, JS_FIRST, JS_FIRSTKEY, JS_KEY, JS_NEXT };
+
+/*
+ * json_grow - room for size bytes in ptr, that has room for *max.
+ */
+static void* json_grow(void* ptr, int64_t* max, int64_t size)
+{
+    if (size < *max)
+        return ptr;
+    *max = size * 2 + 64;
+    ptr = realloc(ptr, *max);
+#ifdef TEST_MALLOC_RETURN
+    if (!ptr)
+        fatal("memory exhausted");
+#endif
+    return ptr;
+}
+
+/*
+ * json_open - read from stream fp, n bytes at once, or from the n characters
+ *	       of string s, that the caller keeps. With n 0, a regular file is
+ *	       read in blocks and another stream a byte at a time, such that
+ *	       json_close can put back what was read ahead.
+ */
+void json_open(JsonReader* js, FILE* fp, char* s, size_t n)
+{
+#ifndef WINDOWS
+    struct stat st;
+#endif
+
+    memset(js, 0, sizeof(JsonReader));
+    if ((js->fp = fp) == 0) {
+        js->buf = s;
+        js->len = n;
+        return;
+    }
+#ifdef WINDOWS
+    if (!n) /* text mode: no seeking back */
+        n = 1;
+#else
+    if (!n)
+        n = !fstat(fileno(fp), &st) && S_ISREG(st.st_mode) ? INPBLOCKMAX : 1;
+#endif
+    js->step = n;
+    js->buf = check_malloc(n);
+}
+
+/*
+ * json_close - release what was read, and put back the bytes of the stream
+ *		that were read ahead.
+ */
+void json_close(JsonReader* js)
+{
+    if (js->fp) {
+        if (js->len - js->pos == 1 && js->step == 1)
+            ungetc(js->buf[js->pos], js->fp);
+        else if (js->pos < js->len)
+            fseek(js->fp, -(long)(js->len - js->pos), SEEK_CUR);
+        free(js->buf);
+    }
+    free(js->str);
+    free(js->kind);
+}
+
+/*
+ * json_fill - read the next block, or return 0 at the end.
+ */
+static int json_fill(JsonReader* js)
+{
+    if (!js->fp)
+        return 0;
+    js->pos = 0;
+    js->len = fread(js->buf, 1, js->step, js->fp);
+    return js->len > 0;
+}
+
+/*
+ * json_peek - the next character that is not white space, or EOF.
+ */
+static int json_peek(JsonReader* js)
+{
+    int ch;
+
+    for (;;) {
+        for (; js->pos < js->len; js->pos++)
+            if ((ch = (unsigned char)js->buf[js->pos]) != ' ' && ch != '\n'
+                && ch != '\t' && ch != '\r')
+                return ch;
+        if (!json_fill(js))
+            return EOF;
+    }
+}
+
+/*
+ * json_look - the next character, that is not read, or EOF.
+ */
+static int json_look(JsonReader* js)
+{
+    if (js->pos == js->len && !json_fill(js))
+        return EOF;
+    return (unsigned char)js->buf[js->pos];
+}
+
+/*
+ * json_getc - read the next character, or EOF.
+ */
+static int json_getc(JsonReader* js)
+{
+    int ch;
+
+    if ((ch = json_look(js)) != EOF)
+        js->pos++;
+    return ch;
+}
+
+/*
+ * json_add - add the n characters s to the string that is read.
+ */
+static void json_add(JsonReader* js, const char* s, size_t n)
+{
+    js->str = json_grow(js->str, &js->room, js->leng + n + 1);
+    memcpy(js->str + js->leng, s, n);
+    js->leng += n;
+}
+
+/*
+ * json_hex - the value of the 4 hex digits after \u, or -1.
+ */
+static int json_hex(JsonReader* js)
+{
+    int i, ch, num = 0;
+
+    for (i = 0; i < 4; i++) {
+        if ((ch = json_getc(js)) == EOF || !isxdigit(ch))
+            return -1;
+        num = num * 16 + (isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10);
+    }
+    return num;
+}
+
+/*
+ * json_utf8 - add code point num, after \u, in UTF-8. A surrogate pair is
+ *	       one code point.
+ */
+static int json_utf8(JsonReader* js, int num)
+{
+    int low, n;
+    char s[4];
+
+    if (num >= 0xD800 && num < 0xDC00) {
+        if (json_getc(js) != '\\' || json_getc(js) != 'u'
+            || (low = json_hex(js)) < 0xDC00 || low >= 0xE000)
+            return 0;
+        num = 0x10000 + ((num - 0xD800) << 10) + (low - 0xDC00);
+    }
+    if (num < 0x80) {
+        s[0] = num;
+        n = 1;
+    } else if (num < 0x800) {
+        s[0] = 0xC0 | num >> 6;
+        s[1] = 0x80 | (num & 0x3F);
+        n = 2;
+    } else if (num < 0x10000) {
+        s[0] = 0xE0 | num >> 12;
+        s[1] = 0x80 | (num >> 6 & 0x3F);
+        s[2] = 0x80 | (num & 0x3F);
+        n = 3;
+    } else {
+        s[0] = 0xF0 | num >> 18;
+        s[1] = 0x80 | (num >> 12 & 0x3F);
+        s[2] = 0x80 | (num >> 6 & 0x3F);
+        s[3] = 0x80 | (num & 0x3F);
+        n = 4;
+    }
+    json_add(js, s, n);
+    return 1;
+}
+
+/*
+ * json_string - read a string, after its opening quote, into js->str. The
+ *		 quote and the backslash are found with memchr, that is
+ *		 vectorized in the C library, and the run before them is
+ *		 copied at once. Strings of Joy end at a zero byte, so \u0000
+ *		 is an error, as is a string that a node cannot hold.
+ */
+static int json_string(JsonReader* js)
+{
+    char *p, *q, *b;
+    int ch, num;
+
+    js->leng = 0;
+    for (;;) {
+        if (js->pos == js->len && !json_fill(js))
+            return 0;
+        p = js->buf + js->pos;
+        q = memchr(p, '"', js->len - js->pos);
+        b = memchr(p, '\\', (q ? q : js->buf + js->len) - p);
+        if (b)
+            q = b;
+        else if (!q)
+            q = js->buf + js->len;
+        json_add(js, p, q - p);
+        js->pos = q - js->buf;
+        if (js->pos == js->len)
+            continue;
+        js->pos++;
+        if (!b)
+            break;
+        switch (ch = json_getc(js)) {
+        case 'b':
+            ch = '\b';
+            break;
+        case 'f':
+            ch = '\f';
+            break;
+        case 'n':
+            ch = '\n';
+            break;
+        case 'r':
+            ch = '\r';
+            break;
+        case 't':
+            ch = '\t';
+            break;
+        case 'u':
+            if ((num = json_hex(js)) <= 0 || !json_utf8(js, num))
+                return 0;
+            continue;
+        case '"':
+        case '\\':
+        case '/':
+            break;
+        default:
+            return 0;
+        }
+        js->str[js->leng++] = ch;
+    }
+    if (js->leng > (int64_t)MAX_STRING_LEN) /* longer than a node holds */
+        return 0;
+    js->str[js->leng] = 0;
+    return 1;
+}
+
+/*
+ * json_number - whether s is a number of JSON: an optional minus, 0 or
+ *		 digits without a leading 0, an optional fraction and an
+ *		 optional exponent.
+ */
+static int json_number(const char* s)
+{
+    if (*s == '-')
+        s++;
+    if (*s == '0')
+        s++;
+    else if (isdigit((unsigned char)*s))
+        while (isdigit((unsigned char)*s))
+            s++;
+    else
+        return 0;
+    if (*s == '.') {
+        if (!isdigit((unsigned char)*++s))
+            return 0;
+        while (isdigit((unsigned char)*s))
+            s++;
+    }
+    if (*s == 'e' || *s == 'E') {
+        if (*++s == '+' || *s == '-')
+            s++;
+        if (!isdigit((unsigned char)*s))
+            return 0;
+        while (isdigit((unsigned char)*s))
+            s++;
+    }
+    return !*s;
+}
+
+/*
+ * json_scalar - read the number, true, false or null that starts with ch
+ *		 into u, and return its type, or 0.
+ */
+static int json_scalar(JsonReader* js, int ch, Types* u)
+{
+    char c;
+
+    js->leng = 0;
+    while (isalnum(ch) || (ch && strchr("+-.", ch))) {
+        c = ch;
+        json_add(js, &c, 1);
+        js->pos++;
+        ch = json_look(js);
+    }
+    if (!js->leng)
+        return 0;
+    js->str[js->leng] = 0;
+    if (!strcmp(js->str, "true") || !strcmp(js->str, "false")) {
+        u->num = *js->str == 't';
+        return BOOLEAN_;
+    }
+    if (!strcmp(js->str, "null"))
+        return USR_;
+    if (!json_number(js->str))
+        return 0;
+    if (!strpbrk(js->str, ".eE")) {
+        u->num = strtoll(js->str, 0, 10);
+        return INTEGER_;
+    }
+    u->dbl = strtod(js->str, 0);
+    return FLOAT_;
+}
+
+/*
+ * json_end - the ] or } that closes the innermost array or object.
+ */
+static int json_end(JsonReader* js)
+{
+    js->pos++;
+    js->expect = --js->depth ? JS_NEXT : JS_VALUE;
+    return js->kind[js->depth] == '[' ? ']' : '}';
+}
+
+/*
+ * json_event - the next event: [ { ] } at the start and the end of an array
+ *		or object, : for a key in u->str, = for a value of type in u,
+ *		0 at the end and -1 after an error. Strings are in js->str
+ *		until the next event. Values follow each other at the top,
+ *		separated by white space, as the lines of NDJSON.
+ */
+int json_event(JsonReader* js, Types* u, int* type)
+{
+    int ch;
+
+    for (;;) {
+        if ((ch = json_peek(js)) == EOF)
+            return js->depth || js->expect != JS_VALUE ? -1 : 0;
+        switch (js->expect) {
+        case JS_NEXT:
+            if (ch == ',') {
+                js->pos++;
+                js->expect = js->kind[js->depth - 1] == '{' ? JS_KEY
+                                                            : JS_VALUE;
+                continue;
+            }
+            if (ch == (js->kind[js->depth - 1] == '[' ? ']' : '}'))
+                return json_end(js);
+            return -1;
+
+        case JS_FIRSTKEY:
+            if (ch == '}')
+                return json_end(js);
+            /* fall through */
+        case JS_KEY:
+            js->pos++;
+            if (ch != '"' || !json_string(js) || json_peek(js) != ':')
+                return -1;
+            js->pos++;
+            js->expect = JS_VALUE;
+            u->str = js->str;
+            *type = STRING_;
+            return ':';
+
+        case JS_FIRST:
+            if (ch == ']')
+                return json_end(js);
+            /* fall through */
+        default:
+            if (ch == '[' || ch == '{') {
+                js->pos++;
+                js->kind = json_grow(js->kind, &js->size, js->depth + 1);
+                js->kind[js->depth++] = ch;
+                js->expect = ch == '[' ? JS_FIRST : JS_FIRSTKEY;
+                return ch;
+            }
+            if (ch == '"') {
+                js->pos++;
+                if (!json_string(js))
+                    return -1;
+                u->str = js->str;
+                *type = STRING_;
+            } else if ((*type = json_scalar(js, ch, u)) == 0)
+                return -1;
+            js->expect = js->depth ? JS_NEXT : JS_VALUE;
+            return '=';
+        }
+    }
+}
+
+/*
+ * json_push - push the value of a : or = event.
+ */
+void json_push(pEnv env, Types* u, int type)
+{
+    if (type == STRING_)
+#ifdef NOBDW
+        NULLARY(STRING_NEWNODE, u->str);
+#else
+        NULLARY(STRING_NEWNODE, GC_strdup(u->str));
+#endif
+    else if (type == USR_) /* null */
+        NULLARY(USR_NEWNODE, enteratom(env, "null"));
+    else if (type == INTEGER_)
+        NULLARY(INTEGER_NEWNODE, u->num);
+    else if (type == FLOAT_)
+        NULLARY(FLOAT_NEWNODE, u->dbl);
+    else
+        NULLARY(BOOLEAN_NEWNODE, u->num);
+}
+
+/*
+ * json_list - make a list of the top n values of the stack, that are
+ *	       linked in place, and push it.
+ */
+static void json_list(pEnv env, int64_t n)
+{
+    Index list = 0, next;
+
+    while (n-- > 0) {
+        next = nextnode1(env->stck);
+        nextnode1(env->stck) = list;
+        list = env->stck;
+        env->stck = next;
+    }
+    NULLARY(LIST_NEWNODE, list);
+}
+
+/*
+ * json_dict - make a dictionary of the top n values of the stack, that are
+ *	       keys and values, and push it. The last of equal keys is kept.
+ */
+static void json_dict(pEnv env, int64_t n)
+{
+    int ret;
+    khint_t k;
+    Index key, value;
+    khash_t(Dict)* d = kh_init(Dict);
+
+    ensure_capacity(env, 1); /* no gc below */
+    for (; n > 0; n -= 2) {
+        value = env->stck;
+        key = nextnode1(value);
+        env->stck = nextnode1(key);
+        nextnode1(value) = 0;
+        if (kh_get(Dict, d, GETSTRING(key)) == kh_end(d)) {
+            /* the table is not scanned by the collector: no GC_strdup */
+            k = kh_put(Dict, d, check_strdup(GETSTRING(key)), &ret);
+            kh_value(d, k) = value;
+        }
+    }
+    NULLARY(DICT_NEWNODE, d);
+}
+
+/*
+ * json_read - push the next value, and return 1, or return 0 at the end and
+ *	       -1 after an error.
+ */
+int json_read(pEnv env, JsonReader* js)
+{
+    Types u;
+    int ev, type;
+    int64_t level = -1, room = 0, *count = 0;
+
+    for (;;) {
+        switch (ev = json_event(js, &u, &type)) {
+        case '[':
+        case '{':
+            count = json_grow(count, &room, (++level + 1) * sizeof(int64_t));
+            count[level] = 0;
+            continue;
+        case ']':
+            json_list(env, count[level--]);
+            break;
+        case '}':
+            json_dict(env, count[level--]);
+            break;
+        case ':':
+        case '=':
+            json_push(env, &u, type);
+            if (ev == ':') {
+                count[level]++;
+                continue;
+            }
+            break;
+        default: /* drop the values that were read */
+            for (; level >= 0; level--)
+                while (count[level]--)
+                    POP(env->stck);
+            free(count);
+            return ev;
+        }
+        if (level < 0)
+            break;
+        count[level]++;
+    }
+    free(count);
+    return 1;
+}
@@ -0,0 +1,893 @@
+/*
+ *  module  : kernel.c
+ *  version : 1.3
+ *  date    : 10/18/26
+ *
+ *  Element-wise kernels of native vectors and matrices, and deferred vectors.
+ *
+ *  Each kernel is one loop over contiguous elements, marked for the compiler
+ *  to vectorize. There is a version for each element type (DT_F64 ...),
+ *  generated by the macros below, so float32 loops handle twice as many
+ *  elements per instruction as float64 loops. Integer arithmetic wraps
+ *  around and integer division by zero gives 0; reductions of integers are
+ *  computed in 64 bits.
+ *
+ *  The element-wise operations on vectors do not call the kernels at once:
+ *  vector_defer records the operation and its operands in the result, that
+ *  therefore forms a small expression of vectors. The expression is
+ *  evaluated when the elements are needed, in chunks that fit in the cache,
+ *  such that the intermediate vectors are never written to memory. A chunk
+ *  of a reduction is reduced directly, without storing the elements at all.
+ *  A view whose elements are not adjacent is gathered per chunk as well.
+ */
+#include "globals.h"
+#include <math.h>
+
+#define VX_CHUNK 256   /* elements per chunk of an expression */
+#define VX_MAX_SIZE 16 /* operations in an expression */
+
+/*
+ * One vectorized loop over n elements.
+ */
+#define LOOP(body)                                                            \
+    _Pragma("omp simd") for (i = 0; i < n; i++) body;
+
+/*
+ * Division and absolute value of float, signed and unsigned elements. U is
+ * the unsigned type of the width of T, such that arithmetic wraps around.
+ */
+#define DIV_FLT(T, U, x, y) ((x) / (y))
+#define DIV_INT(T, U, x, y)                                                   \
+    ((y) == 0 ? (T)0 : (y) == -1 ? (T)(0 - (U)(x)) : (T)((x) / (y)))
+#define DIV_UNS(T, U, x, y) ((y) == 0 ? (T)0 : (T)((x) / (y)))
+#define ABS_FLT(T, U, x) ((T)fabs(x))
+#define ABS_INT(T, U, x) ((x) < 0 ? (T)(0 - (U)(x)) : (x))
+#define ABS_UNS(T, U, x) (x)
+
+/*
+ * c = a op b, element by element.
+ */
+#define KERNEL_BINARY(SUF, T, U, DIV)                                         \
+    static void binary_##SUF(int op, T* restrict c, const T* restrict a,     \
+                             const T* restrict b, size_t n)                  \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_ADD:                                                          \
+            LOOP(c[i] = (T)((U)a[i] + (U)b[i]))                               \
+            break;                                                            \
+        case NK_SUB:                                                          \
+            LOOP(c[i] = (T)((U)a[i] - (U)b[i]))                               \
+            break;                                                            \
+        case NK_MUL:                                                          \
+            LOOP(c[i] = (T)((U)a[i] * (U)b[i]))                               \
+            break;                                                            \
+        case NK_DIV:                                                          \
+            LOOP(c[i] = DIV(T, U, a[i], b[i]))                                \
+            break;                                                            \
+        case NK_EQ:                                                           \
+            LOOP(c[i] = a[i] == b[i])                                         \
+            break;                                                            \
+        case NK_NE:                                                           \
+            LOOP(c[i] = a[i] != b[i])                                         \
+            break;                                                            \
+        case NK_LT:                                                           \
+            LOOP(c[i] = a[i] < b[i])                                          \
+            break;                                                            \
+        case NK_LE:                                                           \
+            LOOP(c[i] = a[i] <= b[i])                                         \
+            break;                                                            \
+        case NK_GT:                                                           \
+            LOOP(c[i] = a[i] > b[i])                                          \
+            break;                                                            \
+        case NK_GE:                                                           \
+            LOOP(c[i] = a[i] >= b[i])                                         \
+            break;                                                            \
+        }                                                                     \
+    }
+
+/*
+ * c = a op s, element by element; for NK_RSUB and NK_RDIV, c = s op a.
+ */
+#define KERNEL_SCALAR(SUF, T, U, DIV)                                         \
+    static void scalar_##SUF(int op, T* restrict c, const T* restrict a,     \
+                             T s, size_t n)                                  \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_ADD:                                                          \
+            LOOP(c[i] = (T)((U)a[i] + (U)s))                                  \
+            break;                                                            \
+        case NK_SUB:                                                          \
+            LOOP(c[i] = (T)((U)a[i] - (U)s))                                  \
+            break;                                                            \
+        case NK_RSUB:                                                         \
+            LOOP(c[i] = (T)((U)s - (U)a[i]))                                  \
+            break;                                                            \
+        case NK_MUL:                                                          \
+            LOOP(c[i] = (T)((U)a[i] * (U)s))                                  \
+            break;                                                            \
+        case NK_DIV:                                                          \
+            LOOP(c[i] = DIV(T, U, a[i], s))                                   \
+            break;                                                            \
+        case NK_RDIV:                                                         \
+            LOOP(c[i] = DIV(T, U, s, a[i]))                                   \
+            break;                                                            \
+        case NK_EQ:                                                           \
+            LOOP(c[i] = a[i] == s)                                            \
+            break;                                                            \
+        case NK_NE:                                                           \
+            LOOP(c[i] = a[i] != s)                                            \
+            break;                                                            \
+        case NK_LT:                                                           \
+            LOOP(c[i] = a[i] < s)                                             \
+            break;                                                            \
+        case NK_LE:                                                           \
+            LOOP(c[i] = a[i] <= s)                                            \
+            break;                                                            \
+        case NK_GT:                                                           \
+            LOOP(c[i] = a[i] > s)                                             \
+            break;                                                            \
+        case NK_GE:                                                           \
+            LOOP(c[i] = a[i] >= s)                                            \
+            break;                                                            \
+        }                                                                     \
+    }
+
+/*
+ * The reduction of a, computed in double; n > 0 for NK_MIN and NK_MAX.
+ */
+#define KERNEL_REDUCE(SUF, T)                                                 \
+    static double reduce_##SUF(int op, const T* restrict a, size_t n)        \
+    {                                                                         \
+        size_t i;                                                             \
+        double r;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_PROD:                                                         \
+            r = 1.0;                                                          \
+            _Pragma("omp simd reduction(* : r)")                              \
+            for (i = 0; i < n; i++)                                           \
+                r *= a[i];                                                    \
+            return r;                                                         \
+        case NK_MIN:                                                          \
+            r = a[0];                                                         \
+            _Pragma("omp simd reduction(min : r)")                            \
+            for (i = 1; i < n; i++)                                           \
+                r = a[i] < r ? a[i] : r;                                      \
+            return r;                                                         \
+        case NK_MAX:                                                          \
+            r = a[0];                                                         \
+            _Pragma("omp simd reduction(max : r)")                            \
+            for (i = 1; i < n; i++)                                           \
+                r = a[i] > r ? a[i] : r;                                      \
+            return r;                                                         \
+        case NK_SUMSQ:                                                        \
+            r = 0.0;                                                          \
+            _Pragma("omp simd reduction(+ : r)")                              \
+            for (i = 0; i < n; i++)                                           \
+                r += (double)a[i] * a[i];                                     \
+            return r;                                                         \
+        default: /* NK_SUM */                                                 \
+            r = 0.0;                                                          \
+            _Pragma("omp simd reduction(+ : r)")                              \
+            for (i = 0; i < n; i++)                                           \
+                r += a[i];                                                    \
+            return r;                                                         \
+        }                                                                     \
+    }
+
+/*
+ * The reduction of integers a, computed in 64 bits; not for NK_SUMSQ.
+ */
+#define KERNEL_IREDUCE(SUF, T)                                                \
+    static int64_t ireduce_##SUF(int op, const T* restrict a, size_t n)      \
+    {                                                                         \
+        size_t i;                                                             \
+        int64_t r;                                                            \
+        uint64_t u;                                                           \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_PROD:                                                         \
+            u = 1;                                                            \
+            _Pragma("omp simd reduction(* : u)")                              \
+            for (i = 0; i < n; i++)                                           \
+                u *= (uint64_t)a[i];                                          \
+            return (int64_t)u;                                                \
+        case NK_MIN:                                                          \
+            r = a[0];                                                         \
+            _Pragma("omp simd reduction(min : r)")                            \
+            for (i = 1; i < n; i++)                                           \
+                r = a[i] < r ? a[i] : r;                                      \
+            return r;                                                         \
+        case NK_MAX:                                                          \
+            r = a[0];                                                         \
+            _Pragma("omp simd reduction(max : r)")                            \
+            for (i = 1; i < n; i++)                                           \
+                r = a[i] > r ? a[i] : r;                                      \
+            return r;                                                         \
+        default: /* NK_SUM */                                                 \
+            u = 0;                                                            \
+            _Pragma("omp simd reduction(+ : u)")                              \
+            for (i = 0; i < n; i++)                                           \
+                u += (uint64_t)a[i];                                          \
+            return (int64_t)u;                                                \
+        }                                                                     \
+    }
+
+/*
+ * c = f(a), element by element. Integers only have the absolute value.
+ */
+#define KERNEL_MAP(SUF, T, U, ABS)                                            \
+    static void map_##SUF(int op, T* restrict c, const T* restrict a,        \
+                          size_t n)                                          \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_ABS:                                                          \
+            LOOP(c[i] = ABS(T, U, a[i]))                                      \
+            break;                                                            \
+        case NK_SQRT:                                                         \
+            LOOP(c[i] = (T)sqrt(a[i]))                                        \
+            break;                                                            \
+        case NK_EXP:                                                          \
+            LOOP(c[i] = (T)exp(a[i]))                                         \
+            break;                                                            \
+        case NK_LOG:                                                          \
+            LOOP(c[i] = (T)log(a[i]))                                         \
+            break;                                                            \
+        }                                                                     \
+    }
+
+#define KERNEL_IMAP(SUF, T, U, ABS)                                           \
+    static void map_##SUF(int op, T* restrict c, const T* restrict a,        \
+                          size_t n)                                          \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        if (op == NK_ABS)                                                     \
+            LOOP(c[i] = ABS(T, U, a[i]))                                      \
+    }
+
+/*
+ * Reductions of the columns of a matrix, one row a at a time: r = r op a,
+ * element by element, with r in double for float elements and in 64 bits
+ * for integers, that wrap around. For the positions of the minimum or
+ * maximum, k[i] becomes row where a[i] is a new one.
+ */
+#define KERNEL_ACCUM(SUF, T, R, U)                                            \
+    static void accum_##SUF(int op, R* restrict r, const T* restrict a,      \
+                            size_t n)                                        \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_PROD:                                                         \
+            LOOP(r[i] = (R)((U)r[i] * (U)a[i]))                               \
+            break;                                                            \
+        case NK_MIN:                                                          \
+            LOOP(r[i] = a[i] < r[i] ? a[i] : r[i])                            \
+            break;                                                            \
+        case NK_MAX:                                                          \
+            LOOP(r[i] = a[i] > r[i] ? a[i] : r[i])                            \
+            break;                                                            \
+        default: /* NK_SUM */                                                 \
+            LOOP(r[i] = (R)((U)r[i] + (U)a[i]))                               \
+            break;                                                            \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static void argaccum_##SUF(int op, R* restrict r, int64_t* restrict k,   \
+                               int64_t row, const T* restrict a, size_t n)   \
+    {                                                                         \
+        size_t i;                                                             \
+                                                                              \
+        switch (op) {                                                         \
+        case NK_MIN:                                                          \
+            LOOP(if (a[i] < r[i]) {                                           \
+                r[i] = a[i];                                                  \
+                k[i] = row;                                                   \
+            })                                                                \
+            break;                                                            \
+        default: /* NK_MAX */                                                 \
+            LOOP(if (a[i] > r[i]) {                                           \
+                r[i] = a[i];                                                  \
+                k[i] = row;                                                   \
+            })                                                                \
+            break;                                                            \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static size_t argreduce_##SUF(int op, const T* a, size_t n)              \
+    {                                                                         \
+        size_t i, k = 0;                                                      \
+                                                                              \
+        for (i = 1; i < n; i++)                                               \
+            if (op == NK_MIN ? a[i] < a[k] : a[i] > a[k])                     \
+                k = i;                                                        \
+        return k;                                                             \
+    }
+
+KERNEL_BINARY(f64, double, double, DIV_FLT)
+KERNEL_BINARY(f32, float, float, DIV_FLT)
+KERNEL_BINARY(i64, int64_t, uint64_t, DIV_INT)
+KERNEL_BINARY(i32, int32_t, uint32_t, DIV_INT)
+KERNEL_BINARY(u8, uint8_t, uint8_t, DIV_UNS)
+
+KERNEL_SCALAR(f64, double, double, DIV_FLT)
+KERNEL_SCALAR(f32, float, float, DIV_FLT)
+KERNEL_SCALAR(i64, int64_t, uint64_t, DIV_INT)
+KERNEL_SCALAR(i32, int32_t, uint32_t, DIV_INT)
+KERNEL_SCALAR(u8, uint8_t, uint8_t, DIV_UNS)
+
+KERNEL_REDUCE(f64, double)
+KERNEL_REDUCE(f32, float)
+KERNEL_REDUCE(i64, int64_t)
+KERNEL_REDUCE(i32, int32_t)
+KERNEL_REDUCE(u8, uint8_t)
+
+KERNEL_IREDUCE(i64, int64_t)
+KERNEL_IREDUCE(i32, int32_t)
+KERNEL_IREDUCE(u8, uint8_t)
+
+KERNEL_MAP(f64, double, double, ABS_FLT)
+KERNEL_MAP(f32, float, float, ABS_FLT)
+KERNEL_IMAP(i64, int64_t, uint64_t, ABS_INT)
+KERNEL_IMAP(i32, int32_t, uint32_t, ABS_INT)
+KERNEL_IMAP(u8, uint8_t, uint8_t, ABS_UNS)
+
+KERNEL_ACCUM(f64, double, double, double)
+KERNEL_ACCUM(f32, float, double, double)
+KERNEL_ACCUM(i64, int64_t, int64_t, uint64_t)
+KERNEL_ACCUM(i32, int32_t, int64_t, uint64_t)
+KERNEL_ACCUM(u8, uint8_t, int64_t, uint64_t)
+
+/*
+ * Conversions to each element type: floats are saturated when converted to
+ * integers, NaN becomes 0; integers wrap around.
+ */
+#define TO_F64(x) ((double)(x))
+#define TO_F32(x) ((float)(x))
+#define SAT_I64(x)                                                            \
+    ((x) != (x)                        ? 0                                    \
+     : (x) <= -9223372036854775808.0 ? INT64_MIN                              \
+     : (x) >= 9223372036854775808.0  ? INT64_MAX                              \
+                                     : (int64_t)(x))
+#define SAT_I32(x)                                                            \
+    ((x) != (x)               ? 0                                             \
+     : (x) <= -2147483648.0 ? INT32_MIN                                       \
+     : (x) >= 2147483647.0  ? INT32_MAX                                       \
+                            : (int32_t)(x))
+#define SAT_U8(x) ((x) != (x) || (x) <= 0 ? 0 : (x) >= 255 ? 255 : (uint8_t)(x))
+#define WRAP_I64(x) ((int64_t)(uint64_t)(x))
+#define WRAP_I32(x) ((int32_t)(uint32_t)(x))
+#define WRAP_U8(x) ((uint8_t)(x))
+
+#define CAST_LOOP(TD, TS, CONV)                                               \
+    {                                                                         \
+        TD* restrict c_ = c;                                                  \
+        const TS* restrict a_ = a;                                            \
+        LOOP(c_[i] = CONV(a_[i]))                                             \
+    }
+
+#define CAST_TO(TD, FROM_FLT, FROM_INT)                                       \
+    switch (from) {                                                           \
+    case DT_F64:                                                              \
+        CAST_LOOP(TD, double, FROM_FLT)                                       \
+        break;                                                                \
+    case DT_F32:                                                              \
+        CAST_LOOP(TD, float, FROM_FLT)                                        \
+        break;                                                                \
+    case DT_I64:                                                              \
+        CAST_LOOP(TD, int64_t, FROM_INT)                                      \
+        break;                                                                \
+    case DT_I32:                                                              \
+        CAST_LOOP(TD, int32_t, FROM_INT)                                      \
+        break;                                                                \
+    case DT_U8:                                                               \
+        CAST_LOOP(TD, uint8_t, FROM_INT)                                      \
+        break;                                                                \
+    }
+
+/*
+ * kernel_width - the number of bytes of an element.
+ */
+size_t kernel_width(int dtype)
+{
+    switch (dtype) {
+    case DT_F32:
+    case DT_I32:
+        return 4;
+    case DT_U8:
+        return 1;
+    default:
+        return 8;
+    }
+}
+
+static const char* dtype_names[] = { "float64", "float32", "int64", "int32",
+                                     "uint8" };
+
+/*
+ * kernel_name - the name of an element type, as used by ncast and ndtype.
+ */
+const char* kernel_name(int dtype) { return dtype_names[dtype]; }
+
+/*
+ * kernel_dtype - the element type with the given name, or -1.
+ */
+int kernel_dtype(const char* name)
+{
+    int i;
+
+    for (i = 0; i < (int)(sizeof(dtype_names) / sizeof(dtype_names[0])); i++)
+        if (!strcmp(name, dtype_names[i]))
+            return i;
+    return -1;
+}
+
+/*
+ * kernel_binary - c = a op b, element by element.
+ */
+void kernel_binary(int dtype, int op, void* c, const void* a, const void* b,
+                   size_t n)
+{
+    switch (dtype) {
+    case DT_F64:
+        binary_f64(op, c, a, b, n);
+        break;
+    case DT_F32:
+        binary_f32(op, c, a, b, n);
+        break;
+    case DT_I64:
+        binary_i64(op, c, a, b, n);
+        break;
+    case DT_I32:
+        binary_i32(op, c, a, b, n);
+        break;
+    case DT_U8:
+        binary_u8(op, c, a, b, n);
+        break;
+    }
+}
+
+/*
+ * kernel_scalar - c = a op s, element by element; for NK_RSUB and NK_RDIV,
+ *		   c = s op a. The scalar has the element type.
+ */
+void kernel_scalar(int dtype, int op, void* c, const void* a,
+                   const NativeScalar* s, size_t n)
+{
+    switch (dtype) {
+    case DT_F64:
+        scalar_f64(op, c, a, s->f64, n);
+        break;
+    case DT_F32:
+        scalar_f32(op, c, a, s->f32, n);
+        break;
+    case DT_I64:
+        scalar_i64(op, c, a, s->i64, n);
+        break;
+    case DT_I32:
+        scalar_i32(op, c, a, s->i32, n);
+        break;
+    case DT_U8:
+        scalar_u8(op, c, a, s->u8, n);
+        break;
+    }
+}
+
+/*
+ * kernel_reduce - the reduction of a, as a double; n > 0 for NK_MIN and
+ *		   NK_MAX.
+ */
+double kernel_reduce(int dtype, int op, const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_F32:
+        return reduce_f32(op, a, n);
+    case DT_I64:
+        return reduce_i64(op, a, n);
+    case DT_I32:
+        return reduce_i32(op, a, n);
+    case DT_U8:
+        return reduce_u8(op, a, n);
+    default:
+        return reduce_f64(op, a, n);
+    }
+}
+
+/*
+ * kernel_ireduce - the reduction of integers a, in 64 bits; n > 0 for
+ *		    NK_MIN and NK_MAX.
+ */
+int64_t kernel_ireduce(int dtype, int op, const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_I32:
+        return ireduce_i32(op, a, n);
+    case DT_U8:
+        return ireduce_u8(op, a, n);
+    default:
+        return ireduce_i64(op, a, n);
+    }
+}
+
+/*
+ * kernel_accumulate - r = r op a, element by element, for reduction op other
+ *		       than NK_SUMSQ. r has doubles for float elements a and
+ *		       64-bit integers otherwise.
+ */
+void kernel_accumulate(int dtype, int op, void* r, const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_F64:
+        accum_f64(op, r, a, n);
+        break;
+    case DT_F32:
+        accum_f32(op, r, a, n);
+        break;
+    case DT_I64:
+        accum_i64(op, r, a, n);
+        break;
+    case DT_I32:
+        accum_i32(op, r, a, n);
+        break;
+    case DT_U8:
+        accum_u8(op, r, a, n);
+        break;
+    }
+}
+
+/*
+ * kernel_argaccumulate - kernel_accumulate of NK_MIN or NK_MAX, that also
+ *			  sets k[i] to row where a[i] becomes r[i].
+ */
+void kernel_argaccumulate(int dtype, int op, void* r, int64_t* k, int64_t row,
+                          const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_F64:
+        argaccum_f64(op, r, k, row, a, n);
+        break;
+    case DT_F32:
+        argaccum_f32(op, r, k, row, a, n);
+        break;
+    case DT_I64:
+        argaccum_i64(op, r, k, row, a, n);
+        break;
+    case DT_I32:
+        argaccum_i32(op, r, k, row, a, n);
+        break;
+    case DT_U8:
+        argaccum_u8(op, r, k, row, a, n);
+        break;
+    }
+}
+
+/*
+ * kernel_argreduce - the index of the first smallest (NK_MIN) or largest
+ *		      (NK_MAX) element of a; n > 0.
+ */
+size_t kernel_argreduce(int dtype, int op, const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_F32:
+        return argreduce_f32(op, a, n);
+    case DT_I64:
+        return argreduce_i64(op, a, n);
+    case DT_I32:
+        return argreduce_i32(op, a, n);
+    case DT_U8:
+        return argreduce_u8(op, a, n);
+    default:
+        return argreduce_f64(op, a, n);
+    }
+}
+
+/*
+ * kernel_map - c = f(a), element by element.
+ */
+void kernel_map(int dtype, int op, void* c, const void* a, size_t n)
+{
+    switch (dtype) {
+    case DT_F64:
+        map_f64(op, c, a, n);
+        break;
+    case DT_F32:
+        map_f32(op, c, a, n);
+        break;
+    case DT_I64:
+        map_i64(op, c, a, n);
+        break;
+    case DT_I32:
+        map_i32(op, c, a, n);
+        break;
+    case DT_U8:
+        map_u8(op, c, a, n);
+        break;
+    }
+}
+
+/*
+ * kernel_cast - convert n elements of type from in a to type to in c.
+ */
+void kernel_cast(int to, void* c, int from, const void* a, size_t n)
+{
+    size_t i;
+
+    switch (to) {
+    case DT_F64:
+        CAST_TO(double, TO_F64, TO_F64)
+        break;
+    case DT_F32:
+        CAST_TO(float, TO_F32, TO_F32)
+        break;
+    case DT_I64:
+        CAST_TO(int64_t, SAT_I64, WRAP_I64)
+        break;
+    case DT_I32:
+        CAST_TO(int32_t, SAT_I32, WRAP_I32)
+        break;
+    case DT_U8:
+        CAST_TO(uint8_t, SAT_U8, WRAP_U8)
+        break;
+    }
+}
+
+/*
+ * kernel_get - element i of a, as a double.
+ */
+double kernel_get(int dtype, const void* a, size_t i)
+{
+    switch (dtype) {
+    case DT_F32:
+        return ((const float*)a)[i];
+    case DT_I64:
+        return (double)((const int64_t*)a)[i];
+    case DT_I32:
+        return ((const int32_t*)a)[i];
+    case DT_U8:
+        return ((const uint8_t*)a)[i];
+    default:
+        return ((const double*)a)[i];
+    }
+}
+
+/*
+ * kernel_geti - element i of integers a.
+ */
+int64_t kernel_geti(int dtype, const void* a, size_t i)
+{
+    switch (dtype) {
+    case DT_I32:
+        return ((const int32_t*)a)[i];
+    case DT_U8:
+        return ((const uint8_t*)a)[i];
+    default:
+        return ((const int64_t*)a)[i];
+    }
+}
+
+/*
+ * kernel_gather - copy n elements of a, inc apart from element i, to c.
+ */
+void kernel_gather(int dtype, void* c, const void* a, int64_t i, int64_t inc,
+                   size_t n)
+{
+    size_t k;
+
+    switch (kernel_width(dtype)) {
+    case 1:
+        for (k = 0; k < n; k++)
+            ((uint8_t*)c)[k] = ((const uint8_t*)a)[i + (int64_t)k * inc];
+        break;
+    case 4:
+        for (k = 0; k < n; k++)
+            ((uint32_t*)c)[k] = ((const uint32_t*)a)[i + (int64_t)k * inc];
+        break;
+    default:
+        for (k = 0; k < n; k++)
+            ((uint64_t*)c)[k] = ((const uint64_t*)a)[i + (int64_t)k * inc];
+        break;
+    }
+}
+
+/*
+ * kernel_combine - the reduction of r, that reduces the first part of some
+ *		    elements, and x, that reduces the rest.
+ */
+double kernel_combine(int op, double r, double x)
+{
+    switch (op) {
+    case NK_PROD:
+        return r * x;
+    case NK_MIN:
+        return x < r ? x : r;
+    case NK_MAX:
+        return x > r ? x : r;
+    default:
+        return r + x;
+    }
+}
+
+/*
+ * kernel_icombine - kernel_combine of integer reductions, wrapping around.
+ */
+int64_t kernel_icombine(int op, int64_t r, int64_t x)
+{
+    switch (op) {
+    case NK_PROD:
+        return (int64_t)((uint64_t)r * (uint64_t)x);
+    case NK_MIN:
+        return x < r ? x : r;
+    case NK_MAX:
+        return x > r ? x : r;
+    default:
+        return (int64_t)((uint64_t)r + (uint64_t)x);
+    }
+}
+
+/*
+ * kernel_set - store x as element i of c, converted as kernel_cast does.
+ */
+void kernel_set(int dtype, void* c, size_t i, double x)
+{
+    kernel_cast(dtype, (char*)c + i * kernel_width(dtype), DT_F64, &x, 1);
+}
+
+/*
+ * Elements i .. i + n - 1 of vector vec, with n at most VX_CHUNK. They are
+ * computed into buf when vec is deferred, and copied there when they are not
+ * adjacent.
+ */
+static const void* vector_chunk(const VectorData* vec, size_t i, size_t n,
+                                void* buf)
+{
+    const void *x, *y;
+    double xbuf[VX_CHUNK], ybuf[VX_CHUNK]; /* room for any element type */
+
+    if (vec->kind == VX_NONE) {
+        if (vec->inc == 1)
+            return (const char*)vec->data + i * kernel_width(vec->dtype);
+        kernel_gather(vec->dtype, buf, vec->data, i * vec->inc, vec->inc, n);
+        return buf;
+    }
+    x = vector_chunk(vec->a, i, n, xbuf);
+    switch (vec->kind) {
+    case VX_BINARY:
+        y = vector_chunk(vec->b, i, n, ybuf);
+        kernel_binary(vec->dtype, vec->op, buf, x, y, n);
+        break;
+    case VX_SCALAR:
+        kernel_scalar(vec->dtype, vec->op, buf, x, &vec->s, n);
+        break;
+    case VX_MAP:
+        kernel_map(vec->dtype, vec->op, buf, x, n);
+        break;
+    }
+    return buf;
+}
+
+/*
+ * vector_defer - the vector that results from an operation of the given kind
+ *		  on vector a and vector b or scalar s, of the element type of
+ *		  a. The operands must not be collected before the result is
+ *		  stored in a node.
+ */
+VectorData* vector_defer(pEnv env, int kind, int op, VectorData* a,
+                         VectorData* b, const NativeScalar* s)
+{
+    VectorData* vec;
+
+    if (a->size + (b ? b->size : 0) + 1 > VX_MAX_SIZE) {
+        vector_force(a); /* keep the expression, and the stack, small */
+        if (b)
+            vector_force(b);
+    }
+    vec = native_vector(env, a->dtype, a->len);
+    vec->kind = kind;
+    vec->op = op;
+    vec->size = 1 + a->size + (b ? b->size : 0);
+    vec->a = a;
+    vec->b = b;
+    if (s)
+        vec->s = *s;
+    return vec;
+}
+
+/*
+ * vector_eval - compute the elements of vector vec into c, without changing
+ *		 vec. This is also safe for a vector of another context.
+ */
+void vector_eval(const VectorData* vec, void* c)
+{
+    size_t i, n, w;
+    const void* x;
+    char* dst;
+
+    w = kernel_width(vec->dtype);
+    for (i = 0; i < (size_t)vec->len; i += n) {
+        n = vec->len - i < VX_CHUNK ? vec->len - i : VX_CHUNK;
+        dst = (char*)c + i * w;
+        if ((x = vector_chunk(vec, i, n, dst)) != dst)
+            memcpy(dst, x, n * w);
+    }
+}
+
+/*
+ * vector_force - compute the elements of a deferred vector, once, and
+ *		  return them. The operands are no longer needed afterwards.
+ *		  The elements of a view are vec->inc apart.
+ */
+void* vector_force(VectorData* vec)
+{
+    if (vec->kind != VX_NONE) {
+        vector_eval(vec, vec->data);
+        vec->kind = VX_NONE;
+        vec->size = 0;
+        vec->a = vec->b = 0;
+    }
+    return vec->data;
+}
+
+/*
+ * vector_reduce - the reduction of the elements of vector vec, as a double,
+ *		   computed per chunk when vec is deferred; vec->len > 0 for
+ *		   NK_MIN and NK_MAX.
+ */
+double vector_reduce(int op, VectorData* vec)
+{
+    size_t i, n;
+    double r = 0.0, x, buf[VX_CHUNK];
+
+    if (vec->kind == VX_NONE && vec->inc == 1)
+        return kernel_reduce(vec->dtype, op, vec->data, vec->len);
+    for (i = 0; i < (size_t)vec->len; i += n) {
+        n = vec->len - i < VX_CHUNK ? vec->len - i : VX_CHUNK;
+        x = kernel_reduce(vec->dtype, op, vector_chunk(vec, i, n, buf), n);
+        r = i ? kernel_combine(op, r, x) : x;
+    }
+    return r;
+}
+
+/*
+ * vector_ireduce - vector_reduce of a vector of integers, in 64 bits.
+ */
+int64_t vector_ireduce(int op, VectorData* vec)
+{
+    size_t i, n;
+    int64_t r = 0, x, buf[VX_CHUNK];
+
+    if (vec->kind == VX_NONE && vec->inc == 1)
+        return kernel_ireduce(vec->dtype, op, vec->data, vec->len);
+    for (i = 0; i < (size_t)vec->len; i += n) {
+        n = vec->len - i < VX_CHUNK ? vec->len - i : VX_CHUNK;
+        x = kernel_ireduce(vec->dtype, op, vector_chunk(vec, i, n, buf), n);
+        r = i ? kernel_icombine(op, r, x) : x;
+    }
+    return r;
+}
+
+/*
+ * vector_cast - convert the elements of vector vec to type to, in c, per
+ *		 chunk when vec is deferred or its elements are not adjacent.
+ */
+void vector_cast(int to, void* c, const VectorData* vec)
+{
+    size_t i, n;
+    int64_t buf[VX_CHUNK];
+
+    if (vec->kind == VX_NONE && vec->inc == 1) {
+        kernel_cast(to, c, vec->dtype, vec->data, vec->len);
+        return;
+    }
+    for (i = 0; i < (size_t)vec->len; i += n) {
+        n = vec->len - i < VX_CHUNK ? vec->len - i : VX_CHUNK;
+        kernel_cast(to, (char*)c + i * kernel_width(to), vec->dtype,
+                    vector_chunk(vec, i, n, buf), n);
+    }
+}
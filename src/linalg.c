@@ -0,0 +1,574 @@
+/*
+ *  module  : linalg.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Factorizations and linear systems of dense matrices of doubles.
+ *
+ *  Matrices are stored by rows, n x n or m x n, without gaps. LU uses
+ *  partial pivoting, QR Householder reflections and Cholesky the lower
+ *  triangle. The built-in versions work on panels of LINALG_BLOCK columns:
+ *  a panel is factored by itself and the rest of the matrix is then updated
+ *  in one pass, with a matrix product, such that the rows that are read stay
+ *  in the cache. With LAPACK (JOY_LAPACK), the factorizations are done by
+ *  dgetrf, dgeqrf and dpotrf, and the systems by dgesv and dgels; the results
+ *  have the same form in both cases.
+ *
+ *  A pivot that is smaller than LINALG_TINY makes the matrix singular, as it
+ *  did for det and inv.
+ */
+#include "globals.h"
+#include <math.h>
+
+#ifdef JOY_BLAS
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include <cblas.h>
+#endif
+#endif
+
+#define LINALG_BLOCK 64   /* columns of a panel */
+#define LINALG_TINY 1e-15 /* smallest pivot */
+
+#ifdef JOY_LAPACK
+/*
+ * Fortran LAPACK, with 32-bit integers. Matrices are stored by columns.
+ */
+extern void dgetrf_(const int* m, const int* n, double* a, const int* lda,
+                    int* ipiv, int* info);
+extern void dgesv_(const int* n, const int* nrhs, double* a, const int* lda,
+                   int* ipiv, double* b, const int* ldb, int* info);
+extern void dgeqrf_(const int* m, const int* n, double* a, const int* lda,
+                    double* tau, double* work, const int* lwork, int* info);
+extern void dgels_(const char* trans, const int* m, const int* n,
+                   const int* nrhs, double* a, const int* lda, double* b,
+                   const int* ldb, double* work, const int* lwork, int* info);
+extern void dpotrf_(const char* uplo, const int* n, double* a, const int* lda,
+                    int* info);
+
+/*
+ * Copy the m x n matrix a, stored by rows, to c, stored by columns, or back.
+ */
+static void linalg_transpose(double* c, const double* a, int64_t m, int64_t n)
+{
+    int64_t i, j;
+
+    for (i = 0; i < m; i++)
+        for (j = 0; j < n; j++)
+            c[j * m + i] = a[i * n + j];
+}
+
+/*
+ * A scratch matrix of m x n doubles.
+ */
+static double* linalg_scratch(int64_t m, int64_t n)
+{
+    return check_malloc((m && n ? m * n : 1) * sizeof(double));
+}
+#endif
+
+/*
+ * linalg_gemm - c += alpha * a * b, with a m x k, b k x n and c m x n,
+ *		 whose rows are lda, ldb and ldc apart.
+ */
+void linalg_gemm(int64_t m, int64_t n, int64_t k, double alpha,
+                 const double* a, int64_t lda, const double* b, int64_t ldb,
+                 double* c, int64_t ldc)
+{
+    if (!m || !n || !k)
+        return;
+#ifdef JOY_BLAS
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, alpha, a,
+                lda, b, ldb, 1.0, c, ldc);
+#else
+    gemm_f64(m, n, k, alpha, a, lda, b, ldb, c, ldc);
+#endif
+}
+
+#ifndef JOY_LAPACK
+/*
+ * Swap rows i and j of n elements.
+ */
+static void linalg_swap(double* a, int64_t n, int64_t i, int64_t j)
+{
+    int64_t k;
+    double x;
+
+    for (k = 0; k < n; k++) {
+        x = a[i * n + k];
+        a[i * n + k] = a[j * n + k];
+        a[j * n + k] = x;
+    }
+}
+#endif
+
+/*
+ * linalg_lu - factor n x n matrix a in place into L U, with L unit lower
+ *	       triangular, after swapping row i with row piv[i], for i from 0
+ *	       to n - 1. Returns 0, or 1 + the column of the first pivot that
+ *	       is too small; the factors are complete in that case as well.
+ */
+int linalg_lu(double* a, int64_t n, int64_t* piv)
+{
+    int info = 0;
+    int64_t i;
+#ifdef JOY_LAPACK
+    int m = n, *ipiv;
+    double* c;
+
+    c = linalg_scratch(n, n);
+    ipiv = check_malloc((n ? n : 1) * sizeof(int));
+    linalg_transpose(c, a, n, n);
+    dgetrf_(&m, &m, c, &m, ipiv, &info);
+    linalg_transpose(a, c, n, n);
+    for (i = 0; i < n; i++)
+        piv[i] = ipiv[i] - 1;
+    free(ipiv);
+    free(c);
+    for (info = 0, i = 0; i < n && !info; i++)
+        if (fabs(a[i * n + i]) < LINALG_TINY)
+            info = i + 1;
+#else
+    int64_t j, k, kb, p, q;
+    double x;
+
+    for (k = 0; k < n; k += LINALG_BLOCK) {
+        kb = n - k < LINALG_BLOCK ? n - k : LINALG_BLOCK;
+        /*
+         * The panel: columns k .. k + kb - 1, unblocked. Rows are swapped
+         * in full.
+         */
+        for (j = k; j < k + kb; j++) {
+            for (p = j, i = j + 1; i < n; i++)
+                if (fabs(a[i * n + j]) > fabs(a[p * n + j]))
+                    p = i;
+            piv[j] = p;
+            if (p != j)
+                linalg_swap(a, n, p, j);
+            if (fabs(a[j * n + j]) < LINALG_TINY && !info)
+                info = j + 1;
+            if (a[j * n + j] == 0.0)
+                continue; /* the column below is 0 as well */
+            for (i = j + 1; i < n; i++) {
+                x = a[i * n + j] /= a[j * n + j];
+#pragma omp simd
+                for (q = j + 1; q < k + kb; q++)
+                    a[i * n + q] -= x * a[j * n + q];
+            }
+        }
+        if (k + kb == n)
+            break;
+        /*
+         * The rows of U to the right of the panel: L11 U12 = A12.
+         */
+        for (j = k; j < k + kb; j++)
+            for (i = j + 1; i < k + kb; i++) {
+                x = a[i * n + j];
+#pragma omp simd
+                for (q = k + kb; q < n; q++)
+                    a[i * n + q] -= x * a[j * n + q];
+            }
+        /*
+         * The rest: A22 -= L21 U12.
+         */
+        linalg_gemm(n - k - kb, n - k - kb, kb, -1.0, a + (k + kb) * n + k,
+                    n, a + k * n + k + kb, n, a + (k + kb) * n + k + kb, n);
+    }
+#endif
+    return info;
+}
+
+#ifndef JOY_LAPACK
+/*
+ * Solve L U x = b for nrhs columns of b, in place, with the factors and the
+ * swaps of linalg_lu.
+ */
+static void linalg_lusolve(const double* a, int64_t n, const int64_t* piv,
+                           double* b, int64_t nrhs)
+{
+    int64_t i, j, q;
+    double x;
+
+    for (i = 0; i < n; i++)
+        if (piv[i] != i)
+            linalg_swap(b, nrhs, i, piv[i]);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < i; j++) {
+            x = a[i * n + j];
+#pragma omp simd
+            for (q = 0; q < nrhs; q++)
+                b[i * nrhs + q] -= x * b[j * nrhs + q];
+        }
+    for (i = n - 1; i >= 0; i--) {
+        for (j = i + 1; j < n; j++) {
+            x = a[i * n + j];
+#pragma omp simd
+            for (q = 0; q < nrhs; q++)
+                b[i * nrhs + q] -= x * b[j * nrhs + q];
+        }
+        x = a[i * n + i];
+#pragma omp simd
+        for (q = 0; q < nrhs; q++)
+            b[i * nrhs + q] /= x;
+    }
+}
+#endif
+
+/*
+ * linalg_solve - solve a x = b for n x n matrix a and nrhs columns of b. The
+ *		  solution replaces b, and a is destroyed. Returns 0, or not
+ *		  0 when a is singular.
+ */
+int linalg_solve(double* a, int64_t n, double* b, int64_t nrhs)
+{
+    int info;
+#ifdef JOY_LAPACK
+    int m = n, k = nrhs, *ipiv;
+    double *c, *d;
+
+    c = linalg_scratch(n, n);
+    d = linalg_scratch(n, nrhs);
+    ipiv = check_malloc((n ? n : 1) * sizeof(int));
+    linalg_transpose(c, a, n, n);
+    linalg_transpose(d, b, n, nrhs);
+    dgesv_(&m, &k, c, &m, ipiv, d, &m, &info);
+    for (m = 0; m < n && !info; m++)
+        if (fabs(c[(int64_t)m * n + m]) < LINALG_TINY)
+            info = m + 1;
+    linalg_transpose(b, d, nrhs, n);
+    free(ipiv);
+    free(d);
+    free(c);
+#else
+    int64_t* piv;
+
+    piv = check_malloc((n ? n : 1) * sizeof(int64_t));
+    if ((info = linalg_lu(a, n, piv)) == 0)
+        linalg_lusolve(a, n, piv, b, nrhs);
+    free(piv);
+#endif
+    return info;
+}
+
+/*
+ * linalg_det - the determinant of n x n matrix a, that is destroyed.
+ */
+double linalg_det(double* a, int64_t n)
+{
+    int64_t i, *piv;
+    double det = 1.0;
+
+    piv = check_malloc((n ? n : 1) * sizeof(int64_t));
+    if (linalg_lu(a, n, piv))
+        det = 0.0;
+    else
+        for (i = 0; i < n; i++)
+            det *= piv[i] == i ? a[i * n + i] : -a[i * n + i];
+    free(piv);
+    return det;
+}
+
+#ifndef JOY_LAPACK
+/*
+ * Cholesky factorization of the lower triangle of n x n matrix a, by panels,
+ * leaving the upper triangle.
+ */
+static int linalg_chol(double* a, int64_t n)
+{
+    int64_t i, j, k, kb, p;
+    double x, sum;
+
+    for (k = 0; k < n; k += LINALG_BLOCK) {
+        kb = n - k < LINALG_BLOCK ? n - k : LINALG_BLOCK;
+        /*
+         * The columns of the panel, a row at a time; the columns before k
+         * have been subtracted already.
+         */
+        for (i = k; i < n; i++)
+            for (j = k; j < k + kb && j <= i; j++) {
+                sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+                for (p = k; p < j; p++)
+                    sum += a[i * n + p] * a[j * n + p];
+                x = a[i * n + j] - sum;
+                if (i > j)
+                    a[i * n + j] = x / a[j * n + j];
+                else if (x > 0.0)
+                    a[j * n + j] = sqrt(x);
+                else
+                    return j + 1;
+            }
+        /*
+         * The rest: A22 -= L21 L21^T, in the lower triangle.
+         */
+        for (i = k + kb; i < n; i++)
+            for (j = k + kb; j <= i; j++) {
+                sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+                for (p = k; p < k + kb; p++)
+                    sum += a[i * n + p] * a[j * n + p];
+                a[i * n + j] -= sum;
+            }
+    }
+    return 0;
+}
+#endif
+
+/*
+ * linalg_cholesky - replace symmetric positive definite n x n matrix a by L,
+ *		     lower triangular, such that a = L L^T. Only the lower
+ *		     triangle of a is used. Returns 0, or 1 + the column where
+ *		     a turned out not to be positive definite.
+ */
+int linalg_cholesky(double* a, int64_t n)
+{
+    int info;
+    int64_t i, j;
+#ifdef JOY_LAPACK
+    int m = n;
+
+    /*
+     * The rows of a are the columns of LAPACK, so its upper triangle is the
+     * lower triangle here, and U^T = L.
+     */
+    dpotrf_("U", &m, a, &m, &info);
+#else
+    info = linalg_chol(a, n);
+#endif
+    if (info)
+        return info;
+    for (i = 0; i < n; i++)
+        for (j = i + 1; j < n; j++)
+            a[i * n + j] = 0.0;
+    return 0;
+}
+
+/*
+ * Element i of reflector p of the panel that starts at column k of a: 1 on
+ * the diagonal, stored below it, and 0 above it.
+ */
+#define REFLECTOR(a, n, k, p, i)                                              \
+    ((i) < (k) + (p) ? 0.0 : (i) == (k) + (p) ? 1.0 : (a)[(i) * (n) + (k) + (p)])
+
+/*
+ * Apply the kb reflectors of the panel that starts at column k of m x n
+ * matrix a, with factors tau, to rows k .. m - 1 of the nc columns of c,
+ * whose rows are ldc apart: c = (I - V T V^T) c, or with T^T when trans.
+ * T is the triangular factor of the block of reflectors.
+ */
+static void linalg_reflect(const double* a, int64_t m, int64_t n, int64_t k,
+                           int64_t kb, const double* tau, double* c,
+                           int64_t ldc, int64_t nc, int trans)
+{
+    int64_t i, p, q, j;
+    double x, *t, *w;
+
+    if (!nc)
+        return;
+    t = check_malloc(kb * kb * sizeof(double));
+    w = check_malloc(kb * nc * sizeof(double));
+    /*
+     * T, upper triangular: T[q][p] = -tau[p] T[q][0..p-1] V[.,0..p-1]^T v_p.
+     */
+    for (p = 0; p < kb; p++) {
+        for (q = 0; q < p; q++) {
+            for (x = 0.0, i = k + p; i < m; i++)
+                x += REFLECTOR(a, n, k, q, i) * REFLECTOR(a, n, k, p, i);
+            w[q] = x;
+        }
+        for (q = 0; q < p; q++) {
+            for (x = 0.0, j = q; j < p; j++)
+                x += t[q * kb + j] * w[j];
+            t[q * kb + p] = -tau[p] * x;
+        }
+        t[p * kb + p] = tau[p];
+        for (q = p + 1; q < kb; q++)
+            t[q * kb + p] = 0.0;
+    }
+    /*
+     * W = V^T c, a row of c at a time.
+     */
+    memset(w, 0, kb * nc * sizeof(double));
+    for (i = k; i < m; i++)
+        for (p = 0; p < kb && k + p <= i; p++) {
+            x = REFLECTOR(a, n, k, p, i);
+#pragma omp simd
+            for (j = 0; j < nc; j++)
+                w[p * nc + j] += x * c[i * ldc + j];
+        }
+    /*
+     * W = T^T W, from the last row, or W = T W, from the first.
+     */
+    if (trans)
+        for (p = kb - 1; p >= 0; p--)
+            for (j = 0; j < nc; j++) {
+                for (x = 0.0, q = 0; q <= p; q++)
+                    x += t[q * kb + p] * w[q * nc + j];
+                w[p * nc + j] = x;
+            }
+    else
+        for (p = 0; p < kb; p++)
+            for (j = 0; j < nc; j++) {
+                for (x = 0.0, q = p; q < kb; q++)
+                    x += t[p * kb + q] * w[q * nc + j];
+                w[p * nc + j] = x;
+            }
+    /*
+     * c -= V W.
+     */
+    for (i = k; i < m; i++)
+        for (p = 0; p < kb && k + p <= i; p++) {
+            x = REFLECTOR(a, n, k, p, i);
+#pragma omp simd
+            for (j = 0; j < nc; j++)
+                c[i * ldc + j] -= x * w[p * nc + j];
+        }
+    free(w);
+    free(t);
+}
+
+/*
+ * linalg_qr - factor m x n matrix a in place into Q R: R is the upper
+ *	       triangle, and Q is the product of min(m, n) reflectors
+ *	       I - tau[j] v v^T, with v stored below the diagonal in column
+ *	       j and an implicit 1 on it.
+ */
+void linalg_qr(double* a, int64_t m, int64_t n, double* tau)
+{
+#ifdef JOY_LAPACK
+    int rows = m, cols = n, lwork = -1, info;
+    double *c, *w, size;
+
+    c = linalg_scratch(m, n);
+    linalg_transpose(c, a, m, n);
+    dgeqrf_(&rows, &cols, c, &rows, tau, &size, &lwork, &info);
+    lwork = size > 1 ? (int)size : 1;
+    w = check_malloc(lwork * sizeof(double));
+    dgeqrf_(&rows, &cols, c, &rows, tau, w, &lwork, &info);
+    linalg_transpose(a, c, n, m);
+    free(w);
+    free(c);
+#else
+    int64_t i, j, k, kb, q, kmin = m < n ? m : n;
+    double alpha, beta, norm, x, *w;
+
+    w = check_malloc((n ? n : 1) * sizeof(double));
+    for (k = 0; k < kmin; k += LINALG_BLOCK) {
+        kb = kmin - k < LINALG_BLOCK ? kmin - k : LINALG_BLOCK;
+        /*
+         * The panel: each reflector is applied to the rest of the panel.
+         */
+        for (j = k; j < k + kb; j++) {
+            alpha = a[j * n + j];
+            for (norm = 0.0, i = j + 1; i < m; i++)
+                norm += a[i * n + j] * a[i * n + j];
+            if ((norm = sqrt(norm)) == 0.0) {
+                tau[j] = 0.0;
+                continue;
+            }
+            beta = alpha >= 0.0 ? -hypot(alpha, norm) : hypot(alpha, norm);
+            tau[j] = (beta - alpha) / beta;
+            for (i = j + 1; i < m; i++)
+                a[i * n + j] /= alpha - beta;
+            a[j * n + j] = beta;
+            for (q = j + 1; q < k + kb; q++)
+                w[q] = a[j * n + q];
+            for (i = j + 1; i < m; i++)
+                for (x = a[i * n + j], q = j + 1; q < k + kb; q++)
+                    w[q] += x * a[i * n + q];
+            for (q = j + 1; q < k + kb; q++)
+                a[j * n + q] -= w[q] *= tau[j];
+            for (i = j + 1; i < m; i++)
+                for (x = a[i * n + j], q = j + 1; q < k + kb; q++)
+                    a[i * n + q] -= x * w[q];
+        }
+        /*
+         * The columns to the right of the panel, with all its reflectors at
+         * once.
+         */
+        linalg_reflect(a, m, n, k, kb, tau + k, a + k + kb, n, n - k - kb, 1);
+    }
+    free(w);
+#endif
+}
+
+/*
+ * linalg_qr_q - the first min(m, n) columns of Q, in m x min(m, n) matrix q,
+ *		 from the result of linalg_qr.
+ */
+void linalg_qr_q(const double* a, int64_t m, int64_t n, const double* tau,
+                 double* q)
+{
+    int64_t i, k, kb, kmin = m < n ? m : n;
+
+    for (i = 0; i < m * kmin; i++)
+        q[i] = 0.0;
+    for (i = 0; i < kmin; i++)
+        q[i * kmin + i] = 1.0;
+    k = kmin ? (kmin - 1) / LINALG_BLOCK * LINALG_BLOCK : 0;
+    for (; k >= 0 && kmin; k -= LINALG_BLOCK) {
+        kb = kmin - k < LINALG_BLOCK ? kmin - k : LINALG_BLOCK;
+        linalg_reflect(a, m, n, k, kb, tau + k, q + k, kmin, kmin - k, 0);
+    }
+}
+
+/*
+ * linalg_lstsq - the x that minimizes |a x - b|, for m x n matrix a with
+ *		  m >= n and full column rank, and nrhs columns of b. The
+ *		  solution replaces the first n rows of b; a is destroyed.
+ *		  Returns 0, or not 0 when the rank is less than n.
+ */
+int linalg_lstsq(double* a, int64_t m, int64_t n, double* b, int64_t nrhs)
+{
+    int info = 0;
+    int64_t i;
+#ifdef JOY_LAPACK
+    int rows = m, cols = n, k2 = nrhs, lwork = -1;
+    double *c, *d, size, *w;
+
+    c = linalg_scratch(m, n);
+    d = linalg_scratch(m, nrhs);
+    linalg_transpose(c, a, m, n);
+    linalg_transpose(d, b, m, nrhs);
+    dgels_("N", &rows, &cols, &k2, c, &rows, d, &rows, &size, &lwork, &info);
+    lwork = size > 1 ? (int)size : 1;
+    w = check_malloc(lwork * sizeof(double));
+    dgels_("N", &rows, &cols, &k2, c, &rows, d, &rows, w, &lwork, &info);
+    for (i = 0; i < n && !info; i++)
+        if (fabs(c[i * m + i]) < LINALG_TINY)
+            info = i + 1;
+    linalg_transpose(b, d, nrhs, m);
+    free(w);
+    free(d);
+    free(c);
+#else
+    int64_t j, k, q;
+    double x, *tau;
+
+    tau = check_malloc((n ? n : 1) * sizeof(double));
+    linalg_qr(a, m, n, tau);
+    for (i = 0; i < n; i++)
+        if (fabs(a[i * n + i]) < LINALG_TINY) {
+            free(tau);
+            return i + 1;
+        }
+    /*
+     * b = Q^T b, then solve R x = b.
+     */
+    for (k = 0; k < n; k += LINALG_BLOCK)
+        linalg_reflect(a, m, n, k, n - k < LINALG_BLOCK ? n - k : LINALG_BLOCK,
+                       tau + k, b, nrhs, nrhs, 1);
+    for (i = n - 1; i >= 0; i--) {
+        for (j = i + 1; j < n; j++) {
+            x = a[i * n + j];
+            for (q = 0; q < nrhs; q++)
+                b[i * nrhs + q] -= x * b[j * nrhs + q];
+        }
+        for (q = 0; q < nrhs; q++)
+            b[i * nrhs + q] /= a[i * n + i];
+    }
+    free(tau);
+#endif
+    return info;
+}
@@ -0,0 +1,242 @@
+/*
+ *  module  : memo.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Cache of the memo and memorec combinators.
+ *
+ *  An entry maps a quotation and an argument to the result of executing the
+ *  quotation with that argument. Keys are compared structurally, using
+ *  hash_value and same_value from hashcons.c. The quote, arg and value of
+ *  each entry are single nodes that act as roots: the collector copies them.
+ *  The number of entries is bounded; when the bound is reached, the least
+ *  recently used entry is evicted.
+ */
+#include "globals.h"
+
+#define MEMO_LIMIT 10000 /* default maximum number of entries */
+#define MEMO_MIN_SIZE 64 /* initial number of entries */
+
+/*
+ * Create an empty table.
+ */
+static MemoTable* memo_new(void)
+{
+    MemoTable* memo;
+
+    memo = check_malloc(sizeof(MemoTable));
+    memo->entry = 0;
+    memo->bucket = 0;
+    memo->size = memo->count = memo->buckets = 0;
+    memo->limit = MEMO_LIMIT;
+    memo->newest = memo->oldest = -1;
+    return memo;
+}
+
+/*
+ * Remove entry i from the LRU list.
+ */
+static void unlink_lru(MemoTable* memo, int i)
+{
+    MemoEntry* ent = &memo->entry[i];
+
+    if (ent->newer >= 0)
+        memo->entry[ent->newer].older = ent->older;
+    else
+        memo->newest = ent->older;
+    if (ent->older >= 0)
+        memo->entry[ent->older].newer = ent->newer;
+    else
+        memo->oldest = ent->newer;
+}
+
+/*
+ * Make entry i the most recently used.
+ */
+static void link_lru(MemoTable* memo, int i)
+{
+    MemoEntry* ent = &memo->entry[i];
+
+    ent->newer = -1;
+    ent->older = memo->newest;
+    if (memo->newest >= 0)
+        memo->entry[memo->newest].newer = i;
+    else
+        memo->oldest = i;
+    memo->newest = i;
+}
+
+/*
+ * Remove entry i from its bucket.
+ */
+static void unlink_bucket(MemoTable* memo, int i)
+{
+    int *p = &memo->bucket[memo->entry[i].hash & (memo->buckets - 1)];
+
+    while (*p != i)
+        p = &memo->entry[*p].chain;
+    *p = memo->entry[i].chain;
+}
+
+/*
+ * Enter entry i in its bucket.
+ */
+static void link_bucket(MemoTable* memo, int i)
+{
+    int* p = &memo->bucket[memo->entry[i].hash & (memo->buckets - 1)];
+
+    memo->entry[i].chain = *p;
+    *p = i;
+}
+
+/*
+ * Make room for one more entry: double the entries and the buckets.
+ */
+static void memo_grow(MemoTable* memo)
+{
+    int i;
+
+    memo->size = memo->size ? 2 * memo->size : MEMO_MIN_SIZE;
+    memo->entry = realloc(memo->entry, memo->size * sizeof(MemoEntry));
+    memo->buckets = memo->size;
+    free(memo->bucket);
+    memo->bucket = malloc(memo->buckets * sizeof(int));
+#ifdef TEST_MALLOC_RETURN
+    if (!memo->entry || !memo->bucket)
+        fatal("memory exhausted");
+#endif
+    for (i = 0; i < memo->buckets; i++)
+        memo->bucket[i] = -1;
+    for (i = 0; i < memo->count; i++)
+        link_bucket(memo, i);
+}
+
+/*
+ * Remove the least recently used entry. The last entry is moved into the
+ * slot that becomes free, so that the entries stay contiguous.
+ */
+static void memo_evict(MemoTable* memo)
+{
+    int i, last;
+
+    unlink_lru(memo, i = memo->oldest);
+    unlink_bucket(memo, i);
+    if (i != (last = --memo->count)) {
+        unlink_bucket(memo, last);
+        memo->entry[i] = memo->entry[last];
+        link_bucket(memo, i);
+        if (memo->entry[i].newer >= 0)
+            memo->entry[memo->entry[i].newer].older = i;
+        else
+            memo->newest = i;
+        if (memo->entry[i].older >= 0)
+            memo->entry[memo->entry[i].older].newer = i;
+        else
+            memo->oldest = i;
+    }
+}
+
+/*
+ * memo_lookup - locate the entry with this key. When found, the entry
+ *		 becomes the most recently used and its position is returned;
+ *		 otherwise -1 is returned.
+ */
+int memo_lookup(pEnv env, uint64_t hash, Index quote, Index arg, int rec)
+{
+    int i;
+    MemoEntry* ent;
+    MemoTable* memo = env->memo;
+
+    if (!memo || !memo->count)
+        return -1;
+    for (i = memo->bucket[hash & (memo->buckets - 1)]; i >= 0;
+         i = ent->chain) {
+        ent = &memo->entry[i];
+        if (ent->hash == hash && ent->rec == rec
+            && same_value(env, ent->arg, arg)
+            && same_value(env, ent->quote, quote)) {
+            unlink_lru(memo, i);
+            link_lru(memo, i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * memo_insert - add an entry. The nodes must have been allocated for the
+ *		 entry, as the table takes ownership of them. An entry with
+ *		 the same key, added by a recursive call, is replaced.
+ */
+void memo_insert(pEnv env, uint64_t hash, Index quote, Index arg, Index value,
+                 int rec)
+{
+    int i;
+    MemoEntry* ent;
+    MemoTable* memo;
+
+    if (!env->memo)
+        env->memo = memo_new();
+    memo = env->memo;
+    if (!memo->limit)
+        return;
+    if ((i = memo_lookup(env, hash, quote, arg, rec)) >= 0) {
+        memo->entry[i].value = value;
+        return;
+    }
+    if (memo->count >= memo->limit)
+        memo_evict(memo);
+    if (memo->count == memo->size)
+        memo_grow(memo);
+    ent = &memo->entry[i = memo->count++];
+    ent->hash = hash;
+    ent->quote = quote;
+    ent->arg = arg;
+    ent->value = value;
+    ent->rec = rec;
+    link_bucket(memo, i);
+    link_lru(memo, i);
+}
+
+/*
+ * memo_setlimit - set the maximum number of entries, evicting entries when
+ *		   there are more. A limit of 0 disables the cache.
+ */
+void memo_setlimit(pEnv env, int limit)
+{
+    if (!env->memo)
+        env->memo = memo_new();
+    env->memo->limit = limit;
+    while (env->memo->count > limit)
+        memo_evict(env->memo);
+}
+
+/*
+ * memo_clear - remove all entries. Called when memory above mem_low is
+ *		released without collection, and by memoclear.
+ */
+void memo_clear(pEnv env)
+{
+    int i;
+    MemoTable* memo = env->memo;
+
+    if (!memo)
+        return;
+    for (i = 0; i < memo->buckets; i++)
+        memo->bucket[i] = -1;
+    memo->count = 0;
+    memo->newest = memo->oldest = -1;
+}
+
+/*
+ * memo_free - release the table.
+ */
+void memo_free(pEnv env)
+{
+    if (env->memo) {
+        free(env->memo->entry);
+        free(env->memo->bucket);
+        free(env->memo);
+        env->memo = 0;
+    }
+}
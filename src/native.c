@@ -0,0 +1,421 @@
+/*
+ *  module  : native.c
+ *  version : 1.3
+ *  date    : 10/18/26
+ *
+ *  Storage of the data of native vectors and matrices, dense and sparse.
+ *
+ *  The data of VECTOR_, MATRIX_ and SPARSE_ nodes is not allocated by the
+ *  conservative collector, because that collector does not scan the memory
+ *  of nodes and would release data that is still in use. Instead, blocks are
+ *  registered in a table. The copying collector marks the blocks of the nodes
+ *  that it copies and native_sweep releases the others. Native values are
+ *  never modified after they have been built, so nodes can share a block;
+ *  only the elements of a deferred vector are computed later, once. A
+ *  deferred vector refers to the blocks of its operands, that are marked with
+ *  it. A view is a small block that refers to the block that has its
+ *  elements, that is marked with it as well. A sparse matrix is one block.
+ *  A file that is mapped into memory is held by a block that views of its
+ *  contents refer to, and is unmapped when that block is released.
+ *
+ *  A block is pinned from allocation until it is stored in a node, such that
+ *  a collection in between does not release it. Blocks of nodes in the space
+ *  of definitions are kept for good.
+ */
+#include "globals.h"
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#endif
+
+#define NATIVE_MIN_SIZE 64          /* initial number of slots */
+#define NATIVE_MIN_FRESH (32 << 20) /* bytes allocated before a collection */
+
+/*
+ * Each block starts with a header; the caller receives the memory after it.
+ */
+typedef struct NativeBlock {
+    size_t size;    /* bytes after the header */
+    unsigned char mark, pin, keep, vector, sparse, file;
+} NativeBlock;
+
+/*
+ * A file mapped into memory, in a block that has the file flag.
+ */
+typedef struct NativeFile {
+    void* addr;  /* start of the mapping */
+    size_t size; /* bytes mapped */
+} NativeFile;
+
+#define HEADER(ptr) ((NativeBlock*)(ptr) - 1)
+
+/*
+ * Create an empty table.
+ */
+static NativeHeap* native_new(void)
+{
+    NativeHeap* heap;
+
+    heap = check_malloc(sizeof(NativeHeap));
+    heap->block = 0;
+    heap->count = heap->size = 0;
+    heap->bytes = heap->fresh = 0;
+    heap->scanned = 0;
+    return heap;
+}
+
+/*
+ * native_alloc - allocate size bytes for the data of a native value. The
+ *		  memory is not cleared. It is pinned until it is stored in
+ *		  a node by newnode. Running out of memory is an error, not
+ *		  fatal, as the size is chosen by the program.
+ */
+void* native_alloc(pEnv env, size_t size)
+{
+    NativeBlock* blk;
+    NativeHeap* heap;
+
+    if (!env->native)
+        env->native = native_new();
+    heap = env->native;
+    if (heap->count == heap->size) {
+        heap->size = heap->size ? 2 * heap->size : NATIVE_MIN_SIZE;
+        heap->block = realloc(heap->block, heap->size * sizeof(NativeBlock*));
+#ifdef TEST_MALLOC_RETURN
+        if (!heap->block)
+            fatal("memory exhausted");
+#endif
+    }
+    if ((blk = malloc(sizeof(NativeBlock) + size)) == 0)
+        execerror(env, "memory for native value", "native");
+    blk->size = size;
+    blk->mark = blk->keep = blk->vector = blk->sparse = blk->file = 0;
+    blk->pin = 1;
+    heap->block[heap->count++] = blk;
+    heap->bytes += size;
+    heap->fresh += size;
+    return blk + 1;
+}
+
+/*
+ * native_vector - allocate a vector of len elements of type dtype.
+ */
+VectorData* native_vector(pEnv env, int dtype, int64_t len)
+{
+    VectorData* vec;
+
+    if (len < 0 || len > NATIVE_MAX_LEN)
+        execerror(env, "smaller size", "native");
+    vec = native_alloc(env, sizeof(VectorData) + len * kernel_width(dtype));
+    HEADER(vec)->vector = 1;
+    vec->len = len;
+    vec->dtype = dtype;
+    vec->data = vec + 1;
+    vec->kind = VX_NONE;
+    vec->op = 0;
+    vec->size = 0;
+    vec->a = vec->b = 0;
+    vec->s.i64 = 0;
+    vec->inc = 1;
+    vec->base = 0;
+    return vec;
+}
+
+/*
+ * native_matrix - allocate a matrix of rows x cols elements of type dtype.
+ */
+MatrixData* native_matrix(pEnv env, int dtype, int64_t rows, int64_t cols)
+{
+    MatrixData* mat;
+
+    if (rows < 0 || cols < 0 || (cols && rows > NATIVE_MAX_LEN / cols))
+        execerror(env, "smaller size", "native");
+    mat = native_alloc(env, sizeof(MatrixData)
+                                + rows * cols * kernel_width(dtype));
+    mat->rows = rows;
+    mat->cols = cols;
+    mat->dtype = dtype;
+    mat->ld = cols;
+    mat->base = 0;
+    mat->data = mat + 1;
+    return mat;
+}
+
+/*
+ * native_sparse - allocate a sparse matrix of rows x cols elements, of which
+ *		   nnz are stored, with compressed rows or columns by format.
+ */
+SparseData* native_sparse(pEnv env, int64_t rows, int64_t cols, int64_t nnz,
+                          int format)
+{
+    SparseData* spm;
+    int64_t major;
+
+    major = format == SP_CSR ? rows : cols;
+    if (rows < 0 || cols < 0 || nnz < 0 || major >= NATIVE_MAX_LEN
+        || nnz > NATIVE_MAX_LEN)
+        execerror(env, "smaller size", "native");
+    spm = native_alloc(env, sizeof(SparseData) + (major + 1 + nnz)
+                                * sizeof(int64_t) + nnz * sizeof(double));
+    HEADER(spm)->sparse = 1;
+    spm->rows = rows;
+    spm->cols = cols;
+    spm->nnz = nnz;
+    spm->format = format;
+    spm->val = (double*)(spm + 1);
+    spm->ptr = (int64_t*)(spm->val + nnz);
+    spm->idx = spm->ptr + major + 1;
+    return spm;
+}
+
+/*
+ * native_file - a block for size bytes at addr, that were mapped from a file
+ *		 by mmap, to be used as the base of views of them. They are
+ *		 unmapped when the block is released.
+ */
+void* native_file(pEnv env, void* addr, size_t size)
+{
+    NativeFile* file;
+
+    file = native_alloc(env, sizeof(NativeFile));
+    HEADER(file)->file = 1;
+    file->addr = addr;
+    file->size = size;
+    return file;
+}
+
+/*
+ * Release a block, and unmap the file that it holds.
+ */
+static void native_release(NativeBlock* blk)
+{
+#ifndef _MSC_VER
+    NativeFile* file;
+
+    if (blk->file) {
+        file = (NativeFile*)(blk + 1);
+        munmap(file->addr, file->size);
+    }
+#endif
+    free(blk);
+}
+
+/*
+ * The block with the elements of native value parent, that is not a view.
+ */
+static void* native_base(void* parent)
+{
+    void* base;
+
+    if (HEADER(parent)->vector)
+        base = ((VectorData*)parent)->base;
+    else
+        base = ((MatrixData*)parent)->base;
+    return base ? base : parent;
+}
+
+/*
+ * native_vector_view - a vector of len elements, inc apart from data, that
+ *			are elements of native value parent. A deferred parent
+ *			must have been computed.
+ */
+VectorData* native_vector_view(pEnv env, void* parent, void* data,
+                               int64_t len, int64_t inc)
+{
+    VectorData* vec;
+    unsigned char dtype;
+
+    if (HEADER(parent)->vector)
+        dtype = ((VectorData*)parent)->dtype;
+    else
+        dtype = ((MatrixData*)parent)->dtype;
+    vec = native_vector(env, dtype, 0);
+    vec->len = len;
+    vec->inc = inc;
+    vec->base = native_base(parent);
+    vec->data = data;
+    return vec;
+}
+
+/*
+ * native_matrix_view - a matrix of rows x cols elements, with rows ld apart
+ *			from data, that are elements of native matrix parent.
+ */
+MatrixData* native_matrix_view(pEnv env, void* parent, void* data,
+                               int64_t rows, int64_t cols, int64_t ld)
+{
+    MatrixData* mat;
+
+    mat = native_matrix(env, ((MatrixData*)parent)->dtype, 0, 0);
+    mat->rows = rows;
+    mat->cols = cols;
+    mat->ld = ld;
+    mat->base = native_base(parent);
+    mat->data = data;
+    return mat;
+}
+
+/*
+ * native_copy - copy a block, possibly of another context, into a new block.
+ *		 A deferred vector is computed into the copy, because its
+ *		 operands belong to the other context, and only the elements
+ *		 of a view are copied.
+ */
+void* native_copy(pEnv env, void* ptr)
+{
+    size_t width;
+    int64_t i;
+    VectorData *vec, *src = ptr;
+    MatrixData *mat, *old = ptr;
+    SparseData *spm, *copy;
+
+    if (!ptr)
+        return 0;
+    if (HEADER(ptr)->sparse) {
+        spm = ptr;
+        copy = native_sparse(env, spm->rows, spm->cols, spm->nnz, spm->format);
+        memcpy(copy->val, spm->val, HEADER(ptr)->size - sizeof(SparseData));
+        return copy;
+    }
+    if (HEADER(ptr)->vector) {
+        vec = native_vector(env, src->dtype, src->len);
+        if (src->kind != VX_NONE || src->inc != 1)
+            vector_eval(src, vec->data);
+        else
+            memcpy(vec->data, src->data, src->len * kernel_width(src->dtype));
+        return vec;
+    }
+    mat = native_matrix(env, old->dtype, old->rows, old->cols);
+    width = kernel_width(old->dtype);
+    if (old->ld == old->cols)
+        memcpy(mat->data, old->data, old->rows * old->cols * width);
+    else
+        for (i = 0; i < old->rows; i++)
+            memcpy((char*)mat->data + i * old->cols * width,
+                   (char*)old->data + i * old->ld * width, old->cols * width);
+    return mat;
+}
+
+/*
+ * native_store - called by newnode when the block is stored in a node.
+ */
+void native_store(void* ptr)
+{
+    if (ptr)
+        HEADER(ptr)->pin = 0;
+}
+
+/*
+ * Set the mark or the keep flag of a block, and of the operands of a deferred
+ * vector or the base of a view. The depth is limited by the size of deferred
+ * expressions.
+ */
+static void native_visit(void* ptr, int keep)
+{
+    VectorData* vec;
+
+    while (ptr) {
+        if (keep ? HEADER(ptr)->keep : HEADER(ptr)->mark)
+            return; /* the operands have been visited as well */
+        if (keep)
+            HEADER(ptr)->keep = 1;
+        else
+            HEADER(ptr)->mark = 1;
+        if (HEADER(ptr)->sparse || HEADER(ptr)->file)
+            return;
+        if (!HEADER(ptr)->vector) {
+            ptr = ((MatrixData*)ptr)->base;
+            continue;
+        }
+        vec = ptr;
+        if (vec->base) { /* a view is not deferred */
+            ptr = vec->base;
+            continue;
+        }
+        if (vec->kind == VX_NONE)
+            return;
+        native_visit(vec->a, keep);
+        ptr = vec->b;
+    }
+}
+
+/*
+ * native_mark - called by the collector for the block of a copied node.
+ */
+void native_mark(void* ptr) { native_visit(ptr, 0); }
+
+/*
+ * native_full - whether so much has been allocated since the last collection
+ *		 that newnode should collect now, instead of waiting until the
+ *		 nodes run out. The limit grows with the data that survives.
+ */
+int native_full(pEnv env)
+{
+    NativeHeap* heap = env->native;
+
+    if (!heap || heap->fresh < NATIVE_MIN_FRESH)
+        return 0;
+    return heap->fresh > heap->bytes - heap->fresh;
+}
+
+/*
+ * Blocks of nodes below mem_low belong to definitions and are kept. The
+ * nodes of a string occupy more than one node; the others are skipped.
+ */
+static void native_scan(pEnv env, NativeHeap* heap)
+{
+    Index n;
+
+    if (heap->scanned < 1)
+        heap->scanned = 1;
+    for (n = heap->scanned; n < env->mem_low; n += nodesize(env, n))
+        if (nodetype(n) == VECTOR_ || nodetype(n) == MATRIX_
+            || nodetype(n) == SPARSE_)
+            native_visit(nodevalue(n).vec, 1);
+    heap->scanned = env->mem_low;
+}
+
+/*
+ * native_sweep - called by the collector after all nodes have been copied.
+ *		  Blocks that were not marked, pinned or kept are released.
+ */
+void native_sweep(pEnv env)
+{
+    size_t i;
+    NativeBlock* blk;
+    NativeHeap* heap = env->native;
+
+    if (!heap)
+        return;
+    native_scan(env, heap);
+    for (i = 0; i < heap->count; i++) /* operands and bases of pinned */
+        if (heap->block[i]->pin)
+            native_visit(heap->block[i] + 1, 0);
+    for (i = 0; i < heap->count;) {
+        blk = heap->block[i];
+        if (blk->mark || blk->pin || blk->keep) {
+            blk->mark = 0;
+            i++;
+            continue;
+        }
+        heap->bytes -= blk->size;
+        native_release(blk);
+        heap->block[i] = heap->block[--heap->count];
+    }
+    heap->fresh = 0;
+}
+
+/*
+ * native_free - release all blocks and the table.
+ */
+void native_free(pEnv env)
+{
+    size_t i;
+
+    if (env->native) {
+        for (i = 0; i < env->native->count; i++)
+            native_release(env->native->block[i]);
+        free(env->native->block);
+        free(env->native);
+        env->native = 0;
+    }
+}
@@ -0,0 +1,361 @@
+/*
+ *  module  : npy.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Native vectors and matrices in the .npy format of NumPy.
+ *
+ *  A file starts with the magic string "\x93NUMPY", the version and a header,
+ *  a Python dictionary with the element type (descr), the order of the
+ *  elements (fortran_order) and the shape. The header is padded such that
+ *  the elements start at a multiple of 64 bytes. npy_load maps the file into
+ *  memory and returns a view of the elements in the mapping: nothing is read
+ *  until it is used, and the pages are shared with the page cache. The
+ *  mapping is private, such that pages that would be written are copied and
+ *  the file is never changed. Elements in the other byte order, and matrices
+ *  in Fortran order, are read and converted instead, and so are all files
+ *  when mmap is not available. npy_save writes version 1.0.
+ */
+#include "globals.h"
+#include <sys/stat.h>
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#endif
+
+#define NPY_MAGIC "\x93NUMPY"
+#define NPY_PREFIX 10  /* magic, version and header length of version 1 */
+#define NPY_ALIGN 64   /* the elements start at a multiple of this */
+#define NPY_CHUNK 4096 /* elements gathered at a time by npy_save */
+
+/*
+ * The shape and element type of a file.
+ */
+typedef struct NpyHeader {
+    int dtype;       /* DT_F64 ... */
+    int swap;        /* elements are in the other byte order */
+    int fortran;     /* matrix elements are stored column by column */
+    int ndim;        /* 0, 1 or 2 */
+    int64_t dim[2];  /* rows and columns, or elements */
+} NpyHeader;
+
+/*
+ * Whether this machine stores the lowest byte first.
+ */
+static int npy_little(void)
+{
+    uint16_t x = 1;
+
+    return *(unsigned char*)&x;
+}
+
+/*
+ * The value of key in header text head, after the colon, or 0.
+ */
+static char* npy_key(char* head, char* key)
+{
+    char* str;
+
+    if ((str = strstr(head, key)) == 0)
+        return 0;
+    str += strlen(key);
+    while (*str == ' ')
+        str++;
+    if (*str++ != ':')
+        return 0;
+    while (*str == ' ')
+        str++;
+    return str;
+}
+
+/*
+ * Parse header text head into hdr. Element types are given as a byte order,
+ * '<', '>', '|' or '=', a kind and a size in bytes.
+ */
+static char* npy_parse(char* head, NpyHeader* hdr)
+{
+    char *str, *end;
+    int order, kind, size;
+
+    if ((str = npy_key(head, "'descr'")) == 0 || *str != '\''
+        || strlen(str) < 5)
+        return "element type in header";
+    order = str[1];
+    kind = str[2];
+    size = str[4] == '\'' ? str[3] - '0' : 0;
+    if (kind == 'f' && size == 8)
+        hdr->dtype = DT_F64;
+    else if (kind == 'f' && size == 4)
+        hdr->dtype = DT_F32;
+    else if (kind == 'i' && size == 8)
+        hdr->dtype = DT_I64;
+    else if (kind == 'i' && size == 4)
+        hdr->dtype = DT_I32;
+    else if ((kind == 'u' || kind == 'b') && size == 1)
+        hdr->dtype = DT_U8;
+    else
+        return "float64, float32, int64, int32 or uint8 elements";
+    hdr->swap = size > 1
+                && ((order == '<' && !npy_little())
+                    || (order == '>' && npy_little()));
+    if ((str = npy_key(head, "'fortran_order'")) == 0)
+        return "order in header";
+    hdr->fortran = !strncmp(str, "True", 4);
+    if ((str = npy_key(head, "'shape'")) == 0 || *str++ != '(')
+        return "shape in header";
+    for (hdr->ndim = 0;;) {
+        while (*str == ' ' || *str == ',')
+            str++;
+        if (*str == ')')
+            break;
+        if (hdr->ndim == 2)
+            return "one or two dimensions";
+        hdr->dim[hdr->ndim] = strtoll(str, &end, 10);
+        if (end == str || hdr->dim[hdr->ndim] < 0)
+            return "shape in header";
+        hdr->ndim++;
+        str = end;
+    }
+    return 0;
+}
+
+/*
+ * Reverse the bytes of each of n elements of width w at a.
+ */
+static void npy_swap(unsigned char* a, size_t w, int64_t n)
+{
+    size_t j;
+    int64_t i;
+    unsigned char t;
+
+    for (i = 0; i < n; i++, a += w)
+        for (j = 0; j < w / 2; j++) {
+            t = a[j];
+            a[j] = a[w - 1 - j];
+            a[w - 1 - j] = t;
+        }
+}
+
+/*
+ * A native value of the shape of hdr, in u, whose elements are to be stored
+ * at the returned address. With a base, it is a view of elements at data.
+ */
+static void* npy_value(pEnv env, NpyHeader* hdr, void* base, void* data,
+                       Operator* type, Types* u)
+{
+    MatrixData* mat;
+
+    if (hdr->ndim < 2) {
+        *type = VECTOR_;
+        u->vec = native_vector(env, hdr->dtype,
+                               base ? 0 : hdr->ndim ? hdr->dim[0] : 1);
+        if (!base)
+            return u->vec->data;
+        u->vec->len = hdr->ndim ? hdr->dim[0] : 1;
+        u->vec->base = base;
+        return u->vec->data = data;
+    }
+    *type = MATRIX_;
+    mat = u->mat = native_matrix(env, hdr->dtype, base ? 0 : hdr->dim[0],
+                                 base ? 0 : hdr->dim[1]);
+    if (!base)
+        return mat->data;
+    mat->rows = hdr->dim[0];
+    mat->cols = mat->ld = hdr->dim[1];
+    mat->base = base;
+    return mat->data = data;
+}
+
+/*
+ * Read the count elements of hdr from fp to a new native value in u. A
+ * matrix in Fortran order is transposed.
+ */
+static char* npy_read(pEnv env, FILE* fp, NpyHeader* hdr, int64_t count,
+                      Operator* type, Types* u)
+{
+    size_t w;
+    void* block;
+    int64_t i, j, rows, cols;
+    unsigned char *a, *c;
+
+    w = kernel_width(hdr->dtype);
+    c = npy_value(env, hdr, 0, 0, type, u);
+    block = *type == VECTOR_ ? (void*)u->vec : (void*)u->mat;
+    if (hdr->ndim < 2 || !hdr->fortran) {
+        if (fread(c, w, count, fp) != (size_t)count) {
+            native_store(block); /* released by the collector */
+            return "complete .npy file";
+        }
+        if (hdr->swap)
+            npy_swap(c, w, count);
+        return 0;
+    }
+    a = check_malloc((count ? count : 1) * w);
+    if (fread(a, w, count, fp) != (size_t)count) {
+        free(a);
+        native_store(block); /* released by the collector */
+        return "complete .npy file";
+    }
+    if (hdr->swap)
+        npy_swap(a, w, count);
+    rows = hdr->dim[0];
+    cols = hdr->dim[1];
+    for (j = 0; j < cols; j++)
+        for (i = 0; i < rows; i++)
+            memcpy(c + (i * cols + j) * w, a + (j * rows + i) * w, w);
+    free(a);
+    return 0;
+}
+
+/*
+ * npy_load - the native vector or matrix in the .npy file at path, in u and
+ *	      its type in type, or an error message. One dimension gives a
+ *	      vector, two a matrix and none a vector of one element.
+ */
+char* npy_load(pEnv env, char* path, Operator* type, Types* u)
+{
+    FILE* fp;
+    int64_t count;
+    size_t w, hlen, offset, size;
+    struct stat st;
+    char *head, *msg;
+    NpyHeader hdr;
+    unsigned char prefix[NPY_PREFIX + 2];
+#ifndef _MSC_VER
+    void *addr, *file;
+#endif
+
+    if ((fp = fopen(path, "rb")) == 0)
+        return "readable .npy file";
+    if (fread(prefix, 1, NPY_PREFIX, fp) != NPY_PREFIX
+        || memcmp(prefix, NPY_MAGIC, 6) || prefix[6] < 1 || prefix[6] > 3) {
+        fclose(fp);
+        return ".npy file";
+    }
+    hlen = prefix[8] | prefix[9] << 8;
+    offset = NPY_PREFIX;
+    if (prefix[6] > 1) { /* the header length has 4 bytes */
+        if (fread(prefix + NPY_PREFIX, 1, 2, fp) != 2) {
+            fclose(fp);
+            return ".npy file";
+        }
+        hlen |= (size_t)prefix[10] << 16 | (size_t)prefix[11] << 24;
+        offset += 2;
+    }
+    head = check_malloc(hlen + 1);
+    if (fread(head, 1, hlen, fp) != hlen) {
+        free(head);
+        fclose(fp);
+        return ".npy file";
+    }
+    head[hlen] = 0;
+    msg = npy_parse(head, &hdr);
+    free(head);
+    if (msg) {
+        fclose(fp);
+        return msg;
+    }
+    offset += hlen;
+    w = kernel_width(hdr.dtype);
+    count = hdr.ndim ? hdr.dim[0] : 1;
+    if (hdr.ndim == 2) {
+        if (hdr.dim[1] && count > NATIVE_MAX_LEN / hdr.dim[1]) {
+            fclose(fp);
+            return "smaller size";
+        }
+        count *= hdr.dim[1];
+    }
+    if (count > NATIVE_MAX_LEN) {
+        fclose(fp);
+        return "smaller size";
+    }
+    size = offset + count * w;
+    if (fstat(fileno(fp), &st) || (uint64_t)st.st_size < size) {
+        fclose(fp);
+        return "complete .npy file";
+    }
+#ifndef _MSC_VER
+    if (count && !hdr.swap
+        && (hdr.ndim < 2 || !hdr.fortran || hdr.dim[0] == 1
+            || hdr.dim[1] == 1)) {
+        addr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp),
+                    0);
+        if (addr != MAP_FAILED) {
+            fclose(fp);
+            file = native_file(env, addr, size);
+            npy_value(env, &hdr, file, (char*)addr + offset, type, u);
+            native_store(file); /* the view keeps it */
+            return 0;
+        }
+    }
+#endif
+    msg = npy_read(env, fp, &hdr, count, type, u);
+    fclose(fp);
+    return msg;
+}
+
+/*
+ * npy_save - write native vector or matrix u, of type type, to a .npy file
+ *	      at path. The result is 0, or an error message.
+ */
+char* npy_save(pEnv env, char* path, Operator type, Types u)
+{
+    FILE* fp;
+    size_t w, len;
+    int dtype, ok;
+    int64_t i, n;
+    char *buf, head[NPY_ALIGN * 2];
+    static char* descr[] = { "f8", "f4", "i8", "i4", "u1" };
+
+    dtype = type == VECTOR_ ? (u.vec ? u.vec->dtype : DT_F64)
+                            : (u.mat ? u.mat->dtype : DT_F64);
+    w = kernel_width(dtype);
+    len = NPY_PREFIX;
+    len += sprintf(head + len, "{'descr': '%c%s', 'fortran_order': False, ",
+                   dtype == DT_U8 ? '|' : npy_little() ? '<' : '>',
+                   descr[dtype]);
+    if (type == VECTOR_)
+        len += sprintf(head + len, "'shape': (%" PRId64 ",), }",
+                       u.vec ? u.vec->len : 0);
+    else
+        len += sprintf(head + len, "'shape': (%" PRId64 ", %" PRId64 "), }",
+                       u.mat ? u.mat->rows : 0, u.mat ? u.mat->cols : 0);
+    while ((len + 1) % NPY_ALIGN)
+        head[len++] = ' ';
+    head[len++] = '\n';
+    memcpy(head, NPY_MAGIC, 6);
+    head[6] = 1;
+    head[7] = 0;
+    head[8] = (len - NPY_PREFIX) & 0xFF;
+    head[9] = (len - NPY_PREFIX) >> 8;
+    if ((fp = fopen(path, "wb")) == 0)
+        return "writable file";
+    ok = fwrite(head, 1, len, fp) == len;
+    if (type == VECTOR_ && u.vec) {
+        vector_force(u.vec);
+        if (u.vec->inc == 1)
+            ok = ok && fwrite(u.vec->data, w, u.vec->len, fp)
+                           == (size_t)u.vec->len;
+        else {
+            buf = check_malloc(NPY_CHUNK * w);
+            for (i = 0; ok && i < u.vec->len; i += n) {
+                n = u.vec->len - i < NPY_CHUNK ? u.vec->len - i : NPY_CHUNK;
+                kernel_gather(dtype, buf, u.vec->data, i * u.vec->inc,
+                              u.vec->inc, n);
+                ok = fwrite(buf, w, n, fp) == (size_t)n;
+            }
+            free(buf);
+        }
+    } else if (type == MATRIX_ && u.mat) {
+        if (u.mat->ld == u.mat->cols)
+            ok = ok && fwrite(u.mat->data, w, u.mat->rows * u.mat->cols, fp)
+                           == (size_t)(u.mat->rows * u.mat->cols);
+        else
+            for (i = 0; ok && i < u.mat->rows; i++)
+                ok = fwrite((char*)u.mat->data + i * u.mat->ld * w, w,
+                            u.mat->cols, fp)
+                     == (size_t)u.mat->cols;
+    }
+    if (fclose(fp) || !ok)
+        return "writable file";
+    return 0;
+}
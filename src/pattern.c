@@ -0,0 +1,305 @@
+/*
+ *  module  : pattern.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Cache of the compiled patterns of match and cases, and the bindings of
+ *  their actions.
+ *
+ *  Programs are keyed by the index of the cases list or the match pattern.
+ *  Like the table of hashcons.c, the cache is weak: after collection,
+ *  programs whose key was copied follow the copy and the others are freed.
+ *  Pattern variables are bound by replacing their symbol table entry; the
+ *  old entries are kept on a stack until the action has finished.
+ */
+#include "globals.h"
+
+#define PAT_MIN_SIZE 64 /* initial number of buckets */
+
+/*
+ * Create an empty cache.
+ */
+static PatternCache* pattern_new(void)
+{
+    PatternCache* pc;
+
+    pc = check_malloc(sizeof(PatternCache));
+    pc->bucket = 0;
+    pc->buckets = pc->count = 0;
+    pc->bind = 0;
+    pc->binds = pc->maxbinds = 0;
+    pc->pend = 0;
+    pc->maxpend = 0;
+    return pc;
+}
+
+/*
+ * Bucket of a key.
+ */
+static int pattern_hash(PatternCache* pc, Index key, int kind)
+{
+    return ((key * 2654435761U) ^ kind) & (pc->buckets - 1);
+}
+
+/*
+ * Release a program.
+ */
+static void program_free(PatProgram* prog)
+{
+    free(prog->instr);
+    free(prog->clause);
+    free(prog->jump);
+    free(prog);
+}
+
+/*
+ * Double the number of buckets.
+ */
+static void pattern_grow(PatternCache* pc)
+{
+    int i, old = pc->buckets;
+    PatProgram **bucket = pc->bucket, *prog, *next;
+
+    pc->buckets = old ? 2 * old : PAT_MIN_SIZE;
+    pc->bucket = calloc(pc->buckets, sizeof(PatProgram*));
+#ifdef TEST_MALLOC_RETURN
+    if (!pc->bucket)
+        fatal("memory exhausted");
+#endif
+    for (i = 0; i < old; i++)
+        for (prog = bucket[i]; prog; prog = next) {
+            next = prog->chain;
+            prog->chain = pc->bucket[pattern_hash(pc, prog->key, prog->kind)];
+            pc->bucket[pattern_hash(pc, prog->key, prog->kind)] = prog;
+        }
+    free(bucket);
+}
+
+/*
+ * pattern_lookup - return the program of key and kind, or 0.
+ */
+PatProgram* pattern_lookup(pEnv env, Index key, int kind)
+{
+    PatProgram* prog;
+    PatternCache* pc = env->patterns;
+
+    if (!pc || !pc->count)
+        return 0;
+    for (prog = pc->bucket[pattern_hash(pc, key, kind)]; prog;
+         prog = prog->chain)
+        if (prog->key == key && prog->kind == kind)
+            return prog;
+    return 0;
+}
+
+/*
+ * pattern_insert - enter a program that was allocated with malloc; the
+ *		    cache takes ownership of it.
+ */
+PatProgram* pattern_insert(pEnv env, PatProgram* prog)
+{
+    int i;
+    PatternCache* pc;
+
+    if (!env->patterns)
+        env->patterns = pattern_new();
+    pc = env->patterns;
+    if (pc->count >= pc->buckets)
+        pattern_grow(pc);
+    i = pattern_hash(pc, prog->key, prog->kind);
+    prog->chain = pc->bucket[i];
+    pc->bucket[i] = prog;
+    pc->count++;
+    return prog;
+}
+
+/*
+ * pattern_bind - bind symbol sym to body, saving its entry. The collector
+ *		  takes care of the body, so the entry is not a root itself.
+ */
+void pattern_bind(pEnv env, int sym, Index body)
+{
+    Entry ent;
+    PatternCache* pc;
+
+    if (!env->patterns)
+        env->patterns = pattern_new();
+    pc = env->patterns;
+    if (pc->binds == pc->maxbinds) {
+        pc->maxbinds = pc->maxbinds ? 2 * pc->maxbinds : 16;
+        pc->bind = realloc(pc->bind, pc->maxbinds * sizeof(PatBinding));
+#ifdef TEST_MALLOC_RETURN
+        if (!pc->bind)
+            fatal("memory exhausted");
+#endif
+    }
+    ent = vec_at(env->symtab, sym);
+    pc->bind[pc->binds].sym = sym;
+    pc->bind[pc->binds].body = body;
+    pc->bind[pc->binds++].saved = ent;
+    ent.is_user = 1;
+    ent.is_root = 0;
+    ent.u.body = body;
+    vec_at(env->symtab, sym) = ent;
+}
+
+/*
+ * pattern_depth - the number of saved entries.
+ */
+int pattern_depth(pEnv env)
+{
+    return env->patterns ? env->patterns->binds : 0;
+}
+
+/*
+ * pattern_unbind - restore the entries that were saved above depth, the
+ *		    most recent first. Also called when execution is aborted.
+ */
+void pattern_unbind(pEnv env, int depth)
+{
+    PatBinding* bind;
+    PatternCache* pc = env->patterns;
+
+    if (!pc)
+        return;
+    while (pc->binds > depth) {
+        bind = &pc->bind[--pc->binds];
+        vec_at(env->symtab, bind->sym) = bind->saved;
+    }
+}
+
+/*
+ * pattern_stack - room for size values that wait to be matched.
+ */
+PatValue* pattern_stack(pEnv env, int size)
+{
+    PatternCache* pc;
+
+    if (!env->patterns)
+        env->patterns = pattern_new();
+    pc = env->patterns;
+    if (pc->maxpend < size) {
+        pc->pend = realloc(pc->pend, size * sizeof(PatValue));
+#ifdef TEST_MALLOC_RETURN
+        if (!pc->pend)
+            fatal("memory exhausted");
+#endif
+        pc->maxpend = size;
+    }
+    return pc->pend;
+}
+
+/*
+ * Follow index n to its copy; return 0 when it was not copied.
+ */
+static int forward(pEnv env, Index* n)
+{
+    if (*n < env->mem_low)
+        return 1;
+    if (env->old_memory[*n].op != COPIED_)
+        return 0;
+    *n = env->old_memory[*n].u.lis;
+    return 1;
+}
+
+/*
+ * Follow all indices of a program; return 0 when the key is dead. The
+ * literals and actions are part of the key, so they are copied with it.
+ */
+static int forward_program(pEnv env, PatProgram* prog)
+{
+    int i;
+
+    if (!forward(env, &prog->key))
+        return 0;
+    for (i = 0; i < prog->instrs; i++)
+        if (prog->instr[i].code == PAT_LIT
+            && !forward(env, &prog->instr[i].lit))
+            return 0;
+    for (i = 0; i < prog->clauses; i++)
+        if (!forward(env, &prog->clause[i].action))
+            return 0;
+    return 1;
+}
+
+/*
+ * Keep the programs for which keep returns 1, and rehash them.
+ */
+static void pattern_filter(pEnv env, int (*keep)(pEnv, PatProgram*))
+{
+    int i, old;
+    PatternCache* pc = env->patterns;
+    PatProgram **bucket, *prog, *next;
+
+    if (!pc || !pc->count)
+        return;
+    bucket = pc->bucket;
+    old = pc->buckets;
+    pc->bucket = calloc(old, sizeof(PatProgram*));
+#ifdef TEST_MALLOC_RETURN
+    if (!pc->bucket)
+        fatal("memory exhausted");
+#endif
+    pc->count = 0;
+    for (i = 0; i < old; i++)
+        for (prog = bucket[i]; prog; prog = next) {
+            next = prog->chain;
+            if (!keep(env, prog)) {
+                program_free(prog);
+                continue;
+            }
+            prog->chain = pc->bucket[pattern_hash(pc, prog->key, prog->kind)];
+            pc->bucket[pattern_hash(pc, prog->key, prog->kind)] = prog;
+            pc->count++;
+        }
+    free(bucket);
+}
+
+/*
+ * pattern_forward - called by the collector after all roots have been
+ *		     copied. Programs follow their keys or are freed.
+ */
+void pattern_forward(pEnv env)
+{
+    pattern_filter(env, forward_program);
+}
+
+/*
+ * Programs of definitions are kept when memory is released.
+ */
+static int below_low(pEnv env, PatProgram* prog)
+{
+    return prog->key < env->mem_low;
+}
+
+/*
+ * pattern_reset - forget the programs above mem_low. Called when memory
+ *		   above mem_low is released without collection.
+ */
+void pattern_reset(pEnv env)
+{
+    pattern_filter(env, below_low);
+}
+
+/*
+ * pattern_free - release the cache.
+ */
+void pattern_free(pEnv env)
+{
+    int i;
+    PatProgram *prog, *next;
+    PatternCache* pc = env->patterns;
+
+    if (!pc)
+        return;
+    for (i = 0; i < pc->buckets; i++)
+        for (prog = pc->bucket[i]; prog; prog = next) {
+            next = prog->chain;
+            program_free(prog);
+        }
+    free(pc->bucket);
+    free(pc->bind);
+    free(pc->pend);
+    free(pc);
+    env->patterns = 0;
+}
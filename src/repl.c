@@ -1,7 +1,7 @@
 /*
  *  module  : repl.c
- *  version : 1.2
- *  date    : 10/11/24
+ *  version : 1.3
+ *  date    : 10/18/26
  */
 #include "globals.h"
 
@@ -87,6 +87,7 @@ void repl(pEnv env)
             }
 #endif
             print(env);
+            joy_flush_term(env);
         }
     }
 }
@@ -1,11 +1,12 @@
 /* FILE : scan.c */
 /*
  *  module  : scan.c
- *  version : 1.86
- *  date    : 10/11/24
+ *  version : 1.88
+ *  date    : 10/18/26
  */
 #include "globals.h"
 #include <stdarg.h>
+#include <sys/stat.h>
 
 static struct keys {
     char* name;
@@ -34,12 +35,77 @@ static struct keys {
  *   env->scanner.startnum    - line of token start
  *   env->scanner.startpos    - position of token start
  *   env->scanner.endpos      - position of token end
+ *   env->scanner.block       - source file read ahead in blocks
  */
 static int stderr_printf_count(const char *fmt, ...);
 #ifdef ALLOW_SYSTEM_CALLS
 static int command_is_safe(const char *cmd);
 #endif
 
+/*
+ * getblock reads the next block of srcfile and returns its first character.
+ * Only regular files other than stdin are read in blocks: a terminal or a
+ * pipe is read a character at a time, as it may be read by builtins as well.
+ * When srcfile has changed, the bytes that were read ahead of the previous
+ * file are given back to it, to be read again when it is continued.
+ */
+static int getblock(pEnv env)
+{
+    FILE* fp = env->scanner.srcfile;
+#ifndef WINDOWS
+    struct stat st;
+#endif
+
+    if (env->scanner.block.fp != fp) {
+        if (env->scanner.block.pos < env->scanner.block.len)
+            fseek(env->scanner.block.fp,
+                  -(long)(env->scanner.block.len - env->scanner.block.pos),
+                  SEEK_CUR);
+        env->scanner.block.fp = fp;
+        env->scanner.block.pos = env->scanner.block.len = 0;
+#ifdef WINDOWS
+        env->scanner.block.on = 0; /* text mode: no seeking back */
+#else
+        env->scanner.block.on = fp != stdin && !fstat(fileno(fp), &st)
+                                && S_ISREG(st.st_mode);
+#endif
+    }
+    if (!env->scanner.block.on)
+        return joy_getc(env, fp);
+    if (!env->scanner.block.buf)
+        env->scanner.block.buf = check_malloc(INPBLOCKMAX);
+    env->scanner.block.pos = 0;
+    if ((env->scanner.block.len = fread(env->scanner.block.buf, 1,
+                                        INPBLOCKMAX, fp)) == 0)
+        return EOF;
+    return (unsigned char)env->scanner.block.buf[env->scanner.block.pos++];
+}
+
+/*
+ * exitlinebuffer - forget the block of srcfile that was read ahead, and
+ *		    release it.
+ */
+void exitlinebuffer(pEnv env)
+{
+    free(env->scanner.block.buf);
+    env->scanner.block.buf = 0;
+    env->scanner.block.fp = 0;
+    env->scanner.block.pos = env->scanner.block.len = 0;
+}
+
+/*
+ * getraw reads the next character from srcfile, from the block when there
+ * is one.
+ */
+static int getraw(pEnv env)
+{
+    if (env->scanner.block.pos < env->scanner.block.len
+        && env->scanner.block.fp == env->scanner.srcfile)
+        return (unsigned char)
+            env->scanner.block.buf[env->scanner.block.pos++];
+    return getblock(env);
+}
+
 /*
  * getch reads the next character from srcfile.
  */
@@ -50,9 +116,10 @@ int getch(pEnv env)
 again:
     if (vec_size(env->pushback))
         return vec_pop(env->pushback);
-    if ((ch = joy_getc(env, env->scanner.srcfile)) == EOF) {
+    if ((ch = getraw(env)) == EOF) {
         if (!env->scanner.ilevel)
             abortexecution_(env, ABORT_QUIT);
+        env->scanner.block.fp = 0; /* the block has been read */
         fclose(env->scanner.srcfile);
         env->scanner.srcfile = env->scanner.infile[--env->scanner.ilevel].fp;
         env->scanner.linenum = env->scanner.infile[env->scanner.ilevel].line;
@@ -63,7 +130,7 @@ again:
     }
     if (!env->scanner.linepos && ch == SHELLESCAPE) {
         /* Check if this is string interpolation $"..." rather than shell escape */
-        int next = joy_getc(env, env->scanner.srcfile);
+        int next = getraw(env);
         if (next == '"') {
             /* It's string interpolation, push back the " and return $ */
             vec_push(env->pushback, next);
@@ -73,13 +140,14 @@ again:
         }
         /* It's a shell escape, continue with shell command processing */
         vec_push(env->string, next);
-        while ((ch = joy_getc(env, env->scanner.srcfile)) != '\n' && ch != EOF)
+        while ((ch = getraw(env)) != '\n' && ch != EOF)
             vec_push(env->string, ch);
         vec_push(env->string, 0);
 #ifdef ALLOW_SYSTEM_CALLS
         if (!env->ignore) {
             char *command = &vec_at(env->string, 0);
             if (command_is_safe(command)) {
+                joy_flush(env); /* before the output of the command */
 #ifndef __clang_analyzer__
                 (void)system(command);
 #else
@@ -115,7 +183,11 @@ void ungetch(pEnv env, int ch)
 {
     if (ch == '\n')
         env->scanner.linenum--; /* about to unread newline */
-    ungetc(ch, env->scanner.srcfile);
+    if (env->scanner.block.pos
+        && env->scanner.block.fp == env->scanner.srcfile)
+        env->scanner.block.buf[--env->scanner.block.pos] = ch;
+    else
+        joy_ungetc(env, ch, env->scanner.srcfile);
     if (env->scanner.linepos > 0)
         env->scanner.linepos--; /* read too far, push back */
 }
@@ -152,7 +224,7 @@ void error(pEnv env, char* str)
 {
     int leng;
 
-    fflush(stdout);
+    joy_flush(env);
     leng = stderr_printf_count("%s:%d:", env->scanner.srcfilename, env->scanner.linenum);
     leng += stderr_printf_count("%.*s", env->scanner.linepos, env->scanner.linebuf);
     if (leng > 0) {
@@ -501,9 +573,74 @@ static int parse_interpolated_string(pEnv env)
     return getch(env); /* read past closing " */
 }
 
+/*
+ * isstop tells whether ch ends a run of the characters of a string (string
+ * set) or of a symbol or number (string not set).
+ */
+static int isstop(int ch, int string)
+{
+    if (string)
+        return ch == '"' || ch == '\\' || ch == '\n' || ch == EOF;
+    switch (ch) { /* the exclude characters of my_getsym */
+    case '"':
+    case '#':
+    case '\'':
+    case '(':
+    case ')':
+    case '.':
+    case ';':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+        return 1;
+    }
+    return ch <= ' ';
+}
+
+/*
+ * getrun pushes ch and the characters after it on env->string, until a
+ * character that isstop, that is returned. The characters that are in the
+ * block are copied at once: a run has no newline, such that only linebuf
+ * needs to be kept as getch would.
+ */
+static int getrun(pEnv env, int ch, int string)
+{
+    size_t n, k;
+    unsigned char *p, *q, *end;
+
+    while (!isstop(ch, string)) {
+        vec_push(env->string, ch);
+        if (!vec_size(env->pushback)
+            && env->scanner.block.pos < env->scanner.block.len
+            && env->scanner.block.fp == env->scanner.srcfile) {
+            p = (unsigned char*)env->scanner.block.buf
+                + env->scanner.block.pos;
+            end = (unsigned char*)env->scanner.block.buf
+                  + env->scanner.block.len;
+            for (q = p; q < end && !isstop(*q, string); q++)
+                ;
+            if ((n = q - p) != 0) {
+                for (k = 0; k < n; k++)
+                    vec_push(env->string, p[k]);
+                k = INPLINEMAX - env->scanner.linepos;
+                memcpy(env->scanner.linebuf + env->scanner.linepos, p,
+                       k < n ? k : n);
+                env->scanner.linepos += k < n ? k : n;
+                env->scanner.linebuf[env->scanner.linepos] = 0;
+                env->scanner.block.pos += n;
+            }
+        }
+        ch = getch(env);
+    }
+    return ch;
+}
+
 /*
  * getsym reads the next symbol from code or from srcfile. The return value is
- * the character after the symbol that was read.
+ * the character after the symbol that was read. The name of a symbol is left
+ * in env->string, until the next symbol is read; so is a string, as nodes
+ * have a copy of it.
  */
 static int my_getsym(pEnv env, int ch)
 {
@@ -562,13 +699,20 @@ start:
     case '"':
         ch = getch(env);
         while (ch != '"') {
-            if (ch == '\\')
-                ch = special(env);
-            vec_push(env->string, ch);
-            ch = getch(env);
+            if (ch == '\\' || ch == '\n' || ch == EOF) {
+                if (ch == '\\')
+                    ch = special(env);
+                vec_push(env->string, ch);
+                ch = getch(env);
+            } else
+                ch = getrun(env, ch, 1);
         }
         vec_push(env->string, 0);
+#ifdef NOBDW
+        env->str = &vec_at(env->string, 0); /* copied into nodes */
+#else
         env->str = GC_CTX_STRDUP(env, &vec_at(env->string, 0));
+#endif
         env->scanner.sym = STRING_;
         env->scanner.endpos = env->scanner.linepos;
         return getch(env); /* read past " */
@@ -597,10 +741,7 @@ start:
         sign = ch; /* possible sign */
         ch = getch(env);
         type = isdigit(sign) || (sign == '-' && isdigit(ch)); /* numeric */
-        while (ch > ' ' && !strchr(exclude, ch)) {
-            vec_push(env->string, ch);
-            ch = getch(env);
-        }
+        ch = getrun(env, ch, 0);
         if (ch == '.') {
             ch = getch(env);
             if (type) {
@@ -616,10 +757,7 @@ start:
                 goto einde;
             }
             vec_push(env->string, '.');
-            while (ch > ' ' && !strchr(exclude, ch)) {
-                vec_push(env->string, ch);
-                ch = getch(env);
-            }
+            ch = getrun(env, ch, 0);
         }
     einde:
         vec_push(env->string, 0);
@@ -677,7 +815,7 @@ start:
             ungetch(env, next);  /* not m[[, push back */
         }
 #endif
-        env->str = GC_CTX_STRDUP(env, ptr);
+        env->str = ptr; /* copied by push_sym and the users that keep it */
         env->scanner.sym = USR_;
     }
     return ch;
@@ -771,7 +909,7 @@ static void push_sym(pEnv env)
         break;
     case USR_:
     case STRING_:
-        node.u.str = env->str;
+        node.u.str = env->str = GC_CTX_STRDUP(env, env->str);
         break;
     }
     node.y = env->scanner.startnum;
@@ -836,7 +974,7 @@ int getsym(pEnv env, int ch)
                 push_sym(env);
                 ch = my_getsym(env, ch);
                 if (env->scanner.sym == USR_) {
-                    initmod(env, env->str);
+                    initmod(env, GC_CTX_STRDUP(env, env->str));
                     module++;
                 } else
                     error(env, "atom expected as name of module");
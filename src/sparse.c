@@ -0,0 +1,387 @@
+/*
+ *  module  : sparse.c
+ *  version : 1.0
+ *  date    : 10/18/26
+ *
+ *  Sparse matrices of doubles, with compressed rows or columns.
+ *
+ *  Only the nonzero elements are stored, such that memory and time are
+ *  proportional to their number, not to rows x cols. The elements of a row
+ *  (or column) are in increasing order of their column (or row), without
+ *  duplicates and without zeros. Converting between the formats, and
+ *  transposing, is a counting sort on the other index, that keeps that
+ *  order. Products with compressed rows compute each row of the result by
+ *  itself; with JOY_PARALLEL, the rows are divided over the threads.
+ */
+#include "globals.h"
+
+#define SPARSE_ROWS 256     /* rows that a thread takes at a time */
+#define SPARSE_SPLIT 100000 /* from this many elements, use the threads */
+
+/*
+ * Compress by the minor index: the n elements of nmaj majors in ptr, idx and
+ * val become those of nmin majors in optr, oidx and oval.
+ */
+static void sparse_flip(int64_t nmaj, int64_t nmin, const int64_t* ptr,
+                        const int64_t* idx, const double* val, int64_t* optr,
+                        int64_t* oidx, double* oval)
+{
+    int64_t i, p, q;
+
+    for (i = 0; i <= nmin; i++)
+        optr[i] = 0;
+    for (p = 0; p < ptr[nmaj]; p++)
+        optr[idx[p] + 1]++;
+    for (i = 0; i < nmin; i++)
+        optr[i + 1] += optr[i];
+    for (i = 0; i < nmaj; i++)
+        for (p = ptr[i]; p < ptr[i + 1]; p++) {
+            q = optr[idx[p]]++;
+            oidx[q] = i;
+            oval[q] = val[p];
+        }
+    for (i = nmin; i > 0; i--) /* restore the starts */
+        optr[i] = optr[i - 1];
+    optr[0] = 0;
+}
+
+/*
+ * sparse_build - sparse matrix of rows x cols from n triplets: element ri[k],
+ *		  ci[k] is x[k]. Duplicates are added; zeros are left out.
+ *		  The indices have been checked.
+ */
+SparseData* sparse_build(pEnv env, int64_t rows, int64_t cols, int64_t n,
+                         const int64_t* ri, const int64_t* ci, const double* x,
+                         int format)
+{
+    SparseData* spm;
+    const int64_t *maj, *min;
+    int64_t i, k, p, nmaj, nmin, nnz, *cptr, *cidx, *ptr, *idx;
+    double *cval, *val;
+
+    if (format == SP_CSR) {
+        maj = ri;
+        min = ci;
+        nmaj = rows;
+        nmin = cols;
+    } else {
+        maj = ci;
+        min = ri;
+        nmaj = cols;
+        nmin = rows;
+    }
+    /*
+     * Compress by the minor index first; compressing that by the major index
+     * then sorts the elements of each major.
+     */
+    cptr = check_malloc((nmin + 1) * sizeof(int64_t));
+    cidx = check_malloc((n ? n : 1) * sizeof(int64_t));
+    cval = check_malloc((n ? n : 1) * sizeof(double));
+    for (i = 0; i <= nmin; i++)
+        cptr[i] = 0;
+    for (k = 0; k < n; k++)
+        cptr[min[k] + 1]++;
+    for (i = 0; i < nmin; i++)
+        cptr[i + 1] += cptr[i];
+    for (k = 0; k < n; k++) {
+        p = cptr[min[k]]++;
+        cidx[p] = maj[k];
+        cval[p] = x[k];
+    }
+    for (i = nmin; i > 0; i--)
+        cptr[i] = cptr[i - 1];
+    cptr[0] = 0;
+    ptr = check_malloc((nmaj + 1) * sizeof(int64_t));
+    idx = check_malloc((n ? n : 1) * sizeof(int64_t));
+    val = check_malloc((n ? n : 1) * sizeof(double));
+    sparse_flip(nmin, nmaj, cptr, cidx, cval, ptr, idx, val);
+    free(cptr);
+    free(cidx);
+    free(cval);
+    /*
+     * Add duplicates and leave out zeros, in place.
+     */
+    for (nnz = i = 0; i < nmaj; i++) {
+        k = nnz;
+        for (p = ptr[i]; p < ptr[i + 1]; p++)
+            if (nnz > k && idx[nnz - 1] == idx[p])
+                val[nnz - 1] += val[p];
+            else {
+                if (nnz > k && val[nnz - 1] == 0)
+                    nnz--;
+                idx[nnz] = idx[p];
+                val[nnz++] = val[p];
+            }
+        if (nnz > k && val[nnz - 1] == 0)
+            nnz--;
+        ptr[i] = k;
+    }
+    ptr[nmaj] = nnz;
+    spm = native_sparse(env, rows, cols, nnz, format);
+    memcpy(spm->ptr, ptr, (nmaj + 1) * sizeof(int64_t));
+    memcpy(spm->idx, idx, nnz * sizeof(int64_t));
+    memcpy(spm->val, val, nnz * sizeof(double));
+    free(ptr);
+    free(idx);
+    free(val);
+    return spm;
+}
+
+/*
+ * sparse_dense - sparse matrix of rows x cols with the nonzero elements of a,
+ *		  whose rows are ld apart.
+ */
+SparseData* sparse_dense(pEnv env, const double* a, int64_t rows, int64_t cols,
+                         int64_t ld, int format)
+{
+    SparseData* spm;
+    int64_t i, j, p, nnz = 0;
+
+    for (i = 0; i < rows; i++)
+        for (j = 0; j < cols; j++)
+            nnz += a[i * ld + j] != 0;
+    spm = native_sparse(env, rows, cols, nnz, format);
+    if (format == SP_CSR) {
+        for (nnz = i = 0; i < rows; i++) {
+            spm->ptr[i] = nnz;
+            for (j = 0; j < cols; j++)
+                if (a[i * ld + j] != 0) {
+                    spm->idx[nnz] = j;
+                    spm->val[nnz++] = a[i * ld + j];
+                }
+        }
+        spm->ptr[rows] = nnz;
+        return spm;
+    }
+    for (j = 0; j <= cols; j++)
+        spm->ptr[j] = 0;
+    for (i = 0; i < rows; i++)
+        for (j = 0; j < cols; j++)
+            spm->ptr[j + 1] += a[i * ld + j] != 0;
+    for (j = 0; j < cols; j++)
+        spm->ptr[j + 1] += spm->ptr[j];
+    for (i = 0; i < rows; i++) /* the rows of each column in order */
+        for (j = 0; j < cols; j++)
+            if (a[i * ld + j] != 0) {
+                p = spm->ptr[j]++;
+                spm->idx[p] = i;
+                spm->val[p] = a[i * ld + j];
+            }
+    for (j = cols; j > 0; j--)
+        spm->ptr[j] = spm->ptr[j - 1];
+    spm->ptr[0] = 0;
+    return spm;
+}
+
+/*
+ * sparse_convert - spm with compressed rows or columns by format.
+ */
+SparseData* sparse_convert(pEnv env, SparseData* spm, int format)
+{
+    SparseData* res;
+
+    if (spm->format == format)
+        return spm;
+    res = native_sparse(env, spm->rows, spm->cols, spm->nnz, format);
+    if (format == SP_CSC)
+        sparse_flip(spm->rows, spm->cols, spm->ptr, spm->idx, spm->val,
+                    res->ptr, res->idx, res->val);
+    else
+        sparse_flip(spm->cols, spm->rows, spm->ptr, spm->idx, spm->val,
+                    res->ptr, res->idx, res->val);
+    return res;
+}
+
+/*
+ * sparse_transpose - the transpose of spm, in the same format.
+ */
+SparseData* sparse_transpose(pEnv env, SparseData* spm)
+{
+    SparseData* res;
+    int64_t nmaj, nmin;
+
+    res = native_sparse(env, spm->cols, spm->rows, spm->nnz, spm->format);
+    nmaj = spm->format == SP_CSR ? spm->rows : spm->cols;
+    nmin = spm->format == SP_CSR ? spm->cols : spm->rows;
+    sparse_flip(nmaj, nmin, spm->ptr, spm->idx, spm->val, res->ptr, res->idx,
+                res->val);
+    return res;
+}
+
+/*
+ * sparse_todense - write the rows x cols elements of spm to c.
+ */
+void sparse_todense(const SparseData* spm, double* c)
+{
+    int64_t i, p, n;
+
+    for (i = 0; i < spm->rows * spm->cols; i++)
+        c[i] = 0;
+    n = spm->format == SP_CSR ? spm->rows : spm->cols;
+    for (i = 0; i < n; i++)
+        for (p = spm->ptr[i]; p < spm->ptr[i + 1]; p++)
+            if (spm->format == SP_CSR)
+                c[i * spm->cols + spm->idx[p]] = spm->val[p];
+            else
+                c[spm->idx[p] * spm->cols + i] = spm->val[p];
+}
+
+/*
+ * sparse_spmv - y = spm * x, with x of cols and y of rows elements.
+ */
+void sparse_spmv(const SparseData* spm, const double* x, double* y)
+{
+    int64_t i, p;
+    double sum;
+
+    if (spm->format == SP_CSR) {
+#ifdef JOY_PARALLEL
+#pragma omp parallel for private(p, sum) schedule(dynamic, SPARSE_ROWS)       \
+    if (spm->nnz >= SPARSE_SPLIT)
+#endif
+        for (i = 0; i < spm->rows; i++) {
+            sum = 0;
+#pragma omp simd reduction(+ : sum)
+            for (p = spm->ptr[i]; p < spm->ptr[i + 1]; p++)
+                sum += spm->val[p] * x[spm->idx[p]];
+            y[i] = sum;
+        }
+        return;
+    }
+    for (i = 0; i < spm->rows; i++)
+        y[i] = 0;
+    for (i = 0; i < spm->cols; i++)
+        for (p = spm->ptr[i]; p < spm->ptr[i + 1]; p++)
+            y[spm->idx[p]] += spm->val[p] * x[i];
+}
+
+/*
+ * sparse_spmm - c = spm * b, with b of cols x n and c of rows x n elements,
+ *		 whose rows are ldb and n apart.
+ */
+void sparse_spmm(const SparseData* spm, const double* b, int64_t ldb,
+                 int64_t n, double* c)
+{
+    int64_t i, j, p;
+    const double* row;
+    double x;
+
+    for (i = 0; i < spm->rows * n; i++)
+        c[i] = 0;
+    if (spm->format == SP_CSR) {
+#ifdef JOY_PARALLEL
+#pragma omp parallel for private(j, p, row, x) schedule(dynamic, SPARSE_ROWS) \
+    if (spm->nnz * n >= SPARSE_SPLIT)
+#endif
+        for (i = 0; i < spm->rows; i++)
+            for (p = spm->ptr[i]; p < spm->ptr[i + 1]; p++) {
+                x = spm->val[p];
+                row = b + spm->idx[p] * ldb;
+#pragma omp simd
+                for (j = 0; j < n; j++)
+                    c[i * n + j] += x * row[j];
+            }
+        return;
+    }
+    for (i = 0; i < spm->cols; i++)
+        for (p = spm->ptr[i]; p < spm->ptr[i + 1]; p++) {
+            x = spm->val[p];
+            row = b + i * ldb;
+#pragma omp simd
+            for (j = 0; j < n; j++)
+                c[spm->idx[p] * n + j] += x * row[j];
+        }
+}
+
+/*
+ * sparse_combine - a op b, element by element, with op NK_ADD, NK_SUB or
+ *		    NK_MUL, in the format of a. The dimensions are the same.
+ */
+SparseData* sparse_combine(pEnv env, int op, const SparseData* a,
+                           const SparseData* b)
+{
+    SparseData* spm;
+    const int64_t *bptr, *bidx;
+    const double* bval;
+    int64_t i, j, p, q, nmaj, nmin, nnz, *ptr, *idx, *tptr = 0, *tidx = 0;
+    double x, *val, *tval = 0;
+
+    nmaj = a->format == SP_CSR ? a->rows : a->cols;
+    nmin = a->format == SP_CSR ? a->cols : a->rows;
+    if (a->format == b->format) {
+        bptr = b->ptr;
+        bidx = b->idx;
+        bval = b->val;
+    } else {
+        tptr = check_malloc((nmaj + 1) * sizeof(int64_t));
+        tidx = check_malloc((b->nnz ? b->nnz : 1) * sizeof(int64_t));
+        tval = check_malloc((b->nnz ? b->nnz : 1) * sizeof(double));
+        sparse_flip(nmin, nmaj, b->ptr, b->idx, b->val, tptr, tidx, tval);
+        bptr = tptr;
+        bidx = tidx;
+        bval = tval;
+    }
+    nnz = op != NK_MUL ? a->nnz + b->nnz : a->nnz < b->nnz ? a->nnz : b->nnz;
+    ptr = check_malloc((nmaj + 1) * sizeof(int64_t));
+    idx = check_malloc((nnz ? nnz : 1) * sizeof(int64_t));
+    val = check_malloc((nnz ? nnz : 1) * sizeof(double));
+    for (nnz = i = 0; i < nmaj; i++) {
+        ptr[i] = nnz;
+        p = a->ptr[i];
+        q = bptr[i];
+        while (p < a->ptr[i + 1] || q < bptr[i + 1]) {
+            if (q == bptr[i + 1]
+                || (p < a->ptr[i + 1] && a->idx[p] < bidx[q])) {
+                x = op == NK_MUL ? 0 : a->val[p];
+                j = a->idx[p++];
+            } else if (p == a->ptr[i + 1] || bidx[q] < a->idx[p]) {
+                x = op == NK_MUL ? 0 : op == NK_SUB ? -bval[q] : bval[q];
+                j = bidx[q++];
+            } else {
+                x = op == NK_MUL   ? a->val[p] * bval[q]
+                    : op == NK_SUB ? a->val[p] - bval[q]
+                                   : a->val[p] + bval[q];
+                j = a->idx[p++];
+                q++;
+            }
+            if (x != 0) {
+                idx[nnz] = j;
+                val[nnz++] = x;
+            }
+        }
+    }
+    ptr[nmaj] = nnz;
+    spm = native_sparse(env, a->rows, a->cols, nnz, a->format);
+    memcpy(spm->ptr, ptr, (nmaj + 1) * sizeof(int64_t));
+    memcpy(spm->idx, idx, nnz * sizeof(int64_t));
+    memcpy(spm->val, val, nnz * sizeof(double));
+    free(ptr);
+    free(idx);
+    free(val);
+    free(tptr);
+    free(tidx);
+    free(tval);
+    return spm;
+}
+
+/*
+ * sparse_scale - spm * x.
+ */
+SparseData* sparse_scale(pEnv env, const SparseData* spm, double x)
+{
+    SparseData* res;
+    int64_t i, major;
+
+    if (x == 0)
+        res = native_sparse(env, spm->rows, spm->cols, 0, spm->format);
+    else
+        res = native_sparse(env, spm->rows, spm->cols, spm->nnz, spm->format);
+    major = spm->format == SP_CSR ? spm->rows : spm->cols;
+    for (i = 0; i <= major; i++)
+        res->ptr[i] = x == 0 ? 0 : spm->ptr[i];
+    for (i = 0; i < res->nnz; i++) {
+        res->idx[i] = spm->idx[i];
+        res->val[i] = spm->val[i] * x;
+    }
+    return res;
+}
@@ -0,0 +1,447 @@
+/*
+ *  module  : stats.c
+ *  version : 1.1
+ *  date    : 10/18/26
+ *
+ *  Sorting, selection and counting of the elements of native vectors.
+ *
+ *  There is a version of each function for each element type, generated by
+ *  a macro, that works on adjacent elements. Sorting is an introsort: a
+ *  quicksort with the median of three as pivot, that switches to heapsort
+ *  when the partitions become unbalanced, and to insertion sort for small
+ *  partitions. Selection of the k-th smallest element is the same quicksort,
+ *  that only continues with the partition that contains k, such that it
+ *  takes linear time on average. Argsort is a merge sort of positions, so
+ *  that equal elements keep their order. NaNs come after all numbers.
+ *  Rolling sums add the element that enters the window and subtract the one
+ *  that leaves; rolling maxima keep the decreasing candidates in a queue.
+ */
+#include "globals.h"
+
+#define STATS_SMALL 16 /* partitions that are sorted by insertion */
+#define STATS_RESUM 4096 /* windows between rolling sums computed anew */
+
+/*
+ * Versions for elements of type T, named by SUF. Sums are of type R, that
+ * are computed in type U. FL tells whether the elements are floats, that
+ * can be NaN, and ISNAN whether one is.
+ */
+#define STATS(SUF, T, R, U, FL, ISNAN)                                        \
+    static void insert_##SUF(T* a, int64_t n)                                 \
+    {                                                                         \
+        T x;                                                                  \
+        int64_t i, j;                                                         \
+                                                                              \
+        for (i = 1; i < n; i++) {                                             \
+            x = a[i];                                                         \
+            for (j = i; j > 0 && x < a[j - 1]; j--)                           \
+                a[j] = a[j - 1];                                              \
+            a[j] = x;                                                         \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static void heap_##SUF(T* a, int64_t n)                                   \
+    {                                                                         \
+        T x;                                                                  \
+        int64_t i, j, k, m;                                                   \
+                                                                              \
+        for (m = n, i = n / 2; m > 1;) {                                      \
+            if (i > 0)                                                        \
+                x = a[--i]; /* build the heap */                              \
+            else {                                                            \
+                x = a[--m]; /* move the largest behind the heap */            \
+                a[m] = a[0];                                                  \
+            }                                                                 \
+            for (j = i; (k = 2 * j + 1) < m; j = k) {                         \
+                if (k + 1 < m && a[k] < a[k + 1])                             \
+                    k++;                                                      \
+                if (!(x < a[k]))                                              \
+                    break;                                                    \
+                a[j] = a[k];                                                  \
+            }                                                                 \
+            a[j] = x;                                                         \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * Partition a, of more than STATS_SMALL elements, into a[0 .. j] and     \
+     * a[j + 1 .. n - 1], with no element of the first greater than any of    \
+     * the second. Both are not empty.                                        \
+     */                                                                       \
+    static int64_t part_##SUF(T* a, int64_t n)                                \
+    {                                                                         \
+        T p, t;                                                               \
+        int64_t i, j;                                                         \
+                                                                              \
+        if (a[n / 2] < a[0]) {                                                \
+            t = a[n / 2];                                                     \
+            a[n / 2] = a[0];                                                  \
+            a[0] = t;                                                         \
+        }                                                                     \
+        if (a[n - 1] < a[n / 2]) {                                            \
+            t = a[n - 1];                                                     \
+            a[n - 1] = a[n / 2];                                              \
+            a[n / 2] = t;                                                     \
+            if (a[n / 2] < a[0]) {                                            \
+                t = a[n / 2];                                                 \
+                a[n / 2] = a[0];                                              \
+                a[0] = t;                                                     \
+            }                                                                 \
+        }                                                                     \
+        p = a[n / 2]; /* the median of three becomes the first */             \
+        a[n / 2] = a[0];                                                      \
+        a[0] = p;                                                             \
+        for (i = -1, j = n;;) {                                               \
+            while (a[++i] < p)                                                \
+                ;                                                             \
+            while (p < a[--j])                                                \
+                ;                                                             \
+            if (i >= j)                                                       \
+                return j;                                                     \
+            t = a[i];                                                         \
+            a[i] = a[j];                                                      \
+            a[j] = t;                                                         \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static void intro_##SUF(T* a, int64_t n, int depth)                       \
+    {                                                                         \
+        int64_t j;                                                            \
+                                                                              \
+        while (n > STATS_SMALL) {                                             \
+            if (depth-- == 0) {                                               \
+                heap_##SUF(a, n);                                             \
+                return;                                                       \
+            }                                                                 \
+            j = part_##SUF(a, n) + 1;                                         \
+            if (j < n - j) { /* recurse into the smaller part */              \
+                intro_##SUF(a, j, depth);                                     \
+                a += j;                                                       \
+                n -= j;                                                       \
+            } else {                                                          \
+                intro_##SUF(a + j, n - j, depth);                             \
+                n = j;                                                        \
+            }                                                                 \
+        }                                                                     \
+        insert_##SUF(a, n);                                                   \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * Move the NaNs to the end; the result is the number of other elements.  \
+     */                                                                       \
+    static int64_t nans_##SUF(T* a, int64_t n)                                \
+    {                                                                         \
+        T t;                                                                  \
+        int64_t i, m;                                                         \
+                                                                              \
+        if (!FL)                                                              \
+            return n;                                                         \
+        for (i = m = 0; i < n; i++)                                           \
+            if (!ISNAN(a[i])) {                                               \
+                t = a[i];                                                     \
+                a[i] = a[m];                                                  \
+                a[m++] = t;                                                   \
+            }                                                                 \
+        return m;                                                             \
+    }                                                                         \
+                                                                              \
+    static void sort_##SUF(T* a, int64_t n)                                   \
+    {                                                                         \
+        n = nans_##SUF(a, n);                                                 \
+        intro_##SUF(a, n, 2 * stats_log2(n));                                 \
+    }                                                                         \
+                                                                              \
+    static double select_##SUF(T* a, int64_t n, int64_t k)                    \
+    {                                                                         \
+        int64_t j, depth = 2 * stats_log2(n);                                 \
+                                                                              \
+        while (n > STATS_SMALL) {                                             \
+            if (depth-- == 0) {                                               \
+                heap_##SUF(a, n);                                             \
+                return a[k];                                                  \
+            }                                                                 \
+            j = part_##SUF(a, n) + 1;                                         \
+            if (k < j)                                                        \
+                n = j;                                                        \
+            else {                                                            \
+                a += j;                                                       \
+                n -= j;                                                       \
+                k -= j;                                                       \
+            }                                                                 \
+        }                                                                     \
+        insert_##SUF(a, n);                                                   \
+        return a[k];                                                          \
+    }                                                                         \
+                                                                              \
+    /*                                                                        \
+     * Merge sort of the positions k of the elements of a, using t.           \
+     */                                                                       \
+    static void argsort_##SUF(const T* a, int64_t* k, int64_t* t, int64_t n)  \
+    {                                                                         \
+        T x;                                                                  \
+        int64_t i, j, p, q, r, lo, mid, hi, w, *src = k, *dst = t, *s;        \
+                                                                              \
+        for (lo = 0; lo < n; lo += STATS_SMALL) {                             \
+            hi = lo + STATS_SMALL < n ? lo + STATS_SMALL : n;                 \
+            for (i = lo; i < hi; i++) {                                       \
+                x = a[i];                                                     \
+                for (j = i;                                                   \
+                     j > lo && STATS_BEFORE(ISNAN, x, a[k[j - 1]]); j--)      \
+                    k[j] = k[j - 1];                                          \
+                k[j] = i;                                                     \
+            }                                                                 \
+        }                                                                     \
+        for (w = STATS_SMALL; w < n; w *= 2) {                                \
+            for (lo = 0; lo < n; lo += 2 * w) {                               \
+                mid = lo + w < n ? lo + w : n;                                \
+                hi = lo + 2 * w < n ? lo + 2 * w : n;                         \
+                for (p = lo, q = mid, r = lo; r < hi; r++)                    \
+                    if (q < hi                                                \
+                        && (p == mid                                          \
+                            || STATS_BEFORE(ISNAN, a[src[q]], a[src[p]])))    \
+                        dst[r] = src[q++];                                    \
+                    else                                                      \
+                        dst[r] = src[p++];                                    \
+            }                                                                 \
+            s = src;                                                          \
+            src = dst;                                                        \
+            dst = s;                                                          \
+        }                                                                     \
+        if (src != k)                                                         \
+            memcpy(k, src, n * sizeof(int64_t));                              \
+    }                                                                         \
+                                                                              \
+    static int64_t unique_##SUF(T* a, int64_t n)                              \
+    {                                                                         \
+        int64_t i, m;                                                         \
+                                                                              \
+        for (i = m = 0; i < n; i++)                                           \
+            if (!m || !(a[i] == a[m - 1] || (ISNAN(a[i]) && ISNAN(a[m - 1])))) \
+                a[m++] = a[i];                                                \
+        return m;                                                             \
+    }                                                                         \
+                                                                              \
+    static void cumsum_##SUF(R* restrict r, const T* restrict a, int64_t n)   \
+    {                                                                         \
+        R s = 0;                                                              \
+        int64_t i;                                                            \
+                                                                              \
+        for (i = 0; i < n; i++)                                               \
+            r[i] = s = (R)((U)s + (U)a[i]);                                   \
+    }                                                                         \
+                                                                              \
+    static void rollsum_##SUF(R* restrict r, const T* restrict a, int64_t n,  \
+                              int64_t w)                                      \
+    {                                                                         \
+        R s = 0;                                                              \
+        int64_t i, j, every;                                                  \
+                                                                              \
+        every = w > STATS_RESUM ? w : STATS_RESUM;                            \
+        for (i = 0; i + w <= n; i++) {                                        \
+            if (!i || (FL && i % every == 0)) /* against rounding */          \
+                for (s = 0, j = i; j < i + w; j++)                            \
+                    s = (R)((U)s + (U)a[j]);                                  \
+            else                                                              \
+                s = (R)((U)s + (U)a[i + w - 1] - (U)a[i - 1]);                \
+            r[i] = s;                                                         \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static void rollmax_##SUF(R* restrict r, const T* restrict a, int64_t n,  \
+                              int64_t w, int64_t* restrict q)                 \
+    {                                                                         \
+        int64_t i, head = 0, tail = 0;                                        \
+                                                                              \
+        for (i = 0; i < n; i++) { /* q has decreasing elements, NaNs kept */  \
+            while (tail > head && !ISNAN(a[q[tail - 1]])                      \
+                   && (ISNAN(a[i]) || a[q[tail - 1]] <= a[i]))                \
+                tail--;                                                       \
+            q[tail++] = i;                                                    \
+            if (q[head] <= i - w)                                             \
+                head++;                                                       \
+            if (i >= w - 1)                                                   \
+                r[i - w + 1] = a[q[head]];                                    \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    static void hist_##SUF(const T* a, int64_t n, const double* edges,        \
+                           int64_t bins, int64_t* restrict counts)            \
+    {                                                                         \
+        double x, lo = 0, hi = 0;                                             \
+        int64_t i, b = 0, l = 0, h;                                           \
+                                                                              \
+        if (!edges) { /* bins of equal width over the range */                \
+            for (i = 0; i < n && ISNAN(a[i]); i++)                            \
+                ;                                                             \
+            if (i < n)                                                        \
+                lo = hi = a[i];                                               \
+            for (; i < n; i++)                                                \
+                if (a[i] < lo)                                                \
+                    lo = a[i];                                                \
+                else if (a[i] > hi)                                           \
+                    hi = a[i];                                                \
+            if (lo == hi) {                                                   \
+                lo -= 0.5;                                                    \
+                hi += 0.5;                                                    \
+            }                                                                 \
+        } else {                                                              \
+            lo = edges[0];                                                    \
+            hi = edges[bins];                                                 \
+        }                                                                     \
+        for (i = 0; i < n; i++) {                                             \
+            x = a[i];                                                         \
+            if (!(x >= lo && x <= hi)) /* outside, or NaN */                  \
+                continue;                                                     \
+            if (!edges)                                                       \
+                b = (x - lo) / (hi - lo) * bins;                              \
+            else                                                              \
+                for (l = 0, h = bins; h - l > 1;) { /* edges[l] <= x */       \
+                    b = (l + h) / 2;                                          \
+                    if (edges[b] <= x)                                        \
+                        l = b;                                                \
+                    else                                                      \
+                        h = b;                                                \
+                }                                                             \
+            counts[edges ? l : b < bins ? b : bins - 1]++;                    \
+        }                                                                     \
+    }
+
+/*
+ * Whether x comes before y: NaNs come last.
+ */
+#define STATS_BEFORE(ISNAN, x, y) ((x) < (y) || (ISNAN(y) && !ISNAN(x)))
+
+#define STATS_NAN(x) ((x) != (x))
+#define STATS_NONE(x) 0
+
+/*
+ * The depth at which introsort switches to heapsort is twice this.
+ */
+static int stats_log2(int64_t n)
+{
+    int k;
+
+    for (k = 0; n > 1; n >>= 1)
+        k++;
+    return k;
+}
+
+STATS(f64, double, double, double, 1, STATS_NAN)
+STATS(f32, float, double, double, 1, STATS_NAN)
+STATS(i64, int64_t, int64_t, uint64_t, 0, STATS_NONE)
+STATS(i32, int32_t, int64_t, uint64_t, 0, STATS_NONE)
+STATS(u8, uint8_t, int64_t, uint64_t, 0, STATS_NONE)
+
+/*
+ * Call name_SUF with args for element type dtype.
+ */
+#define STATS_CALL(dtype, name, args)                                         \
+    switch (dtype) {                                                          \
+    case DT_F32:                                                              \
+        name##_f32 args;                                                      \
+        break;                                                                \
+    case DT_I64:                                                              \
+        name##_i64 args;                                                      \
+        break;                                                                \
+    case DT_I32:                                                              \
+        name##_i32 args;                                                      \
+        break;                                                                \
+    case DT_U8:                                                               \
+        name##_u8 args;                                                       \
+        break;                                                                \
+    default:                                                                  \
+        name##_f64 args;                                                      \
+        break;                                                                \
+    }
+
+/*
+ * stats_sort - sort the n elements of a in increasing order, NaNs last.
+ */
+void stats_sort(int dtype, void* a, int64_t n)
+{
+    STATS_CALL(dtype, sort, (a, n))
+}
+
+/*
+ * stats_argsort - the positions of the n elements of a in the order of
+ *		   stats_sort, in k; equal elements keep their order.
+ */
+void stats_argsort(int dtype, const void* a, int64_t* k, int64_t n)
+{
+    int64_t* t;
+
+    t = check_malloc((n ? n : 1) * sizeof(int64_t));
+    STATS_CALL(dtype, argsort, (a, k, t, n))
+    free(t);
+}
+
+/*
+ * stats_select - the k-th smallest of the n elements of a, that has no NaNs,
+ *		  counting from 0. The elements are reordered such that it is
+ *		  a[k], with no greater element before it and no smaller one
+ *		  after it.
+ */
+double stats_select(int dtype, void* a, int64_t n, int64_t k)
+{
+    double x;
+
+    STATS_CALL(dtype, x = select, (a, n, k))
+    return x;
+}
+
+/*
+ * stats_unique - remove the repetitions of the n sorted elements of a; the
+ *		  result is the number that remains.
+ */
+int64_t stats_unique(int dtype, void* a, int64_t n)
+{
+    int64_t m = 0;
+
+    STATS_CALL(dtype, m = unique, (a, n))
+    return m;
+}
+
+/*
+ * stats_cumsum - the running sums of the n elements of a, in r: doubles for
+ *		  float elements and 64-bit integers, that wrap around,
+ *		  otherwise.
+ */
+void stats_cumsum(int dtype, void* r, const void* a, int64_t n)
+{
+    STATS_CALL(dtype, cumsum, (r, a, n))
+}
+
+/*
+ * stats_hist - the number of the n elements of a in each of the bins between
+ *		the bins + 1 increasing edges, in counts. Each bin includes its
+ *		lower edge, and the last also its upper edge. Without edges,
+ *		the bins have equal width over the range of the elements.
+ */
+void stats_hist(int dtype, const void* a, int64_t n, const double* edges,
+                int64_t bins, int64_t* counts)
+{
+    memset(counts, 0, bins * sizeof(int64_t));
+    STATS_CALL(dtype, hist, (a, n, edges, bins, counts))
+}
+
+/*
+ * stats_rollsum - the sums of the n - w + 1 windows of w elements of a, in r,
+ *		   as for stats_cumsum.
+ */
+void stats_rollsum(int dtype, void* r, const void* a, int64_t n, int64_t w)
+{
+    STATS_CALL(dtype, rollsum, (r, a, n, w))
+}
+
+/*
+ * stats_rollmax - the maxima of the n - w + 1 windows of w elements of a, in
+ *		   r, as for stats_cumsum. A window with a NaN has maximum NaN.
+ */
+void stats_rollmax(int dtype, void* r, const void* a, int64_t n, int64_t w)
+{
+    int64_t* q;
+
+    q = check_malloc((n ? n : 1) * sizeof(int64_t));
+    STATS_CALL(dtype, rollmax, (r, a, n, w, q))
+    free(q);
+}
@@ -1,7 +1,7 @@
 /*
  *  module  : symbol.c
- *  version : 1.8
- *  date    : 09/16/24
+ *  version : 1.9
+ *  date    : 10/18/26
  */
 #include "globals.h"
 #include <stdarg.h>
@@ -128,7 +128,7 @@ static int definition(pEnv env, int ch)
     index = enteratom(env, name);
     ent = vec_at(env->symtab, index);
     if (!ent.is_user && env->config.overwrite) {
-        fflush(stdout);
+        joy_flush(env);
         stderr_printf("warning: overwriting inbuilt '%s'\n", ent.name);
     }
     ent.is_user = 1;
@@ -193,7 +193,7 @@ int compound_def(pEnv env, int ch)
         break;
 
     default:
-        fflush(stdout);
+        joy_flush(env);
         stderr_printf("warning: empty compound definition\n");
         break;
     }
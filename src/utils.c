@@ -1,7 +1,7 @@
 /*
  *  module  : utils.c
- *  version : 1.47
- *  date    : 01/14/25
+ *  version : 1.48
+ *  date    : 10/18/26
  */
 #include "globals.h"
 
@@ -102,6 +102,9 @@ void inimem1(pEnv env, int status)
     } else if (status) {
         env->stck = env->inits; /* reset the stack to initial */
         env->memoryindex = env->mem_low;  /* retain only definitions */
+        hashcons_reset(env);
+        memo_clear(env);
+        pattern_reset(env);
     }
     env->conts = env->dump = 0;
     env->dump1 = env->dump2 = env->dump3 = env->dump4 = env->dump5 = 0;
@@ -149,6 +152,100 @@ void printnode(pEnv env, Index p)
 /* Forward declaration for mutual recursion */
 static Index copy(pEnv env, Index n);
 
+/*
+ * Copy the values of dictionary d. Nodes can share a dictionary, so this is
+ * done once in a collection.
+ */
+static void copy_dict(pEnv env, khash_t(Dict)* d)
+{
+    int ret;
+    khint_t k;
+
+    if (!d)
+        return;
+    if (!env->copied)
+        env->copied = kh_init(Seen);
+    kh_put(Seen, env->copied, (uint64_t)(uintptr_t)d, &ret);
+    if (!ret) /* already copied */
+        return;
+    for (k = kh_begin(d); k != kh_end(d); k++)
+        if (kh_exist(d, k))
+            kh_value(d, k) = copy(env, kh_value(d, k));
+}
+
+/*
+ * Release dictionary d and its keys, that it owns.
+ */
+static void dict_destroy(khash_t(Dict)* d)
+{
+    khint_t k;
+
+    for (k = kh_begin(d); k != kh_end(d); k++)
+        if (kh_exist(d, k))
+            free((char*)kh_key(d, k));
+    kh_destroy(Dict, d);
+}
+
+/*
+ * Called by the collector after all nodes have been copied. The tables of
+ * dictionaries that were not copied are released. Tables of nodes in the
+ * space of definitions are kept for good, and so are tables in a parallel
+ * child, that can be the parent's.
+ */
+static void dict_sweep(pEnv env)
+{
+    Index n;
+    khint_t k;
+    khash_t(Seen)* live = env->dicts;
+
+#if defined(JOY_PARALLEL) && defined(NOBDW)
+    if (env->parent_memory)
+        live = 0;
+#endif
+    if (live) {
+        if (env->dicts_scanned < 1)
+            env->dicts_scanned = 1;
+        for (n = env->dicts_scanned; n < env->mem_low; n += nodesize(env, n))
+            if (nodetype(n) == DICT_
+                && (k = kh_get(Seen, live, (uint64_t)(uintptr_t)nodevalue(n)
+                                               .dict)) != kh_end(live))
+                kh_del(Seen, live, k);
+        env->dicts_scanned = env->mem_low;
+        for (k = kh_begin(live); k != kh_end(live); k++)
+            if (kh_exist(live, k)
+                && (!env->copied
+                    || kh_get(Seen, env->copied, kh_key(live, k))
+                           == kh_end(env->copied))) {
+                dict_destroy((khash_t(Dict)*)(uintptr_t)kh_key(live, k));
+                kh_del(Seen, live, k);
+            }
+    }
+    if (env->copied) {
+        kh_destroy(Seen, env->copied);
+        env->copied = 0;
+    }
+}
+
+/*
+ * dict_free - release the tables of dictionaries, at the end.
+ */
+void dict_free(pEnv env)
+{
+    khint_t k;
+
+    if (!env->dicts)
+        return;
+#if defined(JOY_PARALLEL) && defined(NOBDW)
+    if (!env->parent_memory)
+#endif
+        for (k = kh_begin(env->dicts); k != kh_end(env->dicts); k++)
+            if (kh_exist(env->dicts, k))
+                dict_destroy(
+                    (khash_t(Dict)*)(uintptr_t)kh_key(env->dicts, k));
+    kh_destroy(Seen, env->dicts);
+    env->dicts = 0;
+}
+
 /*
  * Copy a single node (not the next chain) from from_space to to_space.
  * Returns the new index. Does NOT recursively copy the next field.
@@ -193,34 +290,21 @@ static Index copy_one(pEnv env, Index n)
         env->memoryindex += num;
     }
     /*
-     * If the node contains a list, then the list needs to be copied. This
+     * If the node contains a list, or the state of a sequence, then the list
+     * needs to be copied. This
      * requires recursive copying (bounded by actual list nesting depth).
      */
-    if (op == LIST_)
+    if (op == LIST_ || op == SEQ_)
         env->memory[temp].u.lis = copy(env, env->old_memory[n].u.lis);
+    if (op == DICT_)
+        copy_dict(env, env->old_memory[n].u.dict);
 #ifdef JOY_NATIVE_TYPES
     /*
-     * If the node contains a native vector, deep-copy the VectorData.
-     * VectorData is allocated atomically (no internal pointers), so we
-     * just need to copy the entire structure including the flexible array.
+     * If the node contains a native vector or matrix, the data is shared by
+     * the copy; it is marked, such that native_sweep does not release it.
      */
-    if (op == VECTOR_ && env->old_memory[n].u.vec) {
-        VectorData* old_vec = env->old_memory[n].u.vec;
-        size_t size = sizeof(VectorData) + old_vec->len * sizeof(double);
-        VectorData* new_vec = GC_CTX_MALLOC_ATOMIC(env, size);
-        memcpy(new_vec, old_vec, size);
-        env->memory[temp].u.vec = new_vec;
-    }
-    /*
-     * If the node contains a native matrix, deep-copy the MatrixData.
-     */
-    if (op == MATRIX_ && env->old_memory[n].u.mat) {
-        MatrixData* old_mat = env->old_memory[n].u.mat;
-        size_t size = sizeof(MatrixData) + old_mat->rows * old_mat->cols * sizeof(double);
-        MatrixData* new_mat = GC_CTX_MALLOC_ATOMIC(env, size);
-        memcpy(new_mat, old_mat, size);
-        env->memory[temp].u.mat = new_mat;
-    }
+    if (op == VECTOR_ || op == MATRIX_ || op == SPARSE_)
+        native_mark(env->old_memory[n].u.vec);
 #endif
     /*
      * The original location is set to COPIED_, such that it will not be copied
@@ -326,6 +410,56 @@ static void scan_roots(pEnv env)
     }
 }
 
+/*
+ * The entries of the memo cache are roots as well.
+ */
+static void scan_memo(pEnv env)
+{
+    int i;
+    MemoEntry* ent;
+
+    if (!env->memo)
+        return;
+    for (i = 0; i < env->memo->count; i++) {
+        ent = &env->memo->entry[i];
+        ent->quote = copy(env, ent->quote);
+        ent->arg = copy(env, ent->arg);
+        ent->value = copy(env, ent->value);
+    }
+}
+
+/*
+ * The bodies of pattern variables that are bound while an action of match or
+ * cases runs are roots, and so are the bodies that they replaced. A body can
+ * be both, so only old indices are passed to copy; the symbol table is
+ * updated from the binding that is visible there.
+ */
+static void scan_pattern(pEnv env)
+{
+    int i;
+    Entry ent;
+    PatBinding* bind;
+
+    if (!env->patterns)
+        return;
+    for (i = 0; i < env->patterns->binds; i++) {
+        bind = &env->patterns->bind[i];
+        ent = vec_at(env->symtab, bind->sym);
+        bind->top = ent.is_user && ent.u.body == bind->body;
+    }
+    for (i = 0; i < env->patterns->binds; i++) {
+        bind = &env->patterns->bind[i];
+        if (bind->saved.is_user && bind->saved.u.body)
+            bind->saved.u.body = copy(env, bind->saved.u.body);
+        bind->body = copy(env, bind->body);
+        if (bind->top) {
+            ent = vec_at(env->symtab, bind->sym);
+            ent.u.body = bind->body;
+            vec_at(env->symtab, bind->sym) = ent;
+        }
+    }
+}
+
 static void gc1(pEnv env, Index *l, Index *r)
 {
     start_gc_clock = clock(); /* statistics */
@@ -397,6 +531,12 @@ static void gc1(pEnv env, Index *l, Index *r)
 
     if (env->variable_busy) /* also copy variables, if there are any */
         scan_roots(env);
+    scan_memo(env);
+    scan_pattern(env);
+    hashcons_forward(env); /* canonical nodes follow their copies */
+    pattern_forward(env);  /* compiled patterns follow their keys */
+    native_sweep(env);     /* release data of native values not copied */
+    dict_sweep(env);       /* and tables of dictionaries */
 }
 
 static void gc2(pEnv env)
@@ -491,13 +631,30 @@ static int count(pEnv env, Index n)
             num += (size + sizeof(Node) - 1) / sizeof(Node);    /* round up */
     }
     /*
-     * If the node contains a list, then the list needs to be counted.
+     * If the node contains a list, or the state of a sequence, then the list
+     * needs to be counted.
      */
-    if (op == LIST_)
+    if (op == LIST_ || op == SEQ_)
         num += count(env, env->memory[n].u.lis);
     return num;
 }
 
+/*
+ * Number of nodes that a copy of node n occupies: 1, unless it contains a
+ * string that does not fit in the first node.
+ */
+int nodesize(pEnv env, Index n)
+{
+    int size, num = 1;
+
+    if (nodetype(n) == STRING_ || nodetype(n) == BIGNUM_) {
+        size = nodeleng(n) + 1;
+        if ((size -= sizeof(Types)) > 0)       /* first part in Types */
+            num += (size + sizeof(Node) - 1) / sizeof(Node); /* round up */
+    }
+    return num;
+}
+
 /*
  * Allocate a number of nodes. The nodes are filled from the parameters.
  * Strings are passed in allocated memory, that is copied to nodes and must
@@ -507,13 +664,24 @@ Index newnode(pEnv env, Operator o, Types u, Index r)
 {
     Index p;
     int size, leng = 0, num = 1, numgc;  /* allocate at least one node */
+    int need_gc = 0;
+    size_t len;
 
     if (o == STRING_ || o == BIGNUM_) {
-        size = leng = strlen(u.str) + 1;
+        if ((len = strlen(u.str)) > MAX_STRING_LEN)
+            execerror(env, "smaller size", "string");
+        size = leng = len + 1;
         if ((size -= sizeof(Types)) > 0) /* first part in Types */
             num += (size + sizeof(Node) - 1) / sizeof(Node); /* round up */
     }
-    if (env->memoryindex + num >= env->memorymax) { /* space for new node */
+#ifdef JOY_NATIVE_TYPES
+    /*
+     * Collect early, when much data of native values has been allocated.
+     */
+    if ((o == VECTOR_ || o == MATRIX_ || o == SPARSE_) && !env->flibrary_busy)
+        need_gc = native_full(env);
+#endif
+    if (need_gc || env->memoryindex + num >= env->memorymax) { /* space */
         /*
          * No garbage collection during the read of definitions.
          */
@@ -530,7 +698,7 @@ Index newnode(pEnv env, Operator o, Types u, Index r)
              * Make sure that, in the case of gc, enough nodes are available.
              */
             numgc = num;
-            if (o == LIST_)
+            if (o == LIST_ || o == SEQ_)
                 numgc += count(env, u.lis);
             numgc += count(env, r);
             /*
@@ -539,7 +707,7 @@ Index newnode(pEnv env, Operator o, Types u, Index r)
              */
             while (env->memoryindex + numgc >= env->memorymax)
                 env->memorymax *= 2;
-            if (o == LIST_)             /* copy parameters */
+            if (o == LIST_ || o == SEQ_) /* copy parameters */
                 gc1(env, &u.lis, &r);
             else                        /* copy roots */
                 gc1(env, 0, &r);
@@ -556,6 +724,17 @@ Index newnode(pEnv env, Operator o, Types u, Index r)
     env->memory[p].u = u;
     env->memory[p].op = o;
     env->memory[p].next = r;
+#ifdef JOY_NATIVE_TYPES
+    if (o == VECTOR_ || o == MATRIX_ || o == SPARSE_)
+        native_store(u.vec); /* no longer pinned */
+#endif
+    if (o == DICT_ && u.dict) { /* the collector releases the table */
+        int ret;
+
+        if (!env->dicts)
+            env->dicts = kh_init(Seen);
+        kh_put(Seen, env->dicts, (uint64_t)(uintptr_t)u.dict, &ret);
+    }
     if (o == STRING_ || o == BIGNUM_) {
         memcpy(&env->memory[p].u, u.str, leng);
         env->memory[p].len = leng - 1;
@@ -1,10 +1,114 @@
 /*
  *  module  : write.c
- *  version : 1.3
- *  date    : 01/20/26
+ *  version : 1.5
+ *  date    : 10/18/26
  */
 #include "globals.h"
 
+/*
+ * writeinteger - the decimal digits of num in buf, that has room for MAXNUM
+ *		  characters. Returns the length.
+ */
+int writeinteger(char* buf, int64_t num)
+{
+    char tmp[MAXNUM], *ptr = tmp + MAXNUM;
+    uint64_t u = num < 0 ? -(uint64_t)num : (uint64_t)num;
+    int leng;
+
+    do
+        *--ptr = '0' + u % 10;
+    while ((u /= 10) != 0);
+    if (num < 0)
+        *--ptr = '-';
+    memcpy(buf, ptr, leng = tmp + MAXNUM - ptr);
+    buf[leng] = 0;
+    return leng;
+}
+
+/*
+ * writedouble - a shortest decimal that reads back as dbl, in buf that has
+ *		 room for MAXNUM characters, in the notation of %g. Returns
+ *		 the length.
+ *
+ * Between 1e-4 and 1e15 the decimal with the fewest digits after the point
+ * is found without printf: dbl * 10^k is rounded to an integer r, and if r
+ * and 10^k are exact as doubles, r / 10^k is rounded correctly by division
+ * and equals dbl exactly when r * 10^-k reads back as dbl. Otherwise the
+ * fewest digits of %g that read back, at most 17, are found with a binary
+ * search: when p digits read back, so do p + 1. In the range above, fewer
+ * than 16 digits would have been found.
+ */
+int writedouble(char* buf, double dbl)
+{
+    static const double tens[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    char tmp[MAXNUM], *ptr = buf;
+    double x, mag = fabs(dbl);
+    int64_t r;
+    int k, lo, hi, prec, leng;
+
+    lo = 1;
+    if (mag >= 1e-4 && mag < 1e15)
+        for (lo = 16, k = 0; k < 23; k++) {
+            if (fabs(x = dbl * tens[k]) >= 9007199254740992.0) /* 2^53 */
+                break;
+            r = (int64_t)(x < 0 ? x - 0.5 : x + 0.5);
+            if ((double)r / tens[k] != dbl)
+                continue;
+            if (!k)
+                return writeinteger(buf, r);
+            if (r < 0) {
+                *ptr++ = '-';
+                r = -r;
+            }
+            leng = writeinteger(tmp, r);
+            if (leng > k) { /* digits before the point */
+                memcpy(ptr, tmp, leng - k);
+                ptr += leng - k;
+            } else
+                *ptr++ = '0';
+            *ptr++ = '.';
+            for (; leng < k; k--) /* leading zeros after the point */
+                *ptr++ = '0';
+            memcpy(ptr, tmp + leng - k, k);
+            ptr[k] = 0;
+            return ptr + k - buf;
+        }
+    for (hi = 17; lo < hi;) {
+        prec = (lo + hi) / 2;
+        leng = snprintf(tmp, MAXNUM, "%.*g", prec, dbl);
+        if (leng < MAXNUM && strtod(tmp, 0) == dbl)
+            hi = prec;
+        else
+            lo = prec + 1;
+    }
+    leng = snprintf(tmp, MAXNUM, "%.*g", lo, dbl);
+    memcpy(buf, tmp, leng + 1);
+    return leng;
+}
+
+#ifdef JOY_NATIVE_TYPES
+/*
+ * Print element i of the data of a native value. Floats always have a
+ * decimal point or an exponent; integers have neither.
+ */
+static void writeelement(pEnv env, int dtype, void* data, int64_t i, FILE* fp)
+{
+    char buf[BUFFERMAX];
+
+    if (dtype == DT_F64 || dtype == DT_F32) {
+        snprintf(buf, BUFFERMAX, "%g", kernel_get(dtype, data, i));
+        if (!strchr(buf, '.') && !strchr(buf, 'e')
+            && isdigit(buf[strlen(buf) - 1]))
+            strcat(buf, ".0");
+    } else
+        snprintf(buf, BUFFERMAX, "%" PRId64, kernel_geti(dtype, data, i));
+    joy_fputs(env, buf, fp);
+}
+#endif
+
 /*
  * writefactor - print a factor in readable format to fp.
  * Uses I/O abstraction for stdout output when callbacks are set.
@@ -149,22 +253,28 @@ void writefactor(pEnv env, Index n, FILE* fp)
         break;
     }
 
+    case SEQ_: {
+        static char* kind[] = { "iterate", "range", "repeat", "cycle", "map",
+                                "filter", "take", "takewhile" };
+        joy_fputs(env, "seq:", fp);
+        if (nodevalue(n).lis)
+            joy_fputs(env, kind[nodevalue(nodevalue(n).lis).num], fp);
+        else
+            joy_fputs(env, "empty", fp);
+        break;
+    }
+
 #ifdef JOY_NATIVE_TYPES
     case VECTOR_: {
         VectorData* v = nodevalue(n).vec;
+        int64_t k;
         joy_fputs(env, "v[", fp);
         if (v) {
-            for (i = 0; i < v->len; i++) {
-                if (i > 0)
+            vector_force(v);
+            for (k = 0; k < v->len; k++) {
+                if (k > 0)
                     joy_putc(env, ' ', fp);
-                snprintf(buf, BUFFERMAX, "%g", v->data[i]);
-                /* Ensure decimal point for whole numbers */
-                ptr = strchr(buf, '.');
-                if (!ptr && !strchr(buf, 'e')) {
-                    if (isdigit(buf[strlen(buf) - 1]))
-                        strcat(buf, ".0");
-                }
-                joy_fputs(env, buf, fp);
+                writeelement(env, v->dtype, v->data, k * v->inc, fp);
             }
         }
         joy_putc(env, ']', fp);
@@ -173,7 +283,7 @@ void writefactor(pEnv env, Index n, FILE* fp)
 
     case MATRIX_: {
         MatrixData* m = nodevalue(n).mat;
-        int r, c;
+        int64_t r, c;
         joy_fputs(env, "m[", fp);
         if (m) {
             for (r = 0; r < m->rows; r++) {
@@ -181,13 +291,7 @@ void writefactor(pEnv env, Index n, FILE* fp)
                 for (c = 0; c < m->cols; c++) {
                     if (c > 0)
                         joy_putc(env, ' ', fp);
-                    snprintf(buf, BUFFERMAX, "%g", m->data[r * m->cols + c]);
-                    ptr = strchr(buf, '.');
-                    if (!ptr && !strchr(buf, 'e')) {
-                        if (isdigit(buf[strlen(buf) - 1]))
-                            strcat(buf, ".0");
-                    }
-                    joy_fputs(env, buf, fp);
+                    writeelement(env, m->dtype, m->data, r * m->ld + c, fp);
                 }
                 joy_putc(env, ']', fp);
             }
@@ -195,6 +299,14 @@ void writefactor(pEnv env, Index n, FILE* fp)
         joy_putc(env, ']', fp);
         break;
     }
+
+    case SPARSE_: {
+        SparseData* sp = nodevalue(n).spm;
+        joy_fprintf(env, fp, "sparse:%s:%" PRId64 "x%" PRId64 ":%" PRId64,
+                    sp->format == SP_CSR ? "csr" : "csc", sp->rows, sp->cols,
+                    sp->nnz);
+        break;
+    }
 #endif /* JOY_NATIVE_TYPES */
 
     default:
@@ -287,6 +287,104 @@ TEST(custom_io)
     joy_destroy(ctx);
 }
 
+/* Count the calls of write_string */
+static int output_calls = 0;
+
+static void test_count_string(void* user_data, const char* s)
+{
+    output_calls++;
+    test_write_string(user_data, s);
+}
+
+/* Test flush policies of the output to the callbacks */
+TEST(flush_policy)
+{
+    JoyIO io = {
+        .write_string = test_count_string,
+    };
+    JoyConfig config = {
+        .io = &io,
+        .flush_policy = JOY_FLUSH_SIZE,
+        .output_buffer_size = 16
+    };
+
+    output_buffer[0] = '\0';
+    output_pos = 0;
+    output_calls = 0;
+    JoyContext* ctx = joy_create(&config);
+    ASSERT(ctx != NULL);
+
+    /* Buffered until full: one call per 16 characters */
+    joy_eval_string(ctx, "[1 2 3 4 5 6 7 8 9 10 11 12] put [13] put .");
+    ASSERT_EQ(output_calls, 2);
+    ASSERT_STR_EQ(output_buffer, "[1 2 3 4 5 6 7 8 9 10 11 12][13]");
+    joy_destroy(ctx);
+
+    /* Flushed at each newline */
+    config.flush_policy = JOY_FLUSH_LINE;
+    config.output_buffer_size = 0;
+    output_buffer[0] = '\0';
+    output_pos = 0;
+    output_calls = 0;
+    ctx = joy_create(&config);
+    joy_eval_string(ctx, "1 put '\\n putch 2 put .");
+    ASSERT_EQ(output_calls, 2);
+    ASSERT_STR_EQ(output_buffer, "1\n2");
+    joy_destroy(ctx);
+}
+
+/* Bulk callbacks: output as counted bytes, input from a string */
+static const char* input_text;
+
+static void test_write_bytes(void* user_data, const char* s, size_t n)
+{
+    (void)user_data;
+    output_calls++;
+    if (output_pos + n < sizeof(output_buffer)) {
+        memcpy(output_buffer + output_pos, s, n);
+        output_pos += n;
+        output_buffer[output_pos] = '\0';
+    }
+}
+
+static size_t test_read_bytes(void* user_data, char* buf, size_t n)
+{
+    size_t len = strlen(input_text);
+
+    (void)user_data;
+    if (len > n)
+        len = n;
+    memcpy(buf, input_text, len);
+    input_text += len;
+    return len;
+}
+
+/* Test write_bytes and read_bytes */
+TEST(bulk_io)
+{
+    JoyIO io = {
+        .write_bytes = test_write_bytes,
+        .read_bytes = test_read_bytes,
+    };
+    JoyConfig config = {
+        .io = &io,
+        .flush_policy = JOY_FLUSH_TERM
+    };
+
+    output_buffer[0] = '\0';
+    output_pos = 0;
+    output_calls = 0;
+    input_text = " 2 + put [1 2 3] put .\n";
+    JoyContext* ctx = joy_create(&config);
+    ASSERT(ctx != NULL);
+
+    /* The term continues in the input of read_bytes; one call writes all */
+    joy_eval_string(ctx, "1");
+    ASSERT_EQ(output_calls, 1);
+    ASSERT_STR_EQ(output_buffer, "3[1 2 3]");
+    joy_destroy(ctx);
+}
+
 int main(void)
 {
     printf("Joy API Tests\n");
@@ -301,6 +399,8 @@ int main(void)
     RUN_TEST(eval_simple);
     RUN_TEST(stack_ops);
     RUN_TEST(errors);
+    RUN_TEST(flush_policy);
+    RUN_TEST(bulk_io);
 
     printf("\n%d/%d tests passed\n", tests_passed, tests_run);
     return tests_passed == tests_run ? 0 : 1;